@@ -1,6 +1,8 @@
 # SPDX-License-Identifier: BSD-3-Clause
 # Copyright(c) 2018 Nippon Telegraph and Telephone Corporation
 
+from ..shell_lib import common
+
 
 class SppMirror(object):
     """Exec spp_mirror command.
@@ -17,7 +19,11 @@ class SppMirror(object):
             'status': None,
             'exit': None,
             'component': ['start', 'stop'],
-            'port': ['add', 'del']}
+            'port': ['add', 'del'],
+            'ring_latency': ['start', 'stop'],
+            'filter': None,
+            'limit': None,
+            'copy_mode': None}
 
     WORKER_TYPES = ['mirror']
 
@@ -71,6 +77,18 @@ class SppMirror(object):
         elif cmd == 'port':
             self._run_port(params)
 
+        elif cmd == 'ring_latency':
+            self._run_ring_latency(params)
+
+        elif cmd == 'filter':
+            self._run_filter(params)
+
+        elif cmd == 'limit':
+            self._run_limit(params)
+
+        elif cmd == 'copy_mode':
+            self._run_copy_mode(params)
+
         elif cmd == 'exit':
             self._run_exit()
 
@@ -142,6 +160,33 @@ class SppMirror(object):
                 # TODO(yasufum) should change 'unuse' to 'unused'
                 print("  - core:%d '' (type: unuse)" % worker['core'])
 
+        # Ring latency of rings enabled with `ring_latency` command
+        if 'ring_latency' in json_obj:
+            print('Ring Latency (ns):')
+            if len(json_obj['ring_latency']) == 0:
+                print('  Not enabled.')
+            for rl in json_obj['ring_latency']:
+                if rl.get('enabled', 1) == 1:
+                    state = ''
+                else:
+                    state = ' (stopped)'
+                print(('  - %s%s: min %d, avg %d, p50 %d, p99 %d, ' +
+                       'p99.9 %d, max %d (count: %d)') % (
+                      rl['port'], state, rl['min'], rl['avg'], rl['p50'],
+                      rl['p99'], rl['p99.9'], rl['max'], rl['count']))
+
+        # Packets not mirrored with sampling, rate limit or failure of copy
+        if 'mirror_stats' in json_obj and len(json_obj['mirror_stats']) > 0:
+            print('Mirror Stats:')
+            for ms in json_obj['mirror_stats']:
+                print(('  - %s (%s copy, sample: %d, rate: %d %s/s): ' +
+                       'sampled_out %d, rate_limited %d, copy_failed %d') % (
+                      ms['name'], ms.get('copy_mode', ''), ms['sample'],
+                      ms['rate'], ms['unit'], ms['sampled_out'],
+                      ms['rate_limited'], ms['copy_failed']))
+
+        common.print_chain_latency(json_obj)
+
     def complete(self, sec_ids, text, line, begidx, endidx):
         """Completion for spp_mirrorcommands.
 
@@ -169,6 +214,14 @@ class SppMirror(object):
 
                     elif sub_tokens[0] == 'port':
                         completions = self._compl_port(sub_tokens)
+                    elif sub_tokens[0] == 'ring_latency':
+                        completions = self._compl_ring_latency(sub_tokens)
+                    elif sub_tokens[0] == 'filter':
+                        completions = self._compl_filter(sub_tokens)
+                    elif sub_tokens[0] == 'limit':
+                        completions = self._compl_limit(sub_tokens)
+                    elif sub_tokens[0] == 'copy_mode':
+                        completions = self._compl_copy_mode(sub_tokens)
             return completions
         except Exception as e:
             print(e)
@@ -271,6 +324,8 @@ class SppMirror(object):
         if params[0] == 'start':
             req_params = {'name': params[1], 'core': int(params[2]),
                           'type': params[3]}
+            if len(params) > 4:
+                req_params['snaplen'] = int(params[4])
             res = self.spp_ctl_cli.post('mirrors/%d/components' % self.sec_id,
                                         req_params)
             if res is not None:
@@ -355,6 +410,97 @@ class SppMirror(object):
             else:
                 print('Error: unknown response.')
 
+    def _run_ring_latency(self, params):
+        """Run `ring_latency` command."""
+
+        if len(params) != 2 or params[0] not in ['start', 'stop']:
+            print('Error: Usage is ring_latency {start|stop} RES_UID')
+            return None
+
+        req_params = {'action': params[0], 'port': params[1]}
+        res = self.spp_ctl_cli.put('mirrors/%d/ring_latency' % self.sec_id,
+                                   req_params)
+        if res is not None:
+            error_codes = self.spp_ctl_cli.rest_common_error_codes
+            if res.status_code == 204:
+                print("Succeeded to %s ring_latency" % params[0])
+            elif res.status_code in error_codes:
+                pass
+            else:
+                print('Error: unknown response.')
+
+    def _run_filter(self, params):
+        """Run `filter` command."""
+
+        if len(params) < 1 or params[0] == '':
+            print('Error: Usage is filter NAME [EXPR]')
+            return None
+
+        # Filter is cleared if no expression is given.
+        req_params = {'filter': ' '.join(params[1:]).strip()}
+        res = self.spp_ctl_cli.put(
+                'mirrors/%d/components/%s/filter' % (self.sec_id, params[0]),
+                req_params)
+        if res is not None:
+            error_codes = self.spp_ctl_cli.rest_common_error_codes
+            if res.status_code == 204:
+                if req_params['filter'] == '':
+                    print("Succeeded to clear filter of '%s'" % params[0])
+                else:
+                    print("Succeeded to set filter of '%s'" % params[0])
+            elif res.status_code in error_codes:
+                pass
+            else:
+                print('Error: unknown response.')
+
+    def _run_limit(self, params):
+        """Run `limit` command."""
+
+        usage = 'Error: Usage is limit NAME SAMPLE RATE {pkts|bytes}'
+        if len(params) != 4 or params[3] not in ['pkts', 'bytes']:
+            print(usage)
+            return None
+        try:
+            req_params = {'sample': int(params[1]), 'rate': int(params[2]),
+                          'unit': params[3]}
+        except ValueError:
+            print(usage)
+            return None
+
+        res = self.spp_ctl_cli.put(
+                'mirrors/%d/components/%s/limit' % (self.sec_id, params[0]),
+                req_params)
+        if res is not None:
+            error_codes = self.spp_ctl_cli.rest_common_error_codes
+            if res.status_code == 204:
+                print("Succeeded to set limit of '%s'" % params[0])
+            elif res.status_code in error_codes:
+                pass
+            else:
+                print('Error: unknown response.')
+
+    def _run_copy_mode(self, params):
+        """Run `copy_mode` command."""
+
+        if len(params) != 2 or params[1] not in ['shallow', 'deep']:
+            print('Error: Usage is copy_mode NAME {shallow|deep}')
+            return None
+
+        req_params = {'mode': params[1]}
+        res = self.spp_ctl_cli.put(
+                'mirrors/%d/components/%s/copy_mode' % (
+                    self.sec_id, params[0]),
+                req_params)
+        if res is not None:
+            error_codes = self.spp_ctl_cli.rest_common_error_codes
+            if res.status_code == 204:
+                print("Succeeded to set %s copy to '%s'" % (
+                      params[1], params[0]))
+            elif res.status_code in error_codes:
+                pass
+            else:
+                print('Error: unknown response.')
+
     def _run_exit(self):
         """Run `exit` command."""
 
@@ -368,6 +514,40 @@ class SppMirror(object):
             else:
                 print('Error: unknown response.')
 
+    def _compl_ring_latency(self, sub_tokens):
+        res = []
+        if len(sub_tokens) == 2:
+            res = [kw for kw in ['start', 'stop']
+                   if kw.startswith(sub_tokens[1])]
+        return res
+
+    def _compl_filter(self, sub_tokens):
+        res = []
+        if len(sub_tokens) == 2:
+            res = [name for name in self.worker_names
+                   if name.startswith(sub_tokens[1])]
+        return res
+
+    def _compl_limit(self, sub_tokens):
+        res = []
+        if len(sub_tokens) == 2:
+            res = [name for name in self.worker_names
+                   if name.startswith(sub_tokens[1])]
+        elif len(sub_tokens) == 5:
+            res = [kw for kw in ['pkts', 'bytes']
+                   if kw.startswith(sub_tokens[4])]
+        return res
+
+    def _compl_copy_mode(self, sub_tokens):
+        res = []
+        if len(sub_tokens) == 2:
+            res = [name for name in self.worker_names
+                   if name.startswith(sub_tokens[1])]
+        elif len(sub_tokens) == 3:
+            res = [kw for kw in ['shallow', 'deep']
+                   if kw.startswith(sub_tokens[2])]
+        return res
+
     def _compl_component(self, sub_tokens):
         if len(sub_tokens) < 6:
             subsub_cmds = ['start', 'stop']
@@ -462,10 +642,14 @@ class SppMirror(object):
 
         spp_mirror is a secondary process for duplicating incoming
         packets to be used as similar to TaaS in OpenStack. This
-        command has four sub commands.
+        command has seven sub commands.
           * status
           * component
           * port
+          * ring_latency
+          * filter
+          * limit
+          * copy_mode
 
         Each of sub commands other than 'status' takes several parameters
         for detailed operations. Notice that 'start' for launching a worker
@@ -483,11 +667,32 @@ class SppMirror(object):
         spp > mirror 1; component start NAME CORE_ID mirror
         spp > mirror 1; component stop NAME CORE_ID mirror
 
+        #   SNAPLEN: copy only leading bytes of packets, up to 2048
+        spp > mirror 1; component start NAME CORE_ID mirror SNAPLEN
+
         # (3) add or delete a port to worker of NAME
         #   RES_UID: resource UID such as 'ring:0' or 'vhost:1'
         #   DIR: 'rx' or 'tx'
         spp > mirror 1; port add RES_UID DIR NAME
         spp > mirror 1; port del RES_UID DIR NAME
+
+        # (4) start or stop measuring latency of a ring
+        spp > mirror 1; ring_latency start RES_UID
+        spp > mirror 1; ring_latency stop RES_UID
+
+        # (5) mirror only packets matched with filter of pcap syntax,
+        #     or mirror all of packets if EXPR is not given
+        spp > mirror 1; filter NAME udp port 53
+        spp > mirror 1; filter NAME
+
+        # (6) mirror 1 in SAMPLE packets under RATE of pkts or bytes per sec,
+        #     or 0 for each of them to disable
+        spp > mirror 1; limit NAME SAMPLE RATE pkts
+        spp > mirror 1; limit NAME 0 0 pkts
+
+        # (7) share a clone among TX ports, or copy for each of them
+        spp > mirror 1; copy_mode NAME shallow
+        spp > mirror 1; copy_mode NAME deep
         """
 
         print(msg)
@@ -2,6 +2,7 @@
 # Copyright(c) 2018 Nippon Telegraph and Telephone Corporation
 
 from .. import spp_common
+from ..shell_lib import common
 
 
 class SppNfv(object):
@@ -95,6 +96,8 @@ class SppNfv(object):
             else:
                 print('  - {} -> {}'.format(port, dst))
 
+        common.print_chain_latency(json_obj)
+
     # TODO(yasufum) change name starts with '_' as private
     def get_ports(self):
         """Get all of ports as a list."""
@@ -71,6 +71,20 @@ class SppPcap(object):
 
         elif cmd == 'start':
             req_params = {'action': 'start'}
+            # Optional params, `snaplen LEN` and `filter EXPR` at the end.
+            params = [p for p in params if p != '']
+            while len(params) > 1:
+                if params[0] == 'snaplen' and params[1].isdigit():
+                    req_params['snaplen'] = int(params[1])
+                    params = params[2:]
+                elif params[0] == 'filter':
+                    req_params['filter'] = ' '.join(params[1:]).strip()
+                    params = []
+                else:
+                    break
+            if len(params) > 0:
+                print('Error: Usage is start [snaplen LEN] [filter EXPR]')
+                return
             res = self.spp_ctl_cli.put('pcaps/%d/capture'
                                        % (self.sec_id), req_params)
             if res is not None:
@@ -160,6 +174,8 @@ class SppPcap(object):
                     print(msg.format(direction='rx', res_id=pt))
                 else:
                     print('    - filename: {}'.format(worker['filename']))
+                    if 'error' in worker.keys():
+                        print('    - error: {}'.format(worker['error']))
 
     def complete(self, sec_ids, text, line, begidx, endidx):
         """Completion for spp_pcap commands.
@@ -258,7 +274,10 @@ class SppPcap(object):
         spp > pcap 1; start
         spp > pcap 1; stop
 
-        # (3) terminate spp_pcap secondaryd
+        # (3) capture only headers of packets matched with filter
+        spp > pcap 1; start snaplen 128 filter udp port 53
+
+        # (4) terminate spp_pcap secondaryd
         spp > pcap 1; exit
         """
 
@@ -587,6 +587,60 @@ class SppTopo(object):
                                                     dst_type, dst_id, attrs)
                             links.append(tmp)
 
+                    elif comp['type'] == 'classifier_learn':
+                        # Packets from a RX port are sent to TX ports
+                        # other than the one paired with it.
+                        for ri, rxp in enumerate(comp['rx_port']):
+                            if self._is_valid_port(rxp['port']):
+                                src_type, src_id = rxp['port'].split(':')
+                            for ti, txp in enumerate(comp['tx_port']):
+                                if ri == ti:
+                                    continue
+                                if self._is_valid_port(txp['port']):
+                                    dst_type, dst_id = txp['port'].split(
+                                        ':')
+
+                                if src_type is None or dst_type is None:
+                                    print('Error: {msg} {comp}:{sid} {ct}'
+                                          .format(
+                                              msg='Falied to parse links in',
+                                              comp='vf',
+                                              sid=sec['client-id'],
+                                              ct=comp['type']))
+                                    return False
+
+                                tmp = link_style.format(src_type, src_id,
+                                                        self.LINK_TYPE,
+                                                        dst_type, dst_id,
+                                                        attrs)
+                                links.append(tmp)
+
+                    elif comp['type'] == 'balancer':
+                        # Packets from each of RX ports are sent to all of
+                        # TX ports.
+                        for rxp in comp['rx_port']:
+                            if self._is_valid_port(rxp['port']):
+                                src_type, src_id = rxp['port'].split(':')
+                            for txp in comp['tx_port']:
+                                if self._is_valid_port(txp['port']):
+                                    dst_type, dst_id = txp['port'].split(
+                                        ':')
+
+                                if src_type is None or dst_type is None:
+                                    print('Error: {msg} {comp}:{sid} {ct}'
+                                          .format(
+                                              msg='Falied to parse links in',
+                                              comp='vf',
+                                              sid=sec['client-id'],
+                                              ct=comp['type']))
+                                    return False
+
+                                tmp = link_style.format(src_type, src_id,
+                                                        self.LINK_TYPE,
+                                                        dst_type, dst_id,
+                                                        attrs)
+                                links.append(tmp)
+
                     elif comp['type'] == 'merge':  # TODO change to merger
                         if len(comp['tx_port']) > 0:
                             txport = comp['tx_port'][0]['port']
@@ -1,6 +1,8 @@
 # SPDX-License-Identifier: BSD-3-Clause
 # Copyright(c) 2018 Nippon Telegraph and Telephone Corporation
 
+from ..shell_lib import common
+
 
 class SppVf(object):
     """Exec SPP VF command.
@@ -18,9 +20,11 @@ class SppVf(object):
             'exit': None,
             'component': ['start', 'stop'],
             'port': ['add', 'del'],
-            'classifier_table': ['add', 'del']}
+            'classifier_table': ['add', 'del'],
+            'ring_latency': ['start', 'stop']}
 
-    WORKER_TYPES = ['forward', 'merge', 'classifier']
+    WORKER_TYPES = ['forward', 'merge', 'classifier', 'classifier_learn',
+                    'balancer']
 
     def __init__(self, spp_ctl_cli, sec_id, use_cache=False):
         self.spp_ctl_cli = spp_ctl_cli
@@ -74,6 +78,9 @@ class SppVf(object):
         elif cmd == 'classifier_table':
             self._run_cls_table(params)
 
+        elif cmd == 'ring_latency':
+            self._run_ring_latency(params)
+
         elif cmd == 'exit':
             self._run_exit()
 
@@ -154,6 +161,23 @@ class SppVf(object):
                 # TODO(yasufum) should change 'unuse' to 'unused'
                 print("  - core:%d '' (type: unuse)" % worker['core'])
 
+        # Ring latency of rings enabled with `ring_latency` command
+        if 'ring_latency' in json_obj:
+            print('Ring Latency (ns):')
+            if len(json_obj['ring_latency']) == 0:
+                print('  Not enabled.')
+            for rl in json_obj['ring_latency']:
+                if rl.get('enabled', 1) == 1:
+                    state = ''
+                else:
+                    state = ' (stopped)'
+                print(('  - %s%s: min %d, avg %d, p50 %d, p99 %d, ' +
+                       'p99.9 %d, max %d (count: %d)') % (
+                      rl['port'], state, rl['min'], rl['avg'], rl['p50'],
+                      rl['p99'], rl['p99.9'], rl['max'], rl['count']))
+
+        common.print_chain_latency(json_obj)
+
     def complete(self, sec_ids, text, line, begidx, endidx):
         """Completion for spp_vf commands.
 
@@ -190,6 +214,8 @@ class SppVf(object):
 
                     elif sub_tokens[0] == 'classifier_table':
                         completions = self._compl_cls_table(sub_tokens)
+                    elif sub_tokens[0] == 'ring_latency':
+                        completions = self._compl_ring_latency(sub_tokens)
             return completions
         except Exception as e:
             print(e)
@@ -257,6 +283,9 @@ class SppVf(object):
         if params[0] == 'start':
             req_params = {'name': params[1], 'core': int(params[2]),
                           'type': params[3]}
+            # classifier sharing the table of given classifier
+            if len(params) > 4:
+                req_params['group'] = params[4]
             res = self.spp_ctl_cli.post('vfs/%d/components' % self.sec_id,
                                         req_params)
             if res is not None:
@@ -297,6 +326,7 @@ class SppVf(object):
         params_index = 0
         req_params = {}
         vlan_params = {}
+        weight = None
         name = None
         flg_mq = False
 
@@ -337,17 +367,26 @@ class SppVf(object):
                     vlan_params["operation"] = "add"
                 elif params[params_index] == "del_vlantag":
                     vlan_params["operation"] = "del"
+                elif params[params_index] == "weight":
+                    weight = 1
                 else:
                     print('Error: vlantag is Only add_vlantag or del_vlantag.')
                     return None
 
             elif ((params_index == 5 and flg_mq is False) or
                     (params_index == 7 and flg_mq is True)):
-                try:
-                    vlan_params["id"] = int(params[params_index])
-                except Exception as _:
-                    print('Error: vid is not a number.')
-                    return None
+                if weight is not None:
+                    try:
+                        weight = int(params[params_index])
+                    except Exception as _:
+                        print('Error: weight is not a number.')
+                        return None
+                else:
+                    try:
+                        vlan_params["id"] = int(params[params_index])
+                    except Exception as _:
+                        print('Error: vid is not a number.')
+                        return None
 
             elif ((params_index == 6 and flg_mq is False) or
                     (params_index == 8 and flg_mq is True)):
@@ -359,7 +398,10 @@ class SppVf(object):
 
             params_index += 1
 
-        req_params["vlan"] = vlan_params
+        if weight is not None:
+            req_params["weight"] = weight
+        else:
+            req_params["vlan"] = vlan_params
         res = self.spp_ctl_cli.put('vfs/%d/components/%s/ports'
                                    % (self.sec_id, name), req_params)
         if res is not None:
@@ -388,9 +430,13 @@ class SppVf(object):
 
             elif params_index == 1:
                 req_params["type"] = params[params_index]
+                if req_params["type"] == "acl":
+                    if not self._parse_cls_acl(params[2:], req_params):
+                        return None
+                    break
                 if (req_params["type"] != "vlan" and
                         req_params["type"] != "mac"):
-                    print("Error: Type is only vlan or mac")
+                    print("Error: Type is only vlan, mac or acl")
                     return None
 
             elif params_index == 2 and req_params["type"] == "vlan":
@@ -425,6 +471,41 @@ class SppVf(object):
             else:
                 print('Error: unknown response.')
 
+    def _parse_cls_acl(self, params, req_params):
+        """Parse 5-tuple and port of ACL rule for `classifier_table`."""
+
+        keys = ['src', 'dst', 'proto', 'src_port', 'dst_port', 'port']
+        if len(params) < len(keys):
+            print("Error: Too few params for acl")
+            return False
+
+        for key, val in zip(keys, params):
+            req_params[key] = val
+
+        # Check Multi queue
+        if len(params) == len(keys) + 2 and params[len(keys)] == "nq":
+            req_params["port"] += "nq" + params[len(keys) + 1]
+        return True
+
+    def _run_ring_latency(self, params):
+        """Run `ring_latency` command."""
+
+        if len(params) != 2 or params[0] not in ['start', 'stop']:
+            print('Error: Usage is ring_latency {start|stop} RES_UID')
+            return None
+
+        req_params = {'action': params[0], 'port': params[1]}
+        res = self.spp_ctl_cli.put('vfs/%d/ring_latency' % self.sec_id,
+                                   req_params)
+        if res is not None:
+            error_codes = self.spp_ctl_cli.rest_common_error_codes
+            if res.status_code == 204:
+                print("Succeeded to %s ring_latency" % params[0])
+            elif res.status_code in error_codes:
+                pass
+            else:
+                print('Error: unknown response.')
+
     def _run_exit(self):
         """Run `exit` command."""
 
@@ -438,8 +519,15 @@ class SppVf(object):
             else:
                 print('Error: unknown response.')
 
+    def _compl_ring_latency(self, sub_tokens):
+        res = []
+        if len(sub_tokens) == 2:
+            res = [kw for kw in ['start', 'stop']
+                   if kw.startswith(sub_tokens[1])]
+        return res
+
     def _compl_component(self, sub_tokens):
-        if len(sub_tokens) < 6:
+        if len(sub_tokens) < 7:
             subsub_cmds = ['start', 'stop']
             res = []
             if len(sub_tokens) == 2:
@@ -466,6 +554,12 @@ class SppVf(object):
                     for wk_type in self.WORKER_TYPES:
                         if wk_type.startswith(sub_tokens[4]):
                             res.append(wk_type)
+            elif len(sub_tokens) == 6:
+                if sub_tokens[1] == 'start' and \
+                        sub_tokens[4] == 'classifier':
+                    for kw in self.worker_names:
+                        if kw.startswith(sub_tokens[5]):
+                            res.append(kw)
             return res
 
     def _compl_port(self, sub_tokens):
@@ -525,7 +619,7 @@ class SppVf(object):
                     compl_phase = None
 
             elif compl_phase == "vlan_tag":
-                res = ["add_vlantag", "del_vlantag"]
+                res = ["add_vlantag", "del_vlantag", "weight"]
                 compl_phase = "vid"
 
             elif (compl_phase == "vid" and
@@ -533,6 +627,11 @@ class SppVf(object):
                 res = ["VID"]
                 compl_phase = "pcp"
 
+            elif (compl_phase == "vid" and
+                  sub_tokens[index - 1] == "weight"):
+                res = ["WEIGHT"]
+                compl_phase = None
+
             elif compl_phase == "pcp":
                 res = ["PCP"]
                 compl_phase = None
@@ -585,7 +684,7 @@ class SppVf(object):
         index = 0
 
         # compl_phase "add_del"  : candidate is add or del
-        # compl_phase "vlan_mac" : candidate is vlan or mac
+        # compl_phase "vlan_mac" : candidate is vlan, mac or acl
         # compl_phase "vid"      : candidate is VID
         # compl_phase "mac_addr" : candidate is MAC_ADDR or default
         # compl_phase "res_uid"  : candidate is RES_UID
@@ -611,9 +710,29 @@ class SppVf(object):
                 compl_phase = "vlan_mac"
 
             elif compl_phase == "vlan_mac":
-                res = ["vlan", "mac"]
+                res = ["vlan", "mac", "acl"]
                 compl_phase = "vid"
 
+            elif compl_phase == "vid" and sub_tokens[index - 1] == "acl":
+                res = ["SRC", "any"]
+                compl_phase = "acl_dst"
+
+            elif compl_phase == "acl_dst":
+                res = ["DST", "any"]
+                compl_phase = "acl_proto"
+
+            elif compl_phase == "acl_proto":
+                res = ["tcp", "udp", "sctp", "icmp", "icmpv6", "any"]
+                compl_phase = "acl_src_port"
+
+            elif compl_phase == "acl_src_port":
+                res = ["SPORT", "any"]
+                compl_phase = "acl_dst_port"
+
+            elif compl_phase == "acl_dst_port":
+                res = ["DPORT", "any"]
+                compl_phase = "res_uid"
+
             elif compl_phase == "vid" and sub_tokens[index - 1] == "vlan":
                 res = ["VID"]
                 compl_phase = "mac_addr"
@@ -649,11 +768,12 @@ class SppVf(object):
         msg = """Send a command to spp_vf.
 
         SPP VF is a secondary process for pseudo SR-IOV features. This
-        command has four sub commands.
+        command has five sub commands.
           * status
           * component
           * port
           * classifier_table
+          * ring_latency
 
         Each of sub commands other than 'status' takes several parameters
         for detailed operations. Notice that 'start' for launching a worker
@@ -668,7 +788,8 @@ class SppVf(object):
         # (2) launch or terminate a worker thread with arbitrary name
         #   NAME: arbitrary name used as identifier
         #   CORE_ID: one of unused cores referred from status
-        #   ROLE: role of workers, 'forward', 'merge' or 'classifier'
+        #   ROLE: role of workers, 'forward', 'merge', 'classifier',
+        #     'classifier_learn' or 'balancer'
         spp > vf 1; component start NAME CORE_ID ROLE
         spp > vf 1; component stop NAME CORE_ID ROLE
 
@@ -694,6 +815,25 @@ class SppVf(object):
         # (7) add or delete an entry of MAC address and resource with vlan ID
         spp > vf 1; classifier_table add vlan VID MAC_ADDR RES_UID
         spp > vf 1; classifier_table del vlan VID MAC_ADDR RES_UID
+
+        # (8) add or delete an ACL rule of 5-tuple and resource
+        #   SRC, DST: IPv4 or IPv6 prefix such as '10.0.0.0/8', or 'any'
+        #   PROTO: 'tcp', 'udp', 'sctp', 'icmp', 'icmpv6', number or 'any'
+        #   SPORT, DPORT: port such as '80', range such as '1024-65535',
+        #     or 'any'
+        spp > vf 1; classifier_table add acl SRC DST PROTO SPORT DPORT RES_UID
+        spp > vf 1; classifier_table del acl SRC DST PROTO SPORT DPORT RES_UID
+
+        # (9) add a TX port with weight to balancer, or change the weight
+        #   WEIGHT: from 0 to 255, and 0 is for no new flows
+        spp > vf 1; port add RES_UID tx NAME weight WEIGHT
+
+        # (10) launch a classifier sharing the table of classifier GROUP
+        spp > vf 1; component start NAME CORE_ID classifier GROUP
+
+        # (11) start or stop measuring latency of a ring
+        spp > vf 1; ring_latency start RES_UID
+        spp > vf 1; ring_latency stop RES_UID
         """
 
         print(msg)
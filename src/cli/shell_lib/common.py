@@ -293,3 +293,24 @@ def print_compl_warinig(msg):
     """
 
     print('// WARN: {msg}'.format(msg=msg))
+
+
+def print_chain_latency(json_obj):
+    """Print chain latency in status of a process.
+
+    It is included only if the process is launched with `--chain-latency`.
+    """
+
+    if 'chain_latency' not in json_obj:
+        return
+
+    print('Chain Latency (ns):')
+    if len(json_obj['chain_latency']) == 0:
+        print('  No samples.')
+    for cl in json_obj['chain_latency']:
+        print(('  - %s %s: hop p50 %d, p99 %d, max %d, ' +
+               'total p50 %d, p99 %d, max %d (count: %d)') % (
+              cl['point'], cl['dir'], cl['hop']['p50'],
+              cl['hop']['p99'], cl['hop']['max'],
+              cl['total']['p50'], cl['total']['p99'],
+              cl['total']['max'], cl['hop']['count']))
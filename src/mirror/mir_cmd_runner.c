@@ -9,7 +9,9 @@
 #include "shared/secondary/spp_worker_th/cmd_parser.h"
 #include "shared/secondary/spp_worker_th/cmd_runner.h"
 #include "shared/secondary/spp_worker_th/cmd_res_formatter.h"
+#include "shared/secondary/spp_worker_th/latency_stats.h"
 #include "shared/secondary/spp_worker_th/port_capability.h"
+#include "shared/secondary/spp_worker_th/pkt_filter.h"
 #include "shared/secondary/spp_worker_th/mirror_deps.h"
 
 #define RTE_LOGTYPE_MIR_CMD_RUNNER RTE_LOGTYPE_USER1
@@ -18,7 +20,8 @@
 /* TODO(yasufum) revise func name for removing the term `component`. */
 static int
 update_comp(enum sppwk_action wk_action, const char *name,
-		unsigned int lcore_id, enum sppwk_worker_type wk_type)
+		unsigned int lcore_id, enum sppwk_worker_type wk_type,
+		uint32_t snaplen)
 {
 	int ret;
 	int ret_del;
@@ -69,6 +72,7 @@ update_comp(enum sppwk_action wk_action, const char *name,
 		comp_info->wk_type = wk_type;
 		comp_info->lcore_id = lcore_id;
 		comp_info->comp_id = comp_lcore_id;
+		comp_info->snaplen = snaplen;
 
 		core->id[core->num] = comp_lcore_id;
 		core->num++;
@@ -107,6 +111,86 @@ update_comp(enum sppwk_action wk_action, const char *name,
 	return ret;
 }
 
+/**
+ * Update filter of mirror component. Given expression is compiled here to
+ * check before flush, and compiled again for new path of mirror in flush.
+ */
+static int
+update_filter(const char *name, const char *expr)
+{
+	int comp_lcore_id;
+	struct sppwk_comp_info *comp_info = NULL;
+	struct sppwk_pkt_filter *filter;
+	int *change_component = NULL;
+
+	comp_lcore_id = sppwk_get_lcore_id(name);
+	if (comp_lcore_id < 0) {
+		RTE_LOG(ERR, MIR_CMD_RUNNER, "Unknown component '%s'.\n",
+				name);
+		return SPPWK_RET_NG;
+	}
+
+	if (expr[0] != '\0') {
+		filter = sppwk_pkt_filter_create(expr);
+		if (filter == NULL)
+			return SPPWK_RET_NG;
+		sppwk_pkt_filter_free(filter);
+	}
+
+	sppwk_get_mng_data(NULL, &comp_info, NULL, NULL, &change_component,
+			NULL);
+	comp_info += comp_lcore_id;
+	strcpy(comp_info->filter, expr);
+	*(change_component + comp_lcore_id) = 1;
+	return SPPWK_RET_OK;
+}
+
+/* Update sampling and rate limit of mirror component. */
+static int
+update_limit(const char *name, const struct sppwk_mir_limit *mir_limit)
+{
+	int comp_lcore_id;
+	struct sppwk_comp_info *comp_info = NULL;
+	int *change_component = NULL;
+
+	comp_lcore_id = sppwk_get_lcore_id(name);
+	if (comp_lcore_id < 0) {
+		RTE_LOG(ERR, MIR_CMD_RUNNER, "Unknown component '%s'.\n",
+				name);
+		return SPPWK_RET_NG;
+	}
+
+	sppwk_get_mng_data(NULL, &comp_info, NULL, NULL, &change_component,
+			NULL);
+	comp_info += comp_lcore_id;
+	comp_info->mir_limit = *mir_limit;
+	*(change_component + comp_lcore_id) = 1;
+	return SPPWK_RET_OK;
+}
+
+/* Update copy mode of mirror component. */
+static int
+update_copy_mode(const char *name, enum sppwk_mir_copy_mode copy_mode)
+{
+	int comp_lcore_id;
+	struct sppwk_comp_info *comp_info = NULL;
+	int *change_component = NULL;
+
+	comp_lcore_id = sppwk_get_lcore_id(name);
+	if (comp_lcore_id < 0) {
+		RTE_LOG(ERR, MIR_CMD_RUNNER, "Unknown component '%s'.\n",
+				name);
+		return SPPWK_RET_NG;
+	}
+
+	sppwk_get_mng_data(NULL, &comp_info, NULL, NULL, &change_component,
+			NULL);
+	comp_info += comp_lcore_id;
+	comp_info->copy_mode = copy_mode;
+	*(change_component + comp_lcore_id) = 1;
+	return SPPWK_RET_OK;
+}
+
 /* Check if over the maximum num of rx and tx ports of component. */
 static int
 check_mir_port_count(enum sppwk_port_dir dir, int nof_rx, int nof_tx)
@@ -121,7 +205,7 @@ check_mir_port_count(enum sppwk_port_dir dir, int nof_rx, int nof_tx)
 	RTE_LOG(INFO, MIR_CMD_RUNNER, "Num of ports after count up,"
 				" port_type=%d, rx=%d, tx=%d\n",
 				dir, nof_rx, nof_tx);
-	if (nof_rx > 1 || nof_tx > 2)
+	if (nof_rx > 1 || nof_tx > MIR_TX_MAX)
 		return SPPWK_RET_NG;
 
 	return SPPWK_RET_OK;
@@ -266,7 +350,8 @@ exec_one_cmd(const struct sppwk_cmd_attrs *cmd)
 				cmd->spec.comp.wk_action,
 				cmd->spec.comp.name,
 				cmd->spec.comp.core,
-				cmd->spec.comp.wk_type);
+				cmd->spec.comp.wk_type,
+				cmd->spec.comp.snaplen);
 		if (ret == 0) {
 			RTE_LOG(INFO, MIR_CMD_RUNNER, "Exec flush.\n");
 			ret = flush_cmd();
@@ -286,6 +371,41 @@ exec_one_cmd(const struct sppwk_cmd_attrs *cmd)
 		}
 		break;
 
+	case SPPWK_CMDTYPE_RING_LATENCY:
+		RTE_LOG(INFO, MIR_CMD_RUNNER, "with action `%s`.\n",
+				sppwk_action_str(cmd->spec.ring_lat.wk_action));
+		ret = sppwk_set_ring_latency(cmd->spec.ring_lat.port.iface_no,
+				cmd->spec.ring_lat.wk_action ==
+				SPPWK_ACT_START);
+		break;
+
+	case SPPWK_CMDTYPE_FILTER:
+		ret = update_filter(cmd->spec.filter.name,
+				cmd->spec.filter.expr);
+		if (ret == 0) {
+			RTE_LOG(INFO, MIR_CMD_RUNNER, "Exec flush.\n");
+			ret = flush_cmd();
+		}
+		break;
+
+	case SPPWK_CMDTYPE_LIMIT:
+		ret = update_limit(cmd->spec.limit.name,
+				&cmd->spec.limit.mir_limit);
+		if (ret == 0) {
+			RTE_LOG(INFO, MIR_CMD_RUNNER, "Exec flush.\n");
+			ret = flush_cmd();
+		}
+		break;
+
+	case SPPWK_CMDTYPE_COPY_MODE:
+		ret = update_copy_mode(cmd->spec.copy_mode.name,
+				cmd->spec.copy_mode.copy_mode);
+		if (ret == 0) {
+			RTE_LOG(INFO, MIR_CMD_RUNNER, "Exec flush.\n");
+			ret = flush_cmd();
+		}
+		break;
+
 	default:
 		/* Do nothing. */
 		ret = SPPWK_RET_OK;
@@ -312,7 +432,8 @@ iterate_lcore_info(struct sppwk_lcore_params *params)
 		core = get_core_info(lcore_id);
 		if (core->num == 0) {
 			ret = (*params->lcore_proc)(params, lcore_id, "",
-					SPPWK_TYPE_NONE_STR, 0, NULL, 0, NULL);
+					SPPWK_TYPE_NONE_STR, 0, NULL, 0, NULL,
+					NULL);
 			if (unlikely(ret != 0)) {
 				RTE_LOG(ERR, MIR_CMD_RUNNER,
 						"Failed to proc on lcore %d\n",
@@ -385,7 +506,13 @@ update_comp_info(struct sppwk_comp_info *p_comp_info, int *p_change_comp)
 			continue;
 
 		comp_info = (p_comp_info + cnt);
-		sppwk_update_port_dir(comp_info);
+		ret = sppwk_update_port_dir(comp_info);
+		if (unlikely(ret < 0)) {
+			RTE_LOG(ERR, MIR_CMD_RUNNER, "Failed to update port "
+					"attributes. ( component = %s)\n",
+					comp_info->name);
+			return SPPWK_RET_NG;
+		}
 
 		ret = update_mirror(comp_info);
 		RTE_LOG(DEBUG, MIR_CMD_RUNNER, "Update mirror.\n");
@@ -437,6 +564,9 @@ int get_status_ops(struct cmd_res_formatter_ops *ops_list)
 		{ "ring", add_interface },
 		{ "master-lcore", add_master_lcore},
 		{ "core", add_core},
+		{ "ring_latency", add_ring_latency},
+		{ "chain_latency", add_chain_latency},
+		{ "mirror_stats", add_mirror_stats},
 		{ "", NULL }
 	};
 	memcpy(ops_list, tmp_ops_list, sizeof(tmp_ops_list));
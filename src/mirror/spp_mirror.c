@@ -8,21 +8,28 @@
 
 #include <rte_common.h>
 #include <rte_cycles.h>
+#include <rte_ether.h>
+#include <rte_malloc.h>
+#include <rte_memcpy.h>
 
 #include "spp_mirror.h"
 #include "shared/secondary/common.h"
 #include "shared/secondary/add_port.h"
 #include "shared/secondary/return_codes.h"
 #include "shared/secondary/utils.h"
+#include "shared/secondary/json_helper.h"
+#include "shared/secondary/string_buffer.h"
 #include "shared/secondary/spp_worker_th/mirror_deps.h"
 #include "shared/secondary/spp_worker_th/cmd_runner.h"
 #include "shared/secondary/spp_worker_th/cmd_parser.h"
 #include "shared/secondary/spp_worker_th/cmd_utils.h"
 #include "shared/secondary/spp_worker_th/port_capability.h"
+#include "shared/secondary/spp_worker_th/conf_rcu.h"
+#include "shared/secondary/spp_worker_th/pkt_filter.h"
+#include "shared/secondary/spp_worker_th/tx_coalesce.h"
+#include "shared/chain_latency.h"
 
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
 #include "shared/secondary/spp_worker_th/latency_stats.h"
-#endif
 
 /* Declare global variables */
 #define RTE_LOGTYPE_MIRROR RTE_LOGTYPE_USER1
@@ -34,13 +41,27 @@
 #define MIR_RX_DESC_DEFAULT 1024
 #define MIR_TX_DESC_DEFAULT 1024
 
+/* Copy mode if it is not given to component. */
+#ifdef SPP_MIRROR_SHALLOWCOPY
+#define MIR_COPY_MODE_DEFAULT SPPWK_MIR_COPY_SHALLOW
+#else
+#define MIR_COPY_MODE_DEFAULT SPPWK_MIR_COPY_DEEP
+#endif /* SPP_MIRROR_SHALLOWCOPY */
+
+/* Max burst of mirror over the rate, as 1/MIR_LIMIT_BURST_DIV sec. */
+#define MIR_LIMIT_BURST_DIV 100
+
 /* getopt_long return value for long option */
 enum SPP_LONGOPT_RETVAL {
 	SPP_LONGOPT_RETVAL__ = 127,
 
 	/* Return value definition for getopt_long(). Only for long option. */
 	SPP_LONGOPT_RETVAL_CLIENT_ID,    /* For `--client-id` */
-	SPP_LONGOPT_RETVAL_VHOST_CLIENT  /* For `--vhost-client` */
+	SPP_LONGOPT_RETVAL_VHOST_CLIENT,  /* For `--vhost-client` */
+	SPP_LONGOPT_RETVAL_TX_FLUSH_US,  /* For `--tx-flush-us` */
+	SPP_LONGOPT_RETVAL_TX_MIN_BURST,  /* For `--tx-min-burst` */
+	SPP_LONGOPT_RETVAL_VLAN_FCS,  /* For `--vlan-fcs` */
+	SPP_LONGOPT_RETVAL_CHAIN_LATENCY  /* For `--chain-latency` */
 };
 
 /* A set of port info of rx and tx */
@@ -55,15 +76,35 @@ struct mirror_path {
 	volatile enum sppwk_worker_type wk_type;
 	int nof_rx;  /* number of receive ports */
 	int nof_tx;  /* number of mirror ports */
+	int shallow;  /* share a clone among TX ports if 1, or deep copy */
+	uint32_t snaplen;  /* bytes of copied packets, or 0 for all */
+	struct rte_mempool *pool;  /* pool on the socket of lcore of mirror */
+	struct sppwk_pkt_filter *filter;  /* mirror matched only, or NULL */
+	struct sppwk_mir_limit limit;  /* sampling and rate of mirror */
+	uint64_t depth;  /* max tokens of rate limit */
+	uint64_t fill_tsc;  /* TSC cycles for filling tokens to depth */
+	uint64_t tsc_hz;  /* TSC cycles per sec */
 	struct mirror_rxtx ports[RTE_MAX_ETHPORTS];  /* used for mirror */
 };
 
+/* State of sampling and rate limit, and counters of packets not mirrored. */
+struct mirror_limiter {
+	uint32_t sample_cnt;  /* num of packets after the last sampled */
+	uint64_t tokens;  /* packets or bytes allowed to be mirrored */
+	uint64_t last_tsc;  /* TSC of the last refilling tokens */
+	uint64_t sampled_out;  /* packets skipped with sampling */
+	uint64_t rate_limited;  /* packets dropped over the rate */
+	uint64_t copy_failed;  /* packets failed to be copied */
+};
+
 /* Information for mirror. */
 struct mirror_info {
-	volatile int ref_index; /* index to reference area */
-	volatile int upd_index; /* index to update area    */
-	struct mirror_path path[TWO_SIDES];
-				/* Information of data path */
+	/* Information of data path published to mirror, or NULL. */
+	struct mirror_path *path;
+	/* Buffers of TX ports referred only from mirror thread. */
+	struct sppwk_tx_buf tx_bufs[MIR_TX_MAX] __rte_cache_aligned;
+	/* Updated only from mirror thread, and read for status. */
+	struct mirror_limiter limiter __rte_cache_aligned;
 };
 
 static uint16_t nb_rxd = MIR_RX_DESC_DEFAULT;
@@ -90,8 +131,8 @@ static struct cancel_backup_info g_backup_info;
 /* mirror info */
 static struct mirror_info g_mirror_info[RTE_MAX_LCORE];
 
-/* mirror mbuf pool */
-static struct rte_mempool *g_mirror_pool;
+/* mirror mbuf pool of each of NUMA sockets */
+static struct rte_mempool *g_mirror_pools[RTE_MAX_NUMA_NODES];
 
 /* Print help message */
 static void
@@ -100,12 +141,26 @@ usage(const char *progname)
 	RTE_LOG(INFO, MIRROR, "Usage: %s [EAL args] --"
 			" --client-id CLIENT_ID"
 			" -s SERVER_IP:SERVER_PORT"
-			" [--vhost-client]\n"
+			" [--vhost-client]"
+			" [--tx-flush-us USEC]"
+			" [--tx-min-burst NUM]"
+			" [--vlan-fcs]"
+			" [--chain-latency]\n"
 			" --client-id CLIENT_ID   : My client ID\n"
 			" -s SERVER_IP:SERVER_PORT  : "
 				"Access information to the server\n"
 			" --vhost-client            : Run vhost on client\n"
-			, progname);
+			" --tx-flush-us USEC        : "
+				"Max time packets wait in TX buffer "
+				"(Default is %d)\n"
+			" --tx-min-burst NUM        : "
+				"Num of packets sent at once (Default is %d)\n"
+			" --vlan-fcs                : "
+				"Calculate FCS of packets of VLAN tag added or "
+				"deleted\n"
+			" --chain-latency           : "
+				"Measure latency of service chain\n"
+			, progname, DEFAULT_TX_FLUSH_US, DEFAULT_TX_MIN_BURST);
 }
 
 /* Parse options for client app */
@@ -131,6 +186,14 @@ parse_app_args(int argc, char *argv[])
 					SPP_LONGOPT_RETVAL_CLIENT_ID },
 			{ "vhost-client", no_argument, NULL,
 					SPP_LONGOPT_RETVAL_VHOST_CLIENT },
+			{ "tx-flush-us", required_argument, NULL,
+					SPP_LONGOPT_RETVAL_TX_FLUSH_US },
+			{ "tx-min-burst", required_argument, NULL,
+					SPP_LONGOPT_RETVAL_TX_MIN_BURST },
+			{ "vlan-fcs", no_argument, NULL,
+					SPP_LONGOPT_RETVAL_VLAN_FCS },
+			{ "chain-latency", no_argument, NULL,
+					SPP_LONGOPT_RETVAL_CHAIN_LATENCY },
 			{ 0 },
 	};
 
@@ -162,6 +225,25 @@ parse_app_args(int argc, char *argv[])
 		case SPP_LONGOPT_RETVAL_VHOST_CLIENT:
 			set_vhost_cli_mode(1);
 			break;
+		case SPP_LONGOPT_RETVAL_TX_FLUSH_US:
+			if (sppwk_parse_tx_flush_us(optarg) != SPPWK_RET_OK) {
+				usage(progname);
+				return SPPWK_RET_NG;
+			}
+			break;
+		case SPP_LONGOPT_RETVAL_TX_MIN_BURST:
+			if (sppwk_parse_tx_min_burst(optarg) != SPPWK_RET_OK) {
+				usage(progname);
+				return SPPWK_RET_NG;
+			}
+			break;
+		case SPP_LONGOPT_RETVAL_VLAN_FCS:
+			sppwk_set_vlan_fcs(1);
+			break;
+		case SPP_LONGOPT_RETVAL_CHAIN_LATENCY:
+			if (chain_lat_init() != 0)
+				return SPPWK_RET_NG;
+			break;
 		case 's':
 			ret = parse_server(&ctl_ip, &ctl_port, optarg);
 			if (ret != SPPWK_RET_OK) {
@@ -185,43 +267,52 @@ parse_app_args(int argc, char *argv[])
 	}
 	RTE_LOG(INFO, MIRROR,
 			"Parsed app args (client_id=%d, server=%s:%d, "
-			"vhost_client=%d)\n",
-			cli_id, ctl_ip, ctl_port, get_vhost_cli_mode());
+			"vhost_client=%d, tx_flush_us=%u, tx_min_burst=%hu, "
+			"vlan_fcs=%d, chain_latency=%d)\n",
+			cli_id, ctl_ip, ctl_port, get_vhost_cli_mode(),
+			sppwk_get_tx_flush_us(), sppwk_get_tx_min_burst(),
+			sppwk_get_vlan_fcs(), chain_lat_enabled());
 	return SPPWK_RET_OK;
 }
 
-/* mirror mbuf pool create */
+/**
+ * Create mbuf pool for each of sockets of lcores, so that mirror allocates
+ * copied packets from local memory. Packets are copied into a segment of
+ * default size even in shallow copy mode if snaplen is given.
+ */
 static int
 mirror_pool_create(int id)
 {
 	unsigned int nb_mbufs;
+	unsigned int lcore_id, socket_id;
+	unsigned int nof_lcores[RTE_MAX_NUMA_NODES] = { 0 };
 	char pool_name[SPP_MIRROR_POOL_NAME_MAX];
 
-	nb_mbufs = RTE_MAX(
-	    (uint16_t)(nb_rxd + nb_txd + MAX_PKT_BURST + MEMPOOL_CACHE_SIZE),
-									8192U);
-	sprintf(pool_name, "%s_%d", SPP_MIRROR_POOL_NAME, id);
-	g_mirror_pool = rte_mempool_lookup(pool_name);
-	if (g_mirror_pool == NULL) {
-#ifdef SPP_MIRROR_SHALLOWCOPY
-		g_mirror_pool = rte_pktmbuf_pool_create(pool_name,
-						nb_mbufs,
-						MEMPOOL_CACHE_SIZE,
-						0,
-						RTE_PKTMBUF_HEADROOM,
-						rte_socket_id());
-#else
-		g_mirror_pool = rte_pktmbuf_pool_create(pool_name,
-						nb_mbufs,
-						MEMPOOL_CACHE_SIZE,
-						0,
-						RTE_MBUF_DEFAULT_BUF_SIZE,
-						rte_socket_id());
-#endif /* SPP_MIRROR_SHALLOWCOPY */
-	}
-	if (g_mirror_pool == NULL) {
-		RTE_LOG(ERR, MIRROR, "Cannot init mbuf pool\n");
-		return SPPWK_RET_NG;
+	RTE_BUILD_BUG_ON(SPPWK_MIR_SNAPLEN_MAX > RTE_MBUF_DEFAULT_DATAROOM);
+
+	RTE_LCORE_FOREACH(lcore_id)
+		nof_lcores[rte_lcore_to_socket_id(lcore_id)]++;
+
+	for (socket_id = 0; socket_id < RTE_MAX_NUMA_NODES; socket_id++) {
+		if (nof_lcores[socket_id] == 0)
+			continue;
+
+		nb_mbufs = RTE_MAX(nb_rxd + nb_txd + MAX_PKT_BURST +
+				MEMPOOL_CACHE_SIZE * nof_lcores[socket_id],
+				8192U);
+		snprintf(pool_name, sizeof(pool_name), "%s_%d_%u",
+				SPP_MIRROR_POOL_NAME, id, socket_id);
+		g_mirror_pools[socket_id] = rte_mempool_lookup(pool_name);
+		if (g_mirror_pools[socket_id] == NULL)
+			g_mirror_pools[socket_id] = rte_pktmbuf_pool_create(
+					pool_name, nb_mbufs,
+					MEMPOOL_CACHE_SIZE, 0,
+					RTE_MBUF_DEFAULT_BUF_SIZE, socket_id);
+		if (g_mirror_pools[socket_id] == NULL) {
+			RTE_LOG(ERR, MIRROR, "Cannot init mbuf pool "
+					"(socket=%u)\n", socket_id);
+			return SPPWK_RET_NG;
+		}
 	}
 
 	return SPPWK_RET_OK;
@@ -231,14 +322,26 @@ mirror_pool_create(int id)
 static void
 mirror_proc_init(void)
 {
-	int cnt = 0;
+	int cnt, i;
+
 	memset(&g_mirror_info, 0x00, sizeof(g_mirror_info));
 	for (cnt = 0; cnt < RTE_MAX_LCORE; cnt++) {
-		g_mirror_info[cnt].ref_index = 0;
-		g_mirror_info[cnt].upd_index = 1;
+		for (i = 0; i < MIR_TX_MAX; i++)
+			sppwk_tx_buf_init(&g_mirror_info[cnt].tx_bufs[i], -1,
+					0, UNDEF, 0, 0);
 	}
 }
 
+/* Release path replaced with new one. */
+static void
+free_mirror_path(void *conf, void *arg __attribute__ ((unused)))
+{
+	struct mirror_path *path = conf;
+
+	sppwk_pkt_filter_free(path->filter);
+	rte_free(path);
+}
+
 /* Update mirror info */
 int
 update_mirror(struct sppwk_comp_info *wk_comp)
@@ -247,23 +350,29 @@ update_mirror(struct sppwk_comp_info *wk_comp)
 	int nof_rx = wk_comp->nof_rx;
 	int nof_tx = wk_comp->nof_tx;
 	struct mirror_info *info = &g_mirror_info[wk_comp->comp_id];
-	struct mirror_path *path = &info->path[info->upd_index];
+	struct mirror_path *path = NULL;
+	struct mirror_path *old_path = NULL;
 
-	/* Check mirror has just one RX and two TX port. */
+	/* Check mirror has just one RX and up to MIR_TX_MAX TX ports. */
 	if (unlikely(nof_rx > 1)) {
 		RTE_LOG(ERR, MIRROR,
 			"Invalid num of RX (id=%d, type=%d, nof_rx=%d)\n",
 			wk_comp->comp_id, wk_comp->wk_type, nof_rx);
 		return SPPWK_RET_NG;
 	}
-	if (unlikely(nof_tx > 2)) {
+	if (unlikely(nof_tx > MIR_TX_MAX)) {
 		RTE_LOG(ERR, MIRROR,
 			"Invalid num of TX (id=%d, type=%d, nof_tx=%d)\n",
 			wk_comp->comp_id, wk_comp->wk_type, nof_tx);
 		return SPPWK_RET_NG;
 	}
 
-	memset(path, 0x00, sizeof(struct mirror_path));
+	path = rte_zmalloc(NULL, sizeof(struct mirror_path), 0);
+	if (unlikely(path == NULL)) {
+		RTE_LOG(ERR, MIRROR, "Cannot allocate path of mirror (id=%d)\n",
+				wk_comp->comp_id);
+		return SPPWK_RET_NG;
+	}
 
 	RTE_LOG(INFO, MIRROR,
 			"Start updating mirror (id=%d, name=%s, type=%d)\n",
@@ -273,6 +382,51 @@ update_mirror(struct sppwk_comp_info *wk_comp)
 	path->wk_type = wk_comp->wk_type;
 	path->nof_rx = wk_comp->nof_rx;
 	path->nof_tx = wk_comp->nof_tx;
+	path->snaplen = wk_comp->snaplen;
+	if (wk_comp->copy_mode == SPPWK_MIR_COPY_DEFAULT)
+		path->shallow = MIR_COPY_MODE_DEFAULT == SPPWK_MIR_COPY_SHALLOW;
+	else
+		path->shallow = wk_comp->copy_mode == SPPWK_MIR_COPY_SHALLOW;
+	/**
+	 * Original packets are also shared with clones, so shallow copy is
+	 * not used if any of TX ports is not sharable. It is an error only if
+	 * shallow copy is given explicitly.
+	 */
+	for (cnt = 0; path->shallow && cnt < nof_tx; cnt++) {
+		if (sppwk_is_pkt_sharable_port(wk_comp->tx_ports[cnt]))
+			continue;
+		if (wk_comp->copy_mode == SPPWK_MIR_COPY_SHALLOW) {
+			RTE_LOG(ERR, MIRROR, "Cannot share packets with TX "
+				"port of VLAN ops or fast free (id=%d)\n",
+				wk_comp->comp_id);
+			rte_free(path);
+			return SPPWK_RET_NG;
+		}
+		RTE_LOG(INFO, MIRROR, "Deep copy is used for TX port of VLAN "
+				"ops or fast free (id=%d)\n", wk_comp->comp_id);
+		path->shallow = 0;
+	}
+	path->pool = g_mirror_pools[rte_lcore_to_socket_id(wk_comp->lcore_id)];
+	path->limit = wk_comp->mir_limit;
+	path->tsc_hz = rte_get_tsc_hz();
+	if (path->limit.rate != 0) {
+		/* Depth is at least for a packet even if rate is too low. */
+		path->depth = RTE_MAX(path->limit.rate / MIR_LIMIT_BURST_DIV,
+				path->limit.is_bytes ?
+				(uint64_t)RTE_ETHER_MAX_JUMBO_FRAME_LEN : 1);
+		path->fill_tsc = path->depth * path->tsc_hz /
+				path->limit.rate;
+	}
+	if (wk_comp->filter[0] != '\0') {
+		path->filter = sppwk_pkt_filter_create(wk_comp->filter);
+		if (unlikely(path->filter == NULL)) {
+			RTE_LOG(ERR, MIRROR,
+				"Cannot create filter (id=%d, name=%s)\n",
+				wk_comp->comp_id, wk_comp->name);
+			rte_free(path);
+			return SPPWK_RET_NG;
+		}
+	}
 	for (cnt = 0; cnt < nof_rx; cnt++)
 		memcpy(&path->ports[cnt].rx, wk_comp->rx_ports[cnt],
 				sizeof(struct sppwk_port_info));
@@ -282,9 +436,10 @@ update_mirror(struct sppwk_comp_info *wk_comp)
 		memcpy(&path->ports[cnt].tx, wk_comp->tx_ports[cnt],
 				sizeof(struct sppwk_port_info));
 
-	info->upd_index = info->ref_index;
-	while (likely(info->ref_index == info->upd_index))
-		rte_delay_us_block(SPPWK_UPDATE_INTERVAL);
+	/* Old path is released after mirror stops to refer it. */
+	old_path = SPPWK_CONF_SET(info->path, path);
+	if (old_path != NULL)
+		sppwk_conf_rcu_defer_free(old_path, free_mirror_path, NULL);
 
 	RTE_LOG(INFO, MIRROR,
 			"Done update mirror (id=%d, name=%s, type=%d)\n",
@@ -293,15 +448,260 @@ update_mirror(struct sppwk_comp_info *wk_comp)
 	return SPPWK_RET_OK;
 }
 
-/* Change index of mirror info */
+/* Copy attributes of original packet other than data. */
 static inline void
-change_mirror_index(int id)
+copy_pkt_meta(struct rte_mbuf *copy, const struct rte_mbuf *org)
 {
-	struct mirror_info *info = &g_mirror_info[id];
-	if (info->ref_index == info->upd_index) {
-	/* Change reference index of port ability. */
-		sppwk_swap_two_sides(SPPWK_SWAP_REF, 0, 0);
-		info->ref_index = (info->upd_index+1) % TWO_SIDES;
+	copy->port = org->port;
+	copy->vlan_tci = org->vlan_tci;
+	copy->tx_offload = org->tx_offload;
+	copy->hash = org->hash;
+	copy->ol_flags = org->ol_flags;
+	copy->packet_type = org->packet_type;
+}
+
+/* Copy `len` bytes from `off` of packet into a segment. */
+static inline void
+copy_pkt_data(struct rte_mbuf *seg, const struct rte_mbuf *org, uint32_t off,
+		uint32_t len)
+{
+	char *dst = rte_pktmbuf_mtod(seg, char *);
+	const void *src;
+
+	/* Data over segments is gathered into `dst` while reading. */
+	src = rte_pktmbuf_read(org, off, len, dst);
+	if (src != dst)
+		rte_memcpy(dst, src, len);
+	seg->data_len = len;
+}
+
+/**
+ * Copy whole of packet larger than a segment into `copy` and segments
+ * allocated additionally. Allocated segments are chained to `copy` even if
+ * it is failed.
+ */
+static int
+copy_pkt_segs(struct rte_mbuf *copy, const struct rte_mbuf *org,
+		struct rte_mempool *pool)
+{
+	uint32_t off = 0;
+	uint32_t len;
+	struct rte_mbuf *seg = copy;
+
+	copy_pkt_meta(copy, org);
+	copy->pkt_len = org->pkt_len;
+	copy->nb_segs = 1;
+	while (1) {
+		len = RTE_MIN(org->pkt_len - off,
+				(uint32_t)rte_pktmbuf_tailroom(seg));
+		copy_pkt_data(seg, org, off, len);
+		off += len;
+		if (off >= org->pkt_len)
+			break;
+
+		seg->next = rte_pktmbuf_alloc(pool);
+		if (unlikely(seg->next == NULL))
+			return SPPWK_RET_NG;
+		seg = seg->next;
+		copy->nb_segs++;
+	}
+	return SPPWK_RET_OK;
+}
+
+/**
+ * Refill tokens of rate limit for the time elapsed from the last. Remainder of
+ * the time less than a token is carried over so that low rate is kept.
+ */
+static inline void
+refill_tokens(struct mirror_limiter *lim, const struct mirror_path *path,
+		uint64_t cur_tsc)
+{
+	uint64_t elapsed = cur_tsc - lim->last_tsc;
+	uint64_t acc, tokens;
+
+	if (elapsed >= path->fill_tsc) {
+		lim->tokens = path->depth;
+		lim->last_tsc = cur_tsc;
+		return;
+	}
+
+	/* No overflow because it is less than `depth * tsc_hz`. */
+	acc = elapsed * path->limit.rate;
+	tokens = acc / path->tsc_hz;
+	if (tokens == 0)
+		return;
+
+	lim->tokens = RTE_MIN(lim->tokens + tokens, path->depth);
+	lim->last_tsc = cur_tsc - (acc % path->tsc_hz) / path->limit.rate;
+}
+
+/**
+ * Pick up packets to be mirrored with 1-in-N sampling and rate limit. Packets
+ * not picked are just counted before copied not to spend mbufs. `picked` can
+ * be the same as `pkts` because picked ones are packed from the head.
+ */
+static uint16_t
+limit_pkts(struct mirror_limiter *lim, const struct mirror_path *path,
+		struct rte_mbuf **pkts, struct rte_mbuf **picked,
+		uint16_t nb_pkts, uint64_t cur_tsc)
+{
+	uint16_t cnt;
+	uint16_t nb_picked = 0;
+	uint64_t cost;
+
+	if (path->limit.rate != 0)
+		refill_tokens(lim, path, cur_tsc);
+
+	for (cnt = 0; cnt < nb_pkts; cnt++) {
+		if (path->limit.sample > 1) {
+			if (++lim->sample_cnt < path->limit.sample) {
+				lim->sampled_out++;
+				continue;
+			}
+			lim->sample_cnt = 0;
+		}
+
+		if (path->limit.rate != 0) {
+			cost = 1;
+			if (path->limit.is_bytes) {
+				cost = pkts[cnt]->pkt_len;
+				if (path->snaplen != 0 && path->snaplen < cost)
+					cost = path->snaplen;
+			}
+			if (lim->tokens < cost) {
+				lim->rate_limited++;
+				continue;
+			}
+			lim->tokens -= cost;
+		}
+		picked[nb_picked++] = pkts[cnt];
+	}
+	return nb_picked;
+}
+
+/**
+ * Copy packets to be mirrored. Only leading `snaplen` bytes are copied into
+ * a segment if it is given. Packets failed to be copied are set to NULL.
+ */
+static void
+copy_pkts(const struct mirror_path *path, struct rte_mbuf **pkts,
+		struct rte_mbuf **copies, uint16_t nb_pkts)
+{
+	uint16_t cnt;
+	uint32_t len;
+
+	/* No packets can be left after filtering. */
+	if (nb_pkts == 0)
+		return;
+
+	if (path->shallow && path->snaplen == 0) {
+		for (cnt = 0; cnt < nb_pkts; cnt++)
+			copies[cnt] = rte_pktmbuf_clone(pkts[cnt], path->pool);
+		return;
+	}
+
+	/* None of packets in the burst is mirrored if pool is exhausted. */
+	if (unlikely(rte_pktmbuf_alloc_bulk(path->pool, copies,
+			nb_pkts) != 0)) {
+		memset(copies, 0, sizeof(struct rte_mbuf *) * nb_pkts);
+		return;
+	}
+
+	rte_prefetch0(rte_pktmbuf_mtod(pkts[0], void *));
+	for (cnt = 0; cnt < nb_pkts; cnt++) {
+		if (likely(cnt + 1 < nb_pkts))
+			rte_prefetch0(rte_pktmbuf_mtod(pkts[cnt + 1], void *));
+
+		len = pkts[cnt]->pkt_len;
+		if (path->snaplen != 0 && path->snaplen < len)
+			len = path->snaplen;
+
+		if (likely(len <= rte_pktmbuf_tailroom(copies[cnt]))) {
+			copy_pkt_meta(copies[cnt], pkts[cnt]);
+			copy_pkt_data(copies[cnt], pkts[cnt], 0, len);
+			copies[cnt]->pkt_len = len;
+		} else if (unlikely(copy_pkt_segs(copies[cnt], pkts[cnt],
+				path->pool) != SPPWK_RET_OK)) {
+			rte_pktmbuf_free(copies[cnt]);
+			copies[cnt] = NULL;
+		}
+	}
+}
+
+/* Add `v` to refcnt of all of segments of a packet to be shared. */
+static inline void
+share_pkt(struct rte_mbuf *pkt, int16_t v)
+{
+	for (; pkt != NULL; pkt = pkt->next)
+		rte_mbuf_refcnt_update(pkt, v);
+}
+
+/**
+ * Send copies of packets to each of mirror TX ports from the second one. In
+ * shallow copy mode, packets are copied once and shared among the ports with
+ * refcnt because no consumer modifies them, and no port is of VLAN ops or
+ * fast free. In deep copy mode, each of ports has its own copies for
+ * consumers modifying packets.
+ */
+static void
+fan_out_pkts(struct mirror_info *info, const struct mirror_path *path,
+		struct rte_mbuf **pkts, uint16_t nb_pkts, uint64_t cur_tsc)
+{
+	int port;
+	uint16_t cnt;
+	uint16_t nb_copies = 0;
+	struct rte_mbuf *copies[MAX_PKT_BURST];
+
+	for (port = 1; port < path->nof_tx; port++) {
+		if (port == 1 || !path->shallow) {
+			copy_pkts(path, pkts, copies, nb_pkts);
+
+			/* Packets failed to be copied are not mirrored. */
+			nb_copies = 0;
+			for (cnt = 0; cnt < nb_pkts; cnt++) {
+				if (likely(copies[cnt] != NULL))
+					copies[nb_copies++] = copies[cnt];
+				else
+					info->limiter.copy_failed++;
+			}
+
+			if (path->shallow && path->nof_tx > 2) {
+				for (cnt = 0; cnt < nb_copies; cnt++)
+					share_pkt(copies[cnt],
+							path->nof_tx - 2);
+			}
+		}
+
+		if (nb_copies != 0)
+			sppwk_tx_buf_push_bulk(&info->tx_bufs[port], copies,
+					nb_copies, cur_tsc);
+	}
+}
+
+/* Transmit all packets in TX buffers of mirror. */
+static void
+flush_mirror(int id)
+{
+	int cnt;
+
+	for (cnt = 0; cnt < MIR_TX_MAX; cnt++)
+		sppwk_tx_buf_flush(&g_mirror_info[id].tx_bufs[cnt]);
+}
+
+/* Flush mirrors removed from lcore before referring to new info. */
+static void
+flush_removed_mirrors(const struct core_info *cur,
+		const struct core_info *next)
+{
+	int i, j;
+
+	for (i = 0; i < cur->num; i++) {
+		for (j = 0; j < next->num; j++) {
+			if (cur->id[i] == next->id[j])
+				break;
+		}
+		if (j == next->num)
+			flush_mirror(cur->id[i]);
 	}
 }
 
@@ -314,129 +714,74 @@ change_mirror_index(int id)
 static int
 mirror_proc(int id)
 {
-	int cnt, buf;
+	int cnt;
 	int nb_rx = 0;
-	int nb_tx = 0;
-	int nb_tx1 = 0;
-	int nb_tx2 = 0;
+	int nb_mir;
+	uint64_t cur_tsc;
 	struct mirror_info *info = &g_mirror_info[id];
 	struct mirror_path *path = NULL;
 	struct sppwk_port_info *rx = NULL;
 	struct sppwk_port_info *tx = NULL;
+	struct sppwk_tx_buf *tx_buf = NULL;
 	struct rte_mbuf *bufs[MAX_PKT_BURST];
-	struct rte_mbuf *copybufs[MAX_PKT_BURST];
-	struct rte_mbuf *org_mbuf = NULL;
-
-	change_mirror_index(id);
-	path = &info->path[info->ref_index];
+	struct rte_mbuf *mirbufs[MAX_PKT_BURST];
+	struct rte_mbuf **mir_pkts;
 
-	/* Practice condition check */
-	if (!(path->nof_tx == 2 && path->nof_rx == 1))
+	path = SPPWK_CONF_GET(info->path);
+	if (unlikely(path == NULL)) {
+		/* Not to keep packets of ports of stopped mirror. */
+		flush_mirror(id);
 		return SPPWK_RET_OK;
+	}
 
-	rx = &path->ports[0].rx;
+	/* Transmit packets to previous TX ports before changing to new ones. */
+	for (cnt = 0; cnt < MIR_TX_MAX; cnt++) {
+		tx = &path->ports[cnt].tx;
+		tx_buf = &info->tx_bufs[cnt];
+		if (likely(tx_buf->ethdev_port_id == tx->ethdev_port_id &&
+				tx_buf->queue_no == tx->queue_no))
+			continue;
+		sppwk_tx_buf_flush(tx_buf);
+		sppwk_tx_buf_init(tx_buf, tx->ethdev_port_id, tx->queue_no,
+				tx->iface_type, tx->iface_no, 0);
+	}
 
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
-	nb_rx = sppwk_eth_ring_stats_rx_burst(rx->ethdev_port_id,
-			rx->iface_type, rx->iface_no, 0, bufs, MAX_PKT_BURST);
-#else
-	nb_rx = rte_eth_rx_burst(rx->ethdev_port_id, rx->queue_no, bufs,
-			MAX_PKT_BURST);
-#endif
+	cur_tsc = rte_rdtsc();
 
-	if (unlikely(nb_rx == 0))
-		return SPPWK_RET_OK;
+	/* Practice condition check */
+	if (path->nof_tx >= 2 && path->nof_rx == 1) {
+		rx = &path->ports[0].rx;
 
-	/* mirror */
-	tx = &path->ports[1].tx;
-	if (tx->ethdev_port_id >= 0) {
-		nb_tx2 = 0;
-		for (cnt = 0; cnt < nb_rx; cnt++) {
-			org_mbuf = bufs[cnt];
-			rte_prefetch0(rte_pktmbuf_mtod(org_mbuf, void *));
-#ifdef SPP_MIRROR_SHALLOWCOPY
-			/* Shallow Copy */
-			copybufs[cnt] = rte_pktmbuf_clone(org_mbuf,
-							g_mirror_pool);
-#else
-			struct rte_mbuf *mirror_mbuf = NULL;
-			struct rte_mbuf **mirror_mbufs = &mirror_mbuf;
-			struct rte_mbuf *copy_mbuf = NULL;
-			/* Deep Copy */
-			do {
-				copy_mbuf = rte_pktmbuf_alloc(g_mirror_pool);
-				if (unlikely(copy_mbuf == NULL)) {
-					rte_pktmbuf_free(mirror_mbuf);
-					mirror_mbuf = NULL;
-					RTE_LOG(INFO, MIRROR,
-						"copy mbuf alloc NG!\n");
-					break;
-				}
-
-				copy_mbuf->data_off = org_mbuf->data_off;
-				copy_mbuf->data_len = org_mbuf->data_len;
-				copy_mbuf->port = org_mbuf->port;
-				copy_mbuf->vlan_tci = org_mbuf->vlan_tci;
-				copy_mbuf->tx_offload = org_mbuf->tx_offload;
-				copy_mbuf->hash = org_mbuf->hash;
-
-				copy_mbuf->next = NULL;
-				copy_mbuf->pkt_len = org_mbuf->pkt_len;
-				copy_mbuf->nb_segs = org_mbuf->nb_segs;
-				copy_mbuf->ol_flags = org_mbuf->ol_flags;
-				copy_mbuf->packet_type = org_mbuf->packet_type;
-
-				rte_memcpy(rte_pktmbuf_mtod(copy_mbuf, char *),
-					rte_pktmbuf_mtod(org_mbuf, char *),
-					org_mbuf->data_len);
-
-				*mirror_mbufs = copy_mbuf;
-				mirror_mbufs = &copy_mbuf->next;
-			} while ((org_mbuf = org_mbuf->next) != NULL);
-			copybufs[cnt] = mirror_mbuf;
+		nb_rx = sppwk_eth_rx_burst(rx->ethdev_port_id, rx->queue_no,
+				bufs, MAX_PKT_BURST);
+	}
 
-#endif /* SPP_MIRROR_SHALLOWCOPY */
+	/* mirror */
+	if (nb_rx != 0 && path->nof_tx >= 2) {
+		/* Filter before copying not to spend mbufs for unmatched. */
+		mir_pkts = bufs;
+		nb_mir = nb_rx;
+		if (path->filter != NULL) {
+			nb_mir = sppwk_pkt_filter_burst(path->filter, bufs,
+					mirbufs, nb_rx);
+			mir_pkts = mirbufs;
 		}
-
-		if (cnt != 0)
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
-			nb_tx2 = sppwk_eth_ring_stats_tx_burst(
-					tx->ethdev_port_id, tx->iface_type,
-					tx->iface_no, 0, copybufs, cnt);
-#else
-			nb_tx2 = rte_eth_tx_burst(tx->ethdev_port_id,
-					tx->queue_no, copybufs, cnt);
-#endif
+		if (path->limit.sample > 1 || path->limit.rate != 0) {
+			nb_mir = limit_pkts(&info->limiter, path, mir_pkts,
+					mirbufs, nb_mir, cur_tsc);
+			mir_pkts = mirbufs;
+		}
+		fan_out_pkts(info, path, mir_pkts, nb_mir, cur_tsc);
 	}
 
 	/* orginal */
-	tx = &path->ports[0].tx;
-	if (tx->ethdev_port_id >= 0)
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
-		nb_tx1 = sppwk_eth_ring_stats_tx_burst(tx->ethdev_port_id,
-				tx->iface_type, tx->iface_no, 0, bufs, nb_rx);
-#else
-		nb_tx1 = rte_eth_tx_burst(tx->ethdev_port_id, tx->queue_no,
-				bufs, nb_rx);
-#endif
-	nb_tx = nb_tx1;
+	if (nb_rx != 0)
+		sppwk_tx_buf_push_bulk(&info->tx_bufs[0], bufs, nb_rx,
+				cur_tsc);
 
-	if (nb_tx1 != nb_tx2)
-		RTE_LOG(INFO, MIRROR,
-			"mirror paket drop nb_rx=%d nb_tx1=%d nb_tx2=%d\n",
-							nb_rx, nb_tx1, nb_tx2);
-
-	/* Discard remained packets to release mbuf */
-	if (nb_tx1 < nb_tx2)
-		nb_tx = nb_tx2;
-	if (unlikely(nb_tx < nb_rx)) {
-		for (buf = nb_tx; buf < nb_rx; buf++)
-			rte_pktmbuf_free(bufs[buf]);
-	}
-	if (unlikely(nb_tx2 < nb_rx)) {
-		for (buf = nb_tx2; buf < nb_rx; buf++)
-			rte_pktmbuf_free(copybufs[buf]);
-	}
+	/* Send packets waiting longer than flush latency budget. */
+	for (cnt = 0; cnt < MIR_TX_MAX; cnt++)
+		sppwk_tx_buf_drain(&info->tx_bufs[cnt], cur_tsc);
 	return SPPWK_RET_OK;
 }
 
@@ -446,22 +791,29 @@ slave_main(void *arg __attribute__ ((unused)))
 {
 	int ret = SPPWK_RET_OK;
 	int cnt = 0;
+	int next_index;
 	unsigned int lcore_id = rte_lcore_id();
 	enum sppwk_lcore_status status = SPPWK_LCORE_STOPPED;
 	struct core_mng_info *info = &g_core_info[lcore_id];
 	struct core_info *core = get_core_info(lcore_id);
 
 	RTE_LOG(INFO, MIRROR, "Slave started on lcore %d.\n", lcore_id);
+	sppwk_conf_rcu_online(lcore_id);
 	set_core_status(lcore_id, SPPWK_LCORE_IDLING);
 
 	while ((status = sppwk_get_lcore_status(lcore_id)) !=
 			SPPWK_LCORE_REQ_STOP) {
+		/* No config is referred from here to the end of loop. */
+		sppwk_conf_rcu_quiescent(lcore_id);
+
 		if (status != SPPWK_LCORE_RUNNING)
 			continue;
 
 		if (sppwk_is_lcore_updated(lcore_id) == 1) {
 			/* Setting with the flush command trigger. */
-			info->ref_index = (info->upd_index+1) % TWO_SIDES;
+			next_index = (info->upd_index+1) % TWO_SIDES;
+			flush_removed_mirrors(core, &info->core[next_index]);
+			info->ref_index = next_index;
 			core = get_core_info(lcore_id);
 		}
 
@@ -482,6 +834,11 @@ slave_main(void *arg __attribute__ ((unused)))
 		}
 	}
 
+	/* Not to leave packets in TX buffers of exiting thread. */
+	for (cnt = 0; cnt < core->num; cnt++)
+		flush_mirror(core->id[cnt]);
+
+	sppwk_conf_rcu_offline(lcore_id);
 	set_core_status(lcore_id, SPPWK_LCORE_STOPPED);
 	RTE_LOG(INFO, MIRROR, "Terminated slave on lcore %d.\n", lcore_id);
 	return ret;
@@ -560,6 +917,9 @@ main(int argc, char *argv[])
 		if (unlikely(ret_mng != 0))
 			break;
 
+		if (unlikely(sppwk_conf_rcu_init() != SPPWK_RET_OK))
+			break;
+
 		mirror_proc_init();
 		sppwk_port_capability_init();
 
@@ -570,24 +930,12 @@ main(int argc, char *argv[])
 		if (unlikely(ret_cmd_init != SPPWK_RET_OK))
 			break;
 
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
-		int port_type, port_id;
-		char dev_name[RTE_DEV_NAME_MAX_LEN] = { 0 };
-		int nof_rings = 0;
-		for (int i = 0; i < RTE_MAX_ETHPORTS; i++) {
-			if (!rte_eth_dev_is_valid_port(i))
-				continue;
-			rte_eth_dev_get_name_by_port(i, dev_name);
-			ret = parse_dev_name(dev_name, &port_type, &port_id);
-			if (port_type == RING)
-				nof_rings++;
-		}
+		/* Rings can be added after launched, so all of IDs are kept. */
 		int ret_ringlatency = sppwk_init_ring_latency_stats(
 				SPP_RING_LATENCY_STATS_SAMPLING_INTERVAL,
-				nof_rings);
+				RTE_MAX_ETHPORTS);
 		if (unlikely(ret_ringlatency != SPPWK_RET_OK))
 			break;
-#endif /* SPP_RINGLATENCYSTATS_ENABLE */
 
 		/* Start worker threads of classifier and forwarder */
 		lcore_id = 0;
@@ -603,13 +951,10 @@ main(int argc, char *argv[])
 
 		/* Start forwarding */
 		set_all_core_status(SPPWK_LCORE_RUNNING);
-#ifdef SPP_MIRROR_SHALLOWCOPY
 		RTE_LOG(INFO, MIRROR,
-			"My ID %d start handling messagei(ShallowCopy)\n", 0);
-#else
-		RTE_LOG(INFO, MIRROR,
-			"My ID %d start handling message(DeepCopy)\n", 0);
-#endif /* #ifdef SPP_MIRROR_SHALLOWCOPY */
+			"My ID %d start handling message (default %s copy)\n",
+			0, MIR_COPY_MODE_DEFAULT == SPPWK_MIR_COPY_SHALLOW ?
+			"shallow" : "deep");
 		RTE_LOG(INFO, MIRROR, "[Press Ctrl-C to quit ...]\n");
 
 		/* Backup the management information after initialization */
@@ -624,15 +969,14 @@ main(int argc, char *argv[])
 			ret_do = sppwk_run_cmd();
 			if (unlikely(ret_do != SPPWK_RET_OK))
 				break;
+
+			/* Release configs not referred from workers. */
+			sppwk_conf_rcu_reclaim();
 			/*
 			 * To avoid making CPU busy, this thread waits
 			 * here for 100 ms.
 			 */
 			usleep(100);
-
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
-			print_ring_latency_stats(&g_iface_info);
-#endif /* SPP_RINGLATENCYSTATS_ENABLE */
 		}
 
 		if (unlikely(ret_do != SPPWK_RET_OK)) {
@@ -653,9 +997,7 @@ main(int argc, char *argv[])
 	 /* Remove vhost sock file if not running in vhost-client mode. */
 	del_vhost_sockfile(g_iface_info.vhost);
 
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
 	sppwk_clean_ring_latency_stats();
-#endif /* SPP_RINGLATENCYSTATS_ENABLE */
 
 	RTE_LOG(INFO, MIRROR, "Exit spp_mirror.\n");
 	return ret;
@@ -669,15 +1011,15 @@ get_mirror_status(unsigned int lcore_id, int id,
 	int ret = SPPWK_RET_NG;
 	int cnt;
 	const char *component_type = NULL;
-	struct mirror_info *info = &g_mirror_info[id];
-	struct mirror_path *path = &info->path[info->ref_index];
+	struct mirror_path *path = g_mirror_info[id].path;
 	struct sppwk_port_idx rx_ports[RTE_MAX_ETHPORTS];
 	struct sppwk_port_idx tx_ports[RTE_MAX_ETHPORTS];
+	struct sppwk_tx_coal_stats tx_stats;
 
-	if (unlikely(path->wk_type == SPPWK_TYPE_NONE)) {
+	if (unlikely(path == NULL || path->wk_type == SPPWK_TYPE_NONE)) {
 		RTE_LOG(ERR, MIRROR,
-			"Mirror is not used. (id=%d, lcore=%d, type=%d)\n",
-			id, lcore_id, path->wk_type);
+			"Mirror is not used. (id=%d, lcore=%d)\n",
+			id, lcore_id);
 		return SPPWK_RET_NG;
 	}
 
@@ -697,12 +1039,102 @@ get_mirror_status(unsigned int lcore_id, int id,
 		tx_ports[cnt].queue_no   = path->ports[cnt].tx.queue_no;
 	}
 
+	memset(&tx_stats, 0x00, sizeof(tx_stats));
+	for (cnt = 0; cnt < MIR_TX_MAX; cnt++)
+		sppwk_tx_buf_add_stats(&tx_stats,
+				&g_mirror_info[id].tx_bufs[cnt]);
+
 	/* Set the information with the function specified by the command. */
 	ret = (*params->lcore_proc)(params, lcore_id, path->name,
 			component_type, path->nof_rx, rx_ports, path->nof_tx,
-			tx_ports);
+			tx_ports, &tx_stats);
 	if (unlikely(ret != 0))
 		return SPPWK_RET_NG;
 
 	return SPPWK_RET_OK;
 }
+
+/* Append counters of packets not mirrored of a component. */
+static int
+append_mirror_stats_block(char **output, const struct sppwk_comp_info *comp,
+		const struct mirror_limiter *lim)
+{
+	int ret = SPPWK_RET_NG;
+	int shallow;
+	const struct mirror_path *path = g_mirror_info[comp->comp_id].path;
+	char *tmp_buff = spp_strbuf_allocate(CMD_RES_BUF_INIT_SIZE);
+	if (unlikely(tmp_buff == NULL)) {
+		RTE_LOG(ERR, MIRROR,
+				"Failed to allocate buffer of mirror stats. "
+				"(name = %s)\n", comp->name);
+		return SPPWK_RET_NG;
+	}
+
+	ret = append_json_str_value(&tmp_buff, "name", comp->name);
+	if (likely(ret == SPPWK_RET_OK))
+		ret = append_json_uint_value(&tmp_buff, "sample",
+				comp->mir_limit.sample);
+	if (likely(ret == SPPWK_RET_OK))
+		ret = append_json_uint64_value(&tmp_buff, "rate",
+				comp->mir_limit.rate);
+	if (likely(ret == SPPWK_RET_OK))
+		ret = append_json_str_value(&tmp_buff, "unit",
+				comp->mir_limit.is_bytes ? "bytes" : "pkts");
+	/* Mode in use is shown if shallow copy is not available. */
+	if (path != NULL)
+		shallow = path->shallow;
+	else
+		shallow = (comp->copy_mode == SPPWK_MIR_COPY_DEFAULT ?
+				MIR_COPY_MODE_DEFAULT : comp->copy_mode) ==
+				SPPWK_MIR_COPY_SHALLOW;
+	if (likely(ret == SPPWK_RET_OK))
+		ret = append_json_str_value(&tmp_buff, "copy_mode",
+				shallow ? "shallow" : "deep");
+	if (likely(ret == SPPWK_RET_OK))
+		ret = append_json_uint64_value(&tmp_buff, "sampled_out",
+				lim->sampled_out);
+	if (likely(ret == SPPWK_RET_OK))
+		ret = append_json_uint64_value(&tmp_buff, "rate_limited",
+				lim->rate_limited);
+	if (likely(ret == SPPWK_RET_OK))
+		ret = append_json_uint64_value(&tmp_buff, "copy_failed",
+				lim->copy_failed);
+	if (likely(ret == SPPWK_RET_OK))
+		ret = append_json_block_brackets(output, "", tmp_buff);
+
+	spp_strbuf_free(tmp_buff);
+	return ret;
+}
+
+/* Add entry of counters of packets not mirrored of each of components. */
+int
+add_mirror_stats(const char *name, char **output,
+		void *tmp __attribute__ ((unused)))
+{
+	int ret = SPPWK_RET_OK;
+	int cnt;
+	char *tmp_buff = spp_strbuf_allocate(CMD_RES_BUF_INIT_SIZE);
+	if (unlikely(tmp_buff == NULL)) {
+		RTE_LOG(ERR, MIRROR,
+				"Failed to get empty buf for append `%s`.\n",
+				name);
+		return SPPWK_RET_NG;
+	}
+
+	for (cnt = 0; cnt < RTE_MAX_LCORE; cnt++) {
+		if (g_component_info[cnt].wk_type != SPPWK_TYPE_MIR)
+			continue;
+
+		ret = append_mirror_stats_block(&tmp_buff,
+				&g_component_info[cnt],
+				&g_mirror_info[cnt].limiter);
+		if (unlikely(ret < SPPWK_RET_OK)) {
+			spp_strbuf_free(tmp_buff);
+			return SPPWK_RET_NG;
+		}
+	}
+
+	ret = append_json_array_brackets(output, name, tmp_buff);
+	spp_strbuf_free(tmp_buff);
+	return ret;
+}
@@ -7,6 +7,12 @@
 
 #include "shared/secondary/spp_worker_th/cmd_utils.h"
 
+/**
+ * Max num of TX ports of mirror. The first one is for original packets, and
+ * others are for copied packets.
+ */
+#define MIR_TX_MAX 8
+
 /**
  * Get mirror status.
  *
@@ -25,4 +31,18 @@
 int get_mirror_status(unsigned int lcore_id, int id,
 		struct sppwk_lcore_params *params);
 
+/**
+ * Add entry of counters of packets not mirrored with sampling, rate limit or
+ * failure of copy to a response in JSON such as
+ * `"mirror_stats": [{"name": "mir1", "sampled_out": 0, ...}]`.
+ *
+ * @param[in] name Name of the entry.
+ * @param[in,out] output Response of status.
+ * @param tmp Not used.
+ * @retval SPPWK_RET_OK If succeeded.
+ * @retval SPPWK_RET_NG If failed.
+ */
+int add_mirror_stats(const char *name, char **output,
+		void *tmp __attribute__ ((unused)));
+
 #endif /* __SPP_MIRROR_H__ */
@@ -17,6 +17,7 @@
 #include "shared/secondary/common.h"
 #include "shared/common.h"
 #include "shared/basic_forwarder.h"
+#include "shared/chain_latency.h"
 
 #include "params.h"
 #include "nfv_status.h"
@@ -38,10 +39,12 @@ uint8_t lcore_id_used[RTE_MAX_LCORE] = {};
 enum {
 	CMD_LINE_OPT_MIN_NUM = 256,
 	CMD_OPT_ENABLE_VHOST_CLI,
+	CMD_OPT_CHAIN_LATENCY,
 };
 
 static struct option lgopts[] = {
 	{"vhost-client", no_argument, NULL, CMD_OPT_ENABLE_VHOST_CLI},
+	{"chain-latency", no_argument, NULL, CMD_OPT_CHAIN_LATENCY},
 	{0}
 };
 
@@ -52,9 +55,9 @@ static void
 usage(const char *progname)
 {
 	RTE_LOG(INFO, SPP_NFV,
-		"Usage: %s [EAL args] -- %s %s %s\n\n",
+		"Usage: %s [EAL args] -- %s %s %s %s\n\n",
 		progname, "-n <client_id>", "-s <ipaddr:port>",
-		"--vhost-client");
+		"--vhost-client", "--chain-latency");
 }
 
 /*
@@ -80,6 +83,10 @@ parse_app_args(int argc, char *argv[])
 		case CMD_OPT_ENABLE_VHOST_CLI:
 			set_vhost_cli_mode(1);
 			break;
+		case CMD_OPT_CHAIN_LATENCY:
+			if (chain_lat_init() != 0)
+				return -1;
+			break;
 		case 'n':
 			if (parse_client_id(&cli_id, optarg) != 0) {
 				usage(progname);
@@ -8,6 +8,7 @@
 #include "shared/common.h"
 #include "shared/basic_forwarder.h"
 #include "shared/port_manager.h"
+#include "shared/chain_latency.h"
 #include "nfv_status.h"
 
 /*
@@ -44,6 +45,12 @@ get_sec_stats_json(char *str, int cli_id,
 	sprintf(str + strlen(str), ",");
 
 	append_patch_info_json(str);
+
+	/* Two bytes are kept for closing bracket and null character. */
+	if (chain_lat_enabled()) {
+		sprintf(str + strlen(str), ",\"chain_latency\":");
+		chain_lat_json(str + strlen(str), MSG_SIZE - strlen(str) - 2);
+	}
 	sprintf(str + strlen(str), "}");
 
 	/* Make sure to be terminated with null character. */
@@ -3,6 +3,7 @@
  */
 
 #include <unistd.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <rte_ether.h>
@@ -10,6 +11,7 @@
 #include <rte_branch_prediction.h>
 
 #include "cmd_parser.h"
+#include "spp_pcap.h"
 #include "shared/secondary/return_codes.h"
 
 #define RTE_LOGTYPE_PCAP_PARSER RTE_LOGTYPE_USER2
@@ -66,6 +68,60 @@ split_cmd_tokens(char *tokens_str, int max_tokens, int *nof_tokens,
 	return SPPWK_RET_OK;
 }
 
+/**
+ * Validate params of start command, `snaplen LEN` and `filter EXPR`. Filter
+ * must be the last because expression is split with spaces and joined again.
+ */
+static int
+parse_cmd_start(struct spp_command_request *request, int nof_tokens,
+		char *tokens[], struct sppwk_parse_err_msg *wk_err_msg,
+		int nof_max_tokens __attribute__ ((unused)))
+{
+	struct pcap_cmd_attr *attr = &request->cmd_attrs[0];
+	unsigned long snaplen;
+	char *endptr = NULL;
+	size_t len = 0;
+	int ret;
+	int i = 1;
+
+	attr->snaplen = 0;
+	attr->filter[0] = '\0';
+	while (i < nof_tokens) {
+		if (strcmp(tokens[i], "snaplen") == 0 && i + 1 < nof_tokens) {
+			snaplen = strtoul(tokens[i + 1], &endptr, 10);
+			if (unlikely(*endptr != '\0') ||
+					unlikely(snaplen == 0) ||
+					unlikely(snaplen > PCAP_SNAPLEN_MAX))
+				return set_string_value_parse_error(wk_err_msg,
+						tokens[i + 1], "snaplen");
+			attr->snaplen = snaplen;
+			i += 2;
+		} else if (strcmp(tokens[i], "filter") == 0 &&
+				i + 1 < nof_tokens) {
+			for (i++; i < nof_tokens; i++) {
+				ret = snprintf(attr->filter + len,
+						SPPWK_FILTER_BUFSZ - len,
+						"%s%s", len > 0 ? " " : "",
+						tokens[i]);
+				if (unlikely(ret < 0) || unlikely((size_t)ret
+						>= SPPWK_FILTER_BUFSZ - len)) {
+					RTE_LOG(ERR, PCAP_PARSER, "Filter "
+						"expression is too long.\n");
+					attr->filter[0] = '\0';
+					return set_string_value_parse_error(
+						wk_err_msg, tokens[i],
+						"filter");
+				}
+				len += ret;
+			}
+		} else {
+			return set_string_value_parse_error(wk_err_msg,
+					tokens[i], "start");
+		}
+	}
+	return SPPWK_RET_OK;
+}
+
 /**
  * A set of attributes of commands for parsing. The fourth member of function
  * pointer is the operator function for the command.
@@ -90,7 +146,7 @@ static struct pcap_cmd_parse_attr pcap_cmd_attrs[] = {
 	{ "_get_client_id", 1, 1, NULL, PCAP_CMDTYPE_CLIENT_ID },
 	{ "status", 1, 1, NULL, PCAP_CMDTYPE_STATUS },
 	{ "exit",  1, 1, NULL, PCAP_CMDTYPE_EXIT },
-	{ "start", 1, 1, NULL, PCAP_CMDTYPE_START },
+	{ "start", 1, SPPWK_MAX_TOKENS, parse_cmd_start, PCAP_CMDTYPE_START },
 	{ "stop",  1, 1, NULL, PCAP_CMDTYPE_STOP },
 	{ "", 0, 0, NULL, 0 }  /* termination */
 };
@@ -98,31 +154,39 @@ static struct pcap_cmd_parse_attr pcap_cmd_attrs[] = {
 /* Parse command requested from spp-ctl. */
 static int
 parse_pcap_cmd(struct spp_command_request *request,
-		const char *cmd_str,
+		const char *cmd_str, size_t cmd_str_len,
 		struct sppwk_parse_err_msg *wk_err_msg)
 {
 	int is_invalid_cmd = 0;
 	struct pcap_cmd_parse_attr *cmd_attr = NULL;
 	int ret;
 	int i;
-	char *tokens[SPPWK_MAX_PARAMS];
+	char *tokens[SPPWK_MAX_TOKENS];
 	int nof_tokens = 0;
 	char tmp_str[SPPWK_MAX_PARAMS * SPPWK_VAL_BUFSZ];
 	memset(tokens, 0x00, sizeof(tokens));
 	memset(tmp_str, 0x00, sizeof(tmp_str));
 
-	strcpy(tmp_str, cmd_str);
-	ret = split_cmd_tokens(tmp_str, SPPWK_MAX_PARAMS,
+	/* Command including filter expression must be in the buffer */
+	if (unlikely(cmd_str_len >= sizeof(tmp_str))) {
+		RTE_LOG(ERR, PCAP_PARSER, "Invalid cmd, too long (%zu).\n",
+				cmd_str_len);
+		return set_parse_error(wk_err_msg,
+				SPPWK_PARSE_WRONG_FORMAT, NULL);
+	}
+	snprintf(tmp_str, sizeof(tmp_str), "%.*s", (int)cmd_str_len,
+			cmd_str);
+	ret = split_cmd_tokens(tmp_str, SPPWK_MAX_TOKENS,
 			&nof_tokens, tokens);
 	if (ret < SPPWK_RET_OK) {
-		RTE_LOG(ERR, PCAP_PARSER, "Invalid cmd '%s', "
-				"num of tokens is over SPPWK_MAX_PARAMS.\n",
-				cmd_str);
+		RTE_LOG(ERR, PCAP_PARSER, "Invalid cmd '%.*s', "
+				"num of tokens is over SPPWK_MAX_TOKENS.\n",
+				(int)cmd_str_len, cmd_str);
 		return set_parse_error(wk_err_msg,
 				SPPWK_PARSE_WRONG_FORMAT, NULL);
 	}
-	RTE_LOG(DEBUG, PCAP_PARSER, "Parsed cmd '%s', nof token is %d\n",
-			cmd_str, nof_tokens);
+	RTE_LOG(DEBUG, PCAP_PARSER, "Parsed cmd '%.*s', nof token is %d\n",
+			(int)cmd_str_len, cmd_str, nof_tokens);
 
 	for (i = 0; pcap_cmd_attrs[i].cmd_name[0] != '\0'; i++) {
 		cmd_attr = &pcap_cmd_attrs[i];
@@ -145,14 +209,16 @@ parse_pcap_cmd(struct spp_command_request *request,
 	}
 
 	if (is_invalid_cmd != 0) {
-		RTE_LOG(ERR, PCAP_PARSER, "Invalid cmd '%s', "
-				"num of params is out of range.\n", cmd_str);
+		RTE_LOG(ERR, PCAP_PARSER, "Invalid cmd '%.*s', "
+				"num of params is out of range.\n",
+				(int)cmd_str_len, cmd_str);
 		return set_parse_error(wk_err_msg,
 				SPPWK_PARSE_WRONG_FORMAT, NULL);
 	}
 
 	RTE_LOG(ERR, PCAP_PARSER,
-			"Unknown cmd '%s' in '%s'.\n", tokens[0], cmd_str);
+			"Unknown cmd '%s' in '%.*s'.\n", tokens[0],
+			(int)cmd_str_len, cmd_str);
 	return set_string_value_parse_error(wk_err_msg, tokens[0], "command");
 }
 
@@ -168,7 +234,8 @@ sppwk_parse_req(
 
 	/* parse request */
 	request->num_command = 1;
-	ret = parse_pcap_cmd(request, request_str, wk_err_msg);
+	ret = parse_pcap_cmd(request, request_str, request_str_len,
+			wk_err_msg);
 	if (unlikely(ret != SPPWK_RET_OK)) {
 		RTE_LOG(ERR, PCAP_PARSER,
 				"Cannot parse command request. "
@@ -20,6 +20,12 @@
 /** maximum number of parameters per command */
 #define SPPWK_MAX_PARAMS 8
 
+/**
+ * Maximum number of tokens of a command. It is larger than SPPWK_MAX_PARAMS
+ * because filter expression of `start` command is given with spaces.
+ */
+#define SPPWK_MAX_TOKENS 64
+
 /** command name string buffer size (include null char) */
 #define SPPWK_NAME_BUFSZ  32
 
@@ -53,6 +59,8 @@ enum pcap_cmd_type {
 
 struct pcap_cmd_attr {
 	enum pcap_cmd_type type;
+	uint32_t snaplen;  /**< snaplen of `start`, or 0 if not given */
+	char filter[SPPWK_FILTER_BUFSZ];  /**< filter of `start`, or empty */
 };
 
 /** request parameters */
@@ -235,6 +235,8 @@ execute_command(const struct pcap_cmd_attr *command)
 		break;
 	case PCAP_CMDTYPE_START:
 		RTE_LOG(INFO, PCAP_RUNNER, "Exec start cmd.\n");
+		ret = spp_pcap_set_capture_params(command->snaplen,
+				command->filter);
 		break;
 	case PCAP_CMDTYPE_STOP:
 		RTE_LOG(INFO, PCAP_RUNNER, "Exec stop cmd.\n");
@@ -452,10 +454,13 @@ append_pcap_core_element_value(
 		const int num_rx,
 		const struct sppwk_port_idx *rx_ports,
 		const int num_tx __attribute__ ((unused)),
-		const struct sppwk_port_idx *tx_ports __attribute__ ((unused)))
+		const struct sppwk_port_idx *tx_ports __attribute__ ((unused)),
+		const struct sppwk_tx_coal_stats *tx_stats
+				__attribute__ ((unused)))
 {
 	int ret = SPPWK_RET_NG;
 	int unuse_flg = 0;
+	const char *error;
 	char *buff, *tmp_buff;
 	buff = params->output;
 
@@ -483,8 +488,15 @@ append_pcap_core_element_value(
 	if (num_rx != 0)
 		ret = append_port_array("rx_port", &tmp_buff,
 				num_rx, rx_ports, SPPWK_PORT_DIR_RX);
-	else
+	else {
 		ret = append_json_str_value("filename", &tmp_buff, name);
+
+		/* Writer failed to open or write file */
+		error = spp_pcap_get_write_error(lcore_id);
+		if (ret >= 0 && error != NULL)
+			ret = append_json_str_value("error", &tmp_buff,
+					error);
+	}
 	if (unlikely(ret < 0))
 		return ret;
 
@@ -877,6 +889,9 @@ process_request(int *sock, const char *request_str, size_t request_str_len)
 			set_command_results(&cmd_results[i], CMD_FAILURE,
 					"error occur");
 
+			/* Capture is not started with invalid params */
+			request.is_requested_start = 0;
+
 			/* not execute remaining commands */
 			for (++i; i < request.num_command ; ++i)
 				set_command_results(&cmd_results[i],
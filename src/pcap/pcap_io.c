@@ -0,0 +1,364 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE  /* O_DIRECT */
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rte_common.h>
+#include <rte_lcore.h>
+#include <rte_log.h>
+#include <rte_pause.h>
+#include <rte_ring.h>
+
+#include "pcap_io.h"
+#include "shared/secondary/return_codes.h"
+#include "shared/secondary/utils.h"
+
+#define RTE_LOGTYPE_PCAP_IO RTE_LOGTYPE_USER2
+
+#define PCAP_IO_ALIGN 4096  /* Alignment of offset and length of O_DIRECT */
+#define PCAP_IO_BUFSZ (1024 * 1024)  /* Size of buffer written at once */
+#define PCAP_IO_NOF_REQS 16  /* Num of requests queued in a stream */
+#define PCAP_IO_PATH_STRLEN 256
+#define PCAP_IO_IDLE_USEC 100  /* Wait of I/O thread if no request */
+
+/* Type of request to I/O thread */
+enum pcap_io_req_type {
+	PCAP_IO_OPEN,  /* Open temporary file */
+	PCAP_IO_WRITE,  /* Write a whole buffer */
+	PCAP_IO_CLOSE,  /* Write remained data, close and rename file */
+};
+
+/* Request to I/O thread, which has its own buffer. */
+struct pcap_io_req {
+	enum pcap_io_req_type type;  /* type of request */
+	size_t len;  /* length of data in buffer */
+	char path[PCAP_IO_PATH_STRLEN];  /* path of file to be opened */
+	void *data;  /* buffer aligned for O_DIRECT */
+};
+
+/* Stream of files of a writer thread. */
+struct pcap_io_stream {
+	struct rte_ring *free_ring;  /* requests not used */
+	struct rte_ring *req_ring;  /* requests to I/O thread */
+	struct pcap_io_req *cur;  /* request filled on writer thread */
+	struct pcap_io_req reqs[PCAP_IO_NOF_REQS];
+	pthread_t thread;  /* I/O thread */
+	int has_thread;  /* I/O thread is launched or not */
+	volatile int stop;  /* Stop I/O thread after all of requests */
+	volatile int error;  /* Failed on I/O thread, cleared at next open */
+
+	/* Members referred only on I/O thread */
+	int fd;  /* file descriptor of temporary file */
+	off_t offset;  /* offset of next write */
+	char path[PCAP_IO_PATH_STRLEN];  /* path of file renamed at close */
+};
+
+/* Open temporary file, with O_DIRECT if it is supported. */
+static int
+io_open(struct pcap_io_stream *st, const char *path)
+{
+	char tmp_path[PCAP_IO_PATH_STRLEN + 4];
+
+	snprintf(st->path, sizeof(st->path), "%s", path);
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	st->fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT,
+			0644);
+	if (st->fd < 0 && errno == EINVAL) {
+		RTE_LOG(DEBUG, PCAP_IO, "O_DIRECT is not supported for %s\n",
+				tmp_path);
+		st->fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	}
+	if (st->fd < 0) {
+		RTE_LOG(ERR, PCAP_IO, "Failed to open %s (%s)\n",
+				tmp_path, strerror(errno));
+		return SPPWK_RET_NG;
+	}
+	st->offset = 0;
+	return SPPWK_RET_OK;
+}
+
+/* Write data at current offset. */
+static int
+io_write(struct pcap_io_stream *st, const void *data, size_t len)
+{
+	ssize_t ret;
+	size_t done = 0;
+
+	while (done < len) {
+		ret = pwrite(st->fd, (const char *)data + done, len - done,
+				st->offset + done);
+		if (ret < 0) {
+			if (errno == EINTR)
+				continue;
+			RTE_LOG(ERR, PCAP_IO, "Failed to write %s (%s)\n",
+					st->path, strerror(errno));
+			return SPPWK_RET_NG;
+		}
+		done += ret;
+	}
+	st->offset += len;
+	return SPPWK_RET_OK;
+}
+
+/**
+ * Write remained data and close file. Data is padded to be aligned for
+ * O_DIRECT, and the padding is truncated before renaming the file.
+ */
+static int
+io_close(struct pcap_io_stream *st, struct pcap_io_req *req)
+{
+	char tmp_path[PCAP_IO_PATH_STRLEN + 4];
+	size_t aligned_len;
+	int ret = SPPWK_RET_OK;
+
+	if (st->fd < 0)
+		return SPPWK_RET_OK;
+
+	if (req->len > 0) {
+		aligned_len = RTE_ALIGN_CEIL(req->len, PCAP_IO_ALIGN);
+		memset((char *)req->data + req->len, 0,
+				aligned_len - req->len);
+		if (io_write(st, req->data, aligned_len) != SPPWK_RET_OK)
+			ret = SPPWK_RET_NG;
+		else if (ftruncate(st->fd, st->offset - aligned_len +
+					req->len) != 0) {
+			RTE_LOG(ERR, PCAP_IO, "Failed to truncate %s (%s)\n",
+					st->path, strerror(errno));
+			ret = SPPWK_RET_NG;
+		}
+	}
+	close(st->fd);
+	st->fd = -1;
+
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", st->path);
+	if (rename(tmp_path, st->path) != 0) {
+		RTE_LOG(ERR, PCAP_IO, "Failed to rename %s (%s)\n",
+				tmp_path, strerror(errno));
+		ret = SPPWK_RET_NG;
+	}
+	return ret;
+}
+
+/* Main loop of I/O thread. It is terminated after all of requests done. */
+static void *
+io_thread_main(void *arg)
+{
+	struct pcap_io_stream *st = arg;
+	struct pcap_io_req *req;
+	void *obj;
+	int ret = SPPWK_RET_OK;
+
+	while (1) {
+		if (rte_ring_sc_dequeue(st->req_ring, &obj) != 0) {
+			if (st->stop)
+				break;
+			usleep(PCAP_IO_IDLE_USEC);
+			continue;
+		}
+
+		/**
+		 * Writing is skipped after an error until the next file is
+		 * opened, but closing is done to keep written data.
+		 */
+		req = obj;
+		if (req->type == PCAP_IO_OPEN)
+			st->error = 0;
+		if (!st->error || req->type == PCAP_IO_CLOSE) {
+			if (req->type == PCAP_IO_OPEN)
+				ret = io_open(st, req->path);
+			else if (req->type == PCAP_IO_WRITE)
+				ret = io_write(st, req->data, req->len);
+			else
+				ret = io_close(st, req);
+			if (ret != SPPWK_RET_OK)
+				st->error = 1;
+		}
+		rte_ring_sp_enqueue(st->free_ring, req);
+	}
+	return NULL;
+}
+
+/**
+ * Get free request on writer thread. It waits for I/O thread to release
+ * a request if all of them are in use. Only writing fails after an error,
+ * so that the file can be closed and the next one can be opened.
+ */
+static struct pcap_io_req *
+get_req(struct pcap_io_stream *st, enum pcap_io_req_type type)
+{
+	struct pcap_io_req *req;
+	void *obj;
+
+	if (unlikely(st->error) && type == PCAP_IO_WRITE)
+		return NULL;
+	while (rte_ring_sc_dequeue(st->free_ring, &obj) != 0) {
+		if (unlikely(st->error) && type == PCAP_IO_WRITE)
+			return NULL;
+		rte_pause();
+	}
+	req = obj;
+	req->type = type;
+	req->len = 0;
+	return req;
+}
+
+/* Pass request to I/O thread. */
+static inline void
+put_req(struct pcap_io_stream *st, struct pcap_io_req *req)
+{
+	/* Never fails because ring can have all of requests */
+	rte_ring_sp_enqueue(st->req_ring, req);
+}
+
+struct pcap_io_stream *
+pcap_io_stream_create(unsigned int id)
+{
+	struct pcap_io_stream *st;
+	char name[RTE_RING_NAMESIZE];
+	unsigned int flags = RING_F_SP_ENQ | RING_F_SC_DEQ | RING_F_EXACT_SZ;
+	int i;
+
+	st = calloc(1, sizeof(*st));
+	if (st == NULL)
+		return NULL;
+	st->fd = -1;
+
+	snprintf(name, sizeof(name), "pcap_io_free_%d_%u",
+			get_client_id(), id);
+	st->free_ring = rte_ring_create(name, PCAP_IO_NOF_REQS,
+			rte_socket_id(), flags);
+	snprintf(name, sizeof(name), "pcap_io_req_%d_%u",
+			get_client_id(), id);
+	st->req_ring = rte_ring_create(name, PCAP_IO_NOF_REQS,
+			rte_socket_id(), flags);
+	if (st->free_ring == NULL || st->req_ring == NULL) {
+		RTE_LOG(ERR, PCAP_IO, "Failed to create rings (%s)\n",
+				rte_strerror(rte_errno));
+		pcap_io_stream_free(st);
+		return NULL;
+	}
+
+	for (i = 0; i < PCAP_IO_NOF_REQS; i++) {
+		if (posix_memalign(&st->reqs[i].data, PCAP_IO_ALIGN,
+					PCAP_IO_BUFSZ) != 0) {
+			RTE_LOG(ERR, PCAP_IO, "Failed to alloc buffers\n");
+			pcap_io_stream_free(st);
+			return NULL;
+		}
+		rte_ring_sp_enqueue(st->free_ring, &st->reqs[i]);
+	}
+
+	if (pthread_create(&st->thread, NULL, io_thread_main, st) != 0) {
+		RTE_LOG(ERR, PCAP_IO, "Failed to create I/O thread\n");
+		pcap_io_stream_free(st);
+		return NULL;
+	}
+	st->has_thread = 1;
+	snprintf(name, sizeof(name), "pcap-io-%u", id);
+	rte_thread_setname(st->thread, name);
+
+	return st;
+}
+
+void
+pcap_io_stream_free(struct pcap_io_stream *st)
+{
+	int i;
+
+	if (st == NULL)
+		return;
+
+	if (st->has_thread) {
+		st->stop = 1;
+		pthread_join(st->thread, NULL);
+	}
+	if (st->fd >= 0)
+		close(st->fd);
+	for (i = 0; i < PCAP_IO_NOF_REQS; i++)
+		free(st->reqs[i].data);
+	rte_ring_free(st->free_ring);
+	rte_ring_free(st->req_ring);
+	free(st);
+}
+
+int
+pcap_io_open(struct pcap_io_stream *st, const char *path)
+{
+	struct pcap_io_req *req;
+
+	req = get_req(st, PCAP_IO_OPEN);
+	if (unlikely(req == NULL))
+		return SPPWK_RET_NG;
+	snprintf(req->path, sizeof(req->path), "%s", path);
+	put_req(st, req);
+	return SPPWK_RET_OK;
+}
+
+int
+pcap_io_write(struct pcap_io_stream *st, const void *data, size_t len)
+{
+	struct pcap_io_req *req;
+	size_t room;
+
+	while (len > 0) {
+		if (st->cur == NULL) {
+			st->cur = get_req(st, PCAP_IO_WRITE);
+			if (unlikely(st->cur == NULL))
+				return SPPWK_RET_NG;
+		}
+		req = st->cur;
+
+		room = PCAP_IO_BUFSZ - req->len;
+		if (room > len)
+			room = len;
+		memcpy((char *)req->data + req->len, data, room);
+		req->len += room;
+		data = (const char *)data + room;
+		len -= room;
+
+		if (req->len == PCAP_IO_BUFSZ) {
+			put_req(st, req);
+			st->cur = NULL;
+		}
+	}
+	return SPPWK_RET_OK;
+}
+
+int
+pcap_io_wait(struct pcap_io_stream *st)
+{
+	unsigned int nof_held = st->cur != NULL;
+
+	/* All of requests are released after done on I/O thread */
+	while (rte_ring_count(st->free_ring) + nof_held < PCAP_IO_NOF_REQS)
+		rte_pause();
+	return st->error ? SPPWK_RET_NG : SPPWK_RET_OK;
+}
+
+int
+pcap_io_close(struct pcap_io_stream *st)
+{
+	struct pcap_io_req *req = st->cur;
+
+	/* Remained data is written with close request */
+	if (req == NULL) {
+		req = get_req(st, PCAP_IO_CLOSE);
+		if (unlikely(req == NULL))
+			return SPPWK_RET_NG;
+	}
+	req->type = PCAP_IO_CLOSE;
+	put_req(st, req);
+	st->cur = NULL;
+	return SPPWK_RET_OK;
+}
@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#ifndef _SPP_PCAP_IO_H_
+#define _SPP_PCAP_IO_H_
+
+/**
+ * @file
+ * Asynchronous file writer of spp_pcap
+ *
+ * Writer thread copies data into aligned buffers and passes them to its own
+ * I/O thread via ring. I/O thread writes the buffers with O_DIRECT, and also
+ * opens, closes and renames files. Writer thread is not blocked in kernel
+ * even while rotating files.
+ */
+
+#include <stddef.h>
+
+/* Stream of files written on an I/O thread, defined in pcap_io.c. */
+struct pcap_io_stream;
+
+/**
+ * Create stream and launch I/O thread for it.
+ *
+ * @param[in] id ID of stream unique in the process, such as lcore ID.
+ * @retval Created stream, or NULL if failed.
+ */
+struct pcap_io_stream *pcap_io_stream_create(unsigned int id);
+
+/**
+ * Stop I/O thread after all of requests are done, and release the stream.
+ *
+ * @param[in] st Stream to be released, or NULL.
+ */
+void pcap_io_stream_free(struct pcap_io_stream *st);
+
+/**
+ * Request to open file. Data is written to `PATH.tmp` which is renamed to
+ * `PATH` when the file is closed. An error of previous file is cleared when
+ * the request is done. Use pcap_io_wait() to get the result of opening.
+ *
+ * @param[in] st Stream of files.
+ * @param[in] path Path of file.
+ * @retval SPPWK_RET_OK succeeded.
+ */
+int pcap_io_open(struct pcap_io_stream *st, const char *path);
+
+/**
+ * Copy data to buffer of the stream. The buffer is passed to I/O thread
+ * when it is filled.
+ *
+ * @param[in] st Stream of files.
+ * @param[in] data Data to be written.
+ * @param[in] len Length of data.
+ * @retval SPPWK_RET_OK succeeded.
+ * @retval SPPWK_RET_NG failed on I/O thread.
+ */
+int pcap_io_write(struct pcap_io_stream *st, const void *data, size_t len);
+
+/**
+ * Wait for I/O thread to finish all of requests passed.
+ *
+ * @param[in] st Stream of files.
+ * @retval SPPWK_RET_OK succeeded.
+ * @retval SPPWK_RET_NG failed on I/O thread after the file is opened.
+ */
+int pcap_io_wait(struct pcap_io_stream *st);
+
+/**
+ * Request to write remained data, close and rename the file. It is done
+ * even after an error to keep data written.
+ *
+ * @param[in] st Stream of files.
+ * @retval SPPWK_RET_OK succeeded.
+ */
+int pcap_io_close(struct pcap_io_stream *st);
+
+#endif /* _SPP_PCAP_IO_H_ */
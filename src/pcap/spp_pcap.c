@@ -2,13 +2,17 @@
  * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
  */
 
+#include <inttypes.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <getopt.h>
 #include <sys/stat.h>
 
 #include <rte_common.h>
+#include <rte_atomic.h>
 #include <rte_cycles.h>
+#include <rte_memcpy.h>
+#include <rte_mbuf_dyn.h>
 
 #include <lz4frame.h>
 
@@ -16,16 +20,14 @@
 #include "data_types.h"
 #include "cmd_utils.h"
 #include "spp_pcap.h"
+#include "pcap_io.h"
 #include "cmd_runner.h"
 #include "cmd_parser.h"
 #include "shared/secondary/common.h"
 #include "shared/secondary/return_codes.h"
 #include "shared/secondary/utils.h"
 #include "shared/secondary/spp_worker_th/port_capability.h"
-
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
-#include "shared/secondary/spp_worker_th/latency_stats.h"
-#endif
+#include "shared/secondary/spp_worker_th/pkt_filter.h"
 
 /* Declare global variables */
 #define RTE_LOGTYPE_SPP_PCAP RTE_LOGTYPE_USER2
@@ -35,23 +37,48 @@
 #define PCAP_FNAME_STRLEN 64
 #define PCAP_FDATE_STRLEN 16
 
-/* Used to identify pcap files */
-#define TCPDUMP_MAGIC 0xa1b2c3d4
+/* Block types of pcapng */
+#define PCAPNG_BT_SHB 0x0a0d0d0a  /* Section Header Block */
+#define PCAPNG_BT_IDB 0x00000001  /* Interface Description Block */
+#define PCAPNG_BT_ISB 0x00000005  /* Interface Statistics Block */
+#define PCAPNG_BT_EPB 0x00000006  /* Enhanced Packet Block */
+
+/* Used to identify byte order of pcapng files */
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1a2b3c4d
 
-/* Indicates major verions of libpcap file */
-#define PCAP_VERSION_MAJOR 2
-#define PCAP_VERSION_MINOR 4
+/* Indicates major verions of pcapng file */
+#define PCAPNG_VERSION_MAJOR 1
+#define PCAPNG_VERSION_MINOR 0
 
-#define PCAP_SNAPLEN_MAX 65535
+/* Option codes of pcapng blocks */
+#define PCAPNG_OPT_ENDOFOPT 0
+#define PCAPNG_OPT_IF_NAME 2
+#define PCAPNG_OPT_IF_TSRESOL 9
+#define PCAPNG_OPT_IF_FILTER 11
+#define PCAPNG_OPT_ISB_IFRECV 4
+#define PCAPNG_OPT_ISB_FILTERACCEPT 6
+#define PCAPNG_OPT_ISB_OSDROP 7
+#define PCAPNG_OPT_BUFSZ 64  /* Size of buffer for options of a block */
+
+#define PCAPNG_TSRESOL_NS 9  /* Timestamp is in 10^-9 sec */
+#define PCAP_MAX_IFACES 16  /* Max num of captured ports */
 
 #define PCAP_LINKTYPE 1  /* Link type 1 means LINKTYPE_ETHERNET */
 #define IN_CHUNK_SIZE (16*1024)
+/* Records are staged and compressed at once in the size of LZ4 block. */
+#define PCAP_STAGE_SIZE (IN_CHUNK_SIZE * 16)
+#define NS_PER_SEC 1000000000ULL
+#define RX_CLOCK_SYNC_INTERVAL 1  /* Calibrate clocks every second */
 #define DEFAULT_OUTPUT_DIR "/tmp"
 #define DEFAULT_FILE_LIMIT 1073741824  /* 1GiB */
 #define PORT_STR_SIZE 16
 #define RING_SIZE 16384
 #define MAX_PCAP_BURST 256  /* Num of received packets at once */
 
+/* Errors of writer shown in status */
+#define PCAP_ERR_OPEN "failed to open file"
+#define PCAP_ERR_WRITE "failed to write file"
+
 /* Ensure snaplen not to be over the maximum size */
 #define TRANCATE_SNAPLEN(a, b) (((a) < (b))?(a):(b))
 
@@ -65,7 +92,8 @@ enum SPP_LONGOPT_RETVAL {
 	 */
 	SPP_LONGOPT_RETVAL_CLIENT_ID,  /* --client-id */
 	SPP_LONGOPT_RETVAL_OUT_DIR,    /* --out-dir */
-	SPP_LONGOPT_RETVAL_FILE_SIZE   /* --fsize */
+	SPP_LONGOPT_RETVAL_FILE_SIZE,  /* --fsize */
+	SPP_LONGOPT_RETVAL_RECEIVERS   /* --receivers */
 };
 
 /* capture thread type */
@@ -97,23 +125,65 @@ static const LZ4F_preferences_t g_kprefs = {
 	{ 0, 0, 0, 0},   /* reserved, must be set to 0 */
 };
 
-/* pcap file header */
-struct __attribute__((__packed__)) pcap_header {
-	uint32_t magic_number;  /* magic number */
+/* pcapng block header */
+struct pcapng_block_header {
+	uint32_t block_type;  /* block type */
+	uint32_t block_len;  /* total length of block */
+};
+
+/* pcapng section header block, following block header */
+struct __attribute__((__packed__)) pcapng_shb {
+	uint32_t magic_number;  /* byte order magic */
 	uint16_t major_ver;  /* major version */
 	uint16_t minor_ver;  /* minor version */
-	int32_t thiszone;  /* GMT to local correction */
-	uint32_t sigfigs;  /* accuracy of timestamps */
+	int64_t section_len;  /* section length, -1 if not specified */
+};
+
+/* pcapng interface description block, following block header */
+struct pcapng_idb {
+	uint16_t linktype;  /* data link type */
+	uint16_t reserved;  /* reserved, must be set to 0 */
 	uint32_t snaplen;  /* max length of captured packets, in octets */
-	uint32_t network;  /* data link type */
 };
 
-/* pcap packet header */
-struct pcap_packet_header {
-	uint32_t ts_sec;   /* time stamp seconds */
-	uint32_t ts_usec;  /* time stamp micro seconds */
-	uint32_t write_len;   /* write length */
-	uint32_t packet_len;  /* packet length */
+/* pcapng interface statistics block, following block header */
+struct pcapng_isb {
+	uint32_t if_id;  /* interface ID */
+	uint32_t ts_high;  /* upper 32 bits of timestamp */
+	uint32_t ts_low;  /* lower 32 bits of timestamp */
+};
+
+/* pcapng enhanced packet block, following block header */
+struct pcapng_epb {
+	uint32_t if_id;  /* interface ID */
+	uint32_t ts_high;  /* upper 32 bits of timestamp */
+	uint32_t ts_low;  /* lower 32 bits of timestamp */
+	uint32_t cap_len;  /* captured length */
+	uint32_t orig_len;  /* packet length */
+};
+
+/* pcapng option header */
+struct pcapng_opt_header {
+	uint16_t code;  /* option code */
+	uint16_t len;  /* length of value without padding */
+};
+
+/* NIC clock of captured port calibrated with TSC on receiver. */
+struct pcap_nic_clock {
+	int has_clock;  /* NIC clock can be read or not */
+	uint64_t base;  /* NIC clock at base_tsc of receiver */
+	uint64_t start;  /* NIC clock at start_tsc of receiver */
+	double ns_per_tick;  /* nanosec per NIC clock, 0 if unknown */
+};
+
+/* Captured port, which is an interface of pcapng. */
+struct pcap_cap_iface {
+	struct sppwk_port_info port;  /* captured port */
+	char name[PORT_STR_SIZE];  /* port name such as `phy:0 nq 1` */
+	struct pcap_nic_clock nic_clock;  /* NIC clock of the port */
+	uint64_t nof_rx;  /* num of received packets */
+	uint64_t nof_drop;  /* num of dropped packets for ring full */
+	uint64_t nof_accept;  /* num of packets matched with filter */
 };
 
 /* Option for pcap. */
@@ -122,8 +192,20 @@ struct pcap_option {
 	uint64_t fsize_limit;  /* file size limit */
 	char compress_file_path[PCAP_FPATH_STRLEN];  /* file path */
 	char compress_file_date[PCAP_FDATE_STRLEN];  /* file name date */
-	struct sppwk_port_info port_cap;  /* capture port */
-	struct rte_ring *cap_ring;  /* RTE ring structure */
+	struct pcap_cap_iface cap_ifaces[PCAP_MAX_IFACES];  /* capture ports */
+	int nof_cap_ifaces;  /* num of capture ports */
+	int nof_receivers;  /* num of receiver threads */
+	/* Ring from each of receivers to its writers */
+	struct rte_ring *cap_rings[PCAP_MAX_IFACES];
+};
+
+/* TSC calibrated to CLOCK_REALTIME for timestamp of received packets. */
+struct pcap_rx_clock {
+	uint64_t base_ns;  /* CLOCK_REALTIME in nanosec at base_tsc */
+	uint64_t base_tsc;  /* TSC at base_ns */
+	uint64_t tsc_hz;  /* TSC frequency */
+	uint64_t next_sync;  /* TSC of next calibration */
+	uint64_t start_tsc;  /* TSC at starting capture */
 };
 
 /**
@@ -137,16 +219,26 @@ struct pcap_mng_info {
 	int file_no;    /* file no */
 	char compress_file_name[PCAP_FNAME_STRLEN];  /* lz4 file name */
 	LZ4F_compressionContext_t ctx;  /* lz4 file Ccontext */
-	FILE *compress_fp;  /* lzf file pointer */
+	struct pcap_io_stream *io;  /* stream written on I/O thread */
+	int is_open;  /* file is opened or not */
 	size_t outbuf_capacity;  /* compress date buffer size */
 	void *outbuff;  /* compress date buffer */
+	void *stage;  /* staging buffer of pcap records */
+	size_t stage_len;  /* length of records in staging buffer */
 	uint64_t file_size;  /* file write size */
+	uint32_t if_mask;  /* bitmask of interface IDs written in file */
+	struct pcap_rx_clock rx_clock;  /* clocks used on receiver */
+	struct rte_ring *ring;  /* ring between receiver and writers */
+	uint32_t snaplen;  /* snaplen of capture written by writer */
+	const char *error;  /* error of writer shown in status, or NULL */
+	char filter[SPPWK_FILTER_BUFSZ];  /* filter of capture, or empty */
 };
 
 /* Pcap status info. */
 struct pcap_status_info {
 	int thread_cnt;  /* thread count */
-	int start_up_cnt;  /* thread start up count */
+	rte_atomic32_t start_up_cnt;  /* thread start up count */
+	rte_atomic32_t rx_run_cnt;  /* running receiver count */
 };
 
 /* Interface management information */
@@ -161,6 +253,11 @@ static int g_capture_request;
 /* Packet capture status information */
 static int g_capture_status;
 
+/* Params given with start command, changed only while not capturing */
+static uint32_t g_capture_snaplen = PCAP_SNAPLEN_MAX;
+static struct sppwk_pkt_filter *g_capture_filter;  /* NULL for all pkts */
+static char g_capture_filter_expr[SPPWK_FILTER_BUFSZ];
+
 /* pcap option */
 static struct pcap_option g_pcap_option;
 
@@ -173,6 +270,26 @@ struct pcap_status_info g_pcap_thread_info;
 /* pcap total write packet count */
 static long long g_total_write[RTE_MAX_LCORE];
 
+/* Dynamic field of mbuf for timestamp in nanosec of received packets */
+static const struct rte_mbuf_dynfield g_rx_ts_dynfield_desc = {
+	.name = "spp_pcap_dynfield_rx_timestamp",
+	.size = sizeof(uint64_t),
+	.align = __alignof__(uint64_t),
+};
+
+/* Offset of timestamp field in mbuf */
+static int g_rx_ts_offset = -1;
+
+/* Dynamic field of mbuf for interface ID of received packets */
+static const struct rte_mbuf_dynfield g_rx_if_dynfield_desc = {
+	.name = "spp_pcap_dynfield_rx_if_id",
+	.size = sizeof(uint16_t),
+	.align = __alignof__(uint16_t),
+};
+
+/* Offset of interface ID field in mbuf */
+static int g_rx_if_offset = -1;
+
 /* Print help message */
 static void
 usage(const char *progname)
@@ -182,13 +299,17 @@ usage(const char *progname)
 		" -s IPADDR:PORT"
 		" -c CAP_PORT"
 		" [--out-dir OUTPUT_DIR]"
-		" [--fsize MAX_FILE_SIZE]\n"
+		" [--fsize MAX_FILE_SIZE]"
+		" [--receivers NUM]\n"
 		" --client-id CLIENT_ID: My client ID\n"
 		" -s IPADDR:PORT: IP addr and sec port for spp-ctl\n"
-		" -c: Captured port (e.g. 'phy:0', 'phy:0 nq 1' or 'ring:1')\n"
+		" -c: Captured port (e.g. 'phy:0', 'phy:0 nq 1' or 'ring:1'),"
+		" can be given up to %d times. All of queues are captured"
+		" if 'nq' is omitted for multi-queue port.\n"
 		" --out-dir: Output dir (Default is /tmp)\n"
 		" --fsize: Maximum captured file size (Default is 1GiB)\n"
-		, progname);
+		" --receivers: Num of receiver threads (Default is 1)\n"
+		, progname, PCAP_MAX_IFACES);
 }
 
 /* Parse `--fsize` option and get the value */
@@ -207,7 +328,10 @@ parse_fsize(const char *fsize_str, uint64_t *fsize)
 	return SPPWK_RET_OK;
 }
 
-/* Parse `-c` option for captured port and get the port type and ID */
+/**
+ * Parse `-c` option for captured port and get the port type and ID. Queue
+ * ID is -1 if all of queues are captured.
+ */
 static int
 parse_captured_port(const char *port_str, int option_index,
 			const int argcopt, char *argvopt[],
@@ -268,15 +392,8 @@ parse_captured_port(const char *port_str, int option_index,
 			return SPPWK_RET_NG;
 		}
 
-	} else {
-		if (get_port_max_queues(type, ret_no) > 1) {
-			RTE_LOG(ERR, SPP_PCAP,
-				"Queue_no is required for the specified "
-				"physical port because of multi-queue.\n"
-				);
-			return SPPWK_RET_NG;
-		}
-	}
+	} else if (get_port_max_queues(type, ret_no) > 1)
+		q_no = -1;  /* All of queues of multi-queue port */
 
 	*iface_type = type;
 	*iface_no = ret_no;
@@ -288,6 +405,64 @@ parse_captured_port(const char *port_str, int option_index,
 	return SPPWK_RET_OK;
 }
 
+/* Add captured port to the list of interfaces of pcapng. */
+static int
+add_cap_iface(const char *port_str, enum port_type iface_type, int iface_no,
+		int queue_no)
+{
+	struct pcap_cap_iface *cap;
+	int i;
+
+	if (g_pcap_option.nof_cap_ifaces >= PCAP_MAX_IFACES) {
+		RTE_LOG(ERR, SPP_PCAP, "Too many captured ports, max %d.\n",
+				PCAP_MAX_IFACES);
+		return SPPWK_RET_NG;
+	}
+
+	cap = &g_pcap_option.cap_ifaces[g_pcap_option.nof_cap_ifaces];
+	cap->port.iface_type = iface_type;
+	cap->port.iface_no = iface_no;
+	cap->port.queue_no = queue_no;
+	if (get_port_max_queues(iface_type, iface_no) > 1)
+		snprintf(cap->name, PORT_STR_SIZE, "%s nq %d",
+				port_str, queue_no);
+	else
+		snprintf(cap->name, PORT_STR_SIZE, "%s", port_str);
+
+	/* Same port and queue cannot be captured twice */
+	for (i = 0; i < g_pcap_option.nof_cap_ifaces; i++) {
+		if (strcmp(g_pcap_option.cap_ifaces[i].name,
+					cap->name) == 0) {
+			RTE_LOG(ERR, SPP_PCAP,
+					"Duplicated captured port '%s'.\n",
+					cap->name);
+			return SPPWK_RET_NG;
+		}
+	}
+	g_pcap_option.nof_cap_ifaces++;
+	return SPPWK_RET_OK;
+}
+
+/* Parse `--receivers` option and get the value */
+static int
+parse_nof_receivers(const char *num_str, int *nof_receivers)
+{
+	long num;
+	char *endptr = NULL;
+
+	num = strtol(num_str, &endptr, 10);
+	if (unlikely(num_str == endptr) || unlikely(*endptr != '\0'))
+		return SPPWK_RET_NG;
+	if (num < 1 || num > PCAP_MAX_IFACES) {
+		RTE_LOG(ERR, SPP_PCAP, "Num of receivers should be "
+				"1 to %d.\n", PCAP_MAX_IFACES);
+		return SPPWK_RET_NG;
+	}
+
+	*nof_receivers = num;
+	return SPPWK_RET_OK;
+}
+
 /* Parse options for client app */
 static int
 parse_app_args(int argc, char *argv[])
@@ -295,7 +470,9 @@ parse_app_args(int argc, char *argv[])
 	int cli_id;  /* Client ID. */
 	char *ctl_ip;  /* IP address of spp_ctl. */
 	int ctl_port;  /* Port num to connect spp_ctl. */
-	char cap_port_str[PORT_STR_SIZE];  /* Captured port. */
+	enum port_type cap_type;  /* Type of captured port. */
+	int cap_no, cap_queue;  /* Port and queue ID of captured port. */
+	int nof_queues;
 	int cnt;
 	int ret;
 	int option_index, opt;
@@ -315,6 +492,8 @@ parse_app_args(int argc, char *argv[])
 			SPP_LONGOPT_RETVAL_OUT_DIR },
 		{ "fsize", required_argument, NULL,
 			SPP_LONGOPT_RETVAL_FILE_SIZE},
+		{ "receivers", required_argument, NULL,
+			SPP_LONGOPT_RETVAL_RECEIVERS},
 		{ 0 },
 	};
 	/**
@@ -328,6 +507,7 @@ parse_app_args(int argc, char *argv[])
 	memset(&g_pcap_option, 0x00, sizeof(g_pcap_option));
 	strcpy(g_pcap_option.compress_file_path, DEFAULT_OUTPUT_DIR);
 	g_pcap_option.fsize_limit = DEFAULT_FILE_LIMIT;
+	g_pcap_option.nof_receivers = 1;
 
 	/* Check options of application */
 	while ((opt = getopt_long(argc, argvopt, "c:s:", lgopts,
@@ -357,24 +537,34 @@ parse_app_args(int argc, char *argv[])
 				return SPPWK_RET_NG;
 			}
 			break;
+		case SPP_LONGOPT_RETVAL_RECEIVERS:
+			if (parse_nof_receivers(optarg,
+					&g_pcap_option.nof_receivers) !=
+					SPPWK_RET_OK) {
+				usage(progname);
+				return SPPWK_RET_NG;
+			}
+			break;
 		case 'c':  /* captured port */
-			strcpy(cap_port_str, optarg);
 			if (parse_captured_port(optarg, optind,
-					argcopt, argvopt,
-					&g_pcap_option.port_cap.iface_type,
-					&g_pcap_option.port_cap.iface_no,
-					&g_pcap_option.port_cap.queue_no) !=
+					argcopt, argvopt, &cap_type,
+					&cap_no, &cap_queue) !=
 					SPPWK_RET_OK) {
 				usage(progname);
 				return SPPWK_RET_NG;
 			}
-			if (get_port_max_queues(
-				g_pcap_option.port_cap.iface_type,
-				g_pcap_option.port_cap.iface_no) > 1) {
-				snprintf(cap_port_str, PORT_STR_SIZE,
-					"%s nq %d",
-					optarg,
-					g_pcap_option.port_cap.queue_no);
+			if (cap_queue < 0)
+				nof_queues = get_port_max_queues(cap_type,
+						cap_no);
+			else
+				nof_queues = 1;
+			for (cnt = 0; cnt < nof_queues; cnt++) {
+				if (add_cap_iface(optarg, cap_type, cap_no,
+						cap_queue < 0 ? cnt :
+						cap_queue) != SPPWK_RET_OK) {
+					usage(progname);
+					return SPPWK_RET_NG;
+				}
 			}
 			port_flg = 1;
 			break;
@@ -400,12 +590,25 @@ parse_app_args(int argc, char *argv[])
 		return SPPWK_RET_NG;
 	}
 
+	/* Each of receivers should have captured ports at least one */
+	if (g_pcap_option.nof_receivers > g_pcap_option.nof_cap_ifaces) {
+		RTE_LOG(ERR, SPP_PCAP, "Receivers %d exceeds captured "
+				"ports %d.\n", g_pcap_option.nof_receivers,
+				g_pcap_option.nof_cap_ifaces);
+		usage(progname);
+		return SPPWK_RET_NG;
+	}
+
 	RTE_LOG(INFO, SPP_PCAP,
 			"Parsed app args ('--client-id %d', '-s %s:%d', "
-			"'-c %s', '--out-dir %s', '--fsize %ld')\n",
-			cli_id, ctl_ip, ctl_port, cap_port_str,
+			"'--out-dir %s', '--fsize %ld', '--receivers %d')\n",
+			cli_id, ctl_ip, ctl_port,
 			g_pcap_option.compress_file_path,
-			g_pcap_option.fsize_limit);
+			g_pcap_option.fsize_limit,
+			g_pcap_option.nof_receivers);
+	for (cnt = 0; cnt < g_pcap_option.nof_cap_ifaces; cnt++)
+		RTE_LOG(INFO, SPP_PCAP, "Captured port %d is '%s'\n",
+				cnt, g_pcap_option.cap_ifaces[cnt].name);
 	return SPPWK_RET_OK;
 }
 
@@ -422,22 +625,29 @@ spp_pcap_get_core_status(
 	char role_type[8];
 	struct pcap_mng_info *info = &g_pcap_info[lcore_id];
 	char name[PCAP_FPATH_STRLEN + PCAP_FDATE_STRLEN];
-	struct sppwk_port_idx rx_ports[1];
+	struct sppwk_port_idx rx_ports[PCAP_MAX_IFACES];
+	struct sppwk_port_info *port;
 	int rx_num = 0;
+	int if_id;
 	int res;
 
 	RTE_LOG(DEBUG, SPP_PCAP, "status core[%d]\n", lcore_id);
 	if (info->type == PCAP_RECEIVE) {
 		memset(rx_ports, 0x00, sizeof(rx_ports));
-		rx_ports[0].iface_type = g_pcap_option.port_cap.iface_type;
-		rx_ports[0].iface_no   = g_pcap_option.port_cap.iface_no;
-		rx_ports[0].queue_no   = g_pcap_option.port_cap.queue_no;
-		rx_num = 1;
+		for (if_id = info->thread_no;
+				if_id < g_pcap_option.nof_cap_ifaces;
+				if_id += g_pcap_option.nof_receivers) {
+			port = &g_pcap_option.cap_ifaces[if_id].port;
+			rx_ports[rx_num].iface_type = port->iface_type;
+			rx_ports[rx_num].iface_no   = port->iface_no;
+			rx_ports[rx_num].queue_no   = port->queue_no;
+			rx_num++;
+		}
 		strcpy(role_type, "receive");
 	}
 	if (info->type == PCAP_WRITE) {
 		memset(name, 0x00, sizeof(name));
-		if (info->compress_fp != NULL)
+		if (info->is_open)
 			snprintf(name, sizeof(name) - 1, "%s/%s",
 					g_pcap_option.compress_file_path,
 					info->compress_file_name);
@@ -446,22 +656,20 @@ spp_pcap_get_core_status(
 
 	/* Set information with specified by the command. */
 	res = (*params->lcore_proc)(params, lcore_id, name, role_type,
-		rx_num, rx_ports, 0, NULL);
+		rx_num, rx_ports, 0, NULL, NULL);
 	if (unlikely(res != 0))
 		return SPPWK_RET_NG;
 
 	return SPPWK_RET_OK;
 }
 
-/* write compressed data into file  */
-static int output_pcap_file(FILE *compress_fp, void *srcbuf, size_t write_len)
+/* Pass compressed data to I/O thread to be written into file. */
+static int output_pcap_file(struct pcap_io_stream *io, void *srcbuf,
+			    size_t write_len)
 {
-	size_t write_size;
-
 	if (write_len == 0)
 		return SPPWK_RET_OK;
-	write_size = fwrite(srcbuf, write_len, 1, compress_fp);
-	if (write_size != 1) {
+	if (pcap_io_write(io, srcbuf, write_len) != SPPWK_RET_OK) {
 		RTE_LOG(ERR, SPP_PCAP, "file write error len=%lu\n",
 								write_len);
 		return SPPWK_RET_NG;
@@ -484,13 +692,348 @@ static int output_lz4_pcap_file(struct pcap_mng_info *info,
 		return SPPWK_RET_NG;
 	}
 	RTE_LOG(DEBUG, SPP_PCAP, "src len=%d\n", src_len);
-	if (output_pcap_file(info->compress_fp, info->outbuff,
+	if (output_pcap_file(info->io, info->outbuff,
 						compress_len) != 0)
 		return SPPWK_RET_NG;
 
 	return SPPWK_RET_OK;
 }
 
+/* Compress and write records in staging buffer. */
+static int flush_stage(struct pcap_mng_info *info)
+{
+	int ret;
+
+	if (info->stage_len == 0)
+		return SPPWK_RET_OK;
+	ret = output_lz4_pcap_file(info, info->stage, info->stage_len);
+	info->stage_len = 0;
+	return ret;
+}
+
+/**
+ * Append data to staging buffer. It is compressed and written each time
+ * the buffer is filled, so that LZ4 compresses a whole block at once.
+ */
+static int stage_pcap_data(struct pcap_mng_info *info,
+			   const void *src, size_t len)
+{
+	size_t room;
+
+	while (len > 0) {
+		room = PCAP_STAGE_SIZE - info->stage_len;
+		if (room > len)
+			room = len;
+		rte_memcpy((char *)info->stage + info->stage_len, src, room);
+		info->stage_len += room;
+		src = (const char *)src + room;
+		len -= room;
+
+		if (info->stage_len == PCAP_STAGE_SIZE &&
+				flush_stage(info) != SPPWK_RET_OK)
+			return SPPWK_RET_NG;
+	}
+	return SPPWK_RET_OK;
+}
+
+/* Release buffers for compression and staging. */
+static void free_write_buffers(struct pcap_mng_info *info)
+{
+	free(info->outbuff);
+	info->outbuff = NULL;
+	free(info->stage);
+	info->stage = NULL;
+	info->stage_len = 0;
+}
+
+/**
+ * Take NIC clock at the same time as TSC of receiver to estimate its
+ * frequency from the TSC elapsed since the capture started.
+ */
+static void sync_nic_clock(struct pcap_nic_clock *nic, uint16_t port_id,
+			   const struct pcap_rx_clock *clk, int init)
+{
+	uint64_t ticks = 0;
+
+	if (init) {
+		nic->ns_per_tick = 0;
+		nic->has_clock = (rte_eth_read_clock(port_id, &ticks) == 0);
+		nic->start = ticks;
+	} else if (!nic->has_clock)
+		return;
+	else if (rte_eth_read_clock(port_id, &ticks) != 0) {
+		nic->ns_per_tick = 0;
+		return;
+	} else if (ticks != nic->start) {
+		nic->ns_per_tick = (double)(clk->base_tsc - clk->start_tsc) *
+			NS_PER_SEC / clk->tsc_hz / (double)(ticks - nic->start);
+	}
+	nic->base = ticks;
+}
+
+/**
+ * Take CLOCK_REALTIME and TSC as base of timestamp, and NIC clocks of ports
+ * captured by the receiver `rx_no`.
+ */
+static void sync_rx_clock(struct pcap_rx_clock *clk, int rx_no, int init)
+{
+	struct pcap_cap_iface *cap;
+	struct timespec now;
+	int i;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	clk->base_tsc = rte_rdtsc();
+	clk->base_ns = (uint64_t)now.tv_sec * NS_PER_SEC + now.tv_nsec;
+	if (init) {
+		clk->tsc_hz = rte_get_tsc_hz();
+		clk->start_tsc = clk->base_tsc;
+	}
+
+	for (i = rx_no; i < g_pcap_option.nof_cap_ifaces;
+			i += g_pcap_option.nof_receivers) {
+		cap = &g_pcap_option.cap_ifaces[i];
+		sync_nic_clock(&cap->nic_clock, cap->port.ethdev_port_id,
+				clk, init);
+	}
+	clk->next_sync = clk->base_tsc +
+		clk->tsc_hz * RX_CLOCK_SYNC_INTERVAL;
+}
+
+/**
+ * Stamp received packets with time in nanosec and interface ID. RX
+ * timestamp of NIC is used if it is given, or TSC read once for the burst
+ * instead.
+ */
+static void stamp_rx_pkts(const struct pcap_rx_clock *clk,
+			  const struct pcap_cap_iface *cap, uint16_t if_id,
+			  struct rte_mbuf **pkts, int nb_pkts)
+{
+	const struct pcap_nic_clock *nic = &cap->nic_clock;
+	uint64_t now_ns;
+	uint64_t *ts;
+	int64_t ticks;
+	int i;
+
+	now_ns = clk->base_ns + (rte_rdtsc() - clk->base_tsc) *
+		NS_PER_SEC / clk->tsc_hz;
+	for (i = 0; i < nb_pkts; i++) {
+		ts = RTE_MBUF_DYNFIELD(pkts[i], g_rx_ts_offset, uint64_t *);
+		if (nic->ns_per_tick > 0 &&
+				(pkts[i]->ol_flags & PKT_RX_TIMESTAMP)) {
+			ticks = (int64_t)(pkts[i]->timestamp - nic->base);
+			*ts = clk->base_ns +
+				(int64_t)(ticks * nic->ns_per_tick);
+		} else
+			*ts = now_ns;
+		*RTE_MBUF_DYNFIELD(pkts[i], g_rx_if_offset, uint16_t *) =
+			if_id;
+	}
+}
+
+/* Append an option of pcapng block to `buf`, and return its length. */
+static size_t put_pcapng_opt(char *buf, uint16_t code, const void *val,
+			     uint16_t len)
+{
+	struct pcapng_opt_header opt;
+	size_t pad_len = RTE_ALIGN(len, 4) - len;
+
+	opt.code = code;
+	opt.len = len;
+	memcpy(buf, &opt, sizeof(opt));
+	if (len > 0)
+		memcpy(buf + sizeof(opt), val, len);
+	memset(buf + sizeof(opt) + len, 0, pad_len);
+	return sizeof(opt) + len + pad_len;
+}
+
+/* Append a pcapng block consisting of body and options to staging buffer */
+static int stage_pcapng_block(struct pcap_mng_info *info, uint32_t type,
+			      const void *body, size_t body_len,
+			      const void *opts, size_t opts_len)
+{
+	struct pcapng_block_header hdr;
+	uint32_t block_len;
+
+	block_len = sizeof(hdr) + body_len + opts_len + sizeof(block_len);
+	hdr.block_type = type;
+	hdr.block_len = block_len;
+	if (stage_pcap_data(info, &hdr, sizeof(hdr)) != SPPWK_RET_OK ||
+			stage_pcap_data(info, body, body_len) !=
+			SPPWK_RET_OK ||
+			stage_pcap_data(info, opts, opts_len) !=
+			SPPWK_RET_OK ||
+			stage_pcap_data(info, &block_len,
+				sizeof(block_len)) != SPPWK_RET_OK)
+		return SPPWK_RET_NG;
+
+	info->file_size += block_len;
+	return SPPWK_RET_OK;
+}
+
+/* Append SHB and IDBs of all of captured ports at the head of file. */
+static int stage_pcapng_headers(struct pcap_mng_info *info)
+{
+	struct pcapng_shb shb;
+	struct pcapng_idb idb;
+	struct pcap_cap_iface *cap;
+	char opts[PCAPNG_OPT_BUFSZ + SPPWK_FILTER_BUFSZ];
+	char filter[SPPWK_FILTER_BUFSZ + 1];
+	uint8_t tsresol = PCAPNG_TSRESOL_NS;
+	size_t opts_len;
+	int i;
+
+	shb.magic_number = PCAPNG_BYTE_ORDER_MAGIC;
+	shb.major_ver = PCAPNG_VERSION_MAJOR;
+	shb.minor_ver = PCAPNG_VERSION_MINOR;
+	shb.section_len = -1;
+	if (stage_pcapng_block(info, PCAPNG_BT_SHB, &shb, sizeof(shb),
+				NULL, 0) != SPPWK_RET_OK)
+		return SPPWK_RET_NG;
+
+	/* Interface ID is the index of captured ports */
+	idb.linktype = PCAP_LINKTYPE;
+	idb.reserved = 0;
+	idb.snaplen = info->snaplen;
+
+	/* Filter option starts with 0 which means expression of libpcap */
+	filter[0] = 0;
+	strcpy(filter + 1, info->filter);
+	for (i = 0; i < g_pcap_option.nof_cap_ifaces; i++) {
+		cap = &g_pcap_option.cap_ifaces[i];
+		opts_len = put_pcapng_opt(opts, PCAPNG_OPT_IF_NAME,
+				cap->name, strlen(cap->name));
+		opts_len += put_pcapng_opt(opts + opts_len,
+				PCAPNG_OPT_IF_TSRESOL, &tsresol,
+				sizeof(tsresol));
+		if (info->filter[0] != '\0')
+			opts_len += put_pcapng_opt(opts + opts_len,
+					PCAPNG_OPT_IF_FILTER, filter,
+					strlen(info->filter) + 1);
+		opts_len += put_pcapng_opt(opts + opts_len,
+				PCAPNG_OPT_ENDOFOPT, NULL, 0);
+		if (stage_pcapng_block(info, PCAPNG_BT_IDB, &idb,
+				sizeof(idb), opts, opts_len) != SPPWK_RET_OK)
+			return SPPWK_RET_NG;
+	}
+	return SPPWK_RET_OK;
+}
+
+/**
+ * Append ISBs of captured ports of which packets are written in the file
+ * at the end of it. Counters are of receiver since the capture started,
+ * and include packets written by other writers.
+ */
+static int stage_pcapng_stats(struct pcap_mng_info *info)
+{
+	struct pcapng_isb isb;
+	struct pcap_cap_iface *cap;
+	struct timespec now;
+	char opts[PCAPNG_OPT_BUFSZ];
+	size_t opts_len;
+	uint64_t ts, cnt;
+	int i;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	ts = (uint64_t)now.tv_sec * NS_PER_SEC + now.tv_nsec;
+	isb.ts_high = (uint32_t)(ts >> 32);
+	isb.ts_low = (uint32_t)ts;
+	for (i = 0; i < g_pcap_option.nof_cap_ifaces; i++) {
+		if ((info->if_mask & (1U << i)) == 0)
+			continue;
+		cap = &g_pcap_option.cap_ifaces[i];
+		isb.if_id = i;
+		cnt = cap->nof_rx;
+		opts_len = put_pcapng_opt(opts, PCAPNG_OPT_ISB_IFRECV,
+				&cnt, sizeof(cnt));
+		cnt = cap->nof_drop;
+		opts_len += put_pcapng_opt(opts + opts_len,
+				PCAPNG_OPT_ISB_OSDROP, &cnt, sizeof(cnt));
+		if (info->filter[0] != '\0') {
+			cnt = cap->nof_accept;
+			opts_len += put_pcapng_opt(opts + opts_len,
+					PCAPNG_OPT_ISB_FILTERACCEPT, &cnt,
+					sizeof(cnt));
+		}
+		opts_len += put_pcapng_opt(opts + opts_len,
+				PCAPNG_OPT_ENDOFOPT, NULL, 0);
+		if (stage_pcapng_block(info, PCAPNG_BT_ISB, &isb,
+				sizeof(isb), opts, opts_len) != SPPWK_RET_OK)
+			return SPPWK_RET_NG;
+	}
+	return SPPWK_RET_OK;
+}
+
+/**
+ * Set name of capture file from date, captured port, thread and file no.
+ * Captured port is `multi` if several ports are captured.
+ */
+static void set_file_name(struct pcap_mng_info *info)
+{
+	const struct sppwk_port_info *port;
+	const char *iface_type_str;
+	char port_str[PORT_STR_SIZE * 2];
+
+	port = &g_pcap_option.cap_ifaces[0].port;
+	if (port->iface_type == PHY)
+		iface_type_str = SPPWK_PHY_STR;
+	else
+		iface_type_str = SPPWK_RING_STR;
+
+	if (g_pcap_option.nof_cap_ifaces > 1)
+		strcpy(port_str, "multi");
+	else if (get_port_max_queues(port->iface_type, port->iface_no) > 1)
+		/* If multi-queue, add queue_no */
+		snprintf(port_str, sizeof(port_str), "%s%dnq%d",
+				iface_type_str, port->iface_no,
+				port->queue_no);
+	else
+		snprintf(port_str, sizeof(port_str), "%s%d",
+				iface_type_str, port->iface_no);
+
+	snprintf(info->compress_file_name, PCAP_FNAME_STRLEN - 1,
+			"spp_pcap.%s.%s.%u.%u.pcapng.lz4",
+			g_pcap_option.compress_file_date, port_str,
+			info->thread_no, info->file_no);
+}
+
+/**
+ * Write the rest of records and the end of LZ4 frame, and request I/O
+ * thread to close and rename the file.
+ */
+static int close_pcap_file(struct pcap_mng_info *info)
+{
+	size_t compress_len;
+	int ret = SPPWK_RET_OK;
+
+	/* flush whatever remains within internal buffers */
+	if (stage_pcapng_stats(info) != SPPWK_RET_OK ||
+			flush_stage(info) != SPPWK_RET_OK) {
+		RTE_LOG(ERR, SPP_PCAP, "Failed to flush records.\n");
+		ret = SPPWK_RET_NG;
+	}
+	compress_len = LZ4F_compressEnd(info->ctx, info->outbuff,
+				info->outbuf_capacity, NULL);
+	if (LZ4F_isError(compress_len)) {
+		RTE_LOG(ERR, SPP_PCAP, "Failed to end compression: "
+				"error %zd\n", compress_len);
+		ret = SPPWK_RET_NG;
+	} else if (output_pcap_file(info->io, info->outbuff,
+					compress_len) != SPPWK_RET_OK) {
+		ret = SPPWK_RET_NG;
+	} else {
+		info->file_size += compress_len;
+	}
+
+	/* file is renamed on I/O thread after remained data is written */
+	if (pcap_io_close(info->io) != SPPWK_RET_OK) {
+		RTE_LOG(ERR, SPP_PCAP, "Failed to close %s\n",
+				info->compress_file_name);
+		ret = SPPWK_RET_NG;
+	}
+	info->is_open = 0;
+	return ret;
+}
+
 /**
  * File compression operation. There are three mode.
  * Open and update and close.
@@ -498,184 +1041,88 @@ static int output_lz4_pcap_file(struct pcap_mng_info *info,
 static int file_compression_operation(struct pcap_mng_info *info,
 				   enum comp_file_generate_mode mode)
 {
-	struct pcap_header pcap_h;
 	size_t ctxCreation;
 	size_t headerSize;
-	size_t compress_len;
-	char temp_file[PCAP_FPATH_STRLEN + PCAP_FNAME_STRLEN];
 	char save_file[PCAP_FPATH_STRLEN + PCAP_FNAME_STRLEN];
-	const char *iface_type_str;
 
 	if (mode == INIT_MODE) { /* initial generation mode */
 		/* write buffer size get */
-		info->outbuf_capacity = LZ4F_compressBound(IN_CHUNK_SIZE,
+		info->outbuf_capacity = LZ4F_compressBound(PCAP_STAGE_SIZE,
 								&g_kprefs);
 		/* write buff allocation */
 		info->outbuff = malloc(info->outbuf_capacity);
+		info->stage = malloc(PCAP_STAGE_SIZE);
+		info->stage_len = 0;
+		if (info->outbuff == NULL || info->stage == NULL) {
+			RTE_LOG(ERR, SPP_PCAP,
+					"Failed to alloc write buffers.\n");
+			free_write_buffers(info);
+			return SPPWK_RET_NG;
+		}
+
+		/* init lz4 stream, which is reused for each of files */
+		if (info->ctx == NULL) {
+			ctxCreation = LZ4F_createCompressionContext(&info->ctx,
+					LZ4F_VERSION);
+			if (LZ4F_isError(ctxCreation)) {
+				RTE_LOG(ERR, SPP_PCAP,
+					"LZ4F_createCompressionContext error "
+					"(%zd)\n", ctxCreation);
+				info->ctx = NULL;
+				free_write_buffers(info);
+				return SPPWK_RET_NG;
+			}
+		}
+
+		/* Params are kept until the capture is stopped */
+		info->snaplen = g_capture_snaplen;
+		strcpy(info->filter, g_capture_filter_expr);
 
 		/* Initialize pcap file name */
 		info->file_size = 0;
 		info->file_no = 1;
-		if (g_pcap_option.port_cap.iface_type == PHY)
-			iface_type_str = SPPWK_PHY_STR;
-		else
-			iface_type_str = SPPWK_RING_STR;
-
-		if (get_port_max_queues(
-			g_pcap_option.port_cap.iface_type,
-			g_pcap_option.port_cap.iface_no) > 1)
-			/* If multi-queue, add queue_no */
-			snprintf(info->compress_file_name,
-					PCAP_FNAME_STRLEN - 1,
-					"spp_pcap.%s.%s%dnq%d.%u.%u.pcap.lz4",
-					g_pcap_option.compress_file_date,
-					iface_type_str,
-					g_pcap_option.port_cap.iface_no,
-					g_pcap_option.port_cap.queue_no,
-					info->thread_no,
-					info->file_no);
-		else
-			snprintf(info->compress_file_name,
-					PCAP_FNAME_STRLEN - 1,
-					"spp_pcap.%s.%s%d.%u.%u.pcap.lz4",
-					g_pcap_option.compress_file_date,
-					iface_type_str,
-					g_pcap_option.port_cap.iface_no,
-					info->thread_no,
-					info->file_no);
+		set_file_name(info);
 	} else if (mode == UPDATE_MODE) { /* update generation mode */
 		/* old compress file close */
-		/* flush whatever remains within internal buffers */
-		compress_len = LZ4F_compressEnd(info->ctx, info->outbuff,
-					info->outbuf_capacity, NULL);
-		if (LZ4F_isError(compress_len)) {
-			RTE_LOG(ERR, SPP_PCAP, "Failed to end compression: "
-					"error %zd\n", compress_len);
-			fclose(info->compress_fp);
-			info->compress_fp = NULL;
-			free(info->outbuff);
-			return SPPWK_RET_NG;
-		}
-		if (output_pcap_file(info->compress_fp, info->outbuff,
-						compress_len) != SPPWK_RET_OK) {
-			fclose(info->compress_fp);
-			info->compress_fp = NULL;
-			free(info->outbuff);
+		if (close_pcap_file(info) != SPPWK_RET_OK) {
+			free_write_buffers(info);
 			return SPPWK_RET_NG;
 		}
 
-		/* flush remained data */
-		fclose(info->compress_fp);
-		info->compress_fp = NULL;
-
-		/* rename temporary file */
-		memset(temp_file, 0,
-			PCAP_FPATH_STRLEN + PCAP_FNAME_STRLEN);
-		memset(save_file, 0,
-			PCAP_FPATH_STRLEN + PCAP_FNAME_STRLEN);
-		snprintf(temp_file,
-		    (PCAP_FPATH_STRLEN + PCAP_FNAME_STRLEN) - 1,
-		    "%s/%s.tmp", g_pcap_option.compress_file_path,
-		    info->compress_file_name);
-		snprintf(save_file,
-		    (PCAP_FPATH_STRLEN + PCAP_FNAME_STRLEN) - 1,
-		    "%s/%s", g_pcap_option.compress_file_path,
-		    info->compress_file_name);
-		rename(temp_file, save_file);
-
 		/* Initialize pcap file name */
 		info->file_size = 0;
 		info->file_no++;
-		if (g_pcap_option.port_cap.iface_type == PHY)
-			iface_type_str = SPPWK_PHY_STR;
-		else
-			iface_type_str = SPPWK_RING_STR;
-
-		if (get_port_max_queues(
-			g_pcap_option.port_cap.iface_type,
-			g_pcap_option.port_cap.iface_no) > 1)
-			/* If multi-queue, add queue_no */
-			snprintf(info->compress_file_name,
-					PCAP_FNAME_STRLEN - 1,
-					"spp_pcap.%s.%s%dnq%d.%u.%u.pcap.lz4",
-					g_pcap_option.compress_file_date,
-					iface_type_str,
-					g_pcap_option.port_cap.iface_no,
-					g_pcap_option.port_cap.queue_no,
-					info->thread_no,
-					info->file_no);
-		else
-			snprintf(info->compress_file_name,
-					PCAP_FNAME_STRLEN - 1,
-					"spp_pcap.%s.%s%d.%u.%u.pcap.lz4",
-					g_pcap_option.compress_file_date,
-					iface_type_str,
-					g_pcap_option.port_cap.iface_no,
-					info->thread_no,
-					info->file_no);
+		set_file_name(info);
 	} else { /* close mode */
 		/* Close temporary file and rename to persistent */
-		if (info->compress_fp == NULL)
+		if (!info->is_open)
 			return SPPWK_RET_OK;
-		compress_len = LZ4F_compressEnd(info->ctx, info->outbuff,
-					info->outbuf_capacity, NULL);
-		if (LZ4F_isError(compress_len)) {
-			RTE_LOG(ERR, SPP_PCAP, "Failed to end compression: "
-					"error %zd\n", compress_len);
-		} else {
-			output_pcap_file(info->compress_fp, info->outbuff,
-								compress_len);
-			info->file_size += compress_len;
-		}
-		/* flush remained data */
-		fclose(info->compress_fp);
-
-		/* rename temporary file */
-		memset(temp_file, 0,
-			PCAP_FPATH_STRLEN + PCAP_FNAME_STRLEN);
-		memset(save_file, 0,
-			PCAP_FPATH_STRLEN + PCAP_FNAME_STRLEN);
-		snprintf(temp_file,
-		    (PCAP_FPATH_STRLEN + PCAP_FNAME_STRLEN) - 1,
-		    "%s/%s.tmp", g_pcap_option.compress_file_path,
-		    info->compress_file_name);
-		snprintf(save_file,
-		    (PCAP_FPATH_STRLEN + PCAP_FNAME_STRLEN) - 1,
-		    "%s/%s", g_pcap_option.compress_file_path,
-		    info->compress_file_name);
-		rename(temp_file, save_file);
-
-		info->compress_fp = NULL;
-		free(info->outbuff);
+		close_pcap_file(info);
+		free_write_buffers(info);
 		return SPPWK_RET_OK;
 	}
 
-	/* file open */
-	memset(temp_file, 0,
-		PCAP_FPATH_STRLEN + PCAP_FNAME_STRLEN);
-	snprintf(temp_file,
-		(PCAP_FPATH_STRLEN + PCAP_FNAME_STRLEN) - 1,
-		"%s/%s.tmp", g_pcap_option.compress_file_path,
+	/* file open, temporary file is created on I/O thread */
+	memset(save_file, 0, PCAP_FPATH_STRLEN + PCAP_FNAME_STRLEN);
+	snprintf(save_file, (PCAP_FPATH_STRLEN + PCAP_FNAME_STRLEN) - 1,
+		"%s/%s", g_pcap_option.compress_file_path,
 		info->compress_file_name);
-	RTE_LOG(INFO, SPP_PCAP, "open compress filename=%s\n", temp_file);
-	info->compress_fp = fopen(temp_file, "wb");
-	if (info->compress_fp == NULL) {
+	RTE_LOG(INFO, SPP_PCAP, "open compress filename=%s\n", save_file);
+	if (pcap_io_open(info->io, save_file) != SPPWK_RET_OK) {
 		RTE_LOG(ERR, SPP_PCAP, "file open error! filename=%s\n",
 						info->compress_file_name);
-		free(info->outbuff);
+		free_write_buffers(info);
 		return SPPWK_RET_NG;
 	}
 
-	/* init lz4 stream */
-	ctxCreation = LZ4F_createCompressionContext(&info->ctx, LZ4F_VERSION);
-	if (LZ4F_isError(ctxCreation)) {
-		RTE_LOG(ERR, SPP_PCAP, "LZ4F_createCompressionContext error "
-						"(%zd)\n", ctxCreation);
-		fclose(info->compress_fp);
-		info->compress_fp = NULL;
-		free(info->outbuff);
+	/* Wait for the first file to be opened to report failure */
+	if (mode == INIT_MODE && pcap_io_wait(info->io) != SPPWK_RET_OK) {
+		RTE_LOG(ERR, SPP_PCAP, "file open error! filename=%s\n",
+						info->compress_file_name);
+		free_write_buffers(info);
 		return SPPWK_RET_NG;
 	}
+	info->is_open = 1;
 
 	/* write compress frame header */
 	headerSize = LZ4F_compressBegin(info->ctx, info->outbuff,
@@ -683,56 +1130,50 @@ static int file_compression_operation(struct pcap_mng_info *info,
 	if (LZ4F_isError(headerSize)) {
 		RTE_LOG(ERR, SPP_PCAP, "Failed to start compression: "
 					"error %zd\n", headerSize);
-		fclose(info->compress_fp);
-		info->compress_fp = NULL;
-		free(info->outbuff);
+		pcap_io_close(info->io);
+		info->is_open = 0;
+		free_write_buffers(info);
 		return SPPWK_RET_NG;
 	}
 	RTE_LOG(DEBUG, SPP_PCAP, "Buffer size is %zd bytes, header size %zd "
 			"bytes\n", info->outbuf_capacity, headerSize);
-	if (output_pcap_file(info->compress_fp, info->outbuff,
+	if (output_pcap_file(info->io, info->outbuff,
 						headerSize) != 0) {
-		fclose(info->compress_fp);
-		info->compress_fp = NULL;
-		free(info->outbuff);
+		pcap_io_close(info->io);
+		info->is_open = 0;
+		free_write_buffers(info);
 		return SPPWK_RET_NG;
 	}
 	info->file_size = headerSize;
 
-	/* init the common pcap header */
-	pcap_h.magic_number = TCPDUMP_MAGIC;
-	pcap_h.major_ver = PCAP_VERSION_MAJOR;
-	pcap_h.minor_ver = PCAP_VERSION_MINOR;
-	pcap_h.thiszone = 0;
-	pcap_h.sigfigs = 0;
-	pcap_h.snaplen = PCAP_SNAPLEN_MAX;
-	pcap_h.network = PCAP_LINKTYPE;
-
-	/* pcap header write */
-	if (output_lz4_pcap_file(info, &pcap_h, sizeof(struct pcap_header))
-							!= SPPWK_RET_OK) {
-		RTE_LOG(ERR, SPP_PCAP, "pcap header write  error!\n");
-		fclose(info->compress_fp);
-		info->compress_fp = NULL;
-		free(info->outbuff);
+	/* pcapng header write */
+	info->if_mask = 0;
+	if (stage_pcapng_headers(info) != SPPWK_RET_OK) {
+		RTE_LOG(ERR, SPP_PCAP, "pcapng header write  error!\n");
+		pcap_io_close(info->io);
+		info->is_open = 0;
+		free_write_buffers(info);
 		return SPPWK_RET_NG;
 	}
 
 	return SPPWK_RET_OK;
 }
 
-/* compress packet data */
+/* Append packet as an EPB to staging buffer */
 static int compress_file_packet(struct pcap_mng_info *info,
 				struct rte_mbuf *cap_pkt)
 {
 	unsigned int write_packet_length;
 	unsigned int packet_length;
-	struct timespec cap_time;
-	struct pcap_packet_header pcap_packet_h;
+	uint64_t cap_time;
+	struct pcapng_block_header block_h;
+	struct pcapng_epb epb;
+	static const char padding[4];
+	unsigned int pad_len;
 	unsigned int remaining_bytes;
 	int bytes_to_write;
 
-	if (info->compress_fp == NULL)
+	if (!info->is_open)
 		return SPPWK_RET_OK;
 
 	/* capture file rool */
@@ -746,38 +1187,43 @@ static int compress_file_packet(struct pcap_mng_info *info,
 	packet_length = rte_pktmbuf_pkt_len(cap_pkt);
 
 	/* truncate packet over the maximum length */
-	write_packet_length = TRANCATE_SNAPLEN(PCAP_SNAPLEN_MAX,
+	write_packet_length = TRANCATE_SNAPLEN(info->snaplen,
 							packet_length);
 
-	/* get time */
-	clock_gettime(CLOCK_REALTIME, &cap_time);
-
-	/* write block header */
-	pcap_packet_h.ts_sec = (int32_t)cap_time.tv_sec;
-	pcap_packet_h.ts_usec = (int32_t)(cap_time.tv_nsec / 1000);
-	pcap_packet_h.write_len = write_packet_length;
-	pcap_packet_h.packet_len = packet_length;
-
-	/* output to lz4_pcap_file */
-	if (output_lz4_pcap_file(info, &pcap_packet_h.ts_sec,
-			sizeof(struct pcap_packet_header)) != SPPWK_RET_OK) {
+	/* timestamp and interface given on receiver */
+	cap_time = *RTE_MBUF_DYNFIELD(cap_pkt, g_rx_ts_offset, uint64_t *);
+	epb.if_id = *RTE_MBUF_DYNFIELD(cap_pkt, g_rx_if_offset, uint16_t *);
+	info->if_mask |= 1U << epb.if_id;
+
+	/* write block header, packet data is padded to 32 bits boundary */
+	epb.ts_high = (uint32_t)(cap_time >> 32);
+	epb.ts_low = (uint32_t)cap_time;
+	epb.cap_len = write_packet_length;
+	epb.orig_len = packet_length;
+	pad_len = RTE_ALIGN(write_packet_length, 4) - write_packet_length;
+	block_h.block_type = PCAPNG_BT_EPB;
+	block_h.block_len = sizeof(block_h) + sizeof(epb) +
+		write_packet_length + pad_len + sizeof(block_h.block_len);
+
+	if (stage_pcap_data(info, &block_h, sizeof(block_h)) !=
+			SPPWK_RET_OK ||
+			stage_pcap_data(info, &epb, sizeof(epb)) !=
+			SPPWK_RET_OK) {
 		file_compression_operation(info, CLOSE_MODE);
 		return SPPWK_RET_NG;
 	}
-	info->file_size += sizeof(struct pcap_packet_header);
+	info->file_size += sizeof(block_h) + sizeof(epb);
 
 	/* write content */
 	remaining_bytes = write_packet_length;
 	while (cap_pkt != NULL && remaining_bytes > 0) {
-		/* write file */
 		bytes_to_write = TRANCATE_SNAPLEN(
 					rte_pktmbuf_data_len(cap_pkt),
 					remaining_bytes);
 
-		/* output to lz4_pcap_file */
-		if (output_lz4_pcap_file(info,
-				rte_pktmbuf_mtod(cap_pkt, void*),
-						bytes_to_write) != 0) {
+		if (stage_pcap_data(info,
+				rte_pktmbuf_mtod(cap_pkt, void *),
+				bytes_to_write) != SPPWK_RET_OK) {
 			file_compression_operation(info, CLOSE_MODE);
 			return SPPWK_RET_NG;
 		}
@@ -786,9 +1232,40 @@ static int compress_file_packet(struct pcap_mng_info *info,
 		info->file_size += bytes_to_write;
 	}
 
+	/* write padding and block trailer */
+	if (stage_pcap_data(info, padding, pad_len) != SPPWK_RET_OK ||
+			stage_pcap_data(info, &block_h.block_len,
+				sizeof(block_h.block_len)) != SPPWK_RET_OK) {
+		file_compression_operation(info, CLOSE_MODE);
+		return SPPWK_RET_NG;
+	}
+	info->file_size += pad_len + sizeof(block_h.block_len);
+
 	return SPPWK_RET_OK;
 }
 
+/**
+ * Move packets matched with capture filter to the head of `pkts`, and free
+ * the rest of packets before enqueueing to ring.
+ */
+static uint16_t filter_rx_pkts(const struct sppwk_pkt_filter *filter,
+			       struct rte_mbuf **pkts, uint16_t nb_pkts)
+{
+	struct rte_mbuf *matched[MAX_PCAP_BURST];
+	uint16_t nb_match;
+	uint16_t i, j = 0;
+
+	nb_match = sppwk_pkt_filter_burst(filter, pkts, matched, nb_pkts);
+	for (i = 0; i < nb_pkts; i++) {
+		if (j < nb_match && pkts[i] == matched[j])
+			j++;
+		else
+			rte_pktmbuf_free(pkts[i]);
+	}
+	memcpy(pkts, matched, sizeof(*pkts) * nb_match);
+	return nb_match;
+}
+
 /* Receive packets from shared ring buffer */
 static int pcap_proc_receive(int lcore_id)
 {
@@ -797,79 +1274,116 @@ static int pcap_proc_receive(int lcore_id)
 	int buf;
 	int nb_rx = 0;
 	int nb_tx = 0;
-	struct sppwk_port_info *rx;
+	int if_id;
+	struct pcap_cap_iface *cap;
 	struct rte_mbuf *bufs[MAX_PCAP_BURST];
 	struct pcap_mng_info *info = &g_pcap_info[lcore_id];
-	struct rte_ring *write_ring = g_pcap_option.cap_ring;
-	static long long total_rx;
-	static long long total_drop;
+	struct rte_ring *write_ring = info->ring;
+	const int rx_no = info->thread_no;
+	const int nof_rx = g_pcap_option.nof_receivers;
 
 	if (g_capture_request == SPP_CAPTURE_IDLE) {
 		if (info->status == SPP_CAPTURE_RUNNING) {
 			RTE_LOG(DEBUG, SPP_PCAP,
 					"Recive on lcore %d, run->idle\n",
 					lcore_id);
-			RTE_LOG(INFO, SPP_PCAP,
-					"Recive on lcore %d, total_rx=%llu, "
-					"total_drop=%llu\n", lcore_id,
-					total_rx, total_drop);
+			for (if_id = rx_no;
+					if_id < g_pcap_option.nof_cap_ifaces;
+					if_id += nof_rx) {
+				cap = &g_pcap_option.cap_ifaces[if_id];
+				RTE_LOG(INFO, SPP_PCAP,
+					"Recive on lcore %d, port %s, "
+					"total_rx=%"PRIu64", "
+					"total_drop=%"PRIu64"\n", lcore_id,
+					cap->name, cap->nof_rx,
+					cap->nof_drop);
+			}
 
+			/* Writers are stopped after all of receivers */
 			info->status = SPP_CAPTURE_IDLE;
-			g_capture_status = SPP_CAPTURE_IDLE;
-			if (g_pcap_thread_info.start_up_cnt != 0)
-				g_pcap_thread_info.start_up_cnt -= 1;
+			if (rte_atomic32_dec_and_test(
+					&g_pcap_thread_info.rx_run_cnt))
+				g_capture_status = SPP_CAPTURE_IDLE;
+			if (rte_atomic32_read(
+					&g_pcap_thread_info.start_up_cnt) != 0)
+				rte_atomic32_dec(
+					&g_pcap_thread_info.start_up_cnt);
 		}
 		return SPPWK_RET_OK;
 	}
 	if (info->status == SPP_CAPTURE_IDLE) {
-		/* Get time for output file name */
-		clock_gettime(CLOCK_REALTIME, &cur_time);
-		memset(g_pcap_option.compress_file_date, 0, PCAP_FDATE_STRLEN);
-		localtime_r(&cur_time.tv_sec, &l_time);
-		strftime(g_pcap_option.compress_file_date, PCAP_FDATE_STRLEN,
+		/* Get time for output file name on the first receiver */
+		if (rx_no == 0) {
+			clock_gettime(CLOCK_REALTIME, &cur_time);
+			memset(g_pcap_option.compress_file_date, 0,
+					PCAP_FDATE_STRLEN);
+			localtime_r(&cur_time.tv_sec, &l_time);
+			strftime(g_pcap_option.compress_file_date,
+					PCAP_FDATE_STRLEN,
 					"%Y%m%d%H%M%S", &l_time);
+			g_capture_status = SPP_CAPTURE_RUNNING;
+		}
 		info->status = SPP_CAPTURE_RUNNING;
-		g_capture_status = SPP_CAPTURE_RUNNING;
+		rte_atomic32_inc(&g_pcap_thread_info.rx_run_cnt);
 
 		RTE_LOG(DEBUG, SPP_PCAP,
 				"Recive on lcore %d, idle->run\n", lcore_id);
 		RTE_LOG(DEBUG, SPP_PCAP,
 				"Recive on lcore %d, start time=%s\n",
 				lcore_id, g_pcap_option.compress_file_date);
-		g_pcap_thread_info.start_up_cnt += 1;
-		total_rx = 0;
-		total_drop = 0;
+		rte_atomic32_inc(&g_pcap_thread_info.start_up_cnt);
+		for (if_id = rx_no; if_id < g_pcap_option.nof_cap_ifaces;
+				if_id += nof_rx) {
+			cap = &g_pcap_option.cap_ifaces[if_id];
+			cap->nof_rx = 0;
+			cap->nof_drop = 0;
+			cap->nof_accept = 0;
+		}
+		sync_rx_clock(&info->rx_clock, rx_no, 1);
 	}
 
 	/* Write thread start up wait. */
-	if (g_pcap_thread_info.thread_cnt > g_pcap_thread_info.start_up_cnt)
+	if (g_pcap_thread_info.thread_cnt >
+			rte_atomic32_read(&g_pcap_thread_info.start_up_cnt))
 		return SPPWK_RET_OK;
 
-	/* Receive packets */
-	rx = &g_pcap_option.port_cap;
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
-	nb_rx = sppwk_eth_ring_stats_rx_burst(rx->ethdev_port_id,
-			rx->iface_type, rx->iface_no, 0, bufs, MAX_PCAP_BURST);
-#else
-	nb_rx = rte_eth_rx_burst(rx->ethdev_port_id, rx->queue_no, bufs,
-			MAX_PCAP_BURST);
-#endif
-	if (unlikely(nb_rx == 0))
-		return SPPWK_RET_OK;
+	if (unlikely(rte_rdtsc() >= info->rx_clock.next_sync))
+		sync_rx_clock(&info->rx_clock, rx_no, 0);
+
+	/* Receive packets from each of ports assigned to this receiver */
+	for (if_id = rx_no; if_id < g_pcap_option.nof_cap_ifaces;
+			if_id += nof_rx) {
+		cap = &g_pcap_option.cap_ifaces[if_id];
+		nb_rx = rte_eth_rx_burst(cap->port.ethdev_port_id,
+				cap->port.queue_no, bufs, MAX_PCAP_BURST);
+		if (nb_rx == 0)
+			continue;
+		cap->nof_rx += nb_rx;
+
+		/* Rejected packets are not passed to writers */
+		if (g_capture_filter != NULL) {
+			nb_rx = filter_rx_pkts(g_capture_filter, bufs, nb_rx);
+			cap->nof_accept += nb_rx;
+			if (nb_rx == 0)
+				continue;
+		}
 
-	/* Forward to ring for writer thread */
-	nb_tx = rte_ring_enqueue_burst(write_ring, (void *)bufs, nb_rx, NULL);
+		stamp_rx_pkts(&info->rx_clock, cap, if_id, bufs, nb_rx);
 
-	/* Discard remained packets to release mbuf */
-	if (unlikely(nb_tx < nb_rx)) {
-		RTE_LOG(ERR, SPP_PCAP, "drop packets(receve) %d\n",
+		/* Forward to ring for writer thread */
+		nb_tx = rte_ring_sp_enqueue_burst(write_ring, (void *)bufs,
+				nb_rx, NULL);
+
+		/* Discard remained packets, counted as dropped */
+		if (unlikely(nb_tx < nb_rx)) {
+			RTE_LOG(DEBUG, SPP_PCAP, "drop packets(receve) %d\n",
 							(nb_rx - nb_tx));
-		for (buf = nb_tx; buf < nb_rx; buf++)
-			rte_pktmbuf_free(bufs[buf]);
-	}
+			for (buf = nb_tx; buf < nb_rx; buf++)
+				rte_pktmbuf_free(bufs[buf]);
+		}
 
-	total_rx += nb_rx;
-	total_drop += nb_rx - nb_tx;
+		cap->nof_drop += nb_rx - nb_tx;
+	}
 
 	return SPPWK_RET_OK;
 }
@@ -883,7 +1397,7 @@ static int pcap_proc_write(int lcore_id)
 	struct rte_mbuf *bufs[MAX_PCAP_BURST];
 	struct rte_mbuf *mbuf = NULL;
 	struct pcap_mng_info *info = &g_pcap_info[lcore_id];
-	struct rte_ring *read_ring = g_pcap_option.cap_ring;
+	struct rte_ring *read_ring = info->ring;
 
 	if (g_capture_status == SPP_CAPTURE_IDLE) {
 		if (info->status == SPP_CAPTURE_IDLE)
@@ -892,17 +1406,18 @@ static int pcap_proc_write(int lcore_id)
 	if (info->status == SPP_CAPTURE_IDLE) {
 		RTE_LOG(DEBUG, SPP_PCAP, "write[%d] idle->run\n", lcore_id);
 		info->status = SPP_CAPTURE_RUNNING;
+		info->error = NULL;
+
+		/* Packets are discarded until stopped if it is failed */
 		if (file_compression_operation(info, INIT_MODE)
-						!= SPPWK_RET_OK) {
-			info->status = SPP_CAPTURE_IDLE;
-			return SPPWK_RET_NG;
-		}
-		g_pcap_thread_info.start_up_cnt += 1;
+						!= SPPWK_RET_OK)
+			info->error = PCAP_ERR_OPEN;
+		rte_atomic32_inc(&g_pcap_thread_info.start_up_cnt);
 		g_total_write[lcore_id] = 0;
 	}
 
-	/* Read packets from shared ring */
-	nb_rx =  rte_ring_mc_dequeue_burst(read_ring, (void *)bufs,
+	/* Read packets from ring of receiver, SC if the only writer */
+	nb_rx =  rte_ring_dequeue_burst(read_ring, (void *)bufs,
 					   MAX_PCAP_BURST, NULL);
 	if (unlikely(nb_rx == 0)) {
 		if (g_capture_status == SPP_CAPTURE_IDLE) {
@@ -914,8 +1429,10 @@ static int pcap_proc_write(int lcore_id)
 					lcore_id, g_total_write[lcore_id]);
 
 			info->status = SPP_CAPTURE_IDLE;
-			if (g_pcap_thread_info.start_up_cnt != 0)
-				g_pcap_thread_info.start_up_cnt -= 1;
+			if (rte_atomic32_read(
+					&g_pcap_thread_info.start_up_cnt) != 0)
+				rte_atomic32_dec(
+					&g_pcap_thread_info.start_up_cnt);
 			if (file_compression_operation(info, CLOSE_MODE)
 							!= SPPWK_RET_OK)
 				return SPPWK_RET_NG;
@@ -926,14 +1443,15 @@ static int pcap_proc_write(int lcore_id)
 	for (buf = 0; buf < nb_rx; buf++) {
 		mbuf = bufs[buf];
 		rte_prefetch0(rte_pktmbuf_mtod(mbuf, void *));
-		if (compress_file_packet(&g_pcap_info[lcore_id], mbuf)
+		if (compress_file_packet(info, mbuf)
 							!= SPPWK_RET_OK) {
 			RTE_LOG(ERR, SPP_PCAP,
 					"Failed compress_file_packet(), "
 					"errno=%d (%s)\n",
 					errno, strerror(errno));
-			ret = SPPWK_RET_NG;
-			info->status = SPP_CAPTURE_IDLE;
+
+			/* Packets are discarded until stopped */
+			info->error = PCAP_ERR_WRITE;
 			file_compression_operation(info, CLOSE_MODE);
 			break;
 		}
@@ -947,6 +1465,49 @@ static int pcap_proc_write(int lcore_id)
 	return ret;
 }
 
+/* Get error of writer occurred in current or last capture */
+const char *
+spp_pcap_get_write_error(unsigned int lcore_id)
+{
+	return g_pcap_info[lcore_id].error;
+}
+
+/* Set params of capture given with start command */
+int
+spp_pcap_set_capture_params(uint32_t snaplen, const char *filter)
+{
+	struct sppwk_pkt_filter *new_filter = NULL;
+
+	/* Receivers refer the filter while capturing */
+	if (g_capture_request == SPP_CAPTURE_RUNNING ||
+			g_capture_status == SPP_CAPTURE_RUNNING) {
+		if (snaplen == 0 && filter[0] == '\0')
+			return SPPWK_RET_OK;
+		RTE_LOG(ERR, SPP_PCAP,
+				"Cannot change params while capturing.\n");
+		return SPPWK_RET_NG;
+	}
+
+	if (filter[0] != '\0') {
+		new_filter = sppwk_pkt_filter_create(filter);
+		if (new_filter == NULL) {
+			RTE_LOG(ERR, SPP_PCAP, "Invalid filter '%s'.\n",
+					filter);
+			return SPPWK_RET_NG;
+		}
+	}
+	sppwk_pkt_filter_free(g_capture_filter);
+	g_capture_filter = new_filter;
+	strcpy(g_capture_filter_expr, filter);
+	g_capture_snaplen = (snaplen == 0) ? PCAP_SNAPLEN_MAX : snaplen;
+	RTE_LOG(INFO, SPP_PCAP, "Capture params, snaplen=%u, filter='%s'\n",
+			g_capture_snaplen, g_capture_filter_expr);
+
+	/* Params must be visible before receivers see start request */
+	rte_smp_wmb();
+	return SPPWK_RET_OK;
+}
+
 /* Main process of slave core */
 static int
 slave_main(void *arg __attribute__ ((unused)))
@@ -955,15 +1516,12 @@ slave_main(void *arg __attribute__ ((unused)))
 	unsigned int lcore_id = rte_lcore_id();
 	struct pcap_mng_info *pcap_info = &g_pcap_info[lcore_id];
 
-	if (pcap_info->thread_no == 0) {
-		RTE_LOG(INFO, SPP_PCAP, "Receiver started on lcore %d.\n",
-				lcore_id);
-		pcap_info->type = PCAP_RECEIVE;
-	} else {
+	if (pcap_info->type == PCAP_RECEIVE)
+		RTE_LOG(INFO, SPP_PCAP, "Receiver %d started on lcore %d.\n",
+				pcap_info->thread_no, lcore_id);
+	else
 		RTE_LOG(INFO, SPP_PCAP, "Writer %d started on lcore %d.\n",
 					pcap_info->thread_no, lcore_id);
-		pcap_info->type = PCAP_WRITE;
-	}
 	set_core_status(lcore_id, SPPWK_LCORE_IDLING);
 
 	while (1) {
@@ -992,6 +1550,83 @@ slave_main(void *arg __attribute__ ((unused)))
 	return ret;
 }
 
+/* Get ethdev port ID of captured port, or add ring PMD for it. */
+static int
+setup_cap_port(struct sppwk_port_info *port_cap)
+{
+	struct sppwk_port_info *port_info;
+	int ret;
+
+	port_info = get_iface_info(port_cap->iface_type, port_cap->iface_no,
+			port_cap->queue_no);
+	if (port_info == NULL) {
+		RTE_LOG(ERR, SPP_PCAP, "caputre port undefined.\n");
+		return SPPWK_RET_NG;
+	}
+	if (port_cap->iface_type == PHY) {
+		if (port_info->iface_type != UNDEF)
+			port_cap->ethdev_port_id = port_info->ethdev_port_id;
+		else {
+			RTE_LOG(ERR, SPP_PCAP,
+				"caputre port undefined.(phy:%d)\n",
+						port_cap->iface_no);
+			return SPPWK_RET_NG;
+		}
+	} else {
+		if (port_info->iface_type == UNDEF) {
+			ret = add_ring_pmd(port_info->iface_no);
+			if (ret == SPPWK_RET_NG) {
+				RTE_LOG(ERR, SPP_PCAP, "caputre port "
+					"undefined.(ring:%d)\n",
+					port_cap->iface_no);
+				return SPPWK_RET_NG;
+			}
+			port_cap->ethdev_port_id = ret;
+		} else {
+			RTE_LOG(ERR, SPP_PCAP, "caputre port "
+					"undefined.(ring:%d)\n",
+					port_cap->iface_no);
+			return SPPWK_RET_NG;
+		}
+	}
+	RTE_LOG(DEBUG, SPP_PCAP,
+			"Recv port type=%d, no=%d, port_id=%d\n",
+			port_cap->iface_type, port_cap->iface_no,
+			port_cap->ethdev_port_id);
+	return SPPWK_RET_OK;
+}
+
+/* Create ring from receiver `rx_no` to writers assigned to it. */
+static int
+create_cap_ring(int rx_no, int nof_writers)
+{
+	char ring_name[RTE_RING_NAMESIZE];
+	int nof_readers;
+	unsigned int flags = RING_F_SP_ENQ;
+	struct rte_ring *ring;
+
+	nof_readers = nof_writers / g_pcap_option.nof_receivers;
+	if (rx_no < nof_writers % g_pcap_option.nof_receivers)
+		nof_readers++;
+	if (nof_readers == 1)
+		flags |= RING_F_SC_DEQ;
+
+	snprintf(ring_name, sizeof(ring_name), "cap_ring_%d_%d",
+			get_client_id(), rx_no);
+	ring = rte_ring_create(ring_name, rte_align32pow2(RING_SIZE),
+			rte_socket_id(), flags);
+	if (ring == NULL) {
+		RTE_LOG(ERR, SPP_PCAP, "ring create error(%s).\n",
+					rte_strerror(rte_errno));
+		return SPPWK_RET_NG;
+	}
+	RTE_LOG(DEBUG, SPP_PCAP, "Ring port name=%s, flags=0x%x\n",
+			ring->name, ring->flags);
+
+	g_pcap_option.cap_rings[rx_no] = ring;
+	return SPPWK_RET_OK;
+}
+
 /**
  * Main function
  *
@@ -1007,6 +1642,11 @@ main(int argc, char *argv[])
 	unsigned int master_lcore;
 	unsigned int lcore_id;
 	unsigned int thread_no;
+	int cap_no;
+	int rx_no;
+	int nof_rx;
+	int nof_writers;
+	struct pcap_mng_info *pcap_info;
 
 #ifdef SPP_DEMONIZE
 	/* Daemonize process */
@@ -1045,6 +1685,18 @@ main(int argc, char *argv[])
 		if (unlikely(ret_parse != 0))
 			break;
 
+		/* Register mbuf fields for received packets */
+		g_rx_ts_offset = rte_mbuf_dynfield_register(
+				&g_rx_ts_dynfield_desc);
+		g_rx_if_offset = rte_mbuf_dynfield_register(
+				&g_rx_if_dynfield_desc);
+		if (unlikely(g_rx_ts_offset < 0 || g_rx_if_offset < 0)) {
+			RTE_LOG(ERR, SPP_PCAP,
+				"Failed to register mbuf fields(%s).\n",
+				rte_strerror(rte_errno));
+			break;
+		}
+
 		/* set manage address */
 		if (spp_set_mng_data_addr(&g_iface_info, g_core_info,
 					&g_capture_request,
@@ -1068,72 +1720,69 @@ main(int argc, char *argv[])
 			break;
 
 		/* capture port setup */
-		struct sppwk_port_info *port_cap = &g_pcap_option.port_cap;
-		struct sppwk_port_info *port_info = get_iface_info(
-						port_cap->iface_type,
-						port_cap->iface_no,
-						port_cap->queue_no);
-		if (port_info == NULL) {
-			RTE_LOG(ERR, SPP_PCAP, "caputre port undefined.\n");
+		for (cap_no = 0; cap_no < g_pcap_option.nof_cap_ifaces;
+				cap_no++) {
+			if (setup_cap_port(
+					&g_pcap_option.cap_ifaces[cap_no].port)
+					!= SPPWK_RET_OK)
+				break;
+		}
+		if (cap_no < g_pcap_option.nof_cap_ifaces)
+			break;
+
+		/* Writers are assigned to each of receivers in turn */
+		nof_rx = g_pcap_option.nof_receivers;
+		nof_writers = rte_lcore_count() - 1 - nof_rx;
+		if (nof_writers < nof_rx) {
+			RTE_LOG(ERR, SPP_PCAP, "Writers %d are less than "
+					"receivers %d.\n", nof_writers, nof_rx);
 			break;
 		}
-		if (port_cap->iface_type == PHY) {
-			if (port_info->iface_type != UNDEF)
-				port_cap->ethdev_port_id =
-					port_info->ethdev_port_id;
-			else {
-				RTE_LOG(ERR, SPP_PCAP,
-					"caputre port undefined.(phy:%d)\n",
-							port_cap->iface_no);
-				break;
-			}
-		} else {
-			if (port_info->iface_type == UNDEF) {
-				ret = add_ring_pmd(port_info->iface_no);
-				if (ret == SPPWK_RET_NG) {
-					RTE_LOG(ERR, SPP_PCAP, "caputre port "
-						"undefined.(ring:%d)\n",
-						port_cap->iface_no);
-					break;
-				}
-				port_cap->ethdev_port_id = ret;
-			} else {
-				RTE_LOG(ERR, SPP_PCAP, "caputre port "
-						"undefined.(ring:%d)\n",
-						port_cap->iface_no);
+
+		/**
+		 * Create ring for each of receivers. It is single consumer if
+		 * only one writer is assigned to the receiver.
+		 */
+		for (rx_no = 0; rx_no < nof_rx; rx_no++) {
+			if (create_cap_ring(rx_no, nof_writers) !=
+					SPPWK_RET_OK)
 				break;
-			}
 		}
-		RTE_LOG(DEBUG, SPP_PCAP,
-				"Recv port type=%d, no=%d, port_id=%d\n",
-				port_cap->iface_type, port_cap->iface_no,
-				port_cap->ethdev_port_id);
-
-		/* create ring */
-		char ring_name[PORT_STR_SIZE];
-		memset(ring_name, 0x00, PORT_STR_SIZE);
-		snprintf(ring_name, PORT_STR_SIZE, "cap_ring_%d",
-				get_client_id());
-		g_pcap_option.cap_ring = rte_ring_create(ring_name,
-					rte_align32pow2(RING_SIZE),
-					rte_socket_id(), 0);
-		if (g_pcap_option.cap_ring == NULL) {
-			RTE_LOG(ERR, SPP_PCAP, "ring create error(%s).\n",
-						rte_strerror(rte_errno));
+		if (rx_no < nof_rx)
 			break;
-		}
-		RTE_LOG(DEBUG, SPP_PCAP, "Ring port name=%s, flags=0x%x\n",
-				g_pcap_option.cap_ring->name,
-				g_pcap_option.cap_ring->flags);
 
 		/* Start worker threads of recive or write */
 		g_pcap_thread_info.thread_cnt = 0;
-		g_pcap_thread_info.start_up_cnt = 0;
+		rte_atomic32_init(&g_pcap_thread_info.start_up_cnt);
+		rte_atomic32_init(&g_pcap_thread_info.rx_run_cnt);
 		lcore_id = 0;
 		thread_no = 0;
+		RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+			pcap_info = &g_pcap_info[lcore_id];
+			if (thread_no < (unsigned int)nof_rx) {
+				pcap_info->type = PCAP_RECEIVE;
+				pcap_info->thread_no = thread_no;
+				pcap_info->ring =
+					g_pcap_option.cap_rings[thread_no];
+			} else {
+				/* Writer ID is started from 1 */
+				pcap_info->type = PCAP_WRITE;
+				pcap_info->thread_no = thread_no - nof_rx + 1;
+				pcap_info->ring = g_pcap_option.cap_rings[
+					(thread_no - nof_rx) % nof_rx];
+
+				/* Files are written on I/O thread of writer */
+				pcap_info->io = pcap_io_stream_create(lcore_id);
+				if (pcap_info->io == NULL)
+					break;
+			}
+			thread_no++;
+		}
+		if (thread_no < rte_lcore_count() - 1)
+			break;
+
 		RTE_LCORE_FOREACH_SLAVE(lcore_id) {
 			g_pcap_thread_info.thread_cnt += 1;
-			g_pcap_info[lcore_id].thread_no = thread_no++;
 			rte_eal_remote_launch(slave_main, NULL, lcore_id);
 		}
 
@@ -1178,9 +1827,21 @@ main(int argc, char *argv[])
 		RTE_LOG(ERR, SPP_PCAP, "Failed to terminate master thread.\n");
 
 	/* capture write ring free */
-	if (g_pcap_option.cap_ring != NULL)
-		rte_ring_free(g_pcap_option.cap_ring);
+	for (rx_no = 0; rx_no < PCAP_MAX_IFACES; rx_no++) {
+		if (g_pcap_option.cap_rings[rx_no] != NULL)
+			rte_ring_free(g_pcap_option.cap_rings[rx_no]);
+	}
 
+	sppwk_pkt_filter_free(g_capture_filter);
+	g_capture_filter = NULL;
+
+	/* I/O threads are stopped after remained files are closed */
+	RTE_LCORE_FOREACH_SLAVE(lcore_id) {
+		pcap_io_stream_free(g_pcap_info[lcore_id].io);
+		g_pcap_info[lcore_id].io = NULL;
+		if (g_pcap_info[lcore_id].ctx != NULL)
+			LZ4F_freeCompressionContext(g_pcap_info[lcore_id].ctx);
+	}
 
 	RTE_LOG(INFO, SPP_PCAP, "Exit spp_pcap.\n");
 	return ret;
@@ -7,6 +7,9 @@
 
 #include "cmd_utils.h"
 
+/** Max length of captured packets, used if snaplen is not given. */
+#define PCAP_SNAPLEN_MAX 65535
+
 /**
  * Pcap get core status
  *
@@ -21,4 +24,26 @@ int spp_pcap_get_core_status(
 		unsigned int lcore_id,
 		struct sppwk_lcore_params *params);
 
+/**
+ * Get error of writer occurred in current or last capture. It is cleared
+ * when the next capture is started.
+ *
+ * @param lcore_id Lcore ID of writer.
+ *
+ * @retval Message of error, or NULL if no error.
+ */
+const char *spp_pcap_get_write_error(unsigned int lcore_id);
+
+/**
+ * Set params of capture given with `start` command. They are applied to
+ * capture started next, and cannot be changed while capturing.
+ *
+ * @param snaplen Max length of captured packets, or 0 for PCAP_SNAPLEN_MAX.
+ * @param filter Filter expression of pcap syntax, or empty for all packets.
+ *
+ * @retval SPPWK_RET_OK succeeded.
+ * @retval SPPWK_RET_NG failed to compile filter, or capture is running.
+ */
+int spp_pcap_set_capture_params(uint32_t snaplen, const char *filter);
+
 #endif /* __SPP_PCAP_H__ */
@@ -11,6 +11,7 @@
 #include "args.h"
 #include "init.h"
 #include "primary.h"
+#include "shared/chain_latency.h"
 
 /* global var for number of rings - extern in header */
 uint16_t num_rings;
@@ -20,6 +21,9 @@ int server_port;
 /* Flag for deciding to forward */
 int do_forwarding;
 
+/* Flag for enabling VLAN insert of NIC */
+int vlan_offload;
+
 /*
  * Long options mapped to a short option.
  *
@@ -30,11 +34,15 @@ enum {
 	CMD_LINE_OPT_MIN_NUM = 256,
 	CMD_OPT_DISP_STATS,
 	CMD_OPT_PORT_NUM, /* For `--port-num` */
+	CMD_OPT_VLAN_OFFLOAD, /* For `--vlan-offload` */
+	CMD_OPT_CHAIN_LATENCY, /* For `--chain-latency` */
 };
 
 struct option lgopts[] = {
 	{"disp-stats", no_argument, NULL, CMD_OPT_DISP_STATS},
 	{"port-num", required_argument, NULL, CMD_OPT_PORT_NUM},
+	{"vlan-offload", no_argument, NULL, CMD_OPT_VLAN_OFFLOAD},
+	{"chain-latency", no_argument, NULL, CMD_OPT_CHAIN_LATENCY},
 	{0}
 };
 
@@ -49,12 +57,15 @@ usage(void)
 	RTE_LOG(INFO, PRIMARY,
 	    "%s [EAL options] -- -p PORTMASK -n NUM_CLIENTS [-s NUM_SOCKETS]"
 		" [--port-num NUM_PORT"
-		" rxq NUM_RX_QUEUE txq NUM_TX_QUEUE]...\n"
+		" rxq NUM_RX_QUEUE txq NUM_TX_QUEUE]... [--vlan-offload]"
+		" [--chain-latency]\n"
 	    " -p PORTMASK: hexadecimal bitmask of ports to use\n"
 	    " -n NUM_RINGS: number of ring ports used from secondaries\n"
 		" --port-num NUM_PORT: number of ports for multi-queue setting\n"
 		" rxq NUM_RX_QUEUE: number of receive queues\n"
 		" txq NUM_TX_QUEUE number of transmit queues\n"
+		" --vlan-offload: enable VLAN insert of NIC if supported\n"
+		" --chain-latency: measure latency of service chain\n"
 	    , progname);
 }
 
@@ -301,6 +312,13 @@ parse_app_args(uint16_t max_ports, int argc, char *argv[])
 				return -1;
 			}
 			break;
+		case CMD_OPT_VLAN_OFFLOAD:
+			vlan_offload = 1;
+			break;
+		case CMD_OPT_CHAIN_LATENCY:
+			if (chain_lat_init() != 0)
+				return -1;
+			break;
 		default:
 			RTE_LOG(ERR,
 				PRIMARY, "ERROR: Unknown option '%c'\n", opt);
@@ -277,18 +277,23 @@ init_port(uint16_t port_num, struct rte_mempool *pktmbuf_pool,
 	fflush(stdout);
 
 	rte_eth_dev_info_get(port_num, &dev_info);
-	if (dev_info.tx_offload_capa & DEV_TX_OFFLOAD_MBUF_FAST_FREE)
+
+	/* VLAN tag of `add_vlantag` of secondaries is inserted by NIC. */
+	if (vlan_offload &&
+			(dev_info.tx_offload_capa & DEV_TX_OFFLOAD_VLAN_INSERT))
 		local_port_conf.txmode.offloads |=
-			DEV_TX_OFFLOAD_MBUF_FAST_FREE;
+			DEV_TX_OFFLOAD_VLAN_INSERT;
 	txq_conf = dev_info.default_txconf;
 	txq_conf.offloads = local_port_conf.txmode.offloads;
+	if (dev_info.tx_offload_capa & DEV_TX_OFFLOAD_MBUF_FAST_FREE)
+		txq_conf.offloads |= DEV_TX_OFFLOAD_MBUF_FAST_FREE;
 
 	/*
 	 * Standard DPDK port initialisation - config port, then set up
 	 * rx and tx rings
 	 */
 	retval = rte_eth_dev_configure(port_num, rx_rings, tx_rings,
-		&port_conf);
+		&local_port_conf);
 	if (retval != 0)
 		return retval;
 
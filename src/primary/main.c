@@ -19,6 +19,7 @@
 #include "primary/flow/flow.h"
 
 #include "shared/port_manager.h"
+#include "shared/chain_latency.h"
 #include "shared/secondary/add_port.h"
 #include "shared/secondary/utils.h"
 
@@ -32,6 +33,9 @@
 #define PRI_BUF_SIZE_RING \
 	(MSG_SIZE - PRI_BUF_SIZE_LCORE - PRI_BUF_SIZE_PHY - PRI_BUF_SIZE_PIPE)
 
+/* Key of chain latency added into the rest of status message. */
+#define PRI_CHAIN_LAT_KEY ",\"chain_latency\":"
+
 #define SPP_PATH_LEN 1024  /* seems enough for path of spp procs */
 #define NOF_TOKENS 48  /* seems enough to contain tokens */
 /* should be contain extra two tokens for `python` and path of launcher */
@@ -829,6 +833,7 @@ get_status_json(char *str)
 	char buf_phy_ports[PRI_BUF_SIZE_PHY];
 	char buf_ring_ports[PRI_BUF_SIZE_RING];
 	char buf_pipes[PRI_BUF_SIZE_PIPE];
+	int pos;
 	memset(buf_phy_ports, '\0', PRI_BUF_SIZE_PHY);
 	memset(buf_ring_ports, '\0', PRI_BUF_SIZE_RING);
 	memset(buf_lcores, '\0', PRI_BUF_SIZE_LCORE);
@@ -847,16 +852,28 @@ get_status_json(char *str)
 		memset(tmp_buf, '\0', sizeof(tmp_buf));
 		forwarder_status_json(tmp_buf);
 
-		sprintf(str, "{%s,%s,%s,%s,%s}",
+		pos = sprintf(str, "{%s,%s,%s,%s,%s",
 				buf_lcores, tmp_buf, buf_phy_ports,
 				buf_ring_ports, buf_pipes);
 
 	} else {
-		sprintf(str, "{%s,%s,%s,%s}",
+		pos = sprintf(str, "{%s,%s,%s,%s",
 				buf_lcores, buf_phy_ports, buf_ring_ports,
 				buf_pipes);
 	}
 
+	/**
+	 * Latency of chain is added after pipes only if enabled, in the rest
+	 * of message not to reduce buffers of ports. Space for at least an
+	 * empty array and closing brace is required.
+	 */
+	if (chain_lat_enabled() && pos + (int)strlen(PRI_CHAIN_LAT_KEY) + 4 <
+			MSG_SIZE) {
+		pos += sprintf(str + pos, "%s", PRI_CHAIN_LAT_KEY);
+		pos += chain_lat_json(str + pos, MSG_SIZE - pos - 1);
+	}
+	sprintf(str + pos, "}");
+
 	return 0;
 }
 
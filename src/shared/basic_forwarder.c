@@ -6,6 +6,7 @@
 #include "shared/common.h"
 #include "shared/basic_forwarder.h"
 #include "shared/port_manager.h"
+#include "shared/chain_latency.h"
 
 void
 forward(void)
@@ -48,8 +49,12 @@ forward(void)
 				continue;
 
 			port_map[in_port].stats->rx += nb_rx;
+			chain_lat_rx(in_port, port_map[in_port].port_type,
+					port_map[in_port].id, bufs, nb_rx);
 
 			/* Send burst of TX packets, to second port of pair. */
+			chain_lat_tx(out_port, port_map[out_port].port_type,
+					port_map[out_port].id, bufs, nb_rx);
 			nb_tx = ports_fwd_array[out_port][out_queue].tx_func(
 				out_port, out_queue, bufs, nb_rx);
 
@@ -0,0 +1,348 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <rte_log.h>
+#include <rte_errno.h>
+#include <rte_lcore.h>
+#include <rte_cycles.h>
+#include <rte_malloc.h>
+#include <rte_mbuf_dyn.h>
+
+#include "chain_latency.h"
+#include "latency_hist.h"
+
+#define RTE_LOGTYPE_CHAIN_LAT RTE_LOGTYPE_USER1
+
+#define NS_PER_SEC 1000000000ULL
+
+/* Length of JSON object of a measurement point. */
+#define CHAIN_LAT_POINT_JSON_LEN 512
+
+/* Timestamps of chain latency in mbuf dynamic field. */
+struct chain_lat_stamp {
+	uint64_t ingress_tsc;  /* TSC at ingress, or 0 if not sampled. */
+	uint64_t hop_tsc;  /* TSC at the previous measurement point. */
+};
+
+enum chain_lat_dir {
+	CHAIN_LAT_RX,
+	CHAIN_LAT_TX,
+	CHAIN_LAT_NOF_DIR,
+};
+
+/**
+ * Measurement point of a port of a lcore. It is updated only from the lcore,
+ * and summed up in master thread without lock.
+ */
+struct chain_lat_point {
+	enum port_type iface_type;
+	int iface_no;
+	uint64_t timer_tsc;  /* Elapsed time from the last sampling. */
+	uint64_t prev_tsc;  /* TSC at the last RX for sampling. */
+	struct latency_hist hop;  /* Latency from the previous point. */
+	struct latency_hist total;  /* Latency from the ingress. */
+} __rte_cache_aligned;
+
+/* Offset of dynamic field, or -1 if chain latency is disabled. */
+static int g_dynfield_offset = -1;
+
+/* Sampling interval and max age of timestamp in cycles. */
+static uint64_t g_samp_intvl;
+static uint64_t g_max_age;
+
+/* Points allocated at the first record in each of lcores. */
+static struct chain_lat_point
+	*g_points[RTE_MAX_LCORE][RTE_MAX_ETHPORTS][CHAIN_LAT_NOF_DIR];
+
+static const struct rte_mbuf_dynfield chain_lat_dynfield_desc = {
+	.name = CHAIN_LAT_DYNFIELD_NAME,
+	.size = sizeof(struct chain_lat_stamp),
+	.align = __alignof__(struct chain_lat_stamp),
+};
+
+/* Register mbuf dynamic field and enable chain latency. */
+int
+chain_lat_init(void)
+{
+	uint64_t hz = rte_get_tsc_hz();
+	int offset;
+
+	offset = rte_mbuf_dynfield_register(&chain_lat_dynfield_desc);
+	if (offset < 0) {
+		RTE_LOG(ERR, CHAIN_LAT, "Cannot register dynamic field of "
+				"chain latency. (err=%d)\n", rte_errno);
+		return -1;
+	}
+
+	latency_set_tsc_hz(hz);
+	g_samp_intvl = CHAIN_LAT_SAMPLING_INTERVAL * hz / NS_PER_SEC;
+	g_max_age = CHAIN_LAT_MAX_AGE / 1000 * (hz / 1000000);
+	g_dynfield_offset = offset;
+
+	RTE_LOG(INFO, CHAIN_LAT, "Chain latency is enabled. (offset=%d)\n",
+			offset);
+	return 0;
+}
+
+/* Check if measurement of chain latency is enabled. */
+int
+chain_lat_enabled(void)
+{
+	return g_dynfield_offset >= 0;
+}
+
+/* Get timestamps in dynamic field of a packet. */
+static inline struct chain_lat_stamp *
+get_stamp(struct rte_mbuf *pkt)
+{
+	return RTE_MBUF_DYNFIELD(pkt, g_dynfield_offset,
+			struct chain_lat_stamp *);
+}
+
+/* Get measurement point of current lcore, or allocate it at first. */
+static struct chain_lat_point *
+get_point(uint16_t port_id, enum chain_lat_dir dir,
+		enum port_type iface_type, int iface_no)
+{
+	unsigned int lcore_id = rte_lcore_id();
+	struct chain_lat_point *point;
+
+	if (unlikely(lcore_id >= RTE_MAX_LCORE || port_id >= RTE_MAX_ETHPORTS))
+		return NULL;
+
+	point = g_points[lcore_id][port_id][dir];
+	if (likely(point != NULL && point->iface_type == iface_type &&
+			point->iface_no == iface_no))
+		return point;
+
+	/* Port ID is reused for other interface after deleted. */
+	if (point != NULL) {
+		memset(point, 0x00, sizeof(*point));
+		point->iface_type = iface_type;
+		point->iface_no = iface_no;
+		return point;
+	}
+
+	point = rte_zmalloc(NULL, sizeof(*point), RTE_CACHE_LINE_SIZE);
+	if (unlikely(point == NULL))
+		return NULL;
+	point->iface_type = iface_type;
+	point->iface_no = iface_no;
+	__atomic_store_n(&g_points[lcore_id][port_id][dir], point,
+			__ATOMIC_RELEASE);
+	return point;
+}
+
+/**
+ * Clear stamps of packets entering the chain. Field is not cleared in
+ * allocating mbuf, and stamp of mbuf freed without passing TX of the end
+ * of the chain is left.
+ */
+static inline void
+clear_stamps(struct rte_mbuf **pkts, uint16_t nb_pkts)
+{
+	uint16_t i;
+
+	for (i = 0; i < nb_pkts; i++)
+		get_stamp(pkts[i])->ingress_tsc = 0;
+}
+
+/* Stamp a packet of a burst for each of sampling interval. */
+static inline void
+stamp_ingress(struct chain_lat_point *point, struct rte_mbuf **pkts,
+		uint16_t nb_pkts, uint64_t now)
+{
+	clear_stamps(pkts, nb_pkts);
+
+	if (unlikely(point == NULL))
+		return;
+
+	point->timer_tsc += now - point->prev_tsc;
+	point->prev_tsc = now;
+	if (unlikely(point->timer_tsc >= g_samp_intvl)) {
+		get_stamp(pkts[0])->ingress_tsc = now;
+		get_stamp(pkts[0])->hop_tsc = now;
+		point->timer_tsc = 0;
+	}
+}
+
+/* Record latency of stamped packets, and clear stamps if `clear` is 1. */
+static inline void
+record_latency(struct chain_lat_point *point, struct rte_mbuf **pkts,
+		uint16_t nb_pkts, uint64_t now, int clear)
+{
+	uint16_t i;
+	struct chain_lat_stamp *stamp;
+
+	for (i = 0; i < nb_pkts; i++) {
+		stamp = get_stamp(pkts[i]);
+		if (likely(stamp->ingress_tsc == 0))
+			continue;
+
+		if (unlikely(now - stamp->ingress_tsc > g_max_age)) {
+			stamp->ingress_tsc = 0;
+			continue;
+		}
+
+		if (likely(point != NULL)) {
+			latency_hist_add(&point->hop,
+					latency_cycles_to_ns(
+						now - stamp->hop_tsc));
+			latency_hist_add(&point->total,
+					latency_cycles_to_ns(
+						now - stamp->ingress_tsc));
+		}
+
+		if (clear)
+			stamp->ingress_tsc = 0;
+		else
+			stamp->hop_tsc = now;
+	}
+}
+
+/**
+ * Stamp packets from phy port, or record latency of stamped packets.
+ * Only packets from ring or pipe are passed from other processes and
+ * can have valid stamps, so that stamps of others are cleared.
+ */
+void
+chain_lat_rx(uint16_t port_id, enum port_type iface_type, int iface_no,
+		struct rte_mbuf **pkts, uint16_t nb_pkts)
+{
+	if (likely(g_dynfield_offset < 0) || nb_pkts == 0)
+		return;
+
+	if (iface_type == PHY)
+		stamp_ingress(get_point(port_id, CHAIN_LAT_RX, iface_type,
+					iface_no),
+				pkts, nb_pkts, rte_rdtsc());
+	else if (iface_type == RING || iface_type == PIPE)
+		record_latency(get_point(port_id, CHAIN_LAT_RX, iface_type,
+					iface_no),
+				pkts, nb_pkts, rte_rdtsc(), 0);
+	else
+		clear_stamps(pkts, nb_pkts);
+}
+
+/* Record latency of packets leaving the chain, and clear stamps. */
+void
+chain_lat_tx(uint16_t port_id, enum port_type iface_type, int iface_no,
+		struct rte_mbuf **pkts, uint16_t nb_pkts)
+{
+	if (likely(g_dynfield_offset < 0) || nb_pkts == 0)
+		return;
+
+	/* Mbuf is passed to next process and recorded at its RX. */
+	if (iface_type == RING || iface_type == PIPE)
+		return;
+
+	record_latency(get_point(port_id, CHAIN_LAT_TX, iface_type,
+				iface_no),
+			pkts, nb_pkts, rte_rdtsc(), 1);
+}
+
+/* Get name of interface type of a measurement point. */
+static const char *
+get_iface_type_str(enum port_type iface_type)
+{
+	switch (iface_type) {
+	case PHY:
+		return "phy";
+	case RING:
+		return "ring";
+	case VHOST:
+		return "vhost";
+	case PCAP:
+		return "pcap";
+	case NULLPMD:
+		return "nullpmd";
+	case TAP:
+		return "tap";
+	case MEMIF:
+		return "memif";
+	case PIPE:
+		return "pipe";
+	default:
+		return "unknown";
+	}
+}
+
+/* Write latency of a point of all of lcores as JSON object. */
+static int
+get_point_json(char *str, size_t size, uint16_t port_id,
+		enum chain_lat_dir dir)
+{
+	unsigned int lcore_id;
+	int len, hop_len, total_len;
+	const struct chain_lat_point *point, *first = NULL;
+	char hop_str[LATENCY_HIST_JSON_LEN];
+	char total_str[LATENCY_HIST_JSON_LEN];
+	/* Too large for stack, and referred only from master thread. */
+	static struct latency_hist hop, total;
+
+	memset(&hop, 0x00, sizeof(hop));
+	memset(&total, 0x00, sizeof(total));
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		point = __atomic_load_n(&g_points[lcore_id][port_id][dir],
+				__ATOMIC_ACQUIRE);
+		if (point == NULL || point->hop.count == 0)
+			continue;
+		if (first == NULL)
+			first = point;
+		latency_hist_merge(&hop, &point->hop);
+		latency_hist_merge(&total, &point->total);
+	}
+	if (first == NULL)
+		return 0;
+
+	hop_len = latency_hist_json(hop_str, sizeof(hop_str), &hop);
+	total_len = latency_hist_json(total_str, sizeof(total_str), &total);
+	if (hop_len >= (int)sizeof(hop_str) ||
+			total_len >= (int)sizeof(total_str))
+		return 0;
+
+	len = snprintf(str, size, "{\"point\":\"%s:%d\",\"dir\":\"%s\","
+			"\"hop\":%s,\"total\":%s}",
+			get_iface_type_str(first->iface_type),
+			first->iface_no,
+			dir == CHAIN_LAT_RX ? "rx" : "tx", hop_str, total_str);
+	return len < (int)size ? len : 0;
+}
+
+/* Write latency of measurement points as JSON array. */
+int
+chain_lat_json(char *str, size_t size)
+{
+	uint16_t port_id;
+	int dir, len, pos;
+	char point_str[CHAIN_LAT_POINT_JSON_LEN];
+
+	if (size < 3)
+		return 0;
+
+	pos = sprintf(str, "[");
+	for (port_id = 0; port_id < RTE_MAX_ETHPORTS; port_id++) {
+		for (dir = 0; dir < CHAIN_LAT_NOF_DIR; dir++) {
+			len = get_point_json(point_str, sizeof(point_str),
+					port_id, dir);
+			if (len == 0)
+				continue;
+
+			/* Keep space for a comma and closing bracket. */
+			if ((size_t)(pos + len + 2) >= size) {
+				RTE_LOG(DEBUG, CHAIN_LAT, "No space for "
+						"chain latency of port %hu.\n",
+						port_id);
+				continue;
+			}
+			pos += sprintf(str + pos, "%s%s",
+					pos > 1 ? "," : "", point_str);
+		}
+	}
+	pos += sprintf(str + pos, "]");
+	return pos;
+}
@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#ifndef __SHARED_CHAIN_LATENCY_H__
+#define __SHARED_CHAIN_LATENCY_H__
+
+/**
+ * @file
+ * Latency of service chain
+ *
+ * A packet received from phy port is sampled for each of
+ * CHAIN_LAT_SAMPLING_INTERVAL ns, and stamped with TSC in a mbuf dynamic
+ * field shared among SPP processes. Each of processes records latency from
+ * the previous point as `hop` and from the ingress as `total` at measurement
+ * points, which are RX of ring, vhost or other ports except phy, and TX of
+ * ports from which mbuf is not passed to other processes, such as phy or
+ * vhost. Stamp is cleared at the TX.
+ */
+
+#include <rte_mbuf.h>
+#include "shared/common.h"
+
+/* Name of mbuf dynamic field for timestamps of chain latency. */
+#define CHAIN_LAT_DYNFIELD_NAME "spp_chain_latency"
+
+/* Interval of sampling packets at ingress in nano sec. */
+#define CHAIN_LAT_SAMPLING_INTERVAL 1000000
+
+/**
+ * Timestamp older than it in nano sec is regarded as a stale one of a mbuf
+ * which is dropped in the chain and reused.
+ */
+#define CHAIN_LAT_MAX_AGE 1000000000ULL
+
+/* Size of buffer for JSON of chain latency of a process. */
+#define CHAIN_LAT_JSON_SIZE 4096
+
+/**
+ * Register mbuf dynamic field and enable measurement of chain latency. It
+ * should be called after rte_eal_init() in each of processes of the chain.
+ *
+ * @retval 0 If succeeded.
+ * @retval -1 If failed to register dynamic field.
+ */
+int chain_lat_init(void);
+
+/**
+ * Check if measurement of chain latency is enabled.
+ *
+ * @retval 1 if enabled, or 0.
+ */
+int chain_lat_enabled(void);
+
+/**
+ * Stamp sampled packets received from phy port, or record latency of
+ * stamped packets received from ring or pipe. Stamps of packets from other
+ * type of port, such as vhost, are cleared.
+ *
+ * @param port_id Ethdev port ID.
+ * @param iface_type Interface type of the port.
+ * @param iface_no Interface number of the port.
+ * @param pkts Received packets.
+ * @param nb_pkts Num of received packets.
+ */
+void chain_lat_rx(uint16_t port_id, enum port_type iface_type, int iface_no,
+		struct rte_mbuf **pkts, uint16_t nb_pkts);
+
+/**
+ * Record latency of stamped packets sent to port of which mbuf is not
+ * passed to other processes, and clear the stamp. It should be called
+ * before packets are sent.
+ *
+ * @param port_id Ethdev port ID.
+ * @param iface_type Interface type of the port.
+ * @param iface_no Interface number of the port.
+ * @param pkts Packets to be sent.
+ * @param nb_pkts Num of packets to be sent.
+ */
+void chain_lat_tx(uint16_t port_id, enum port_type iface_type, int iface_no,
+		struct rte_mbuf **pkts, uint16_t nb_pkts);
+
+/**
+ * Write latency of measurement points as JSON array such as
+ * `[{"point":"ring:0","dir":"rx","hop":{...},"total":{...}}]`. Points are
+ * omitted if not enough buffer, and points without samples are omitted.
+ *
+ * @param[out] str Buffer of the JSON array.
+ * @param size Size of `str`.
+ * @return Length of the JSON array.
+ */
+int chain_lat_json(char *str, size_t size);
+
+#endif  /* __SHARED_CHAIN_LATENCY_H__ */
@@ -0,0 +1,141 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+
+#include <rte_branch_prediction.h>
+
+#include "latency_hist.h"
+
+#define NS_PER_SEC 1000000000ULL
+
+/* Bits of fixed point of nano sec per cycle. */
+#define NS_PER_CYCLE_SHIFT 32
+
+#define NS_PER_CYCLE_FRAC_MASK ((1ULL << NS_PER_CYCLE_SHIFT) - 1)
+
+/**
+ * Integer and fraction parts of nano sec per cycle in fixed point of
+ * NS_PER_CYCLE_SHIFT bits.
+ */
+static uint64_t g_ns_per_cycle_int;
+static uint64_t g_ns_per_cycle_frac;
+
+/* Max cycles converted to nano sec without overflow. */
+static uint64_t g_max_cycles;
+
+/* Set TSC hz for converting cycles to nano sec. */
+void
+latency_set_tsc_hz(uint64_t hz)
+{
+	uint64_t ns_per_cycle;
+
+	if (hz == 0)
+		return;
+
+	ns_per_cycle = (NS_PER_SEC << NS_PER_CYCLE_SHIFT) / hz;
+	g_ns_per_cycle_int = ns_per_cycle >> NS_PER_CYCLE_SHIFT;
+	g_ns_per_cycle_frac = ns_per_cycle & NS_PER_CYCLE_FRAC_MASK;
+
+	/* Sum of products of each part is less than cycles * (int + 1). */
+	g_max_cycles = UINT64_MAX / (g_ns_per_cycle_int + 1) / 2;
+}
+
+/**
+ * Convert TSC cycles to nano sec with fixed point multiplication. Fraction
+ * part is multiplied with upper and lower halves of cycles separately not
+ * to overflow for cycles of more than 32 bits.
+ */
+uint64_t
+latency_cycles_to_ns(uint64_t cycles)
+{
+	uint64_t ns;
+
+	if (unlikely(cycles > g_max_cycles))
+		return LATENCY_MAX_NS;
+
+	ns = cycles * g_ns_per_cycle_int +
+			(cycles >> NS_PER_CYCLE_SHIFT) * g_ns_per_cycle_frac +
+			(((cycles & NS_PER_CYCLE_FRAC_MASK) *
+			  g_ns_per_cycle_frac) >> NS_PER_CYCLE_SHIFT);
+	return RTE_MIN(ns, LATENCY_MAX_NS);
+}
+
+/* Get the largest latency in nano sec counted in the entry of histogram. */
+static uint64_t
+get_latency_ent_max(unsigned int ent)
+{
+	unsigned int shift;
+
+	if (ent < LATENCY_SUB_CNT * 2)
+		return ent;
+
+	shift = ent / LATENCY_SUB_CNT - 1;
+	return ((uint64_t)(ent % LATENCY_SUB_CNT + LATENCY_SUB_CNT + 1)
+			<< shift) - 1;
+}
+
+/* Add counts of a histogram to another one. */
+void
+latency_hist_merge(struct latency_hist *dst, const struct latency_hist *src)
+{
+	unsigned int ent;
+
+	if (src->count == 0)
+		return;
+
+	if (dst->count == 0 || src->min_ns < dst->min_ns)
+		dst->min_ns = src->min_ns;
+	if (src->max_ns > dst->max_ns)
+		dst->max_ns = src->max_ns;
+	dst->sum_ns += src->sum_ns;
+	dst->count += src->count;
+	for (ent = 0; ent < TOTAL_LATENCY_ENT; ent++)
+		dst->distr[ent] += src->distr[ent];
+}
+
+/* Get a percentile of latency from a histogram. */
+uint64_t
+latency_hist_percentile(const struct latency_hist *hist,
+		unsigned int per_100k)
+{
+	unsigned int ent;
+	uint64_t total = 0, target;
+
+	/* Count of entries, not `count` which might be updated meanwhile. */
+	for (ent = 0; ent < TOTAL_LATENCY_ENT; ent++)
+		total += hist->distr[ent];
+	if (total == 0)
+		return 0;
+
+	/* Rank of the sample of the percentile, rounded up. */
+	target = (total * per_100k + 99999) / 100000;
+	if (target == 0)
+		target = 1;
+
+	total = 0;
+	for (ent = 0; ent < TOTAL_LATENCY_ENT; ent++) {
+		total += hist->distr[ent];
+		if (total >= target)
+			break;
+	}
+	return RTE_MIN(get_latency_ent_max(ent), hist->max_ns);
+}
+
+/* Write summary of a histogram as a JSON object. */
+int
+latency_hist_json(char *str, size_t size, const struct latency_hist *hist)
+{
+	return snprintf(str, size, "{\"count\":%" PRIu64 ",\"min\":%" PRIu64
+			",\"avg\":%" PRIu64 ",\"p50\":%" PRIu64
+			",\"p99\":%" PRIu64 ",\"p99.9\":%" PRIu64
+			",\"max\":%" PRIu64 "}",
+			hist->count, hist->min_ns,
+			hist->count > 0 ? hist->sum_ns / hist->count : 0,
+			latency_hist_percentile(hist, LATENCY_P50),
+			latency_hist_percentile(hist, LATENCY_P99),
+			latency_hist_percentile(hist, LATENCY_P999),
+			hist->max_ns);
+}
@@ -0,0 +1,124 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#ifndef __SHARED_LATENCY_HIST_H__
+#define __SHARED_LATENCY_HIST_H__
+
+/**
+ * @file
+ * Histogram of latency
+ *
+ * Latency in nano sec is counted with log-linear histogram as HDR
+ * histogram. Latency less than 2 * LATENCY_SUB_CNT ns is counted in each of
+ * entries, and longer one is counted in one of LATENCY_SUB_CNT entries
+ * dividing each range of power of two equally. Error of latency of an entry
+ * is less than 1 / LATENCY_SUB_CNT.
+ */
+
+#include <stdint.h>
+#include <rte_common.h>
+
+#define LATENCY_SUB_BITS 4
+#define LATENCY_SUB_CNT (1 << LATENCY_SUB_BITS)
+
+/* Latency longer than about 17 sec is counted as the max latency. */
+#define LATENCY_MAX_BITS 34
+#define LATENCY_MAX_NS ((1ULL << LATENCY_MAX_BITS) - 1)
+
+#define TOTAL_LATENCY_ENT \
+	((LATENCY_MAX_BITS - LATENCY_SUB_BITS + 1) * LATENCY_SUB_CNT)
+
+/* Size of buffer enough for JSON object of latency_hist_json(). */
+#define LATENCY_HIST_JSON_LEN 256
+
+/* Percentiles of latency in units of 1/100000. */
+#define LATENCY_P50 50000
+#define LATENCY_P99 99000
+#define LATENCY_P999 99900
+
+/* Histogram and summary of latency. */
+struct latency_hist {
+	uint64_t count;  /* Num of sampled packets. */
+	uint64_t sum_ns;  /* Sum of latency for average. */
+	uint64_t min_ns;  /* Min latency, or 0 if no sample. */
+	uint64_t max_ns;  /* Max latency. */
+	uint64_t distr[TOTAL_LATENCY_ENT];  /* Distribution of latency. */
+};
+
+/* Get index of entry of histogram for latency in nano sec. */
+static inline unsigned int
+latency_hist_ent(uint64_t ns)
+{
+	unsigned int shift;
+
+	if (ns < LATENCY_SUB_CNT * 2)
+		return (unsigned int)ns;
+
+	/* Top LATENCY_SUB_BITS + 1 bits are used as index in the range. */
+	shift = 63 - __builtin_clzll(ns) - LATENCY_SUB_BITS;
+	return shift * LATENCY_SUB_CNT + (unsigned int)(ns >> shift);
+}
+
+/* Count a sample of latency in nano sec, up to LATENCY_MAX_NS. */
+static inline void
+latency_hist_add(struct latency_hist *hist, uint64_t ns)
+{
+	ns = RTE_MIN(ns, LATENCY_MAX_NS);
+	hist->distr[latency_hist_ent(ns)]++;
+	if (hist->count == 0 || ns < hist->min_ns)
+		hist->min_ns = ns;
+	if (ns > hist->max_ns)
+		hist->max_ns = ns;
+	hist->sum_ns += ns;
+	hist->count++;
+}
+
+/**
+ * Set TSC hz for converting cycles to nano sec. It should be called before
+ * latency_cycles_to_ns().
+ *
+ * @param hz TSC hz, such as rte_get_tsc_hz().
+ */
+void latency_set_tsc_hz(uint64_t hz);
+
+/**
+ * Convert TSC cycles to nano sec with fixed point multiplication.
+ *
+ * @param cycles TSC cycles.
+ * @return Nano sec, up to LATENCY_MAX_NS.
+ */
+uint64_t latency_cycles_to_ns(uint64_t cycles);
+
+/**
+ * Add counts of a histogram to another one.
+ *
+ * @param[in,out] dst Histogram to which counts are added.
+ * @param[in] src Histogram added to `dst`.
+ */
+void latency_hist_merge(struct latency_hist *dst,
+		const struct latency_hist *src);
+
+/**
+ * Get a percentile of latency from a histogram. It is the largest latency
+ * of the entry of the histogram, but not larger than the max latency.
+ *
+ * @param hist Histogram of latency.
+ * @param per_100k Percentile in units of 1/100000, such as LATENCY_P99.
+ * @return Latency in nano sec, or 0 if no sample.
+ */
+uint64_t latency_hist_percentile(const struct latency_hist *hist,
+		unsigned int per_100k);
+
+/**
+ * Write summary of a histogram as a JSON object such as
+ * `{"count":10,"min":120,"avg":150,"p50":143,"p99":207,...}`.
+ *
+ * @param[out] str Buffer of the JSON object.
+ * @param size Size of `str`.
+ * @return Length of the JSON object as snprintf().
+ */
+int latency_hist_json(char *str, size_t size,
+		const struct latency_hist *hist);
+
+#endif  /* __SHARED_LATENCY_HIST_H__ */
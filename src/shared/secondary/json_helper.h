@@ -6,6 +6,7 @@
 #define _SPPWK_JSON_HELPER_H_
 
 #include <string.h>
+#include <stdint.h>
 #include <rte_branch_prediction.h>
 #include <rte_log.h>
 #include "return_codes.h"
@@ -45,6 +46,17 @@ int append_json_comma(char **output);
  */
 int append_json_uint_value(char **output, const char *name, unsigned int val);
 
+/**
+ * Add a uint64 value to given JSON string.
+ *
+ * @param[in,out] output Placeholder of JSON msg.
+ * @param[in] name Name as a key.
+ * @param[in] val Uint64 value of the key.
+ * @retval SPPWK_RET_OK if succeeded.
+ * @retval SPPWK_RET_NG if failed.
+ */
+int append_json_uint64_value(char **output, const char *name, uint64_t val);
+
 /**
  * Add an int value to given JSON string.
  *
@@ -4,6 +4,7 @@
 
 #include <unistd.h>
 #include <string.h>
+#include <arpa/inet.h>
 
 #include <rte_ether.h>
 #include <rte_log.h>
@@ -64,6 +65,7 @@ sppwk_cmd_type_str(enum sppwk_cmd_type ctype)
 	switch (ctype) {
 	case SPPWK_CMDTYPE_CLS_MAC:
 	case SPPWK_CMDTYPE_CLS_VLAN:
+	case SPPWK_CMDTYPE_CLS_ACL:
 		return "classifier";
 	case SPPWK_CMDTYPE_CLIENT_ID:
 		return "_get_client_id";
@@ -75,6 +77,14 @@ sppwk_cmd_type_str(enum sppwk_cmd_type ctype)
 		return "component";
 	case SPPWK_CMDTYPE_PORT:
 		return "port";
+	case SPPWK_CMDTYPE_RING_LATENCY:
+		return "ring_latency";
+	case SPPWK_CMDTYPE_FILTER:
+		return "filter";
+	case SPPWK_CMDTYPE_LIMIT:
+		return "limit";
+	case SPPWK_CMDTYPE_COPY_MODE:
+		return "copy_mode";
 	default:
 		return "unknown";
 	}
@@ -89,9 +99,35 @@ const char *CLS_TYPE_LIST[] = {
 	"none",
 	"mac",
 	"vlan",
+	"acl",
 	"",  /* termination */
 };
 
+/* Term for any value of fields of ACL rule of classifier. */
+#define CLS_ACL_ANY_STR "any"
+
+/**
+ * List of names of IP protocols for ACL rule of classifier. The index is
+ * not used as protocol number, but for `CLS_ACL_PROTO_NUMS`.
+ */
+static const char *CLS_ACL_PROTO_LIST[] = {
+	"tcp",
+	"udp",
+	"sctp",
+	"icmp",
+	"icmpv6",
+	"",  /* termination */
+};
+
+/* Protocol numbers of the names in `CLS_ACL_PROTO_LIST`. */
+static const uint8_t CLS_ACL_PROTO_NUMS[] = {
+	IPPROTO_TCP,
+	IPPROTO_UDP,
+	IPPROTO_SCTP,
+	IPPROTO_ICMP,
+	IPPROTO_ICMPV6,
+};
+
 /**
  * List of port direction. The order of items should be same as the order of
  * enum `sppwk_port_dir` in data_types.h.
@@ -113,6 +149,28 @@ const char *PORT_ABILITY_LIST[] = {
 	"none",
 	"add_vlantag",
 	"del_vlantag",
+	"weight",
+	"",  /* termination */
+};
+
+/**
+ * List of units of rate of mirror. The index is used as `is_bytes` of
+ * struct sppwk_mir_limit.
+ */
+static const char *MIR_RATE_UNIT_LIST[] = {
+	"pkts",
+	"bytes",
+	"",  /* termination */
+};
+
+/**
+ * List of copy modes of mirror. The order of items should be same as the
+ * order of enum `sppwk_mir_copy_mode` in data_types.h.
+ */
+static const char *MIR_COPY_MODE_LIST[] = {
+	"default",
+	"shallow",
+	"deep",
 	"",  /* termination */
 };
 
@@ -479,6 +537,75 @@ parse_comp_type(void *output, const char *arg_val,
 	return SPPWK_RET_OK;
 }
 
+/**
+ * Parse given name of classifier of `arg_val` in `component` command. New
+ * classifier joins the group of it and shares its classifier table.
+ */
+static int
+parse_comp_group(void *output, const char *arg_val,
+		int allow_override __attribute__ ((unused)))
+{
+	int ret;
+	struct sppwk_cmd_comp *component = output;
+
+	if (unlikely(component->wk_action != SPPWK_ACT_START) ||
+			unlikely(component->wk_type != SPPWK_TYPE_CLS)) {
+		RTE_LOG(ERR, WK_CMD_PARSER,
+				"Group is only for starting classifier.\n");
+		return SPPWK_RET_NG;
+	}
+
+	ret = sppwk_get_lcore_id(arg_val);
+	if (unlikely(ret < 0)) {
+		RTE_LOG(ERR, WK_CMD_PARSER,
+				"Unknown classifier '%s' of group.\n",
+				arg_val);
+		return SPPWK_RET_NG;
+	}
+
+	if (strlen(arg_val) >= SPPWK_NAME_BUFSZ)
+		return SPPWK_RET_NG;
+
+	strcpy(component->grp_name, arg_val);
+	return SPPWK_RET_OK;
+}
+
+/**
+ * Parse given num of leading bytes of packets copied by mirror of `arg_val`
+ * in `component` command. 0 is for copying whole of packets.
+ */
+static int
+parse_comp_snaplen(struct sppwk_cmd_comp *component, const char *arg_val)
+{
+	int snaplen;
+
+	if (unlikely(get_int_in_range(&snaplen, arg_val, 0,
+			SPPWK_MIR_SNAPLEN_MAX) != SPPWK_RET_OK)) {
+		RTE_LOG(ERR, WK_CMD_PARSER,
+				"Snaplen should be from 0 to %d. val=%s\n",
+				SPPWK_MIR_SNAPLEN_MAX, arg_val);
+		return SPPWK_RET_NG;
+	}
+
+	component->snaplen = snaplen;
+	return SPPWK_RET_OK;
+}
+
+/**
+ * Parse optional param of `component` command which depends on the type,
+ * group of classifier or snaplen of mirror.
+ */
+static int
+parse_comp_opt(void *output, const char *arg_val, int allow_override)
+{
+	struct sppwk_cmd_comp *component = output;
+
+	if (component->wk_action == SPPWK_ACT_START &&
+			component->wk_type == SPPWK_TYPE_MIR)
+		return parse_comp_snaplen(component, arg_val);
+	return parse_comp_group(output, arg_val, allow_override);
+}
+
 /* Parse given action for port of `arg_val` in `port` command. */
 static int
 parse_port_action(void *output, const char *arg_val,
@@ -543,6 +670,163 @@ parse_port(void *output, const char *arg_val, int allow_override)
 	return SPPWK_RET_OK;
 }
 
+/* Parse name of mirror component which is already started. */
+static int
+parse_mir_comp_name(void *output, const char *arg_val,
+		int allow_override __attribute__ ((unused)))
+{
+	int comp_id;
+
+	comp_id = sppwk_get_lcore_id(arg_val);
+	if (unlikely(comp_id < SPPWK_RET_OK)) {
+		RTE_LOG(ERR, WK_CMD_PARSER,
+				"Unknown component name. val=%s\n", arg_val);
+		return SPPWK_RET_NG;
+	}
+
+	if (unlikely(sppwk_get_comp_type(comp_id) != SPPWK_TYPE_MIR)) {
+		RTE_LOG(ERR, WK_CMD_PARSER,
+				"Not a mirror component. val=%s\n", arg_val);
+		return SPPWK_RET_NG;
+	}
+
+	if (strlen(arg_val) >= SPPWK_NAME_BUFSZ)
+		return SPPWK_RET_NG;
+
+	strcpy(output, arg_val);
+	return SPPWK_RET_OK;
+}
+
+/* Parse N of 1-in-N sampling of mirror, or 0 for all. */
+static int
+parse_limit_sample(void *output, const char *arg_val,
+		int allow_override __attribute__ ((unused)))
+{
+	int ret;
+	unsigned int sample;
+
+	ret = get_uint_in_range(&sample, arg_val, 0, SPPWK_MIR_SAMPLE_MAX);
+	if (unlikely(ret < SPPWK_RET_OK)) {
+		RTE_LOG(ERR, WK_CMD_PARSER,
+				"Invalid sampling of mirror. val=%s\n",
+				arg_val);
+		return SPPWK_RET_NG;
+	}
+
+	*(uint32_t *)output = sample;
+	return SPPWK_RET_OK;
+}
+
+/* Parse max rate per sec of mirror, or 0 for no limit. */
+static int
+parse_limit_rate(void *output, const char *arg_val,
+		int allow_override __attribute__ ((unused)))
+{
+	uint64_t rate;
+	char *endptr = NULL;
+
+	/* Negative value is not rejected by strtoull(). */
+	if (unlikely(arg_val[0] == '-'))
+		return SPPWK_RET_NG;
+
+	rate = strtoull(arg_val, &endptr, 0);
+	if (unlikely(endptr == arg_val) || unlikely(*endptr != '\0') ||
+			unlikely(rate > SPPWK_MIR_RATE_MAX)) {
+		RTE_LOG(ERR, WK_CMD_PARSER,
+				"Invalid rate of mirror. val=%s\n", arg_val);
+		return SPPWK_RET_NG;
+	}
+
+	*(uint64_t *)output = rate;
+	return SPPWK_RET_OK;
+}
+
+/* Parse unit of rate of mirror, `pkts` or `bytes`. */
+static int
+parse_limit_unit(void *output, const char *arg_val,
+		int allow_override __attribute__ ((unused)))
+{
+	int ret;
+
+	ret = get_list_idx(arg_val, MIR_RATE_UNIT_LIST);
+	if (unlikely(ret < SPPWK_RET_OK)) {
+		RTE_LOG(ERR, WK_CMD_PARSER,
+				"Unknown unit of rate. val=%s\n", arg_val);
+		return SPPWK_RET_NG;
+	}
+
+	*(int *)output = ret;
+	return SPPWK_RET_OK;
+}
+
+/* Parse copy mode of mirror, `shallow` or `deep`. */
+static int
+parse_copy_mode(void *output, const char *arg_val,
+		int allow_override __attribute__ ((unused)))
+{
+	int ret;
+
+	ret = get_list_idx(arg_val, MIR_COPY_MODE_LIST);
+	if (unlikely(ret != SPPWK_MIR_COPY_SHALLOW) &&
+			unlikely(ret != SPPWK_MIR_COPY_DEEP)) {
+		RTE_LOG(ERR, WK_CMD_PARSER,
+				"Unknown copy mode. val=%s\n", arg_val);
+		return SPPWK_RET_NG;
+	}
+
+	*(int *)output = ret;
+	return SPPWK_RET_OK;
+}
+
+/* Parse given action of `ring_latency` command. */
+static int
+parse_ring_lat_action(void *output, const char *arg_val,
+		int allow_override __attribute__ ((unused)))
+{
+	int ret;
+	ret = get_list_idx(arg_val, CMD_ACT_LIST);
+	if (unlikely(ret != SPPWK_ACT_START) &&
+			unlikely(ret != SPPWK_ACT_STOP)) {
+		RTE_LOG(ERR, WK_CMD_PARSER,
+				"Unknown ring_latency action. val=%s\n",
+				arg_val);
+		return SPPWK_RET_NG;
+	}
+
+	*(int *)output = ret;
+	return SPPWK_RET_OK;
+}
+
+/* Parse given ring port of `ring_latency` command, which must be added. */
+static int
+parse_ring_lat_port(void *output, const char *arg_val,
+		int allow_override __attribute__ ((unused)))
+{
+	int ret;
+	struct sppwk_port_idx tmp_port;
+	struct sppwk_cmd_ring_latency *ring_lat = output;
+
+	ret = parse_port_uid(&tmp_port, arg_val);
+	if (ret < SPPWK_RET_OK)
+		return SPPWK_RET_NG;
+
+	if (unlikely(tmp_port.iface_type != RING)) {
+		RTE_LOG(ERR, WK_CMD_PARSER, "Port is not a ring. val=%s\n",
+				arg_val);
+		return SPPWK_RET_NG;
+	}
+
+	if (unlikely(is_added_port(tmp_port.iface_type, tmp_port.iface_no,
+			tmp_port.queue_no) == 0)) {
+		RTE_LOG(ERR, WK_CMD_PARSER, "Port not added. val=%s\n",
+				arg_val);
+		return SPPWK_RET_NG;
+	}
+
+	ring_lat->port = tmp_port;
+	return SPPWK_RET_OK;
+}
+
 /* Parse port rx and tx value. */
 static int
 parse_port_direction(void *output, const char *arg_val, int allow_override)
@@ -642,8 +926,18 @@ parse_port_vlan_ops(void *output, const char *arg_val,
 					arg_val);
 			return SPPWK_RET_NG;
 		}
+		/* Weight is only for distributing packets to TX ports. */
+		if (unlikely(ret == SPPWK_PORT_OPS_WEIGHT &&
+				port->dir != SPPWK_PORT_DIR_TX)) {
+			RTE_LOG(ERR, WK_CMD_PARSER,
+					"Weight is only for TX port. val=%s\n",
+					arg_val);
+			return SPPWK_RET_NG;
+		}
 		port_attrs->ops = ret;
 		port_attrs->dir = port->dir;
+		if (ret == SPPWK_PORT_OPS_WEIGHT)
+			port_attrs->weight = 1;
 		break;
 	case SPPWK_PORT_OPS_ADD_VLAN:
 		/* Nothing to do. */
@@ -685,6 +979,28 @@ parse_port_vid(void *output, const char *arg_val,
 	return SPPWK_RET_OK;
 }
 
+/* Parse weight of TX port of balancer for port command. */
+static int
+parse_port_weight(void *output, const char *arg_val,
+		int allow_override __attribute__ ((unused)))
+{
+	struct sppwk_cmd_port *port = output;
+	struct sppwk_port_attrs *port_attrs = &port->port_attrs;
+
+	if (unlikely(port_attrs->ops != SPPWK_PORT_OPS_WEIGHT))
+		return SPPWK_RET_NG;
+
+	if (unlikely(get_int_in_range(&port_attrs->weight, arg_val, 0,
+			SPP_BLC_WEIGHT_MAX) < SPPWK_RET_OK)) {
+		RTE_LOG(ERR, WK_CMD_PARSER,
+				"Invalid `%s` for parsing weight.\n",
+				arg_val);
+		return SPPWK_RET_NG;
+	}
+
+	return SPPWK_RET_OK;
+}
+
 /* Parse PCP for port command */
 static int
 parse_port_pcp(void *output, const char *arg_val,
@@ -799,6 +1115,229 @@ parse_cls_vid(void *output, const char *arg_val,
 	return SPPWK_RET_OK;
 }
 
+/**
+ * Parse IP prefix such as `192.168.1.0/24`, `2001:db8::/32` or `any` for ACL
+ * rule. Address without prefix length is parsed as a host. Bits out of the
+ * prefix are cleared to compare rules as the same.
+ */
+static int
+parse_acl_prefix(const char *arg_val, int *ip_ver, uint8_t *addr,
+		uint8_t *plen)
+{
+	int i;
+	int max_plen;
+	int tmp_plen;
+	char *slash;
+	char addr_str[SPPWK_VAL_BUFSZ];
+
+	memset(addr, 0x00, 16);
+	if (strcmp(arg_val, CLS_ACL_ANY_STR) == 0) {
+		*ip_ver = 0;
+		*plen = 0;
+		return SPPWK_RET_OK;
+	}
+
+	if (unlikely(strlen(arg_val) >= sizeof(addr_str)))
+		return SPPWK_RET_NG;
+	strcpy(addr_str, arg_val);
+
+	slash = strchr(addr_str, '/');
+	if (slash != NULL)
+		*slash = '\0';
+
+	if (inet_pton(AF_INET, addr_str, addr) == 1) {
+		*ip_ver = 4;
+		max_plen = 32;
+	} else if (inet_pton(AF_INET6, addr_str, addr) == 1) {
+		*ip_ver = 6;
+		max_plen = 128;
+	} else
+		return SPPWK_RET_NG;
+
+	tmp_plen = max_plen;
+	if (slash != NULL && get_int_in_range(&tmp_plen, slash + 1, 0,
+			max_plen) < SPPWK_RET_OK)
+		return SPPWK_RET_NG;
+	*plen = (uint8_t)tmp_plen;
+
+	for (i = 0; i < max_plen / 8; i++) {
+		if (tmp_plen >= 8)
+			tmp_plen -= 8;
+		else {
+			addr[i] &= (uint8_t)(0xff << (8 - tmp_plen));
+			tmp_plen = 0;
+		}
+	}
+	return SPPWK_RET_OK;
+}
+
+/* Parse source prefix of ACL rule for classifier_table command. */
+static int
+parse_cls_acl_src(void *output, const char *arg_val,
+		int allow_override __attribute__ ((unused)))
+{
+	struct sppwk_cls_acl_rule *rule = output;
+
+	if (unlikely(parse_acl_prefix(arg_val, &rule->ip_ver,
+			rule->src_addr, &rule->src_plen) < SPPWK_RET_OK)) {
+		RTE_LOG(ERR, WK_CMD_PARSER, "Invalid source `%s`.\n",
+				arg_val);
+		return SPPWK_RET_NG;
+	}
+	return SPPWK_RET_OK;
+}
+
+/**
+ * Parse destination prefix of ACL rule for classifier_table command. It must
+ * be the same IP version as source if both of them are not `any`.
+ */
+static int
+parse_cls_acl_dst(void *output, const char *arg_val,
+		int allow_override __attribute__ ((unused)))
+{
+	int ip_ver;
+	struct sppwk_cls_acl_rule *rule = output;
+
+	if (unlikely(parse_acl_prefix(arg_val, &ip_ver,
+			rule->dst_addr, &rule->dst_plen) < SPPWK_RET_OK)) {
+		RTE_LOG(ERR, WK_CMD_PARSER, "Invalid destination `%s`.\n",
+				arg_val);
+		return SPPWK_RET_NG;
+	}
+
+	if (ip_ver == 0)
+		return SPPWK_RET_OK;
+
+	if (unlikely(rule->ip_ver != 0 && rule->ip_ver != ip_ver)) {
+		RTE_LOG(ERR, WK_CMD_PARSER, "IP version of `%s` is "
+				"different from source.\n", arg_val);
+		return SPPWK_RET_NG;
+	}
+	rule->ip_ver = ip_ver;
+	return SPPWK_RET_OK;
+}
+
+/* Parse protocol name or number of ACL rule for classifier_table command. */
+static int
+parse_cls_acl_proto(void *output, const char *arg_val,
+		int allow_override __attribute__ ((unused)))
+{
+	int idx;
+	int proto;
+	struct sppwk_cls_acl_rule *rule = output;
+
+	if (strcmp(arg_val, CLS_ACL_ANY_STR) == 0) {
+		rule->proto = 0;
+		rule->proto_mask = 0;
+		return SPPWK_RET_OK;
+	}
+
+	idx = get_list_idx(arg_val, CLS_ACL_PROTO_LIST);
+	if (idx >= 0)
+		proto = CLS_ACL_PROTO_NUMS[idx];
+	else if (unlikely(get_int_in_range(&proto, arg_val, 0, UINT8_MAX)
+			< SPPWK_RET_OK)) {
+		RTE_LOG(ERR, WK_CMD_PARSER, "Invalid protocol `%s`.\n",
+				arg_val);
+		return SPPWK_RET_NG;
+	}
+
+	rule->proto = (uint8_t)proto;
+	rule->proto_mask = UINT8_MAX;
+	return SPPWK_RET_OK;
+}
+
+/* Parse L4 port range such as `80`, `1024-65535` or `any` for ACL rule. */
+static int
+parse_acl_port_range(const char *arg_val, uint16_t *lo, uint16_t *hi)
+{
+	int tmp_lo, tmp_hi;
+	char *hyphen;
+	char range_str[SPPWK_VAL_BUFSZ];
+
+	if (strcmp(arg_val, CLS_ACL_ANY_STR) == 0) {
+		*lo = 0;
+		*hi = UINT16_MAX;
+		return SPPWK_RET_OK;
+	}
+
+	if (unlikely(strlen(arg_val) >= sizeof(range_str)))
+		return SPPWK_RET_NG;
+	strcpy(range_str, arg_val);
+
+	hyphen = strchr(range_str, '-');
+	if (hyphen != NULL)
+		*hyphen = '\0';
+
+	if (unlikely(get_int_in_range(&tmp_lo, range_str, 0, UINT16_MAX)
+			< SPPWK_RET_OK))
+		return SPPWK_RET_NG;
+
+	tmp_hi = tmp_lo;
+	if (hyphen != NULL && get_int_in_range(&tmp_hi, hyphen + 1, tmp_lo,
+			UINT16_MAX) < SPPWK_RET_OK)
+		return SPPWK_RET_NG;
+
+	*lo = (uint16_t)tmp_lo;
+	*hi = (uint16_t)tmp_hi;
+	return SPPWK_RET_OK;
+}
+
+/**
+ * Check if port range other than `any` is given with protocol which has L4
+ * ports at the head of its header. Protocol is parsed before ports.
+ */
+static int
+check_acl_port_range(const struct sppwk_cls_acl_rule *rule, uint16_t lo,
+		uint16_t hi)
+{
+	if (lo == 0 && hi == UINT16_MAX)
+		return SPPWK_RET_OK;
+
+	if (unlikely(rule->proto_mask == 0 || (rule->proto != IPPROTO_TCP &&
+			rule->proto != IPPROTO_UDP &&
+			rule->proto != IPPROTO_SCTP))) {
+		RTE_LOG(ERR, WK_CMD_PARSER, "Port range is only for tcp, "
+				"udp or sctp.\n");
+		return SPPWK_RET_NG;
+	}
+	return SPPWK_RET_OK;
+}
+
+/* Parse source port range of ACL rule for classifier_table command. */
+static int
+parse_cls_acl_sport(void *output, const char *arg_val,
+		int allow_override __attribute__ ((unused)))
+{
+	struct sppwk_cls_acl_rule *rule = output;
+
+	if (unlikely(parse_acl_port_range(arg_val, &rule->src_port_lo,
+			&rule->src_port_hi) < SPPWK_RET_OK)) {
+		RTE_LOG(ERR, WK_CMD_PARSER, "Invalid source port `%s`.\n",
+				arg_val);
+		return SPPWK_RET_NG;
+	}
+	return check_acl_port_range(rule, rule->src_port_lo,
+			rule->src_port_hi);
+}
+
+/* Parse destination port range of ACL rule for classifier_table command. */
+static int
+parse_cls_acl_dport(void *output, const char *arg_val,
+		int allow_override __attribute__ ((unused)))
+{
+	struct sppwk_cls_acl_rule *rule = output;
+
+	if (unlikely(parse_acl_port_range(arg_val, &rule->dst_port_lo,
+			&rule->dst_port_hi) < SPPWK_RET_OK)) {
+		RTE_LOG(ERR, WK_CMD_PARSER,
+				"Invalid destination port `%s`.\n", arg_val);
+		return SPPWK_RET_NG;
+	}
+	return check_acl_port_range(rule, rule->dst_port_lo,
+			rule->dst_port_hi);
+}
+
 /* Parse port for classifier_table command */
 static int
 parse_cls_port(void *cls_cmd_attr, const char *arg_val,
@@ -823,6 +1362,15 @@ parse_cls_port(void *cls_cmd_attr, const char *arg_val,
 	if (cls_attrs->cls_type == SPPWK_CLS_TYPE_MAC)
 		cls_attrs->vid = ETH_VLAN_ID_MAX;
 
+	/**
+	 * Several ACL rules can be assigned to a port in addition to MAC
+	 * address, so the port is not checked if used.
+	 */
+	if (cls_attrs->cls_type == SPPWK_CLS_TYPE_ACL) {
+		cls_attrs->port = tmp_port;
+		return SPPWK_RET_OK;
+	}
+
 	if (unlikely(cls_attrs->wk_action == SPPWK_ACT_ADD)) {
 		if (!is_used_with_addr(ETH_VLAN_ID_MAX, 0,
 				tmp_port.iface_type, tmp_port.iface_no,
@@ -930,6 +1478,57 @@ cmd_ops_list[][SPPWK_MAX_PARAMS] = {
 		},
 		SPPWK_CMD_NO_PARAMS,
 	},
+	{  /* classifier_table(ACL) */
+		{
+			.name = "action",
+			.offset = offsetof(struct sppwk_cmd_attrs,
+					spec.cls_table.wk_action),
+			.func = parse_cls_action
+		},
+		{
+			.name = "type",
+			.offset = offsetof(struct sppwk_cmd_attrs,
+					spec.cls_table.cls_type),
+			.func = parse_cls_type
+		},
+		{
+			.name = "source",
+			.offset = offsetof(struct sppwk_cmd_attrs,
+					spec.cls_table.acl),
+			.func = parse_cls_acl_src
+		},
+		{
+			.name = "destination",
+			.offset = offsetof(struct sppwk_cmd_attrs,
+					spec.cls_table.acl),
+			.func = parse_cls_acl_dst
+		},
+		{
+			.name = "protocol",
+			.offset = offsetof(struct sppwk_cmd_attrs,
+					spec.cls_table.acl),
+			.func = parse_cls_acl_proto
+		},
+		{
+			.name = "source port",
+			.offset = offsetof(struct sppwk_cmd_attrs,
+					spec.cls_table.acl),
+			.func = parse_cls_acl_sport
+		},
+		{
+			.name = "destination port",
+			.offset = offsetof(struct sppwk_cmd_attrs,
+					spec.cls_table.acl),
+			.func = parse_cls_acl_dport
+		},
+		{
+			.name = "port",
+			.offset = offsetof(struct sppwk_cmd_attrs,
+					spec.cls_table),
+			.func = parse_cls_port
+		},
+		SPPWK_CMD_NO_PARAMS,
+	},
 	{ SPPWK_CMD_NO_PARAMS },  /* _get_client_id */
 	{ SPPWK_CMD_NO_PARAMS },  /* status */
 	{ SPPWK_CMD_NO_PARAMS },  /* exit */
@@ -955,6 +1554,11 @@ cmd_ops_list[][SPPWK_MAX_PARAMS] = {
 			.offset = offsetof(struct sppwk_cmd_attrs, spec.comp),
 			.func = parse_comp_type
 		},
+		{
+			.name = "group or snaplen",
+			.offset = offsetof(struct sppwk_cmd_attrs, spec.comp),
+			.func = parse_comp_opt
+		},
 		SPPWK_CMD_NO_PARAMS,
 	},
 	{  /* port */
@@ -997,6 +1601,64 @@ cmd_ops_list[][SPPWK_MAX_PARAMS] = {
 		},
 		SPPWK_CMD_NO_PARAMS,
 	},
+	{  /* ring_latency */
+		{
+			.name = "action",
+			.offset = offsetof(struct sppwk_cmd_attrs,
+					spec.ring_lat.wk_action),
+			.func = parse_ring_lat_action
+		},
+		{
+			.name = "port",
+			.offset = offsetof(struct sppwk_cmd_attrs,
+					spec.ring_lat),
+			.func = parse_ring_lat_port
+		},
+		SPPWK_CMD_NO_PARAMS,
+	},
+	{ SPPWK_CMD_NO_PARAMS }, /* filter */
+	{  /* limit */
+		{
+			.name = "name",
+			.offset = offsetof(struct sppwk_cmd_attrs,
+					spec.limit.name),
+			.func = parse_mir_comp_name
+		},
+		{
+			.name = "sample",
+			.offset = offsetof(struct sppwk_cmd_attrs,
+					spec.limit.mir_limit.sample),
+			.func = parse_limit_sample
+		},
+		{
+			.name = "rate",
+			.offset = offsetof(struct sppwk_cmd_attrs,
+					spec.limit.mir_limit.rate),
+			.func = parse_limit_rate
+		},
+		{
+			.name = "unit",
+			.offset = offsetof(struct sppwk_cmd_attrs,
+					spec.limit.mir_limit.is_bytes),
+			.func = parse_limit_unit
+		},
+		SPPWK_CMD_NO_PARAMS,
+	},
+	{  /* copy_mode */
+		{
+			.name = "name",
+			.offset = offsetof(struct sppwk_cmd_attrs,
+					spec.copy_mode.name),
+			.func = parse_mir_comp_name
+		},
+		{
+			.name = "mode",
+			.offset = offsetof(struct sppwk_cmd_attrs,
+					spec.copy_mode.copy_mode),
+			.func = parse_copy_mode
+		},
+		SPPWK_CMD_NO_PARAMS,
+	},
 	{ SPPWK_CMD_NO_PARAMS }, /* termination */
 };
 
@@ -1027,12 +1689,77 @@ parse_cmd_comp(struct sppwk_cmd_req *request, int argc, char *argv[],
 	return SPPWK_RET_OK;
 }
 
+/**
+ * Validate given command for filter of mirror component. Expression is split
+ * with spaces as other params, so joined again. It is cleared if not given.
+ */
+static int
+parse_cmd_filter(struct sppwk_cmd_req *request, int argc, char *argv[],
+		struct sppwk_parse_err_msg *wk_err_msg,
+		int maxargc __attribute__ ((unused)))
+{
+	int i;
+	size_t len = 0;
+	struct sppwk_cmd_filter *filter = &request->commands[0].spec.filter;
+
+	if (unlikely(parse_mir_comp_name(filter->name, argv[1], 0) !=
+			SPPWK_RET_OK))
+		return set_detailed_parse_error(wk_err_msg, "name", argv[1]);
+
+	filter->expr[0] = '\0';
+	for (i = 2; i < argc; i++) {
+		len += strlen(argv[i]) + (i > 2);
+		if (unlikely(len >= SPPWK_FILTER_BUFSZ)) {
+			RTE_LOG(ERR, WK_CMD_PARSER,
+					"Filter expression is too long.\n");
+			return set_detailed_parse_error(wk_err_msg, "expr",
+					argv[i]);
+		}
+		if (i > 2)
+			strcat(filter->expr, " ");
+		strcat(filter->expr, argv[i]);
+	}
+	return SPPWK_RET_OK;
+}
+
+/* Return 1 as true if given type of classifier_table is ACL. */
+static inline int
+is_cls_type_acl(const char *type_str)
+{
+	return strcmp(type_str, CLS_TYPE_LIST[SPPWK_CLS_TYPE_ACL]) == 0;
+}
+
 /* Validate given command for clssfier_table. */
 /* TODO(yasufum) spp_vf specific function must be localized to vf. */
 static int
 parse_cmd_cls_table(struct sppwk_cmd_req *request, int argc, char *argv[],
 		struct sppwk_parse_err_msg *wk_err_msg, int maxargc)
 {
+	/* ACL rule is not given with MAC address. */
+	if (unlikely(is_cls_type_acl(argv[2]))) {
+		RTE_LOG(ERR, WK_CMD_PARSER, "Invalid params for `%s` of "
+				"classifier_table.\n", argv[2]);
+		return set_detailed_parse_error(wk_err_msg, "type", argv[2]);
+	}
+
+	return parse_cmd_comp(request, argc, argv, wk_err_msg, maxargc);
+}
+
+/* Validate given command for clssfier_table of ACL. */
+/* TODO(yasufum) spp_vf specific function must be localized to vf. */
+static int
+parse_cmd_cls_table_acl(struct sppwk_cmd_req *request, int argc,
+		char *argv[], struct sppwk_parse_err_msg *wk_err_msg,
+		int maxargc)
+{
+	if (unlikely(!is_cls_type_acl(argv[2]))) {
+		RTE_LOG(ERR, WK_CMD_PARSER, "Invalid params for `%s` of "
+				"classifier_table.\n", argv[2]);
+		return set_detailed_parse_error(wk_err_msg, "type", argv[2]);
+	}
+
+	memset(&request->commands[0].spec.cls_table.acl, 0x00,
+			sizeof(struct sppwk_cls_acl_rule));
 	return parse_cmd_comp(request, argc, argv, wk_err_msg, maxargc);
 }
 
@@ -1047,6 +1774,13 @@ parse_cmd_cls_table_vlan(struct sppwk_cmd_req *request, int argc, char *argv[],
 	int ci = request->commands[0].type;
 	int pi = 0;
 	struct sppwk_cmd_ops *list = NULL;
+
+	if (unlikely(is_cls_type_acl(argv[2]))) {
+		RTE_LOG(ERR, WK_CMD_PARSER, "Invalid params for `%s` of "
+				"classifier_table.\n", argv[2]);
+		return set_detailed_parse_error(wk_err_msg, "type", argv[2]);
+	}
+
 	for (pi = 1; pi < argc; pi++) {
 		list = &cmd_ops_list[ci][pi-1];
 		ret = (*list->func)((void *)
@@ -1063,6 +1797,13 @@ parse_cmd_cls_table_vlan(struct sppwk_cmd_req *request, int argc, char *argv[],
 	return SPPWK_RET_OK;
 }
 
+/* Parser of weight given in the place of VLAN ID of port command. */
+static struct sppwk_cmd_ops port_weight_ops = {
+	.name = "port weight",
+	.offset = offsetof(struct sppwk_cmd_attrs, spec.port),
+	.func = parse_port_weight
+};
+
 /* Validate given command for port. */
 static int
 parse_cmd_port(struct sppwk_cmd_req *request, int argc, char *argv[],
@@ -1073,13 +1814,23 @@ parse_cmd_port(struct sppwk_cmd_req *request, int argc, char *argv[],
 	int pi = 0;
 	struct sppwk_cmd_ops *list = NULL;
 	int flag = 0;
+	int is_weight = 0;
 
 	/* check add vlatag */
 	if (argc == maxargc)
 		flag = 1;
 
+	/* Weight of port already added can be changed as well as vlantag. */
+	if (argc > 5 && strcmp(argv[5],
+			PORT_ABILITY_LIST[SPPWK_PORT_OPS_WEIGHT]) == 0) {
+		flag = 1;
+		is_weight = 1;
+	}
+
 	for (pi = 1; pi < argc; pi++) {
 		list = &cmd_ops_list[ci][pi-1];
+		if (is_weight && pi == 6)
+			list = &port_weight_ops;
 		ret = (*list->func)((void *)
 				((char *)&request->commands[0] + list->offset),
 				argv[pi], flag);
@@ -1115,11 +1866,16 @@ struct cmd_parse_attrs {
 static struct cmd_parse_attrs cmd_attr_list[] = {
 	{ "classifier_table", 5, 5, parse_cmd_cls_table },
 	{ "classifier_table", 6, 6, parse_cmd_cls_table_vlan },
+	{ "classifier_table", 9, 9, parse_cmd_cls_table_acl },
 	{ "_get_client_id", 1, 1, NULL },
 	{ "status", 1, 1, NULL },
 	{ "exit", 1, 1, NULL },
-	{ "component", 3, 5, parse_cmd_comp },
+	{ "component", 3, 6, parse_cmd_comp },
 	{ "port", 5, 8, parse_cmd_port },
+	{ "ring_latency", 3, 3, parse_cmd_comp },
+	{ "filter", 2, SPPWK_MAX_TOKENS, parse_cmd_filter },
+	{ "limit", 5, 5, parse_cmd_comp },
+	{ "copy_mode", 3, 3, parse_cmd_comp },
 	{ "", 0, 0, NULL }  /* termination */
 };
 
@@ -1139,7 +1895,7 @@ parse_wk_cmd(struct sppwk_cmd_req *request,
 	 * It is so misunderstandable for maintainance.
 	 */
 	int argc = 0;
-	char *argv[SPPWK_MAX_PARAMS];
+	char *argv[SPPWK_MAX_TOKENS];
 	char tmp_str[SPPWK_MAX_PARAMS*SPPWK_VAL_BUFSZ];
 	memset(argv, 0x00, sizeof(argv));
 	memset(tmp_str, 0x00, sizeof(tmp_str));
@@ -1152,12 +1908,12 @@ parse_wk_cmd(struct sppwk_cmd_req *request,
 	 * here. The checking is not explicit in the name of func, and checking
 	 * itself is done in the next step as following. No need to do here.
 	 */
-	ret = split_cmd_params(tmp_str, SPPWK_MAX_PARAMS, &argc, argv);
+	ret = split_cmd_params(tmp_str, SPPWK_MAX_TOKENS, &argc, argv);
 	if (ret < SPPWK_RET_OK) {
 		RTE_LOG(ERR, WK_CMD_PARSER,
 				"Num of params should be less than %d. "
 				"request_str=%s\n",
-				SPPWK_MAX_PARAMS, request_str);
+				SPPWK_MAX_TOKENS, request_str);
 		return set_parse_error(wk_err_msg, SPPWK_PARSE_WRONG_FORMAT,
 				NULL);
 	}
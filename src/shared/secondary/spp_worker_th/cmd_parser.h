@@ -15,8 +15,17 @@
 /* Maximum number of commands per request. */
 #define SPPWK_MAX_CMDS 32
 
-/* Maximum number of parameters per command. */
-#define SPPWK_MAX_PARAMS 8
+/**
+ * Maximum number of parameters per command. `classifier_table` of ACL takes
+ * the most of params.
+ */
+#define SPPWK_MAX_PARAMS 9
+
+/**
+ * Maximum number of tokens of a command. It is larger than SPPWK_MAX_PARAMS
+ * because filter expression of `filter` command is given with spaces.
+ */
+#define SPPWK_MAX_TOKENS 64
 
 /* Size of string buffer of message including null char. */
 #define SPPWK_NAME_BUFSZ  32
@@ -24,6 +33,15 @@
 /* Size of string buffer of detailed message including null char. */
 #define SPPWK_VAL_BUFSZ 111
 
+/* Max snaplen of mirror, data room of a segment of mbuf of copied packet. */
+#define SPPWK_MIR_SNAPLEN_MAX 2048
+
+/* Max N of 1-in-N sampling of mirror. */
+#define SPPWK_MIR_SAMPLE_MAX 65535
+
+/* Max rate per sec of mirror, which is enough for 100 GB/s. */
+#define SPPWK_MIR_RATE_MAX 100000000000ULL
+
 /**
  * Error code for diagnosis and notifying the reason. It starts from 1 because
  * 0 is used for succeeded and not appropriate for error in general.
@@ -68,11 +86,16 @@ const char *sppwk_action_str(enum sppwk_action wk_action);
 enum sppwk_cmd_type {
 	SPPWK_CMDTYPE_CLS_MAC,
 	SPPWK_CMDTYPE_CLS_VLAN,
+	SPPWK_CMDTYPE_CLS_ACL,
 	SPPWK_CMDTYPE_CLIENT_ID,  /**< get_client_id */
 	SPPWK_CMDTYPE_STATUS,  /**< status */
 	SPPWK_CMDTYPE_EXIT,  /**< exit */
 	SPPWK_CMDTYPE_WORKER,  /**< worker thread */
 	SPPWK_CMDTYPE_PORT,  /**< port */
+	SPPWK_CMDTYPE_RING_LATENCY,  /**< ring_latency */
+	SPPWK_CMDTYPE_FILTER,  /**< filter */
+	SPPWK_CMDTYPE_LIMIT,  /**< limit */
+	SPPWK_CMDTYPE_COPY_MODE,  /**< copy_mode */
 };
 
 const char *sppwk_cmd_type_str(enum sppwk_cmd_type ctype);
@@ -80,9 +103,10 @@ const char *sppwk_cmd_type_str(enum sppwk_cmd_type ctype);
 /* `classifier_table` command specific parameters. */
 struct sppwk_cls_cmd_attrs {
 	enum sppwk_action wk_action;  /**< add or del */
-	enum sppwk_cls_type cls_type;  /**< currently only for MAC. */
+	enum sppwk_cls_type cls_type;  /**< MAC, VLAN or ACL. */
 	int vid;  /**< VLAN ID  */
 	char mac[SPPWK_VAL_BUFSZ];  /**< MAC address  */
+	struct sppwk_cls_acl_rule acl;  /**< 5-tuple rule for ACL */
 	struct sppwk_port_idx port;/**< Destination port type and number */
 };
 
@@ -97,6 +121,8 @@ struct sppwk_cmd_comp {
 	char name[SPPWK_NAME_BUFSZ];  /**< component name */
 	unsigned int core;  /**< logical core number */
 	enum sppwk_worker_type wk_type;  /**< worker thread type */
+	char grp_name[SPPWK_NAME_BUFSZ];  /**< classifier of group, or empty */
+	uint32_t snaplen;  /**< bytes copied by mirror, or 0 for all */
 };
 
 /* `port` command parameters. */
@@ -108,6 +134,30 @@ struct sppwk_cmd_port {
 	struct sppwk_port_attrs port_attrs;  /**< port attrs for spp_vf. */
 };
 
+/* `ring_latency` command parameters. */
+struct sppwk_cmd_ring_latency {
+	enum sppwk_action wk_action;  /**< start or stop */
+	struct sppwk_port_idx port;  /**< ring port to be measured */
+};
+
+/* `filter` command parameters. */
+struct sppwk_cmd_filter {
+	char name[SPPWK_NAME_BUFSZ];  /**< component name */
+	char expr[SPPWK_FILTER_BUFSZ];  /**< filter expression, or empty */
+};
+
+/* `limit` command parameters. */
+struct sppwk_cmd_limit {
+	char name[SPPWK_NAME_BUFSZ];  /**< component name */
+	struct sppwk_mir_limit mir_limit;  /**< sampling and rate */
+};
+
+/* `copy_mode` command parameters. */
+struct sppwk_cmd_copy_mode {
+	char name[SPPWK_NAME_BUFSZ];  /**< component name */
+	enum sppwk_mir_copy_mode copy_mode;  /**< shallow or deep */
+};
+
 /* TODO(yasufum) Add usage and desc for members. What's command descriptors? */
 struct sppwk_cmd_attrs {
 	enum sppwk_cmd_type type; /**< command type */
@@ -117,6 +167,10 @@ struct sppwk_cmd_attrs {
 		struct sppwk_cmd_flush flush;
 		struct sppwk_cmd_comp comp;
 		struct sppwk_cmd_port port;
+		struct sppwk_cmd_ring_latency ring_lat;
+		struct sppwk_cmd_filter filter;
+		struct sppwk_cmd_limit limit;
+		struct sppwk_cmd_copy_mode copy_mode;
 	} spec;  /* TODO(yasufum) rename no reasonable name */
 };
 
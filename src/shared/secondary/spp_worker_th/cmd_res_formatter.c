@@ -4,8 +4,12 @@
 
 #include "cmd_res_formatter.h"
 #include "port_capability.h"
+#include "tx_coalesce.h"
 #include "cmd_utils.h"
 #include "shared/secondary/json_helper.h"
+#include "shared/chain_latency.h"
+
+#include "latency_stats.h"
 
 #ifdef SPP_VF_MODULE
 #include "vf_deps.h"
@@ -30,6 +34,7 @@ const char *PORT_ABILITY_STAT_LIST[] = {
 	"none",
 	"add",
 	"del",
+	"weight",
 	"",  /* termination */
 };
 
@@ -305,11 +310,12 @@ append_core_element_value(struct sppwk_lcore_params *params,
 		const unsigned int lcore_id,
 		const char *name, const char *type,
 		const int num_rx, const struct sppwk_port_idx *rx_ports,
-		const int num_tx, const struct sppwk_port_idx *tx_ports)
+		const int num_tx, const struct sppwk_port_idx *tx_ports,
+		const struct sppwk_tx_coal_stats *tx_stats)
 {
 	int ret = SPPWK_RET_NG;
 	int unuse_flg = 0;
-	char *buff, *tmp_buff;
+	char *buff, *tmp_buff, *stats_buff;
 	buff = params->output;
 	tmp_buff = spp_strbuf_allocate(CMD_RES_BUF_INIT_SIZE);
 	if (unlikely(tmp_buff == NULL)) {
@@ -353,6 +359,30 @@ append_core_element_value(struct sppwk_lcore_params *params,
 			return ret;
 	}
 
+	/* Counters of flushing TX buffers, such as "tx_flush": {...}. */
+	if (unuse_flg && tx_stats != NULL) {
+		stats_buff = spp_strbuf_allocate(CMD_RES_BUF_INIT_SIZE);
+		if (unlikely(stats_buff == NULL)) {
+			RTE_LOG(ERR, WK_CMD_RES_FMT,
+					"Failed to allocate buffer of TX stats. "
+					"(name = %s)\n", name);
+			spp_strbuf_free(tmp_buff);
+			return SPPWK_RET_NG;
+		}
+
+		ret = append_json_uint64_value(&stats_buff, "full",
+				tx_stats->full_flushes);
+		if (likely(ret == SPPWK_RET_OK))
+			ret = append_json_uint64_value(&stats_buff, "timeout",
+					tx_stats->timeout_flushes);
+		if (likely(ret == SPPWK_RET_OK))
+			ret = append_json_block_brackets(&tmp_buff, "tx_flush",
+					stats_buff);
+		spp_strbuf_free(stats_buff);
+		if (unlikely(ret < SPPWK_RET_OK))
+			return ret;
+	}
+
 	ret = append_json_block_brackets(&buff, "", tmp_buff);
 	spp_strbuf_free(tmp_buff);
 	params->output = buff;
@@ -585,3 +615,120 @@ add_master_lcore(const char *name, char **output,
 	ret = append_json_int_value(output, name, rte_get_master_lcore());
 	return ret;
 }
+
+/* Append summary of latency of a ring such as `{"port": "ring:0", ...}`. */
+static int
+append_ring_latency_block(char **output, int ring_id,
+		const struct latency_hist *stats)
+{
+	int ret = SPPWK_RET_NG;
+	int hist_len;
+	char port_str[CMD_TAG_APPEND_SIZE];
+	char hist_str[LATENCY_HIST_JSON_LEN];
+	char *tmp_buff;
+
+	/* Members of summary of histogram are appended without braces. */
+	hist_len = latency_hist_json(hist_str, sizeof(hist_str), stats);
+	if (unlikely(hist_len < 2 || hist_len >= (int)sizeof(hist_str))) {
+		RTE_LOG(ERR, WK_CMD_RES_FMT,
+				"Failed to format ring latency. "
+				"(ring = %d)\n", ring_id);
+		return SPPWK_RET_NG;
+	}
+
+	tmp_buff = spp_strbuf_allocate(CMD_RES_BUF_INIT_SIZE);
+	if (unlikely(tmp_buff == NULL)) {
+		RTE_LOG(ERR, WK_CMD_RES_FMT,
+				"Failed to allocate buffer of ring latency. "
+				"(ring = %d)\n", ring_id);
+		return SPPWK_RET_NG;
+	}
+
+	sppwk_port_uid(port_str, RING, ring_id, 0);
+	ret = append_json_str_value(&tmp_buff, "port", port_str);
+	if (likely(ret == SPPWK_RET_OK))
+		ret = append_json_int_value(&tmp_buff, "enabled",
+				sppwk_is_ring_latency_enabled(ring_id));
+	if (likely(ret == SPPWK_RET_OK))
+		ret = append_json_comma(&tmp_buff);
+	if (likely(ret == SPPWK_RET_OK)) {
+		tmp_buff = spp_strbuf_append(tmp_buff, hist_str + 1,
+				hist_len - 2);
+		if (unlikely(tmp_buff == NULL))
+			return SPPWK_RET_NG;
+	}
+	if (likely(ret == SPPWK_RET_OK))
+		ret = append_json_block_brackets(output, "", tmp_buff);
+
+	spp_strbuf_free(tmp_buff);
+	return ret;
+}
+
+/**
+ * Add entry of latency of rings in nano sec to a response in JSON such as
+ * `"ring_latency": [{"port": "ring:0", "enabled": 1, "count": 10, ...}]`.
+ * Rings neither enabled nor having any of sampled packets are not included.
+ */
+int
+add_ring_latency(const char *name, char **output,
+		void *tmp __attribute__ ((unused)))
+{
+	int ret = SPPWK_RET_OK;
+	int ring_id;
+	struct latency_hist stats;
+	char *tmp_buff = spp_strbuf_allocate(CMD_RES_BUF_INIT_SIZE);
+	if (unlikely(tmp_buff == NULL)) {
+		RTE_LOG(ERR, WK_CMD_RES_FMT,
+				"Failed to get empty buf for append `%s`.\n",
+				name);
+		return SPPWK_RET_NG;
+	}
+
+	for (ring_id = 0; ring_id < sppwk_get_ring_latency_stats_count();
+			ring_id++) {
+		sppwk_get_ring_latency_stats(ring_id, &stats);
+		if (stats.count == 0 &&
+				!sppwk_is_ring_latency_enabled(ring_id))
+			continue;
+
+		ret = append_ring_latency_block(&tmp_buff, ring_id, &stats);
+		if (unlikely(ret < SPPWK_RET_OK)) {
+			spp_strbuf_free(tmp_buff);
+			return SPPWK_RET_NG;
+		}
+	}
+
+	ret = append_json_array_brackets(output, name, tmp_buff);
+	spp_strbuf_free(tmp_buff);
+	return ret;
+}
+
+/**
+ * Add entry of latency of service chain in nano sec to a response in JSON
+ * such as `"chain_latency": [{"point": "ring:0", "dir": "rx", ...}]`. It is
+ * not included if measurement is disabled.
+ */
+int
+add_chain_latency(const char *name, char **output,
+		void *tmp __attribute__ ((unused)))
+{
+	int len;
+	char chain_lat[CHAIN_LAT_JSON_SIZE];
+
+	if (!chain_lat_enabled())
+		return SPPWK_RET_OK;
+
+	chain_lat_json(chain_lat, sizeof(chain_lat));
+	len = strlen(*output);
+	*output = spp_strbuf_append(*output, "",
+			strlen(name) + strlen(chain_lat) + JSON_APPEND_LEN);
+	if (unlikely(*output == NULL)) {
+		RTE_LOG(ERR, WK_CMD_RES_FMT,
+				"Failed to add `%s` to response.\n", name);
+		return SPPWK_RET_NG;
+	}
+
+	sprintf(&(*output)[len], JSON_APPEND_VALUE("%s"),
+			JSON_APPEND_COMMA(len), name, chain_lat);
+	return SPPWK_RET_OK;
+}
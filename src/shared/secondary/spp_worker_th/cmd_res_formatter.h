@@ -51,7 +51,8 @@ int append_core_element_value(struct sppwk_lcore_params *params,
 		const unsigned int lcore_id,
 		const char *name, const char *type,
 		const int num_rx, const struct sppwk_port_idx *rx_ports,
-		const int num_tx, const struct sppwk_port_idx *tx_ports);
+		const int num_tx, const struct sppwk_port_idx *tx_ports,
+		const struct sppwk_tx_coal_stats *tx_stats);
 
 int append_response_list_value(char **output,
 		struct cmd_res_formatter_ops *responses, void *tmp);
@@ -74,4 +75,10 @@ int add_interface(const char *name, char **output,
 
 int add_master_lcore(const char *name, char **output,
 		void *tmp __attribute__ ((unused)));
+
+int add_ring_latency(const char *name, char **output,
+		void *tmp __attribute__ ((unused)));
+
+int add_chain_latency(const char *name, char **output,
+		void *tmp __attribute__ ((unused)));
 #endif
@@ -606,6 +606,29 @@ set_component_change_port(struct sppwk_port_info *port,
 	}
 }
 
+/**
+ * Check if component of given ID is still referred from any of lcores.
+ * Stopped component is referred until its worker thread flushes its TX
+ * buffers with the flush command.
+ */
+static int
+is_comp_id_referred(int comp_id)
+{
+	int lcore_id, cnt;
+	struct core_mng_info *info;
+	struct core_info *core;
+
+	for (lcore_id = 0; lcore_id < RTE_MAX_LCORE; lcore_id++) {
+		info = g_mng_data.p_core_info + lcore_id;
+		core = &info->core[info->ref_index];
+		for (cnt = 0; cnt < core->num; cnt++) {
+			if (core->id[cnt] == comp_id)
+				return 1;
+		}
+	}
+	return 0;
+}
+
 /* Get ID of unused lcore. */
 int
 get_free_lcore_id(void)
@@ -614,7 +637,8 @@ get_free_lcore_id(void)
 
 	int cnt = 0;
 	for (cnt = 0; cnt < RTE_MAX_LCORE; cnt++) {
-		if ((comp_info + cnt)->wk_type == SPPWK_TYPE_NONE)
+		if ((comp_info + cnt)->wk_type == SPPWK_TYPE_NONE &&
+				!is_comp_id_referred(cnt))
 			return cnt;
 	}
 	return SPPWK_RET_NG;
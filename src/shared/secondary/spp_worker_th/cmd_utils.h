@@ -21,6 +21,8 @@
  */
 /** Identifier string for each component (status command) */
 #define SPPWK_TYPE_CLS_STR "classifier"
+#define SPPWK_TYPE_CLS_LEARN_STR "classifier_learn"
+#define SPPWK_TYPE_BLC_STR "balancer"
 #define SPPWK_TYPE_MRG_STR "merge"
 #define SPPWK_TYPE_FWD_STR "forward"
 #define SPPWK_TYPE_MIR_STR "mirror"
@@ -39,6 +41,9 @@
 /** Maximum VLAN PCP, used only for spp_vf. */
 #define SPP_VLAN_PCP_MAX 7
 
+/** Maximum weight of TX port of balancer, used only for spp_vf. */
+#define SPP_BLC_WEIGHT_MAX 255
+
 /* Max number of core status check */
 #define SPP_CORE_STATUS_CHECK_MAX 5
 
@@ -60,6 +65,8 @@
  */
 /* Name string for each component */
 #define CORE_TYPE_CLASSIFIER_MAC_STR "classifier"
+#define CORE_TYPE_CLASSIFIER_LEARN_STR "classifier_learn"
+#define CORE_TYPE_BALANCER_STR "balancer"
 #define CORE_TYPE_MERGE_STR	     "merge"
 #define CORE_TYPE_FORWARD_STR	     "forward"
 #define CORE_TYPE_MIRROR_STR	     "mirror"
@@ -68,7 +75,8 @@
 enum sppwk_cls_type {
 	SPPWK_CLS_TYPE_NONE,
 	SPPWK_CLS_TYPE_MAC,
-	SPPWK_CLS_TYPE_VLAN
+	SPPWK_CLS_TYPE_VLAN,
+	SPPWK_CLS_TYPE_ACL  /* 5-tuple of L3 and L4 headers. */
 };
 
 /* Flag of processing type to copy management information */
@@ -0,0 +1,143 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include <rte_log.h>
+#include <rte_lcore.h>
+#include <rte_malloc.h>
+#include <rte_rcu_qsbr.h>
+
+#include "conf_rcu.h"
+#include "../return_codes.h"
+
+#define RTE_LOGTYPE_SPPWK_CONF_RCU RTE_LOGTYPE_USER1
+
+/* Config waiting for worker threads to pass through quiescent state. */
+struct conf_defer_ent {
+	uint64_t token;  /* Token of QSBR at releasing the config. */
+	void *conf;  /* Config to be released. */
+	sppwk_conf_free_t free_fn;  /* Function to release the config. */
+	void *arg;  /* Argument of free_fn. */
+	struct conf_defer_ent *next;
+};
+
+/* QSBR variable of worker threads, each of which is identified with lcore. */
+static struct rte_rcu_qsbr *g_conf_qsv;
+
+/* List of deferred configs in the order of token. Used only by master. */
+static struct conf_defer_ent *g_defer_head;
+static struct conf_defer_ent *g_defer_tail;
+
+/* Initialize QSBR variable of worker threads. */
+int
+sppwk_conf_rcu_init(void)
+{
+	size_t sz = rte_rcu_qsbr_get_memsize(RTE_MAX_LCORE);
+
+	g_conf_qsv = rte_zmalloc(NULL, sz, RTE_CACHE_LINE_SIZE);
+	if (unlikely(g_conf_qsv == NULL)) {
+		RTE_LOG(ERR, SPPWK_CONF_RCU, "Cannot allocate QSBR variable.\n");
+		return SPPWK_RET_NG;
+	}
+
+	if (unlikely(rte_rcu_qsbr_init(g_conf_qsv, RTE_MAX_LCORE) != 0)) {
+		RTE_LOG(ERR, SPPWK_CONF_RCU,
+				"Cannot initialize QSBR variable.\n");
+		rte_free(g_conf_qsv);
+		g_conf_qsv = NULL;
+		return SPPWK_RET_NG;
+	}
+	return SPPWK_RET_OK;
+}
+
+/* Start to report quiescent state from worker thread. */
+void
+sppwk_conf_rcu_online(unsigned int lcore_id)
+{
+	rte_rcu_qsbr_thread_register(g_conf_qsv, lcore_id);
+	rte_rcu_qsbr_thread_online(g_conf_qsv, lcore_id);
+}
+
+/* Stop to report quiescent state from worker thread. */
+void
+sppwk_conf_rcu_offline(unsigned int lcore_id)
+{
+	rte_rcu_qsbr_thread_offline(g_conf_qsv, lcore_id);
+	rte_rcu_qsbr_thread_unregister(g_conf_qsv, lcore_id);
+}
+
+/* Report quiescent state from worker thread. */
+void
+sppwk_conf_rcu_quiescent(unsigned int lcore_id)
+{
+	rte_rcu_qsbr_quiescent(g_conf_qsv, lcore_id);
+}
+
+/* Release the first entry of deferred list. */
+static void
+release_defer_head(void)
+{
+	struct conf_defer_ent *ent = g_defer_head;
+
+	ent->free_fn(ent->conf, ent->arg);
+	g_defer_head = ent->next;
+	if (g_defer_head == NULL)
+		g_defer_tail = NULL;
+	free(ent);
+}
+
+/* Release configs which are not referred anymore without waiting. */
+void
+sppwk_conf_rcu_reclaim(void)
+{
+	while (g_defer_head != NULL) {
+		if (rte_rcu_qsbr_check(g_conf_qsv, g_defer_head->token,
+					false) != 1)
+			break;
+		release_defer_head();
+	}
+}
+
+/* Wait for worker threads and release all of configs deferred. */
+void
+sppwk_conf_rcu_reclaim_all(void)
+{
+	rte_rcu_qsbr_synchronize(g_conf_qsv, RTE_QSBR_THRID_INVALID);
+	while (g_defer_head != NULL)
+		release_defer_head();
+}
+
+/* Release config after all of worker threads pass through quiescent state. */
+void
+sppwk_conf_rcu_defer_free(void *conf, sppwk_conf_free_t free_fn, void *arg)
+{
+	struct conf_defer_ent *ent;
+
+	ent = malloc(sizeof(struct conf_defer_ent));
+	if (unlikely(ent == NULL)) {
+		/* Release it without deferring as the last resort. */
+		RTE_LOG(WARNING, SPPWK_CONF_RCU,
+				"Cannot allocate deferred entry, wait for "
+				"worker threads.\n");
+		sppwk_conf_rcu_reclaim_all();
+		free_fn(conf, arg);
+		return;
+	}
+
+	ent->token = rte_rcu_qsbr_start(g_conf_qsv);
+	ent->conf = conf;
+	ent->free_fn = free_fn;
+	ent->arg = arg;
+	ent->next = NULL;
+	if (g_defer_tail == NULL)
+		g_defer_head = ent;
+	else
+		g_defer_tail->next = ent;
+	g_defer_tail = ent;
+
+	/* Release old configs as much as possible for saving memory. */
+	sppwk_conf_rcu_reclaim();
+}
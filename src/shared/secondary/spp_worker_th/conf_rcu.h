@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#ifndef _SPPWK_TH_CONF_RCU_H_
+#define _SPPWK_TH_CONF_RCU_H_
+
+/**
+ * @file
+ * SPP worker config swap with RCU
+ *
+ * Config of each of components is referred from worker thread via a pointer,
+ * and replaced by publishing new one from command thread. Old config is
+ * released after all of worker threads pass through quiescent state, so
+ * command thread does not need to wait for worker threads.
+ */
+
+/**
+ * Get config published. It is called from worker threads.
+ *
+ * @param p Pointer to the config.
+ */
+#define SPPWK_CONF_GET(p) __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+
+/**
+ * Publish new config and return old one. It is called from command thread.
+ *
+ * @param p Pointer to the config.
+ * @param v Pointer to new config.
+ */
+#define SPPWK_CONF_SET(p, v) __atomic_exchange_n(&(p), (v), __ATOMIC_ACQ_REL)
+
+/**
+ * Function to release config which is not referred from worker threads.
+ *
+ * @param conf Config to be released.
+ * @param arg Argument given to `sppwk_conf_rcu_defer_free()`.
+ */
+typedef void (*sppwk_conf_free_t)(void *conf, void *arg);
+
+/**
+ * Initialize QSBR variable of worker threads. It is called from master.
+ *
+ * @retval SPPWK_RET_OK If succeeded.
+ * @retval SPPWK_RET_NG If failed.
+ */
+int sppwk_conf_rcu_init(void);
+
+/**
+ * Start to report quiescent state from worker thread.
+ *
+ * @param lcore_id Lcore ID of worker thread.
+ */
+void sppwk_conf_rcu_online(unsigned int lcore_id);
+
+/**
+ * Stop to report quiescent state from worker thread.
+ *
+ * @param lcore_id Lcore ID of worker thread.
+ */
+void sppwk_conf_rcu_offline(unsigned int lcore_id);
+
+/**
+ * Report quiescent state. Worker thread must call it at each of loops in
+ * which no config is referred.
+ *
+ * @param lcore_id Lcore ID of worker thread.
+ */
+void sppwk_conf_rcu_quiescent(unsigned int lcore_id);
+
+/**
+ * Release config after all of worker threads pass through quiescent state.
+ * Configs are released in the order of calling this function. If it is
+ * failed to defer, it waits for worker threads and releases immediately.
+ *
+ * @param conf Config removed from worker threads.
+ * @param free_fn Function to release the config.
+ * @param arg Argument of `free_fn`.
+ */
+void sppwk_conf_rcu_defer_free(void *conf, sppwk_conf_free_t free_fn,
+		void *arg);
+
+/**
+ * Release configs which are not referred anymore without waiting.
+ * It is called from master periodically.
+ */
+void sppwk_conf_rcu_reclaim(void);
+
+/**
+ * Wait for worker threads and release all of configs deferred.
+ */
+void sppwk_conf_rcu_reclaim_all(void);
+
+#endif  /* _SPPWK_TH_CONF_RCU_H_ */
@@ -10,6 +10,9 @@
 #define STR_LEN_SHORT 32  /* Size of short string. */
 #define STR_LEN_NAME 128  /* Size of string for names. */
 
+/* Size of string of packet filter expression including null char. */
+#define SPPWK_FILTER_BUFSZ 256
+
 /** Identifier string for each interface */
 #define SPPWK_PHY_STR "phy"
 #define SPPWK_VHOST_STR "vhost"
@@ -51,6 +54,7 @@ enum sppwk_port_ops {
 	SPPWK_PORT_OPS_NONE,
 	SPPWK_PORT_OPS_ADD_VLAN,  /* Add vlan tag. */
 	SPPWK_PORT_OPS_DEL_VLAN,  /* Delete vlan tag. */
+	SPPWK_PORT_OPS_WEIGHT,  /* Weight of TX port of balancer. */
 };
 
 /** VLAN tag information */
@@ -58,6 +62,7 @@ struct sppwk_vlan_tag {
 	int vid; /**< VLAN ID */
 	int pcp; /**< Priority Code Point */
 	int tci; /**< Tag Control Information */
+	int hw_offload; /**< Inserted or stripped by NIC */
 };
 
 /* Ability for vlantag for a port. */
@@ -71,6 +76,7 @@ struct sppwk_port_attrs {
 	enum sppwk_port_ops ops;  /**< Port capability Operations */
 	enum sppwk_port_dir dir;  /**< Direction of RX, TX or both */
 	union sppwk_port_capability capability;   /**< Port capability */
+	int weight;  /**< Weight of TX port of balancer for `weight` ops */
 };
 
 /* Type of SPP worker thread. */
@@ -81,6 +87,8 @@ enum sppwk_worker_type {
 	SPPWK_TYPE_MRG,  /**< Merger */
 	SPPWK_TYPE_FWD,  /**< Forwarder */
 	SPPWK_TYPE_MIR,  /**< Mirror */
+	SPPWK_TYPE_CLS_LEARN,  /**< Classifier with MAC learning */
+	SPPWK_TYPE_BLC,  /**< Balancer */
 };
 
 /* Attributes for classifying. */
@@ -90,6 +98,24 @@ struct sppwk_cls_attrs {
 	struct sppwk_vlan_tag vlantag;   /**< VLAN tag information */
 };
 
+/**
+ * 5-tuple rule of classifier matched with ACL. Addresses are in network byte
+ * order and bits out of prefix are cleared. Ports are ranges in host order.
+ */
+struct sppwk_cls_acl_rule {
+	int ip_ver;  /**< 4 or 6, or 0 if both of addresses are any. */
+	uint8_t src_addr[16];  /**< Source address */
+	uint8_t src_plen;  /**< Prefix length of source, 0 for any */
+	uint8_t dst_addr[16];  /**< Destination address */
+	uint8_t dst_plen;  /**< Prefix length of destination, 0 for any */
+	uint8_t proto;  /**< IP protocol number */
+	uint8_t proto_mask;  /**< 0xff, or 0 for any protocol */
+	uint16_t src_port_lo;  /**< Lower bound of source port */
+	uint16_t src_port_hi;  /**< Upper bound of source port */
+	uint16_t dst_port_lo;  /**< Lower bound of destination port */
+	uint16_t dst_port_hi;  /**< Upper bound of destination port */
+};
+
 /**
  * Simply define type and index of resource UID such as phy:0. For detailed
  * attributions, use `sppwk_port_info` which has additional port params.
@@ -110,18 +136,40 @@ struct sppwk_port_info {
 	struct sppwk_port_attrs port_attrs[PORT_CAPABL_MAX];
 };
 
+/**
+ * Copy mode of mirror. Shallow copy is for consumers which do not modify
+ * packets, and deep copy is for ones which modify.
+ */
+enum sppwk_mir_copy_mode {
+	SPPWK_MIR_COPY_DEFAULT,  /**< Mode defined at build time */
+	SPPWK_MIR_COPY_SHALLOW,  /**< Clone with indirect mbufs */
+	SPPWK_MIR_COPY_DEEP,  /**< Copy packet data */
+};
+
+/* Limit of packets copied by mirror for analyzers not absorbing line rate. */
+struct sppwk_mir_limit {
+	uint32_t sample;  /**< Mirror 1 in `sample` packets, or 0 for all */
+	uint64_t rate;  /**< Max rate per sec of mirror, or 0 for no limit */
+	int is_bytes;  /**< Rate is of bytes per sec if 1, or packets per sec */
+};
+
 /* Attributes of SPP worker thread named as `component`. */
 struct sppwk_comp_info {
 	char name[STR_LEN_NAME];  /**< Component name */
 	enum sppwk_worker_type wk_type;  /**< Type of worker thread */
 	unsigned int lcore_id;
 	int comp_id;  /**< Component ID */
+	int grp_comp_id;  /**< First classifier of group, or -1 */
 	int nof_rx;  /**< The number of rx ports */
 	int nof_tx;  /**< The number of tx ports */
 	/**< rx ports */
 	struct sppwk_port_info *rx_ports[RTE_MAX_QUEUES_PER_PORT];
 	/**< tx ports */
 	struct sppwk_port_info *tx_ports[RTE_MAX_QUEUES_PER_PORT];
+	uint32_t snaplen;  /**< Bytes copied by mirror, or 0 for all */
+	char filter[SPPWK_FILTER_BUFSZ];  /**< Mirror filter, or empty */
+	struct sppwk_mir_limit mir_limit;  /**< Sampling and rate of mirror */
+	enum sppwk_mir_copy_mode copy_mode;  /**< Copy mode of mirror */
 };
 
 /* Manage number of interfaces  and port information as global variable. */
@@ -138,6 +186,7 @@ struct iface_info {
 };
 
 struct sppwk_lcore_params;
+struct sppwk_tx_coal_stats;
 /**
  * Define func to iterate lcore to list core information for showing status
  * or so, as a member of struct `sppwk_lcore_params`.
@@ -150,7 +199,9 @@ typedef int (*sppwk_lcore_proc)(
 		const int nof_rx,  /* Number of RX ports */
 		const struct sppwk_port_idx *rx_ports,
 		const int nof_tx,  /* Number of TX ports */
-		const struct sppwk_port_idx *tx_ports);
+		const struct sppwk_port_idx *tx_ports,
+		/* Counters of TX coalescing, or NULL if not supported. */
+		const struct sppwk_tx_coal_stats *tx_stats);
 
 /**
  * iterate core table parameters used to list content of lcore table for.
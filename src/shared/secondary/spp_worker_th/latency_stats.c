@@ -6,76 +6,101 @@
 #include <sys/types.h>
 #include <stdio.h>
 #include <stddef.h>
-#include <math.h>
+#include <string.h>
 
 #include <rte_mbuf.h>
 #include <rte_log.h>
+#include <rte_lcore.h>
 #include <rte_cycles.h>
 #include <rte_malloc.h>
-#include <rte_memcpy.h>
 
 #include "latency_stats.h"
 #include "cmd_utils.h"
 #include "port_capability.h"
 #include "../return_codes.h"
 
-#define NS_PER_SEC 1E9
+#define NS_PER_SEC 1000000000ULL
 
 #define RTE_LOGTYPE_SPP_RING_LATENCY_STATS RTE_LOGTYPE_USER1
 
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
-
-/** ring latency statistics information */
+/**
+ * ring latency statistics information of a lcore. It is updated only from
+ * the lcore, and summed up in master thread without lock.
+ */
 struct ring_latency_stats_info {
 	uint64_t timer_tsc;  /**< sampling interval */
 	uint64_t prev_tsc;   /**< previous time */
-	struct ring_latency_stats_t stats;  /**< list of stats */
-};
+	struct latency_hist stats;  /**< list of stats */
+} __rte_cache_aligned;
 
 /** sampling interval */
 static uint64_t g_samp_intvl;
 
-/** ring latency statistics information instance */
+/**
+ * ring latency statistics information instance, which has `g_stats_count`
+ * entries for each of lcores.
+ */
 static struct ring_latency_stats_info *g_stats_info;
 
 /** number of ring latency statistics */
 static uint16_t g_stats_count;
 
-/* clock cycles per nano second */
-static inline uint64_t
-cycles_per_ns(void)
+/** flags of rings of which latency is measured, `g_stats_count` entries */
+static uint8_t *g_stats_enabled;
+
+/* Get stats info of ring of the current lcore, or NULL. */
+static inline struct ring_latency_stats_info *
+get_stats_info(int ring_id)
 {
-	return rte_get_timer_hz() / NS_PER_SEC;
+	int lcore_idx = rte_lcore_index(rte_lcore_id());
+
+	if (unlikely(lcore_idx < 0 || ring_id < 0 ||
+			ring_id >= g_stats_count))
+		return NULL;
+	return &g_stats_info[lcore_idx * g_stats_count + ring_id];
 }
 
-/**
- * TODO(Hideyuki Yamashita) This function has a fatal bug in rte_zmalloc()
- * for `g_stats_info` and should be fixed. rte_zmalloc() returns NULL for
- * unknow reason.
- */
 int
 sppwk_init_ring_latency_stats(uint64_t samp_intvl, uint16_t stats_count)
 {
+	uint64_t hz = rte_get_tsc_hz();
+
+	if (unlikely(stats_count == 0 || hz == 0)) {
+		RTE_LOG(ERR, SPP_RING_LATENCY_STATS, "Invalid params for "
+				"ring latency stats. (count=%hu, hz=%lu)\n",
+				stats_count, hz);
+		return SPPWK_RET_NG;
+	}
+
 	/* allocate memory for ring latency statistics information */
 	g_stats_info = rte_zmalloc(
 			"global ring_latency_stats_info",
-			sizeof(struct ring_latency_stats_info) * stats_count,
-			0);
+			sizeof(struct ring_latency_stats_info) * stats_count *
+			rte_lcore_count(), RTE_CACHE_LINE_SIZE);
 	if (unlikely(g_stats_info == NULL)) {
 		RTE_LOG(ERR, SPP_RING_LATENCY_STATS, "Cannot allocate memory "
 				"for ring latency stats info\n");
 		return SPPWK_RET_NG;
 	}
 
+	g_stats_enabled = rte_zmalloc("global ring_latency_stats_enabled",
+			stats_count, 0);
+	if (unlikely(g_stats_enabled == NULL)) {
+		RTE_LOG(ERR, SPP_RING_LATENCY_STATS, "Cannot allocate memory "
+				"for ring latency stats flags\n");
+		rte_free(g_stats_info);
+		g_stats_info = NULL;
+		return SPPWK_RET_NG;
+	}
+
 	/* store global information for ring latency statistics */
-	g_samp_intvl = samp_intvl * cycles_per_ns();
+	g_samp_intvl = samp_intvl * hz / NS_PER_SEC;
+	latency_set_tsc_hz(hz);
 	g_stats_count = stats_count;
 
 	RTE_LOG(DEBUG, SPP_RING_LATENCY_STATS,
-			"g_samp_intvl=%lu, g_stats_count=%hu, "
-			"cpns=%lu, NS_PER_SEC=%f\n",
-			g_samp_intvl, g_stats_count,
-			cycles_per_ns(), NS_PER_SEC);
+			"g_samp_intvl=%lu, g_stats_count=%hu, hz=%lu\n",
+			g_samp_intvl, g_stats_count, hz);
 
 	return SPPWK_RET_OK;
 }
@@ -85,40 +110,67 @@ sppwk_clean_ring_latency_stats(void)
 {
 	/* free memory for ring latency statistics information */
 	if (likely(g_stats_info != NULL)) {
-		rte_free(g_stats_info);
 		g_stats_count = 0;
+		rte_free(g_stats_enabled);
+		g_stats_enabled = NULL;
+		rte_free(g_stats_info);
+		g_stats_info = NULL;
 	}
 }
 
+/* Enable or disable measuring latency of a ring. */
+int
+sppwk_set_ring_latency(int ring_id, int enabled)
+{
+	struct sppwk_port_info *port;
+
+	if (unlikely(ring_id < 0 || ring_id >= g_stats_count)) {
+		RTE_LOG(ERR, SPP_RING_LATENCY_STATS, "Invalid ring for "
+				"ring latency stats. (ring=%d)\n", ring_id);
+		return SPPWK_RET_NG;
+	}
+	g_stats_enabled[ring_id] = enabled ? 1 : 0;
+
+	/* Port not added yet is updated when it is assigned to component. */
+	port = get_sppwk_port(RING, ring_id, 0);
+	if (port->iface_type == RING)
+		sppwk_update_burst_ops(port);
+
+	RTE_LOG(INFO, SPP_RING_LATENCY_STATS, "Ring latency stats is %s. "
+			"(ring=%d)\n", enabled ? "enabled" : "disabled",
+			ring_id);
+	return SPPWK_RET_OK;
+}
+
+/* Check if latency of a ring is measured. */
+int
+sppwk_is_ring_latency_enabled(int ring_id)
+{
+	if (unlikely(ring_id < 0 || ring_id >= g_stats_count))
+		return 0;
+	return g_stats_enabled[ring_id];
+}
+
+/* Set timestamp to a packet of a burst for each of sampling interval. */
 void
 sppwk_add_ring_latency_time(int ring_id,
 		struct rte_mbuf **pkts, uint16_t nb_pkts)
 {
-	unsigned int i;
-	uint64_t diff_tsc, now;
-	struct ring_latency_stats_info *stats_info = &g_stats_info[ring_id];
+	uint64_t now;
+	struct ring_latency_stats_info *stats_info = get_stats_info(ring_id);
 
-	for (i = 0; i < nb_pkts; i++) {
+	if (unlikely(stats_info == NULL || nb_pkts == 0))
+		return;
 
-		/* get tsc now */
-		now = rte_rdtsc();
-
-		/* calculate difference from the previous processing time */
-		diff_tsc = now - stats_info->prev_tsc;
-		stats_info->timer_tsc += diff_tsc;
-
-		/* set tsc to mbuf timestamp if it is over sampling interval. */
-		if (unlikely(stats_info->timer_tsc >= g_samp_intvl)) {
-			RTE_LOG(DEBUG, SPP_RING_LATENCY_STATS,
-					"Set timestamp. ring_id=%d, "
-					"pkts_index=%u, timestamp=%lu\n",
-					ring_id, i, now);
-			pkts[i]->timestamp = now;
-			stats_info->timer_tsc = 0;
-		}
-
-		/* update previous tsc */
-		stats_info->prev_tsc = now;
+	/* calculate difference from the previous processing time */
+	now = rte_rdtsc();
+	stats_info->timer_tsc += now - stats_info->prev_tsc;
+	stats_info->prev_tsc = now;
+
+	/* set tsc to mbuf timestamp if it is over sampling interval. */
+	if (unlikely(stats_info->timer_tsc >= g_samp_intvl)) {
+		pkts[0]->timestamp = now;
+		stats_info->timer_tsc = 0;
 	}
 }
 
@@ -128,8 +180,10 @@ sppwk_calc_ring_latency(int ring_id,
 {
 	unsigned int i;
 	uint64_t now;
-	int64_t latency;
-	struct ring_latency_stats_info *stats_info = &g_stats_info[ring_id];
+	struct ring_latency_stats_info *stats_info = get_stats_info(ring_id);
+
+	if (unlikely(stats_info == NULL))
+		return;
 
 	now = rte_rdtsc();
 	for (i = 0; i < nb_pkts; i++) {
@@ -137,12 +191,11 @@ sppwk_calc_ring_latency(int ring_id,
 			continue;
 
 		/* calc latency if mbuf `timestamp` is non-zero. */
-		latency = (uint64_t)floor((now - pkts[i]->timestamp) /
-				cycles_per_ns());
-		if (likely(latency < TOTAL_LATENCY_ENT-1))
-			stats_info->stats.distr[latency]++;
-		else
-			stats_info->stats.distr[TOTAL_LATENCY_ENT-1]++;
+		latency_hist_add(&stats_info->stats,
+				latency_cycles_to_ns(now - pkts[i]->timestamp));
+
+		/* Not counted again in the next ring. */
+		pkts[i]->timestamp = 0;
 	}
 }
 
@@ -154,87 +207,16 @@ sppwk_get_ring_latency_stats_count(void)
 
 void
 sppwk_get_ring_latency_stats(int ring_id,
-		struct ring_latency_stats_t *stats)
-{
-	struct ring_latency_stats_info *stats_info = &g_stats_info[ring_id];
-
-	rte_memcpy(stats, &stats_info->stats,
-			sizeof(struct ring_latency_stats_t));
-}
-
-/* Print statistics of time for packet processing in ring interface */
-void
-print_ring_latency_stats(struct iface_info *if_info)
-{
-	/* Clear screen and move cursor to top left */
-	const char topLeft[] = { 27, '[', '1', ';', '1', 'H', '\0' };
-	const char clr[] = { 27, '[', '2', 'J', '\0' };
-	printf("%s%s", clr, topLeft);
-
-	int ring_cnt, stats_cnt;
-	struct ring_latency_stats_t stats[RTE_MAX_ETHPORTS];
-	memset(&stats, 0x00, sizeof(stats));
-
-	printf("RING Latency\n");
-	printf(" RING");
-	for (ring_cnt = 0; ring_cnt < RTE_MAX_ETHPORTS; ring_cnt++) {
-		if (if_info->ring[ring_cnt].iface_type == UNDEF)
-			continue;
-
-		sppwk_get_ring_latency_stats(ring_cnt, &stats[ring_cnt]);
-		printf(", %-18d", ring_cnt);
-	}
-	printf("\n");
-
-	for (stats_cnt = 0; stats_cnt < TOTAL_LATENCY_ENT;
-			stats_cnt++) {
-		printf("%3dns", stats_cnt);
-		for (ring_cnt = 0; ring_cnt < RTE_MAX_ETHPORTS; ring_cnt++) {
-			if (if_info->ring[ring_cnt].iface_type == UNDEF)
-				continue;
-
-			printf(", 0x%-16lx", stats[ring_cnt].distr[stats_cnt]);
-		}
-		printf("\n");
-	}
-}
-
-/* Wrapper function for rte_eth_rx_burst() with calc ring latency. */
-uint16_t
-sppwk_eth_ring_stats_rx_burst(uint16_t port_id,
-		enum port_type iface_type,
-		int iface_no,
-		uint16_t queue_id  __attribute__ ((unused)),
-		struct rte_mbuf **rx_pkts, const uint16_t nb_pkts)
+		struct latency_hist *stats)
 {
-	uint16_t nb_rx;
+	unsigned int lcore_idx;
 
-	nb_rx = rte_eth_rx_burst(port_id, 0, rx_pkts, nb_pkts);
+	memset(stats, 0x00, sizeof(struct latency_hist));
+	if (unlikely(ring_id < 0 || ring_id >= g_stats_count))
+		return;
 
-	/* TODO(yasufum) confirm why it returns SPPWK_RET_OK. */
-	if (unlikely(nb_rx == 0))
-		return SPPWK_RET_OK;
-
-	if (iface_type == RING)
-		sppwk_calc_ring_latency(iface_no, rx_pkts, nb_pkts);
-	return nb_rx;
+	/* Values might be updated meanwhile, but not locked for workers. */
+	for (lcore_idx = 0; lcore_idx < rte_lcore_count(); lcore_idx++)
+		latency_hist_merge(stats, &g_stats_info[
+				lcore_idx * g_stats_count + ring_id].stats);
 }
-
-/* Wrapper function for rte_eth_tx_burst() with calc ring latency. */
-uint16_t
-sppwk_eth_ring_stats_tx_burst(uint16_t port_id,
-		enum port_type iface_type,
-		int iface_no,
-		uint16_t queue_id __attribute__ ((unused)),
-		struct rte_mbuf **tx_pkts, uint16_t nb_pkts)
-{
-	uint16_t nb_tx;
-
-	nb_tx = rte_eth_tx_burst(port_id, 0, tx_pkts, nb_pkts);
-
-	if (iface_type == RING)
-		sppwk_add_ring_latency_time(iface_no, tx_pkts, nb_pkts);
-	return nb_tx;
-}
-
-#endif /* SPP_RINGLATENCYSTATS_ENABLE */
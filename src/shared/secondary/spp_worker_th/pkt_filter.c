@@ -0,0 +1,439 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include <rte_bpf.h>
+#include <rte_errno.h>
+#include <rte_log.h>
+#include <rte_malloc.h>
+
+#include <pcap/pcap.h>
+#include <pcap/bpf.h>
+
+#include "pkt_filter.h"
+#include "shared/secondary/return_codes.h"
+
+#define RTE_LOGTYPE_SPPWK_PKT_FILTER RTE_LOGTYPE_USER1
+
+/* Registers of eBPF assigned to ones of classic BPF. */
+#define REG_A EBPF_REG_0  /* Accumulator, also return value. */
+#define REG_X EBPF_REG_7  /* Index register. */
+#define REG_TMP EBPF_REG_8  /* Scratch register, offset of packet load. */
+#define REG_CTX EBPF_REG_6  /* Mbuf referred from packet load. */
+#define REG_PTR EBPF_REG_1  /* Scratch registers for address of packet. */
+#define REG_PTR2 EBPF_REG_2
+#define REG_FP EBPF_REG_10  /* Frame pointer for scratch memory. */
+
+/* Max length of packets given to libpcap for compiling. */
+#define PKT_FILTER_SNAPLEN 65535
+
+/**
+ * Size of buffer of mbuf told to verifier of rte_bpf. It covers `data_off`
+ * and offset of packet load both of which are 16 bits at most, and actual
+ * range is checked with `data_len` at runtime.
+ */
+#define PKT_FILTER_BUF_SIZE (2 * UINT16_MAX + sizeof(uint32_t))
+
+/* Num of packets run with interpreter at once. */
+#define PKT_FILTER_BURST 32
+
+/* Compiled filter. */
+struct sppwk_pkt_filter {
+	struct rte_bpf *bpf;  /* Loaded eBPF program. */
+	struct rte_bpf_jit jit;  /* JIT compiled code, or func is NULL. */
+};
+
+/* Context of converting classic BPF into eBPF. */
+struct bpf_conv {
+	struct ebpf_insn *ins;  /* Converted program, or NULL for counting. */
+	uint32_t nb_ins;  /* Num of instructions emitted. */
+	const uint32_t *addrs;  /* Index of converted for each of classic. */
+};
+
+/* Append an eBPF instruction, or just count it if no buffer. */
+static void
+emit(struct bpf_conv *conv, uint8_t code, uint8_t dst, uint8_t src,
+		int16_t off, int32_t imm)
+{
+	struct ebpf_insn *ins;
+
+	if (conv->ins != NULL) {
+		ins = &conv->ins[conv->nb_ins];
+		ins->code = code;
+		ins->dst_reg = dst;
+		ins->src_reg = src;
+		ins->off = off;
+		ins->imm = imm;
+	}
+	conv->nb_ins++;
+}
+
+/* Offset of jump from the next instruction to the classic one of `target`. */
+static inline int16_t
+jmp_off(const struct bpf_conv *conv, uint32_t target)
+{
+	return (int16_t)(conv->addrs[target] - (conv->nb_ins + 1));
+}
+
+/* Offset of scratch memory M[k] of classic BPF on stack. */
+static inline int16_t
+mem_off(uint32_t k)
+{
+	return -(int16_t)((BPF_MEMWORDS - k) * sizeof(uint32_t));
+}
+
+/**
+ * Load packet data of `size` at offset `k`, or `X + k` if `ind`, to `dst` in
+ * host byte order. `BPF_LD | BPF_ABS` of eBPF is not supported in rte_bpf
+ * before DPDK 20.08, so data is read from `buf_addr` and `data_off` of mbuf.
+ * Program returns 0 as classic BPF if the data is out of the first segment.
+ */
+static void
+emit_pkt_load(struct bpf_conv *conv, uint8_t dst, uint8_t size, int ind,
+		uint32_t k)
+{
+	int32_t len;
+
+	if (size == BPF_B)
+		len = sizeof(uint8_t);
+	else if (size == BPF_H)
+		len = sizeof(uint16_t);
+	else
+		len = sizeof(uint32_t);
+
+	/* Offset is unsigned 32 bits as classic BPF. */
+	if (ind) {
+		emit(conv, EBPF_ALU64 | EBPF_MOV | BPF_X, REG_TMP, REG_X, 0, 0);
+		emit(conv, BPF_ALU | BPF_ADD | BPF_K, REG_TMP, 0, 0, k);
+	} else {
+		emit(conv, BPF_ALU | EBPF_MOV | BPF_K, REG_TMP, 0, 0, k);
+	}
+
+	/* Return 0 unless offset + len <= data_len, compared as signed. */
+	emit(conv, BPF_LDX | BPF_MEM | BPF_H, REG_PTR, REG_CTX,
+			offsetof(struct rte_mbuf, data_len), 0);
+	emit(conv, EBPF_ALU64 | BPF_SUB | BPF_K, REG_PTR, 0, 0, len);
+	emit(conv, BPF_JMP | EBPF_JSLE | BPF_X, REG_TMP, REG_PTR, 2, 0);
+	emit(conv, BPF_ALU | EBPF_MOV | BPF_K, REG_A, 0, 0, 0);
+	emit(conv, BPF_JMP | EBPF_EXIT, 0, 0, 0, 0);
+
+	emit(conv, BPF_LDX | BPF_MEM | EBPF_DW, REG_PTR, REG_CTX,
+			offsetof(struct rte_mbuf, buf_addr), 0);
+	emit(conv, BPF_LDX | BPF_MEM | BPF_H, REG_PTR2, REG_CTX,
+			offsetof(struct rte_mbuf, data_off), 0);
+	emit(conv, EBPF_ALU64 | BPF_ADD | BPF_X, REG_PTR, REG_PTR2, 0, 0);
+	emit(conv, EBPF_ALU64 | BPF_ADD | BPF_X, REG_PTR, REG_TMP, 0, 0);
+	emit(conv, BPF_LDX | BPF_MEM | size, dst, REG_PTR, 0, 0);
+
+	/* Value in network byte order is converted as loaded in classic. */
+	if (len > 1)
+		emit(conv, BPF_ALU | EBPF_END | EBPF_TO_BE, dst, 0, 0,
+				len * 8);
+}
+
+/* Convert load instruction of classic BPF to A or X. */
+static int
+convert_load(struct bpf_conv *conv, const struct bpf_insn *fp)
+{
+	uint8_t dst = BPF_CLASS(fp->code) == BPF_LD ? REG_A : REG_X;
+
+	switch (BPF_MODE(fp->code)) {
+	case BPF_ABS:
+		emit_pkt_load(conv, REG_A, BPF_SIZE(fp->code), 0, fp->k);
+		break;
+	case BPF_IND:
+		emit_pkt_load(conv, REG_A, BPF_SIZE(fp->code), 1, fp->k);
+		break;
+	case BPF_LEN:
+		emit(conv, BPF_LDX | BPF_MEM | BPF_W, dst, REG_CTX,
+				offsetof(struct rte_mbuf, pkt_len), 0);
+		break;
+	case BPF_IMM:
+		emit(conv, BPF_ALU | EBPF_MOV | BPF_K, dst, 0, 0, fp->k);
+		break;
+	case BPF_MEM:
+		if (unlikely(fp->k >= BPF_MEMWORDS))
+			return SPPWK_RET_NG;
+		emit(conv, BPF_LDX | BPF_MEM | BPF_W, dst, REG_FP,
+				mem_off(fp->k), 0);
+		break;
+	case BPF_MSH:
+		/* X = 4 * (P[k] & 0xf) */
+		emit_pkt_load(conv, REG_X, BPF_B, 0, fp->k);
+		emit(conv, BPF_ALU | BPF_AND | BPF_K, REG_X, 0, 0, 0xf);
+		emit(conv, BPF_ALU | BPF_LSH | BPF_K, REG_X, 0, 0, 2);
+		break;
+	default:
+		return SPPWK_RET_NG;
+	}
+	return SPPWK_RET_OK;
+}
+
+/* Convert conditional jump of classic BPF which has both of targets. */
+static int
+convert_jmp(struct bpf_conv *conv, const struct bpf_insn *fp, uint32_t i,
+		uint32_t len)
+{
+	uint8_t op = BPF_OP(fp->code);
+
+	if (op == BPF_JA) {
+		if (unlikely(fp->k >= len - i - 1))
+			return SPPWK_RET_NG;
+		emit(conv, BPF_JMP | BPF_JA, 0, 0, jmp_off(conv, i + 1 + fp->k),
+				0);
+		return SPPWK_RET_OK;
+	}
+
+	if (unlikely(op != BPF_JEQ && op != BPF_JGT && op != BPF_JGE &&
+			op != BPF_JSET))
+		return SPPWK_RET_NG;
+	if (unlikely(fp->jt >= len - i - 1) || unlikely(fp->jf >= len - i - 1))
+		return SPPWK_RET_NG;
+
+	/* Immediate is sign extended in eBPF, but A is unsigned 32 bits. */
+	if (BPF_SRC(fp->code) == BPF_K && (int32_t)fp->k < 0) {
+		emit(conv, BPF_ALU | EBPF_MOV | BPF_K, REG_TMP, 0, 0, fp->k);
+		emit(conv, BPF_JMP | op | BPF_X, REG_A, REG_TMP,
+				jmp_off(conv, i + 1 + fp->jt), 0);
+	} else {
+		emit(conv, BPF_JMP | op | BPF_SRC(fp->code), REG_A,
+				BPF_SRC(fp->code) == BPF_X ? REG_X : 0,
+				jmp_off(conv, i + 1 + fp->jt), fp->k);
+	}
+
+	if (fp->jf != 0)
+		emit(conv, BPF_JMP | BPF_JA, 0, 0,
+				jmp_off(conv, i + 1 + fp->jf), 0);
+	return SPPWK_RET_OK;
+}
+
+/* Convert an instruction of classic BPF of index `i`. */
+static int
+convert_insn(struct bpf_conv *conv, const struct bpf_insn *fp, uint32_t i,
+		uint32_t len)
+{
+	uint8_t op;
+
+	switch (BPF_CLASS(fp->code)) {
+	case BPF_LD:
+	case BPF_LDX:
+		return convert_load(conv, fp);
+	case BPF_ST:
+	case BPF_STX:
+		if (unlikely(fp->k >= BPF_MEMWORDS))
+			return SPPWK_RET_NG;
+		emit(conv, BPF_STX | BPF_MEM | BPF_W, REG_FP,
+				BPF_CLASS(fp->code) == BPF_ST ? REG_A : REG_X,
+				mem_off(fp->k), 0);
+		return SPPWK_RET_OK;
+	case BPF_ALU:
+		op = BPF_OP(fp->code);
+		if (op == BPF_NEG) {
+			emit(conv, BPF_ALU | BPF_NEG, REG_A, 0, 0, 0);
+			return SPPWK_RET_OK;
+		}
+		if (unlikely(op != BPF_ADD && op != BPF_SUB &&
+				op != BPF_MUL && op != BPF_DIV &&
+				op != BPF_OR && op != BPF_AND &&
+				op != BPF_LSH && op != BPF_RSH &&
+				op != BPF_MOD && op != BPF_XOR))
+			return SPPWK_RET_NG;
+		emit(conv, BPF_ALU | op | BPF_SRC(fp->code), REG_A,
+				BPF_SRC(fp->code) == BPF_X ? REG_X : 0, 0,
+				fp->k);
+		return SPPWK_RET_OK;
+	case BPF_JMP:
+		return convert_jmp(conv, fp, i, len);
+	case BPF_RET:
+		if (BPF_RVAL(fp->code) == BPF_K)
+			emit(conv, BPF_ALU | EBPF_MOV | BPF_K, REG_A, 0, 0,
+					fp->k);
+		else if (BPF_RVAL(fp->code) == BPF_X)
+			emit(conv, EBPF_ALU64 | EBPF_MOV | BPF_X, REG_A, REG_X,
+					0, 0);
+		emit(conv, BPF_JMP | EBPF_EXIT, 0, 0, 0, 0);
+		return SPPWK_RET_OK;
+	case BPF_MISC:
+		if (BPF_MISCOP(fp->code) == BPF_TAX)
+			emit(conv, EBPF_ALU64 | EBPF_MOV | BPF_X, REG_X, REG_A,
+					0, 0);
+		else
+			emit(conv, EBPF_ALU64 | EBPF_MOV | BPF_X, REG_A, REG_X,
+					0, 0);
+		return SPPWK_RET_OK;
+	default:
+		return SPPWK_RET_NG;
+	}
+}
+
+/**
+ * Convert classic BPF into eBPF taking mbuf as an argument. Instructions are
+ * counted at first to resolve offsets of jumps, and converted at second.
+ */
+static struct ebpf_insn *
+convert_filter(const struct bpf_insn *prog, uint32_t len, uint32_t *nb_ins)
+{
+	int pass;
+	uint32_t i;
+	uint32_t *addrs;
+	struct bpf_conv conv;
+
+	addrs = rte_zmalloc(NULL, sizeof(uint32_t) * len, 0);
+	if (unlikely(addrs == NULL))
+		return NULL;
+
+	memset(&conv, 0, sizeof(conv));
+	conv.addrs = addrs;
+	for (pass = 0; pass < 2; pass++) {
+		conv.nb_ins = 0;
+		/* Keep mbuf for packet load, and clear A and X. */
+		emit(&conv, EBPF_ALU64 | EBPF_MOV | BPF_X, REG_CTX,
+				EBPF_REG_1, 0, 0);
+		emit(&conv, BPF_ALU | EBPF_MOV | BPF_K, REG_A, 0, 0, 0);
+		emit(&conv, BPF_ALU | EBPF_MOV | BPF_K, REG_X, 0, 0, 0);
+
+		for (i = 0; i < len; i++) {
+			addrs[i] = conv.nb_ins;
+			if (unlikely(convert_insn(&conv, &prog[i], i, len) !=
+					SPPWK_RET_OK)) {
+				RTE_LOG(ERR, SPPWK_PKT_FILTER,
+						"Cannot convert insn %u "
+						"(code=%#x).\n",
+						i, prog[i].code);
+				rte_free(conv.ins);
+				rte_free(addrs);
+				return NULL;
+			}
+		}
+
+		if (pass == 0) {
+			conv.ins = rte_zmalloc(NULL, sizeof(struct ebpf_insn) *
+					conv.nb_ins, 0);
+			if (unlikely(conv.ins == NULL)) {
+				rte_free(addrs);
+				return NULL;
+			}
+		}
+	}
+
+	rte_free(addrs);
+	*nb_ins = conv.nb_ins;
+	return conv.ins;
+}
+
+/* Load converted program on rte_bpf, and get JIT compiled one if exists. */
+static struct sppwk_pkt_filter *
+load_filter(const struct ebpf_insn *ins, uint32_t nb_ins)
+{
+	struct rte_bpf_prm prm;
+	struct sppwk_pkt_filter *filter;
+
+	filter = rte_zmalloc(NULL, sizeof(struct sppwk_pkt_filter), 0);
+	if (unlikely(filter == NULL))
+		return NULL;
+
+	memset(&prm, 0, sizeof(prm));
+	prm.ins = ins;
+	prm.nb_ins = nb_ins;
+	prm.prog_arg.type = RTE_BPF_ARG_PTR_MBUF;
+	prm.prog_arg.size = sizeof(struct rte_mbuf);
+	prm.prog_arg.buf_size = PKT_FILTER_BUF_SIZE;
+
+	filter->bpf = rte_bpf_load(&prm);
+	if (unlikely(filter->bpf == NULL)) {
+		RTE_LOG(ERR, SPPWK_PKT_FILTER, "Cannot load filter, %s.\n",
+				rte_strerror(rte_errno));
+		rte_free(filter);
+		return NULL;
+	}
+
+	/* Interpreter is used if JIT is not supported. */
+	if (rte_bpf_get_jit(filter->bpf, &filter->jit) != 0)
+		memset(&filter->jit, 0, sizeof(filter->jit));
+	return filter;
+}
+
+/* Compile filter of given expression of pcap syntax. */
+struct sppwk_pkt_filter *
+sppwk_pkt_filter_create(const char *expr)
+{
+	pcap_t *pcap;
+	uint32_t nb_ins = 0;
+	struct bpf_program fcode;
+	struct ebpf_insn *ins;
+	struct sppwk_pkt_filter *filter;
+
+	pcap = pcap_open_dead(DLT_EN10MB, PKT_FILTER_SNAPLEN);
+	if (unlikely(pcap == NULL)) {
+		RTE_LOG(ERR, SPPWK_PKT_FILTER, "Cannot open pcap.\n");
+		return NULL;
+	}
+
+	if (pcap_compile(pcap, &fcode, expr, 1, PCAP_NETMASK_UNKNOWN) != 0) {
+		RTE_LOG(ERR, SPPWK_PKT_FILTER,
+				"Cannot compile filter '%s', %s.\n",
+				expr, pcap_geterr(pcap));
+		pcap_close(pcap);
+		return NULL;
+	}
+	pcap_close(pcap);
+
+	ins = convert_filter(fcode.bf_insns, fcode.bf_len, &nb_ins);
+	pcap_freecode(&fcode);
+	if (unlikely(ins == NULL))
+		return NULL;
+
+	/* Program is copied in rte_bpf, so converted one is not kept. */
+	filter = load_filter(ins, nb_ins);
+	rte_free(ins);
+	if (unlikely(filter == NULL))
+		return NULL;
+
+	RTE_LOG(INFO, SPPWK_PKT_FILTER,
+			"Compiled filter '%s' (nb_ins=%u, jit=%d).\n",
+			expr, nb_ins, filter->jit.func != NULL);
+	return filter;
+}
+
+/* Release filter created with sppwk_pkt_filter_create(). */
+void
+sppwk_pkt_filter_free(struct sppwk_pkt_filter *filter)
+{
+	if (filter == NULL)
+		return;
+
+	rte_bpf_destroy(filter->bpf);
+	rte_free(filter);
+}
+
+/* Run filter over a burst of packets and pick up matched packets. */
+uint16_t
+sppwk_pkt_filter_burst(const struct sppwk_pkt_filter *filter,
+		struct rte_mbuf **pkts, struct rte_mbuf **matched,
+		uint16_t nb_pkts)
+{
+	uint16_t i, j, n;
+	uint16_t nb_matched = 0;
+	uint64_t rc[PKT_FILTER_BURST];
+
+	if (likely(filter->jit.func != NULL)) {
+		for (i = 0; i < nb_pkts; i++) {
+			if (filter->jit.func(pkts[i]) != 0)
+				matched[nb_matched++] = pkts[i];
+		}
+		return nb_matched;
+	}
+
+	for (i = 0; i < nb_pkts; i += n) {
+		n = RTE_MIN(nb_pkts - i, PKT_FILTER_BURST);
+		rte_bpf_exec_burst(filter->bpf, (void **)&pkts[i], rc, n);
+		for (j = 0; j < n; j++) {
+			if (rc[j] != 0)
+				matched[nb_matched++] = pkts[i + j];
+		}
+	}
+	return nb_matched;
+}
@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#ifndef _SPPWK_TH_PKT_FILTER_H_
+#define _SPPWK_TH_PKT_FILTER_H_
+
+/**
+ * @file
+ * SPP worker packet filter
+ *
+ * Filter expression of pcap syntax such as `udp port 53` is compiled into
+ * classic BPF with libpcap, and converted into eBPF run on `rte_bpf`. JIT
+ * compiled code is used if it is supported on the platform.
+ */
+
+#include <rte_mbuf.h>
+
+/* Compiled filter, defined in pkt_filter.c. */
+struct sppwk_pkt_filter;
+
+/**
+ * Compile filter of given expression of pcap syntax.
+ *
+ * @param[in] expr Filter expression.
+ * @retval Compiled filter, or NULL if failed.
+ */
+struct sppwk_pkt_filter *sppwk_pkt_filter_create(const char *expr);
+
+/**
+ * Release filter created with sppwk_pkt_filter_create().
+ *
+ * @param[in] filter Filter to be released, or NULL.
+ */
+void sppwk_pkt_filter_free(struct sppwk_pkt_filter *filter);
+
+/**
+ * Run filter over a burst of packets and pick up matched packets. Order of
+ * packets is kept in `matched`.
+ *
+ * @param[in] filter Compiled filter.
+ * @param[in] pkts Packets to be filtered.
+ * @param[out] matched Packets matched with the filter.
+ * @param[in] nb_pkts Num of packets in `pkts`.
+ * @retval Num of packets in `matched`.
+ */
+uint16_t sppwk_pkt_filter_burst(const struct sppwk_pkt_filter *filter,
+		struct rte_mbuf **pkts, struct rte_mbuf **matched,
+		uint16_t nb_pkts);
+
+#endif /* _SPPWK_TH_PKT_FILTER_H_ */
@@ -3,22 +3,27 @@
  */
 
 #include <rte_ether.h>
+#include <rte_ethdev.h>
 #include <rte_ip.h>
 #include <rte_udp.h>
 #include <rte_tcp.h>
 #include <rte_net_crc.h>
+#include <rte_malloc.h>
+#include <rte_prefetch.h>
+
+#ifdef RTE_MACHINE_CPUFLAG_SSE4_1
+#include <rte_vect.h>
+#endif
 
 #include "port_capability.h"
+#include "conf_rcu.h"
 #include "shared/secondary/return_codes.h"
-
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
+#include "shared/chain_latency.h"
 #include "latency_stats.h"
-#endif
 
 /**
  * TODO(yasufum) This `port capability` is intended to be used mainly for VLAN
- * features. However, other features, such as two sides structure of
- * management info or port direction, are also included this capability.
+ * features. However, other features, such as port direction, are also included this capability.
  * For the reason, SPP worker processes other spp_vf should include the
  * capability even if it is not using VLAN. It is a bad design because of
  * tightly coupled for dependency and it is so confusing.
@@ -26,16 +31,17 @@
  * This problem should be fixed in a future update.
  */
 
+/* Num of packets of which TPID is checked at once in VLAN operation. */
+#define VLAN_BURST_UNIT 4
+
 /* Port capability management information used as a member of port_mng_info. */
 struct port_capabl_mng_info {
-	/* TODO(yasufum) rename ref_index and upd_index because flag. */
-	/* TODO(yasufum) consider to not use two flags for (0,1) and (1,0). */
-	volatile int ref_index; /* Flag to indicate using reference side. */
-	volatile int upd_index; /* Flag to indicate using update side. */
-
-	/* A set of attrs including sppwk_port_capability. */
+	/**
+	 * A set of attrs including sppwk_port_capability, which is published
+	 * to worker threads and replaced with new one at updating.
+	 */
 	/* TODO(yasufum) confirm why using PORT_CAPABL_MAX. */
-	struct sppwk_port_attrs port_attrs[TWO_SIDES][PORT_CAPABL_MAX];
+	struct sppwk_port_attrs *port_attrs;
 };
 
 /* Port ability port information */
@@ -44,26 +50,52 @@ struct port_mng_info {
 	int iface_no;  /* Interface number. */
 	struct port_capabl_mng_info rx;  /* Mng data of capability for RX. */
 	struct port_capabl_mng_info tx;  /* Mng data of capability for Tx. */
+	int vlan_strip;  /* VLAN strip of NIC is enabled for `del_vlantag`. */
 };
 
 /* Information for VLAN tag management. */
 struct port_mng_info g_port_mng_info[RTE_MAX_ETHPORTS];
 
+/* Port attributes without any of operations shared among ports. */
+static struct sppwk_port_attrs g_no_port_attrs[PORT_CAPABL_MAX];
+
+/* Burst functions of each of ports. */
+struct sppwk_burst_ops g_sppwk_burst_ops[RTE_MAX_ETHPORTS];
+
+static void select_burst_ops(uint16_t port_id);
+
 /* TPID of VLAN. */
 static uint16_t g_vlan_tpid;
 
-/* Initialize g_port_mng_info, and set ref side to 0 and update side to 1. */
+/* FCS is calculated for packets of VLAN tag added or deleted in software. */
+static int g_vlan_fcs;
+
+/* Enable or disable calculating FCS of packets of VLAN features. */
+void
+sppwk_set_vlan_fcs(int enabled)
+{
+	g_vlan_fcs = enabled;
+}
+
+/* Check if FCS of packets of VLAN features is calculated. */
+int
+sppwk_get_vlan_fcs(void)
+{
+	return g_vlan_fcs;
+}
+
+/* Initialize g_port_mng_info with port attributes without operations. */
 void
 sppwk_port_capability_init(void)
 {
 	int cnt = 0;
 	g_vlan_tpid = rte_cpu_to_be_16(RTE_ETHER_TYPE_VLAN);
 	memset(g_port_mng_info, 0x00, sizeof(g_port_mng_info));
+	memset(g_no_port_attrs, 0x00, sizeof(g_no_port_attrs));
 	for (cnt = 0; cnt < RTE_MAX_ETHPORTS; cnt++) {
-		g_port_mng_info[cnt].rx.ref_index = 0;
-		g_port_mng_info[cnt].rx.upd_index = 1;
-		g_port_mng_info[cnt].tx.ref_index = 0;
-		g_port_mng_info[cnt].tx.upd_index = 1;
+		g_port_mng_info[cnt].rx.port_attrs = g_no_port_attrs;
+		g_port_mng_info[cnt].tx.port_attrs = g_no_port_attrs;
+		select_burst_ops(cnt);
 	}
 }
 
@@ -86,7 +118,7 @@ sppwk_get_port_attrs(struct sppwk_port_attrs **p_attrs,
 		break;
 	}
 
-	*p_attrs = mng->port_attrs[mng->ref_index];
+	*p_attrs = SPPWK_CONF_GET(mng->port_attrs);
 }
 
 /* Calculation and Setting of FCS. */
@@ -99,163 +131,313 @@ set_fcs_packet(struct rte_mbuf *pkt)
 			pkt->data_len, RTE_NET_CRC32_ETH);
 }
 
-/* Add VLAN tag to a packet. It is called from add_vlan_tag_all(). */
+/**
+ * Insert VLAN header of given TCI after MAC addresses. Original ether type
+ * is not moved because it is placed at the end of VLAN header after the
+ * insertion.
+ */
 static inline int
-add_vlan_tag_one(
-		struct rte_mbuf *pkt,
-		const union sppwk_port_capability *capability)
+push_vlan_hdr(struct rte_mbuf *pkt, uint16_t tci)
+{
+	struct rte_ether_hdr *new_ether = NULL;
+#ifdef RTE_MACHINE_CPUFLAG_SSE4_1
+	__m128i hdr;
+
+	new_ether = (struct rte_ether_hdr *)rte_pktmbuf_prepend(pkt,
+			sizeof(struct rte_vlan_hdr));
+	if (unlikely(new_ether == NULL))
+		return SPPWK_RET_NG;
+
+	/**
+	 * MAC addresses and TPID with TCI are written with a 16 bytes store
+	 * after loading the addresses from prepended area and shifting them.
+	 */
+	hdr = _mm_srli_si128(_mm_loadu_si128((const __m128i *)new_ether),
+			sizeof(struct rte_vlan_hdr));
+	hdr = _mm_insert_epi32(hdr, (int)((uint32_t)g_vlan_tpid |
+				((uint32_t)tci << 16)), 3);
+	_mm_storeu_si128((__m128i *)new_ether, hdr);
+#else
+	struct rte_ether_hdr *old_ether = NULL;
+	struct rte_vlan_hdr *vlan = NULL;
+
+	old_ether = rte_pktmbuf_mtod(pkt, struct rte_ether_hdr *);
+	new_ether = (struct rte_ether_hdr *)rte_pktmbuf_prepend(pkt,
+			sizeof(struct rte_vlan_hdr));
+	if (unlikely(new_ether == NULL))
+		return SPPWK_RET_NG;
+
+	memmove(new_ether, old_ether, RTE_ETHER_ADDR_LEN * 2);
+	new_ether->ether_type = g_vlan_tpid;
+	vlan = (struct rte_vlan_hdr *)&new_ether[1];
+	vlan->vlan_tci = tci;
+#endif
+	return SPPWK_RET_OK;
+}
+
+/**
+ * Remove VLAN header after MAC addresses. Inner ether type is not moved
+ * because it is placed at the end of Ethernet header after the removal.
+ */
+static inline int
+pop_vlan_hdr(struct rte_mbuf *pkt)
 {
 	struct rte_ether_hdr *old_ether = NULL;
 	struct rte_ether_hdr *new_ether = NULL;
-	struct rte_vlan_hdr  *vlan      = NULL;
-	const struct sppwk_vlan_tag *vlantag = &capability->vlantag;
+#ifdef RTE_MACHINE_CPUFLAG_SSE4_1
+	__m128i hdr;
 
 	old_ether = rte_pktmbuf_mtod(pkt, struct rte_ether_hdr *);
-	if (old_ether->ether_type == g_vlan_tpid) {
-		/* For packets with VLAN tags, only VLAN ID is updated */
-		new_ether = old_ether;
-		vlan = (struct rte_vlan_hdr *)&new_ether[1];
-	} else {
-		/* For packets without VLAN tag, add VLAN tag. */
-		new_ether = (struct rte_ether_hdr *)rte_pktmbuf_prepend(pkt,
-				sizeof(struct rte_vlan_hdr));
-		if (unlikely(new_ether == NULL)) {
-			RTE_LOG(ERR, PORT, "Failed to "
-					"get additional header area.\n");
-			return SPPWK_RET_NG;
-		}
+	hdr = _mm_loadu_si128((const __m128i *)old_ether);
+	new_ether = (struct rte_ether_hdr *)rte_pktmbuf_adj(pkt,
+			sizeof(struct rte_vlan_hdr));
+	if (unlikely(new_ether == NULL))
+		return SPPWK_RET_NG;
+
+	/* Store 12 bytes of MAC addresses loaded before overwritten. */
+	_mm_storel_epi64((__m128i *)new_ether, hdr);
+	*(unaligned_uint32_t *)&new_ether->s_addr.addr_bytes[2] =
+		(uint32_t)_mm_extract_epi32(hdr, 2);
+#else
+	uint32_t *old, *new;
 
-		rte_memcpy(new_ether, old_ether, sizeof(struct rte_ether_hdr));
-		vlan = (struct rte_vlan_hdr *)&new_ether[1];
-		vlan->eth_proto = new_ether->ether_type;
-		new_ether->ether_type = g_vlan_tpid;
+	old_ether = rte_pktmbuf_mtod(pkt, struct rte_ether_hdr *);
+	new_ether = (struct rte_ether_hdr *)rte_pktmbuf_adj(pkt,
+			sizeof(struct rte_vlan_hdr));
+	if (unlikely(new_ether == NULL))
+		return SPPWK_RET_NG;
+
+	/* Copy from the end because areas are overlapped. */
+	old = (uint32_t *)old_ether;
+	new = (uint32_t *)new_ether;
+	new[2] = old[2];
+	new[1] = old[1];
+	new[0] = old[0];
+#endif
+	return SPPWK_RET_OK;
+}
+
+/* Get bit mask of packets of VLAN tagged, checking TPID of each of them. */
+static inline unsigned int
+get_vlan_tagged_mask(struct rte_mbuf **pkts, int nb_pkts)
+{
+	int i;
+	unsigned int mask = 0;
+	const struct rte_ether_hdr *eth;
+
+	for (i = 0; i < nb_pkts; i++) {
+		eth = rte_pktmbuf_mtod(pkts[i], const struct rte_ether_hdr *);
+		mask |= (unsigned int)(eth->ether_type == g_vlan_tpid) << i;
 	}
+	return mask;
+}
 
-	vlan->vlan_tci = vlantag->tci;
-	set_fcs_packet(pkt);
+/* Prefetch headers of packets of the unit starting from given position. */
+static inline void
+prefetch_vlan_unit(struct rte_mbuf **pkts, int pos, int nb_pkts)
+{
+	int i;
+
+	for (i = pos; i < pos + VLAN_BURST_UNIT && i < nb_pkts; i++)
+		rte_prefetch0(rte_pktmbuf_mtod(pkts[i], void *));
+}
+
+/* Add VLAN tag to a packet. It is called from add_vlan_tag_all(). */
+static inline int
+add_vlan_tag_one(struct rte_mbuf *pkt, unsigned int tagged,
+		const struct sppwk_vlan_tag *vlantag)
+{
+	struct rte_ether_hdr *ether = NULL;
+	struct rte_vlan_hdr *vlan = NULL;
+	uint16_t tci = (uint16_t)vlantag->tci;
+
+	if (tagged) {
+		/* For packets with VLAN tags, only TCI is updated. */
+		ether = rte_pktmbuf_mtod(pkt, struct rte_ether_hdr *);
+		vlan = (struct rte_vlan_hdr *)&ether[1];
+		vlan->vlan_tci = tci;
+	} else if (vlantag->hw_offload) {
+		/* NIC inserts VLAN tag without moving header. */
+		pkt->ol_flags |= PKT_TX_VLAN_PKT;
+		pkt->vlan_tci = rte_be_to_cpu_16(tci);
+		return SPPWK_RET_OK;
+	} else if (unlikely(push_vlan_hdr(pkt, tci) != SPPWK_RET_OK)) {
+		RTE_LOG(ERR, PORT, "Failed to "
+				"get additional header area.\n");
+		return SPPWK_RET_NG;
+	}
+
+	if (unlikely(g_vlan_fcs))
+		set_fcs_packet(pkt);
 	return SPPWK_RET_OK;
 }
 
-/* Add VLAN tag to all packets. */
+/**
+ * Add VLAN tag to all packets. Packets are processed for each of units of
+ * VLAN_BURST_UNIT, and headers of next unit are prefetched meanwhile.
+ * Return the number of packets succeeded.
+ */
 static inline int
 add_vlan_tag_all(
 		struct rte_mbuf **pkts, int nb_pkts,
 		const union sppwk_port_capability *capability)
 {
-	int ret = SPPWK_RET_OK;
-	int cnt = 0;
-	for (cnt = 0; cnt < nb_pkts; cnt++) {
-		ret = add_vlan_tag_one(pkts[cnt], capability);
-		if (unlikely(ret < 0)) {
-			RTE_LOG(ERR, PORT,
-					"Failed to add VLAN tag."
-					"(pkts %d/%d)\n", cnt, nb_pkts);
-			break;
+	int cnt, i, nof_unit;
+	unsigned int tagged;
+
+	prefetch_vlan_unit(pkts, 0, nb_pkts);
+	for (cnt = 0; cnt < nb_pkts; cnt += nof_unit) {
+		nof_unit = RTE_MIN(VLAN_BURST_UNIT, nb_pkts - cnt);
+		prefetch_vlan_unit(pkts, cnt + nof_unit, nb_pkts);
+
+		tagged = get_vlan_tagged_mask(&pkts[cnt], nof_unit);
+		for (i = 0; i < nof_unit; i++) {
+			if (unlikely(add_vlan_tag_one(pkts[cnt + i],
+					tagged & (1U << i),
+					&capability->vlantag) < 0)) {
+				RTE_LOG(ERR, PORT,
+						"Failed to add VLAN tag."
+						"(pkts %d/%d)\n",
+						cnt + i, nb_pkts);
+				return cnt + i;
+			}
 		}
 	}
-	return cnt;
+	return nb_pkts;
 }
 
 /* Delete VLAN tag from a packet. It is called from del_vlan_tag_all(). */
 static inline int
-del_vlan_tag_one(
-		struct rte_mbuf *pkt,
-		const union sppwk_port_capability *cbl __attribute__ ((unused)))
+del_vlan_tag_one(struct rte_mbuf *pkt, unsigned int tagged,
+		const struct sppwk_vlan_tag *vlantag)
 {
-	struct rte_ether_hdr *old_ether = NULL;
-	struct rte_ether_hdr *new_ether = NULL;
-	uint32_t *old, *new;
+	/* Tag is already stripped by NIC, and inner one is kept. */
+	if (vlantag->hw_offload && (pkt->ol_flags & PKT_RX_VLAN_STRIPPED))
+		return SPPWK_RET_OK;
 
-	old_ether = rte_pktmbuf_mtod(pkt, struct rte_ether_hdr *);
-	if (old_ether->ether_type == g_vlan_tpid) {
-		/* For packets without VLAN tag, delete VLAN tag. */
-		new_ether = (struct rte_ether_hdr *)rte_pktmbuf_adj(pkt,
-				sizeof(struct rte_vlan_hdr));
-		if (unlikely(new_ether == NULL)) {
-			RTE_LOG(ERR, PORT, "Failed to "
-					"delete unnecessary header area.\n");
-			return SPPWK_RET_NG;
-		}
+	/* Nothing to do for packets without VLAN tag. */
+	if (!tagged)
+		return SPPWK_RET_OK;
 
-		old = (uint32_t *)old_ether;
-		new = (uint32_t *)new_ether;
-		new[2] = old[2];
-		new[1] = old[1];
-		new[0] = old[0];
-		old[0] = 0;
-		set_fcs_packet(pkt);
+	if (unlikely(pop_vlan_hdr(pkt) != SPPWK_RET_OK)) {
+		RTE_LOG(ERR, PORT, "Failed to "
+				"delete unnecessary header area.\n");
+		return SPPWK_RET_NG;
 	}
+
+	if (unlikely(g_vlan_fcs))
+		set_fcs_packet(pkt);
 	return SPPWK_RET_OK;
 }
 
-/* Delete VLAN tag from all packets. */
+/**
+ * Delete VLAN tag from all packets in the same manner as add_vlan_tag_all().
+ * Return the number of packets succeeded.
+ */
 static inline int
 del_vlan_tag_all(
 		struct rte_mbuf **pkts, int nb_pkts,
 		const union sppwk_port_capability *capability)
 {
-	int ret = SPPWK_RET_OK;
-	int cnt = 0;
-	for (cnt = 0; cnt < nb_pkts; cnt++) {
-		ret = del_vlan_tag_one(pkts[cnt], capability);
-		if (unlikely(ret < 0)) {
-			RTE_LOG(ERR, PORT,
-					"Failed to del VLAN tag."
-					"(pkts %d/%d)\n", cnt, nb_pkts);
-			break;
+	int cnt, i, nof_unit;
+	unsigned int tagged;
+
+	prefetch_vlan_unit(pkts, 0, nb_pkts);
+	for (cnt = 0; cnt < nb_pkts; cnt += nof_unit) {
+		nof_unit = RTE_MIN(VLAN_BURST_UNIT, nb_pkts - cnt);
+		prefetch_vlan_unit(pkts, cnt + nof_unit, nb_pkts);
+
+		tagged = get_vlan_tagged_mask(&pkts[cnt], nof_unit);
+		for (i = 0; i < nof_unit; i++) {
+			if (unlikely(del_vlan_tag_one(pkts[cnt + i],
+					tagged & (1U << i),
+					&capability->vlantag) < 0)) {
+				RTE_LOG(ERR, PORT,
+						"Failed to del VLAN tag."
+						"(pkts %d/%d)\n",
+						cnt + i, nb_pkts);
+				return cnt + i;
+			}
 		}
 	}
-	return cnt;
+	return nb_pkts;
 }
 
-/* Swap ref side and update side. */
-/* TODO(yasufum) add desc for this function. */
-void
-sppwk_swap_two_sides(
-		enum sppwk_swap_type swap_type,
-		int port_id, enum sppwk_port_dir dir)
+/* Release port attributes replaced with new one. */
+static void
+free_port_attrs(void *conf, void *arg __attribute__ ((unused)))
 {
-	int cnt;
-	static int num_rx;
-	static int num_tx;
-	static int rx_list[RTE_MAX_ETHPORTS];
-	static int tx_list[RTE_MAX_ETHPORTS];
-	struct port_capabl_mng_info *mng = NULL;
+	rte_free(conf);
+}
 
-	if (swap_type == SPPWK_SWAP_UPD) {
-		switch (dir) {
-		case SPPWK_PORT_DIR_RX:
-			mng = &g_port_mng_info[port_id].rx;
-			mng->upd_index = mng->ref_index;
-			rx_list[num_rx++] = port_id;
-			break;
-		case SPPWK_PORT_DIR_TX:
-			mng = &g_port_mng_info[port_id].tx;
-			mng->upd_index = mng->ref_index;
-			tx_list[num_tx++] = port_id;
-			break;
-		default:
-			/* Not used. */
-			break;
-		}
-		return;
-	}
+/* Check if VLAN insert of NIC is enabled for TX of given port. */
+static int
+is_vlan_insert_enabled(uint16_t port_id)
+{
+	if (!rte_eth_dev_is_valid_port(port_id))
+		return 0;
 
-	for (cnt = 0; cnt < num_rx; cnt++) {
-		mng = &g_port_mng_info[rx_list[cnt]].rx;
-		mng->ref_index = (mng->upd_index+1) % TWO_SIDES;
-		rx_list[cnt] = 0;
+	return (rte_eth_devices[port_id].data->dev_conf.txmode.offloads &
+			DEV_TX_OFFLOAD_VLAN_INSERT) != 0;
+}
+
+/**
+ * Check if given port has only one RX queue. VLAN strip of NIC is enabled
+ * for all of queues of the port, so it is used only if the queue is
+ * received only by the component of `del_vlantag` and affects no other
+ * consumer of the port in any of processes.
+ */
+static int
+has_single_rx_queue(uint16_t port_id)
+{
+	if (!rte_eth_dev_is_valid_port(port_id))
+		return 0;
+
+	return rte_eth_devices[port_id].data->nb_rx_queues == 1;
+}
+
+/**
+ * Enable or disable VLAN strip of NIC for RX of given port if it is
+ * supported. Return 1 if it is enabled, or 0.
+ */
+static int
+set_vlan_strip(struct port_mng_info *port_mng, uint16_t port_id, int on)
+{
+	int mask;
+	struct rte_eth_dev_info dev_info;
+
+	if (port_mng->vlan_strip == on)
+		return on;
+
+	if (on) {
+		if (!rte_eth_dev_is_valid_port(port_id))
+			return 0;
+		rte_eth_dev_info_get(port_id, &dev_info);
+		if (!(dev_info.rx_offload_capa & DEV_RX_OFFLOAD_VLAN_STRIP))
+			return 0;
 	}
 
-	for (cnt = 0; cnt < num_tx; cnt++) {
-		mng = &g_port_mng_info[tx_list[cnt]].tx;
-		mng->ref_index = (mng->upd_index+1) % TWO_SIDES;
-		tx_list[cnt] = 0;
+	mask = rte_eth_dev_get_vlan_offload(port_id);
+	if (unlikely(mask < 0))
+		return port_mng->vlan_strip;
+	if (on)
+		mask |= ETH_VLAN_STRIP_OFFLOAD;
+	else
+		mask &= ~ETH_VLAN_STRIP_OFFLOAD;
+
+	if (unlikely(rte_eth_dev_set_vlan_offload(port_id, mask) != 0)) {
+		RTE_LOG(INFO, PORT, "Cannot %s VLAN strip of NIC, done in "
+				"software. (port=%d)\n",
+				on ? "enable" : "disable", port_id);
+		return port_mng->vlan_strip;
 	}
+
+	port_mng->vlan_strip = on;
+	return on;
 }
 
 /* Update port attributes of given direction. */
-static void
+static int
 update_port_attrs(struct sppwk_port_info *port,
 		enum sppwk_port_dir dir)
 {
@@ -265,7 +447,9 @@ update_port_attrs(struct sppwk_port_info *port,
 	struct port_capabl_mng_info *mng = NULL;
 	struct sppwk_port_attrs *port_attrs_in = port->port_attrs;
 	struct sppwk_port_attrs *port_attrs_out = NULL;
+	struct sppwk_port_attrs *port_attrs_old = NULL;
 	struct sppwk_vlan_tag *tag = NULL;
+	int vlan_strip = 0;
 
 	port_mng->iface_type = port->iface_type;
 	port_mng->iface_no   = port->iface_no;
@@ -282,13 +466,22 @@ update_port_attrs(struct sppwk_port_info *port,
 		break;
 	}
 
-	port_attrs_out = mng->port_attrs[mng->upd_index];
-	memset(port_attrs_out, 0x00, sizeof(struct sppwk_port_attrs)
-			* PORT_CAPABL_MAX);
+	port_attrs_out = rte_zmalloc(NULL, sizeof(struct sppwk_port_attrs)
+			* PORT_CAPABL_MAX, 0);
+	if (unlikely(port_attrs_out == NULL)) {
+		RTE_LOG(ERR, PORT, "Cannot allocate port attributes. "
+				"(port=%d)\n", port_id);
+		return SPPWK_RET_NG;
+	}
+
 	for (in_cnt = 0; in_cnt < PORT_CAPABL_MAX; in_cnt++) {
 		if (port_attrs_in[in_cnt].dir != dir)
 			continue;
 
+		/* Weight is referred from balancer, not in RX or TX burst. */
+		if (port_attrs_in[in_cnt].ops == SPPWK_PORT_OPS_WEIGHT)
+			continue;
+
 		memcpy(&port_attrs_out[out_cnt], &port_attrs_in[in_cnt],
 				sizeof(struct sppwk_port_attrs));
 
@@ -297,8 +490,20 @@ update_port_attrs(struct sppwk_port_info *port,
 			tag = &port_attrs_out[out_cnt].capability.vlantag;
 			tag->tci = rte_cpu_to_be_16(SPP_VLANTAG_CALC_TCI(
 					tag->vid, tag->pcp));
+			/* Inserted by NIC if it is enabled for the port. */
+			tag->hw_offload = (dir == SPPWK_PORT_DIR_TX &&
+					is_vlan_insert_enabled(port_id));
 			break;
 		case SPPWK_PORT_OPS_DEL_VLAN:
+			/* Stripped by NIC if it is sole consumer of port. */
+			tag = &port_attrs_out[out_cnt].capability.vlantag;
+			if (dir == SPPWK_PORT_DIR_RX &&
+					has_single_rx_queue(port_id)) {
+				vlan_strip = 1;
+				tag->hw_offload = set_vlan_strip(port_mng,
+						port_id, 1);
+			}
+			break;
 		default:
 			/* Nothing to do. */
 			break;
@@ -307,11 +512,58 @@ update_port_attrs(struct sppwk_port_info *port,
 		out_cnt++;
 	}
 
-	sppwk_swap_two_sides(SPPWK_SWAP_UPD, port_id, dir);
+	/* VLAN strip is disabled if `del_vlantag` of RX is removed. */
+	if (dir == SPPWK_PORT_DIR_RX && !vlan_strip)
+		set_vlan_strip(port_mng, port_id, 0);
+
+	/* Share attributes without operations instead of allocated one. */
+	if (out_cnt == 0) {
+		rte_free(port_attrs_out);
+		port_attrs_out = g_no_port_attrs;
+	}
+
+	/* Old attrs is released after worker threads stop to refer it. */
+	port_attrs_old = SPPWK_CONF_SET(mng->port_attrs, port_attrs_out);
+	if (port_attrs_old != g_no_port_attrs)
+		sppwk_conf_rcu_defer_free(port_attrs_old,
+				free_port_attrs, NULL);
+
+	return SPPWK_RET_OK;
+}
+
+/* Check if packets shared with refcnt can be sent to given TX port. */
+int
+sppwk_is_pkt_sharable_port(const struct sppwk_port_info *port)
+{
+	int cnt;
+	uint64_t offloads;
+	struct rte_eth_txq_info qinfo;
+
+	/* Attributes other than VLAN operations of TX do not modify. */
+	for (cnt = 0; cnt < PORT_CAPABL_MAX; cnt++) {
+		if (port->port_attrs[cnt].dir == SPPWK_PORT_DIR_TX &&
+				(port->port_attrs[cnt].ops ==
+				 SPPWK_PORT_OPS_ADD_VLAN ||
+				 port->port_attrs[cnt].ops ==
+				 SPPWK_PORT_OPS_DEL_VLAN))
+			return 0;
+	}
+	if (port->ethdev_port_id < 0 ||
+			!rte_eth_dev_is_valid_port(port->ethdev_port_id))
+		return 1;
+
+	/* Offloads of the queue include ones of the port if available. */
+	if (rte_eth_tx_queue_info_get(port->ethdev_port_id, port->queue_no,
+			&qinfo) == 0)
+		offloads = qinfo.conf.offloads;
+	else
+		offloads = rte_eth_devices[port->ethdev_port_id].data->
+				dev_conf.txmode.offloads;
+	return (offloads & DEV_TX_OFFLOAD_MBUF_FAST_FREE) == 0;
 }
 
 /* Update port direction of given component. */
-void
+int
 sppwk_update_port_dir(const struct sppwk_comp_info *comp)
 {
 	int cnt;
@@ -319,13 +571,18 @@ sppwk_update_port_dir(const struct sppwk_comp_info *comp)
 
 	for (cnt = 0; cnt < comp->nof_rx; cnt++) {
 		port_info = comp->rx_ports[cnt];
-		update_port_attrs(port_info, SPPWK_PORT_DIR_RX);
+		if (unlikely(update_port_attrs(port_info,
+					SPPWK_PORT_DIR_RX) != SPPWK_RET_OK))
+			return SPPWK_RET_NG;
 	}
 
 	for (cnt = 0; cnt < comp->nof_tx; cnt++) {
 		port_info = comp->tx_ports[cnt];
-		update_port_attrs(port_info, SPPWK_PORT_DIR_TX);
+		if (unlikely(update_port_attrs(port_info,
+					SPPWK_PORT_DIR_TX) != SPPWK_RET_OK))
+			return SPPWK_RET_NG;
 	}
+	return SPPWK_RET_OK;
 }
 
 /**
@@ -363,7 +620,7 @@ vlan_operation(uint16_t port_id, struct rte_mbuf **pkts, const uint16_t nb_pkts,
 
 		/* Add or delete VLAN tag with operation function. */
 		ok_pkts = vlan_ops[port_attrs[cnt].ops](
-				pkts, ok_pkts, &port_attrs->capability);
+				pkts, ok_pkts, &port_attrs[cnt].capability);
 	}
 
 	/* Discard remained packets to release mbuf. */
@@ -375,79 +632,177 @@ vlan_operation(uint16_t port_id, struct rte_mbuf **pkts, const uint16_t nb_pkts,
 	return ok_pkts;
 }
 
-/* Wrapper function for rte_eth_rx_burst() with VLAN feature. */
-uint16_t
-sppwk_eth_vlan_rx_burst(uint16_t port_id,
-		uint16_t queue_id,
-		struct rte_mbuf **rx_pkts, const uint16_t nb_pkts)
+/* Measure latency of packets received from given port. */
+static inline void
+measure_rx_latency(uint16_t port_id, struct rte_mbuf **pkts,
+		uint16_t nb_pkts)
+{
+	struct port_mng_info *port_mng = &g_port_mng_info[port_id];
+
+	if (port_mng->iface_type == RING &&
+			sppwk_is_ring_latency_enabled(port_mng->iface_no))
+		sppwk_calc_ring_latency(port_mng->iface_no, pkts, nb_pkts);
+	chain_lat_rx(port_id, port_mng->iface_type, port_mng->iface_no,
+			pkts, nb_pkts);
+}
+
+/* Measure latency of packets sent to given port. */
+static inline void
+measure_tx_latency(uint16_t port_id, struct rte_mbuf **pkts,
+		uint16_t nb_pkts)
+{
+	struct port_mng_info *port_mng = &g_port_mng_info[port_id];
+
+	/* Timestamp is set before packets are referred from receiver. */
+	if (port_mng->iface_type == RING &&
+			sppwk_is_ring_latency_enabled(port_mng->iface_no))
+		sppwk_add_ring_latency_time(port_mng->iface_no, pkts,
+				nb_pkts);
+	chain_lat_tx(port_id, port_mng->iface_type, port_mng->iface_no,
+			pkts, nb_pkts);
+}
+
+/* RX burst without any of features. */
+static uint16_t
+eth_rx_burst(uint16_t port_id, uint16_t queue_id,
+		struct rte_mbuf **rx_pkts, uint16_t nb_pkts)
+{
+	return rte_eth_rx_burst(port_id, queue_id, rx_pkts, nb_pkts);
+}
+
+/* TX burst without any of features. */
+static uint16_t
+eth_tx_burst(uint16_t port_id, uint16_t queue_id,
+		struct rte_mbuf **tx_pkts, uint16_t nb_pkts)
+{
+	return rte_eth_tx_burst(port_id, queue_id, tx_pkts, nb_pkts);
+}
+
+/* RX burst with latency measurement. */
+static uint16_t
+eth_stats_rx_burst(uint16_t port_id, uint16_t queue_id,
+		struct rte_mbuf **rx_pkts, uint16_t nb_pkts)
 {
 	uint16_t nb_rx;
+
+	nb_rx = rte_eth_rx_burst(port_id, queue_id, rx_pkts, nb_pkts);
+	if (likely(nb_rx != 0))
+		measure_rx_latency(port_id, rx_pkts, nb_rx);
+	return nb_rx;
+}
+
+/* TX burst with latency measurement. */
+static uint16_t
+eth_stats_tx_burst(uint16_t port_id, uint16_t queue_id,
+		struct rte_mbuf **tx_pkts, uint16_t nb_pkts)
+{
+	measure_tx_latency(port_id, tx_pkts, nb_pkts);
+	return rte_eth_tx_burst(port_id, queue_id, tx_pkts, nb_pkts);
+}
+
+/* RX burst with VLAN feature. */
+static uint16_t
+eth_vlan_rx_burst(uint16_t port_id, uint16_t queue_id,
+		struct rte_mbuf **rx_pkts, uint16_t nb_pkts)
+{
+	uint16_t nb_rx;
+
 	nb_rx = rte_eth_rx_burst(port_id, queue_id, rx_pkts, nb_pkts);
 	if (unlikely(nb_rx == 0))
-		return SPPWK_RET_OK;
+		return 0;
 
 	/* Add or delete VLAN tag. */
 	return vlan_operation(port_id, rx_pkts, nb_rx, SPPWK_PORT_DIR_RX);
 }
 
-/* Wrapper function for rte_eth_tx_burst() with VLAN feature. */
-uint16_t
-sppwk_eth_vlan_tx_burst(uint16_t port_id,
-		uint16_t queue_id,
+/* TX burst with VLAN feature. */
+static uint16_t
+eth_vlan_tx_burst(uint16_t port_id, uint16_t queue_id,
 		struct rte_mbuf **tx_pkts, uint16_t nb_pkts)
 {
 	uint16_t nb_tx;
 
 	/* Add or delete VLAN tag. */
 	nb_tx = vlan_operation(port_id, tx_pkts, nb_pkts, SPPWK_PORT_DIR_TX);
-
 	if (unlikely(nb_tx == 0))
-		return SPPWK_RET_OK;
+		return 0;
 
 	return rte_eth_tx_burst(port_id, queue_id, tx_pkts, nb_tx);
 }
 
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
-
-/* Wrapper function for rte_eth_rx_burst() with VLAN feature. */
-uint16_t
-sppwk_eth_vlan_ring_stats_rx_burst(uint16_t port_id,
-		enum port_type iface_type, int iface_no,
-		uint16_t queue_id __attribute__ ((unused)),
-		struct rte_mbuf **rx_pkts, const uint16_t nb_pkts)
+/* RX burst with VLAN feature and latency measurement. */
+static uint16_t
+eth_vlan_stats_rx_burst(uint16_t port_id, uint16_t queue_id,
+		struct rte_mbuf **rx_pkts, uint16_t nb_pkts)
 {
 	uint16_t nb_rx;
-	nb_rx = rte_eth_rx_burst(port_id, 0, rx_pkts, nb_pkts);
+
+	nb_rx = rte_eth_rx_burst(port_id, queue_id, rx_pkts, nb_pkts);
 	if (unlikely(nb_rx == 0))
-		return SPPWK_RET_OK;
+		return 0;
 
-	if (iface_type == RING)
-		sppwk_calc_ring_latency(iface_no, rx_pkts, nb_pkts);
+	measure_rx_latency(port_id, rx_pkts, nb_rx);
 
 	/* Add or delete VLAN tag. */
 	return vlan_operation(port_id, rx_pkts, nb_rx, SPPWK_PORT_DIR_RX);
 }
 
-/* Wrapper function for rte_eth_tx_burst() with VLAN feature. */
-uint16_t
-sppwk_eth_vlan_ring_stats_tx_burst(uint16_t port_id,
-		enum port_type iface_type, int iface_no,
-		uint16_t queue_id __attribute__ ((unused)),
+/* TX burst with VLAN feature and latency measurement. */
+static uint16_t
+eth_vlan_stats_tx_burst(uint16_t port_id, uint16_t queue_id,
 		struct rte_mbuf **tx_pkts, uint16_t nb_pkts)
 {
 	uint16_t nb_tx;
 
 	/* Add or delete VLAN tag. */
 	nb_tx = vlan_operation(port_id, tx_pkts, nb_pkts, SPPWK_PORT_DIR_TX);
-
 	if (unlikely(nb_tx == 0))
-		return SPPWK_RET_OK;
+		return 0;
 
-	if (iface_type == RING) {
-		sppwk_add_ring_latency_time(iface_no, tx_pkts, nb_pkts);
-	}
+	measure_tx_latency(port_id, tx_pkts, nb_tx);
+	return rte_eth_tx_burst(port_id, queue_id, tx_pkts, nb_tx);
+}
 
-	return rte_eth_tx_burst(port_id, 0, tx_pkts, nb_tx);
+/**
+ * Select burst functions of a port from latency measurement. Burst
+ * functions with VLAN feature are always selected for callers of it even
+ * if the port has no operations, because worker threads might call old
+ * ones for a while after attributes are published. It is skipped in
+ * vlan_operation() which checks published attributes by itself.
+ */
+static void
+select_burst_ops(uint16_t port_id)
+{
+	struct port_mng_info *port_mng = &g_port_mng_info[port_id];
+	struct sppwk_burst_ops *ops = &g_sppwk_burst_ops[port_id];
+	int stats = chain_lat_enabled() || (port_mng->iface_type == RING &&
+			sppwk_is_ring_latency_enabled(port_mng->iface_no));
+
+	if (stats) {
+		ops->rx = eth_stats_rx_burst;
+		ops->tx = eth_stats_tx_burst;
+		ops->vlan_rx = eth_vlan_stats_rx_burst;
+		ops->vlan_tx = eth_vlan_stats_tx_burst;
+	} else {
+		ops->rx = eth_rx_burst;
+		ops->tx = eth_tx_burst;
+		ops->vlan_rx = eth_vlan_rx_burst;
+		ops->vlan_tx = eth_vlan_tx_burst;
+	}
 }
 
-#endif /* SPP_RINGLATENCYSTATS_ENABLE */
+/* Select burst functions of given port again. */
+void
+sppwk_update_burst_ops(const struct sppwk_port_info *port)
+{
+	struct port_mng_info *port_mng;
+
+	if (unlikely(port->ethdev_port_id < 0 ||
+			port->ethdev_port_id >= RTE_MAX_ETHPORTS))
+		return;
+
+	port_mng = &g_port_mng_info[port->ethdev_port_id];
+	port_mng->iface_type = port->iface_type;
+	port_mng->iface_no = port->iface_no;
+	select_burst_ops(port->ethdev_port_id);
+}
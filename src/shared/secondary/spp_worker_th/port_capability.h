@@ -12,23 +12,33 @@
  * Provide about the ability per port.
  */
 
+#include <rte_mbuf.h>
 #include "cmd_utils.h"
 
 /** Calculate TCI of VLAN tag. */
 #define SPP_VLANTAG_CALC_TCI(id, pcp) (((pcp & 0x07) << 13) | (id & 0x0fff))
 
-/** Type for swaping sides . */
-enum sppwk_swap_type {
-	SPPWK_SWAP_REF,  /** Swap to reference area. */
-	SPPWK_SWAP_UPD,  /** Swap to update area. */
-};
-
 /**
- * Initialize global variable g_port_mng_info, and set ref side to 0 and
- * update side to 1.
+ * Initialize global variable g_port_mng_info with port attributes without
+ * any of operations.
  */
 void sppwk_port_capability_init(void);
 
+/**
+ * Enable or disable calculating FCS of packets of which VLAN tag is added
+ * or deleted in software. It is disabled as default.
+ *
+ * @param enabled 1 for enabled, or 0.
+ */
+void sppwk_set_vlan_fcs(int enabled);
+
+/**
+ * Check if FCS of packets of VLAN features is calculated.
+ *
+ * @retval 1 if enabled, or 0.
+ */
+int sppwk_get_vlan_fcs(void);
+
 /**
  * Get port attributes of given ID and direction from global g_port_mng_info.
  *
@@ -41,25 +51,95 @@ void sppwk_get_port_attrs(
 		int port_id, enum sppwk_port_dir dir);
 
 /**
- * Swap ref side and update side.
+ * Update port direction of given component. Port attributes are published
+ * to worker threads, and old ones are released after worker threads stop to
+ * refer them.
  *
- * @param port_id Etherdev ID.
- * @param rxtx RX/TX ID of port_id.
- * @param type Type for changing index.
+ * @param comp Pointer to sppwk_comp_info.
+ * @retval SPPWK_RET_OK If succeeded.
+ * @retval SPPWK_RET_NG If failed.
  */
-void sppwk_swap_two_sides(
-		enum sppwk_swap_type swap_type,
-		int port_id, enum sppwk_port_dir dir);
+int sppwk_update_port_dir(const struct sppwk_comp_info *comp);
 
 /**
- * Update port direction of given component.
+ * Check if packets shared with refcnt among ports can be sent to given TX
+ * port. They must not be modified with VLAN operations, or released
+ * regardless of refcnt with DEV_TX_OFFLOAD_MBUF_FAST_FREE of the queue.
  *
- * @param comp Pointer to sppwk_comp_info.
+ * @param port TX port info.
+ * @retval 1 if packets can be shared, or 0.
+ */
+int sppwk_is_pkt_sharable_port(const struct sppwk_port_info *port);
+
+/**
+ * Burst function of RX or TX of a port, which has the same params as
+ * rte_eth_rx_burst() and rte_eth_tx_burst().
+ */
+typedef uint16_t (*sppwk_burst_t)(uint16_t port_id, uint16_t queue_id,
+		struct rte_mbuf **pkts, uint16_t nb_pkts);
+
+/**
+ * Burst functions of a port. They are selected when latency measurement of
+ * the port is updated, so that RX and TX bursts do not check it if it is
+ * not enabled. VLAN features are checked in each of bursts with them.
+ */
+struct sppwk_burst_ops {
+	sppwk_burst_t rx;  /**< RX without VLAN features. */
+	sppwk_burst_t tx;  /**< TX without VLAN features. */
+	sppwk_burst_t vlan_rx;  /**< RX with VLAN features. */
+	sppwk_burst_t vlan_tx;  /**< TX with VLAN features. */
+};
+
+/* Burst functions of each of ports referred from worker threads. */
+extern struct sppwk_burst_ops g_sppwk_burst_ops[RTE_MAX_ETHPORTS];
+
+/**
+ * Select burst functions of given port again, for example, after latency
+ * measurement of the port is enabled or disabled.
+ *
+ * @param port Port info of which `ethdev_port_id` is valid.
+ */
+void sppwk_update_burst_ops(const struct sppwk_port_info *port);
+
+/**
+ * Wrapper function for rte_eth_rx_burst() with latency measurement if it
+ * is enabled for the port.
+ *
+ * @param[in] port_id Etherdev ID.
+ * @param[in] queue_id RX queue ID.
+ * @param[in] rx_pkts Pointers to mbuf should be enough to store nb_pkts.
+ * @param nb_pkts Maximum number of RX packets.
+ * @return Number of RX packets as number of pointers to mbuf.
+ */
+static inline uint16_t
+sppwk_eth_rx_burst(uint16_t port_id, uint16_t queue_id,
+		struct rte_mbuf **rx_pkts, const uint16_t nb_pkts)
+{
+	return g_sppwk_burst_ops[port_id].rx(port_id, queue_id, rx_pkts,
+			nb_pkts);
+}
+
+/**
+ * Wrapper function for rte_eth_tx_burst() with latency measurement if it
+ * is enabled for the port.
+ *
+ * @param port_id Etherdev ID.
+ * @param[in] queue_id TX queue ID.
+ * @param[in] tx_pkts Pointers to mbuf should be enough to store nb_pkts.
+ * @param nb_pkts Maximum number of TX packets.
+ * @return Number of TX packets as number of pointers to mbuf.
  */
-void sppwk_update_port_dir(const struct sppwk_comp_info *comp);
+static inline uint16_t
+sppwk_eth_tx_burst(uint16_t port_id, uint16_t queue_id,
+		struct rte_mbuf **tx_pkts, uint16_t nb_pkts)
+{
+	return g_sppwk_burst_ops[port_id].tx(port_id, queue_id, tx_pkts,
+			nb_pkts);
+}
 
 /**
- * Wrapper function for rte_eth_rx_burst() with VLAN feature.
+ * Wrapper function for rte_eth_rx_burst() with VLAN feature and latency
+ * measurement if they are enabled for the port.
  *
  * @param[in] port_id Etherdev ID.
  * @param[in] queue_id RX queue ID.
@@ -67,11 +147,17 @@ void sppwk_update_port_dir(const struct sppwk_comp_info *comp);
  * @param nb_pkts Maximum number of RX packets.
  * @return Number of RX packets as number of pointers to mbuf.
  */
-uint16_t sppwk_eth_vlan_rx_burst(uint16_t port_id, uint16_t queue_id,
-		struct rte_mbuf **rx_pkts, const uint16_t nb_pkts);
+static inline uint16_t
+sppwk_eth_vlan_rx_burst(uint16_t port_id, uint16_t queue_id,
+		struct rte_mbuf **rx_pkts, const uint16_t nb_pkts)
+{
+	return g_sppwk_burst_ops[port_id].vlan_rx(port_id, queue_id, rx_pkts,
+			nb_pkts);
+}
 
 /**
- * Wrapper function for rte_eth_tx_burst() with VLAN feature.
+ * Wrapper function for rte_eth_tx_burst() with VLAN feature and latency
+ * measurement if they are enabled for the port.
  *
  * @param port_id Etherdev ID.
  * @param[in] queue_id TX queue ID.
@@ -79,7 +165,12 @@ uint16_t sppwk_eth_vlan_rx_burst(uint16_t port_id, uint16_t queue_id,
  * @param nb_pkts Maximum number of TX packets.
  * @return Number of TX packets as number of pointers to mbuf.
  */
-uint16_t sppwk_eth_vlan_tx_burst(uint16_t port_id, uint16_t queue_id,
-		struct rte_mbuf **tx_pkts, uint16_t nb_pkts);
+static inline uint16_t
+sppwk_eth_vlan_tx_burst(uint16_t port_id, uint16_t queue_id,
+		struct rte_mbuf **tx_pkts, uint16_t nb_pkts)
+{
+	return g_sppwk_burst_ops[port_id].vlan_tx(port_id, queue_id, tx_pkts,
+			nb_pkts);
+}
 
 #endif /*  __PORT_CAPABILITY_H__ */
@@ -0,0 +1,161 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#include <stdlib.h>
+
+#include <rte_log.h>
+#include <rte_cycles.h>
+#include <rte_ethdev.h>
+#include <rte_memcpy.h>
+
+#include "tx_coalesce.h"
+#include "port_capability.h"
+#include "../return_codes.h"
+
+#define RTE_LOGTYPE_SPPWK_TX_COAL RTE_LOGTYPE_USER1
+
+/* Flush latency budget in micro sec given as an option. */
+static uint32_t g_tx_flush_us = DEFAULT_TX_FLUSH_US;
+
+/* Num of packets to be transmitted at once given as an option. */
+static uint16_t g_tx_min_burst = DEFAULT_TX_MIN_BURST;
+
+/* Set flush latency budget from string of option in micro sec. */
+int
+sppwk_parse_tx_flush_us(const char *us_str)
+{
+	unsigned long flush_us;
+	char *endptr = NULL;
+
+	flush_us = strtoul(us_str, &endptr, 10);
+	if (unlikely(us_str == endptr) || unlikely(*endptr != '\0'))
+		return SPPWK_RET_NG;
+
+	/* Longer than a sec is not expected as latency of packets. */
+	if (unlikely(flush_us > US_PER_S))
+		return SPPWK_RET_NG;
+
+	g_tx_flush_us = (uint32_t)flush_us;
+	return SPPWK_RET_OK;
+}
+
+/* Set min burst from string of option. */
+int
+sppwk_parse_tx_min_burst(const char *burst_str)
+{
+	unsigned long min_burst;
+	char *endptr = NULL;
+
+	min_burst = strtoul(burst_str, &endptr, 10);
+	if (unlikely(burst_str == endptr) || unlikely(*endptr != '\0'))
+		return SPPWK_RET_NG;
+
+	if (unlikely(min_burst < 1 || min_burst > MAX_PKT_BURST))
+		return SPPWK_RET_NG;
+
+	g_tx_min_burst = (uint16_t)min_burst;
+	return SPPWK_RET_OK;
+}
+
+/* Get flush latency budget in micro sec. */
+uint32_t
+sppwk_get_tx_flush_us(void)
+{
+	return g_tx_flush_us;
+}
+
+/* Get num of packets in TX buffer to be transmitted at once. */
+uint16_t
+sppwk_get_tx_min_burst(void)
+{
+	return g_tx_min_burst;
+}
+
+/* Assign TX port to the buffer. */
+void
+sppwk_tx_buf_init(struct sppwk_tx_buf *buf, int port_id, uint16_t queue_no,
+		enum port_type iface_type, int iface_no, int use_vlan)
+{
+	buf->ethdev_port_id = port_id;
+	buf->queue_no = queue_no;
+	buf->iface_type = iface_type;
+	buf->iface_no = iface_no;
+	buf->use_vlan = use_vlan;
+	buf->min_burst = g_tx_min_burst;
+	buf->flush_tsc = (rte_get_tsc_hz() + US_PER_S - 1) / US_PER_S *
+			g_tx_flush_us;
+	buf->nof_pkts = 0;
+	buf->first_tsc = 0;
+}
+
+/* Transmit packets to the port of the buffer and discard remained ones. */
+static void
+transmit_packets(struct sppwk_tx_buf *buf, struct rte_mbuf **pkts,
+		uint16_t nb_pkts)
+{
+	uint16_t n_tx, i;
+
+	if (unlikely(buf->ethdev_port_id < 0)) {
+		n_tx = 0;
+	} else if (buf->use_vlan) {
+		n_tx = sppwk_eth_vlan_tx_burst(buf->ethdev_port_id,
+				buf->queue_no, pkts, nb_pkts);
+	} else {
+		n_tx = sppwk_eth_tx_burst(buf->ethdev_port_id, buf->queue_no,
+				pkts, nb_pkts);
+	}
+
+	/* free cannot transmit packets */
+	if (unlikely(n_tx < nb_pkts)) {
+		for (i = n_tx; i < nb_pkts; i++)
+			rte_pktmbuf_free(pkts[i]);
+		RTE_LOG(DEBUG, SPPWK_TX_COAL,
+				"drop packets(tx). num=%hu, ethdev_port_id=%d\n",
+				(uint16_t)(nb_pkts - n_tx),
+				buf->ethdev_port_id);
+	}
+}
+
+/* Transmit all of packets in the buffer. */
+void
+sppwk_tx_buf_flush(struct sppwk_tx_buf *buf)
+{
+	if (buf->nof_pkts == 0)
+		return;
+
+	transmit_packets(buf, buf->pkts, buf->nof_pkts);
+	buf->nof_pkts = 0;
+}
+
+/* Add packets to the buffer, and transmit if reaching min burst. */
+void
+sppwk_tx_buf_push_bulk(struct sppwk_tx_buf *buf, struct rte_mbuf **pkts,
+		uint16_t nb_pkts, uint64_t cur_tsc)
+{
+	uint16_t n;
+
+	/* Send packets directly without copying if enough. */
+	if (buf->nof_pkts == 0 && nb_pkts >= buf->min_burst) {
+		buf->stats.full_flushes++;
+		transmit_packets(buf, pkts, nb_pkts);
+		return;
+	}
+
+	while (nb_pkts > 0) {
+		if (buf->nof_pkts == 0)
+			buf->first_tsc = cur_tsc;
+
+		n = RTE_MIN(nb_pkts, (uint16_t)(MAX_PKT_BURST - buf->nof_pkts));
+		rte_memcpy(&buf->pkts[buf->nof_pkts], pkts,
+				sizeof(struct rte_mbuf *) * n);
+		buf->nof_pkts += n;
+		pkts += n;
+		nb_pkts -= n;
+
+		if (buf->nof_pkts >= buf->min_burst) {
+			buf->stats.full_flushes++;
+			sppwk_tx_buf_flush(buf);
+		}
+	}
+}
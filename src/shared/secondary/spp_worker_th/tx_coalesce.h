@@ -0,0 +1,164 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#ifndef _SPPWK_TH_TX_COALESCE_H_
+#define _SPPWK_TH_TX_COALESCE_H_
+
+/**
+ * @file
+ * SPP worker TX coalescing
+ *
+ * Packets sent to a TX port from a component are kept in a buffer of the
+ * component, and transmitted at once if the number of packets reaches
+ * min burst, or the oldest packet waits longer than flush latency budget.
+ */
+
+#include <rte_mbuf.h>
+#include "cmd_utils.h"
+
+/* Default flush latency budget of packets in TX buffer in micro sec. */
+#define DEFAULT_TX_FLUSH_US 100
+
+/* Default num of packets in TX buffer to be transmitted at once. */
+#define DEFAULT_TX_MIN_BURST MAX_PKT_BURST
+
+/* Counters of flushing TX buffers. */
+struct sppwk_tx_coal_stats {
+	uint64_t full_flushes;  /* Flushed for reaching min burst. */
+	uint64_t timeout_flushes;  /* Flushed for exceeding latency budget. */
+};
+
+/* Buffer of packets to be sent to a TX port. */
+struct sppwk_tx_buf {
+	int ethdev_port_id;  /* Ethdev port ID, or -1 if not assigned. */
+	uint16_t queue_no;  /* TX queue ID. */
+	enum port_type iface_type;  /* Interface type for ring latency. */
+	int iface_no;  /* Interface number for ring latency. */
+	int use_vlan;  /* Add or delete VLAN tag if it is 1. */
+	uint16_t min_burst;  /* Num of packets transmitted at once. */
+	uint16_t nof_pkts;  /* Num of packets in pkts[]. */
+	uint64_t flush_tsc;  /* Flush latency budget in TSC cycles. */
+	uint64_t first_tsc;  /* TSC at buffering the oldest packet. */
+	struct sppwk_tx_coal_stats stats;  /* Counters of flushing. */
+	struct rte_mbuf *pkts[MAX_PKT_BURST];  /* Packets to be sent. */
+};
+
+/**
+ * Set flush latency budget from string of option in micro sec. It must be
+ * called before TX buffers are initialized.
+ *
+ * @param[in] us_str String of flush latency budget.
+ * @retval SPPWK_RET_OK If succeeded.
+ * @retval SPPWK_RET_NG If failed.
+ */
+int sppwk_parse_tx_flush_us(const char *us_str);
+
+/**
+ * Set min burst from string of option. It must be called before TX buffers
+ * are initialized.
+ *
+ * @param[in] burst_str String of num of packets from 1 to MAX_PKT_BURST.
+ * @retval SPPWK_RET_OK If succeeded.
+ * @retval SPPWK_RET_NG If failed.
+ */
+int sppwk_parse_tx_min_burst(const char *burst_str);
+
+/* Get flush latency budget in micro sec. */
+uint32_t sppwk_get_tx_flush_us(void);
+
+/* Get num of packets in TX buffer to be transmitted at once. */
+uint16_t sppwk_get_tx_min_burst(void);
+
+/**
+ * Assign TX port to the buffer. Counters are not cleared for keeping
+ * statistics of a component across updating ports.
+ *
+ * @param buf TX buffer which must be empty.
+ * @param port_id Ethdev port ID, or -1 for no port.
+ * @param queue_no TX queue ID.
+ * @param iface_type Interface type of the port.
+ * @param iface_no Interface number of the port.
+ * @param use_vlan 1 if add or delete VLAN tag with port capability.
+ */
+void sppwk_tx_buf_init(struct sppwk_tx_buf *buf, int port_id,
+		uint16_t queue_no, enum port_type iface_type, int iface_no,
+		int use_vlan);
+
+/**
+ * Transmit all of packets in the buffer. Packets failed to be sent are
+ * discarded.
+ *
+ * @param buf TX buffer.
+ */
+void sppwk_tx_buf_flush(struct sppwk_tx_buf *buf);
+
+/**
+ * Add packets to the buffer, and transmit if num of packets reaches min
+ * burst. Packets are sent without copying if enough packets are given
+ * while the buffer is empty.
+ *
+ * @param buf TX buffer.
+ * @param pkts Packets to be sent.
+ * @param nb_pkts Num of packets.
+ * @param cur_tsc Current TSC.
+ */
+void sppwk_tx_buf_push_bulk(struct sppwk_tx_buf *buf,
+		struct rte_mbuf **pkts, uint16_t nb_pkts, uint64_t cur_tsc);
+
+/**
+ * Add a packet to the buffer, and transmit if num of packets reaches min
+ * burst.
+ *
+ * @param buf TX buffer.
+ * @param pkt Packet to be sent.
+ * @param cur_tsc Current TSC.
+ */
+static inline void
+sppwk_tx_buf_push(struct sppwk_tx_buf *buf, struct rte_mbuf *pkt,
+		uint64_t cur_tsc)
+{
+	if (buf->nof_pkts == 0)
+		buf->first_tsc = cur_tsc;
+	buf->pkts[buf->nof_pkts++] = pkt;
+
+	if (unlikely(buf->nof_pkts >= buf->min_burst)) {
+		buf->stats.full_flushes++;
+		sppwk_tx_buf_flush(buf);
+	}
+}
+
+/**
+ * Transmit packets if the oldest one waits longer than flush latency budget.
+ * It should be called at each of loops of worker thread.
+ *
+ * @param buf TX buffer.
+ * @param cur_tsc Current TSC.
+ */
+static inline void
+sppwk_tx_buf_drain(struct sppwk_tx_buf *buf, uint64_t cur_tsc)
+{
+	if (likely(buf->nof_pkts == 0))
+		return;
+
+	if (cur_tsc - buf->first_tsc >= buf->flush_tsc) {
+		buf->stats.timeout_flushes++;
+		sppwk_tx_buf_flush(buf);
+	}
+}
+
+/**
+ * Add counters of the buffer to given stats for showing status.
+ *
+ * @param[in,out] stats Sum of counters.
+ * @param[in] buf TX buffer.
+ */
+static inline void
+sppwk_tx_buf_add_stats(struct sppwk_tx_coal_stats *stats,
+		const struct sppwk_tx_buf *buf)
+{
+	stats->full_flushes += buf->stats.full_flushes;
+	stats->timeout_flushes += buf->stats.timeout_flushes;
+}
+
+#endif  /* _SPPWK_TH_TX_COALESCE_H_ */
@@ -18,11 +18,28 @@
 #define NOF_VLAN 4096
 
 /* Num of entries of ops_list in vf_cmd_runner.c. */
-#define NOF_STAT_OPS 8
+#define NOF_STAT_OPS 10
 
-/* Classifier for MAC addresses. */
+/**
+ * Max num of MAC entries looked up by linear comparison instead of hash
+ * table. It is faster than probing hash table if the table is small enough.
+ */
+#define NOF_CLS_LINEAR_ENTRIES 8
+
+/* VID of VLAN untagged */
+#define VLAN_UNTAGGED_VID 0x0fff
+
+/* Key of classifier table which consists of VID and MAC address. */
+struct cls_tbl_key {
+	uint16_t vid;  /* VLAN ID, or VLAN_UNTAGGED_VID for untagged. */
+	struct rte_ether_addr addr;  /* MAC address. */
+};
+
+/**
+ * Classifier for MAC addresses of a VLAN. Entries of MAC address are
+ * registered in `cls_tbl` of `cls_comp_info` shared among all of VLANs.
+ */
 struct mac_classifier {
-	struct rte_hash *cls_tbl;  /* Hash table for MAC classification. */
 	int nof_cls_ports;  /* Num of ports classified validly. */
 	/**
 	 * Ports for classification.
@@ -31,6 +48,10 @@ struct mac_classifier {
 	 */
 	int cls_ports[RTE_MAX_QUEUES_PER_PORT];
 	int default_cls_idx;  /* Default index for classification. */
+	int nof_entries;  /* Num of MAC entries of the VLAN in cls_tbl. */
+	/* MAC addrs compared linearly if nof_entries is small enough. */
+	uint64_t lin_keys[NOF_CLS_LINEAR_ENTRIES] __rte_aligned(16);
+	int lin_idx[NOF_CLS_LINEAR_ENTRIES];  /* Indices of lin_keys. */
 };
 
 /* Attirbutes of port for classification. */
@@ -41,18 +62,33 @@ struct cls_port_info {
 	int queue_no;   /* Index of queue per port handled by classifier. */
 	int iface_no_global;  /* ID for interface generated by spp_vf */
 	uint16_t ethdev_port_id;  /* Ethdev port ID. */
-	uint16_t nof_pkts;  /* Number of packets in pkts[]. */
-	struct rte_mbuf *pkts[MAX_PKT_BURST];  /* packets to be classified. */
+	uint64_t cls_mac_addr;  /* MAC address classified to TX port. */
+	uint16_t cls_vid;  /* VID classified to TX port. */
+	/* MAC address and VID read at once by classifier thread, or 0. */
+	uint64_t cls_key;
 };
 
+/* ACL of 5-tuple rules compiled for a classifier, defined in spp_vf. */
+struct cls_acl;
+
 /* classifier component information */
 struct cls_comp_info {
 	char name[STR_LEN_NAME];  /* component name */
+	unsigned int conf_ver;  /* Version incremented if ports are changed. */
 	int mac_addr_entry;  /* mac address entry flag */
+	struct cls_acl *acl;  /* ACL matched before MAC address, or NULL. */
+	unsigned int acl_ver;  /* Version of ACL rules compiled in `acl`. */
+	struct rte_hash *cls_tbl;  /* Table of pairs of VID and MAC address. */
 	struct mac_classifier *mac_clfs[NOF_VLAN];  /* classifiers per VLAN. */
 	int nof_tx_ports;  /* Number of TX ports info entries. */
-	/* Classifier has one RX port and several TX ports. */
+	/**
+	 * Classifier has one RX port and several TX ports, and RX queues of
+	 * the same phy port if flow offload is enabled.
+	 */
 	struct cls_port_info rx_port_i;  /* RX port info classified. */
+	int nof_flow_rx;  /* Num of RX queues paired with TX ports. */
+	/* RX queues of packets steered with rules of flow offload. */
+	uint16_t flow_rx_queues[RTE_MAX_QUEUES_PER_PORT];
 	/**
 	 * TX info.
 	 * For multi-queue case, size of ports should be
@@ -64,21 +100,38 @@ struct cls_comp_info {
 int add_core(const char *name, char **output,
 		void *tmp __attribute__ ((unused)));
 
+/* get vid from ethernet header of packet */
+static inline uint16_t
+get_vid_from_hdr(const struct rte_ether_hdr *eth)
+{
+	const struct rte_vlan_hdr *vh;
+
+	if (eth->ether_type == rte_cpu_to_be_16(RTE_ETHER_TYPE_VLAN)) {
+		/* vlan tagged */
+		vh = (const struct rte_vlan_hdr *)(eth + 1);
+		return rte_be_to_cpu_16(vh->vlan_tci) & 0x0fff;
+	}
+
+	/* vlan untagged */
+	return VLAN_UNTAGGED_VID;
+}
+
 /* Release instance of mac classifier. */
 static inline void
 free_mac_classifier(struct mac_classifier *mac_clf)
 {
 	if (mac_clf == NULL)
 		return;
-	if (mac_clf->cls_tbl != NULL)
-		rte_hash_free(mac_clf->cls_tbl);
 	rte_free(mac_clf);
 }
 
 int exec_one_cmd(const struct sppwk_cmd_attrs *cmd);
 
 /**
- * Update classifier info.
+ * Update classifier info. Classifier joins the group of `grp_comp_id` of
+ * given info. Members of a group share the table of the first classifier
+ * of the group, and send packets to their own TX ports of the same index
+ * as the first one.
  *
  * @param wk_comp_info Pointer to internal data of classifier.
  * @retval SPPWK_RET_OK If succeeded.
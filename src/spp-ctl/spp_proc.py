@@ -166,9 +166,12 @@ class VfCommon(SppProc):
         return "status"
 
     @exec_command
-    def start_component(self, comp_name, core_id, comp_type):
-        return ("component start {comp_name} {core_id} {comp_type}"
-                .format(**locals()))
+    def start_component(self, comp_name, core_id, comp_type, group=None):
+        cmd = ("component start {comp_name} {core_id} {comp_type}"
+               .format(**locals()))
+        if group is not None:
+            cmd += " %s" % group
+        return cmd
 
     @exec_command
     def stop_component(self, comp_name):
@@ -178,6 +181,10 @@ class VfCommon(SppProc):
     def port_del(self, port, direction, comp_name):
         return "port del {port} {direction} {comp_name}".format(**locals())
 
+    @exec_command
+    def set_ring_latency(self, action, port):
+        return "ring_latency {action} {port}".format(**locals())
+
     @exec_command
     def do_exit(self):
         return "exit"
@@ -199,6 +206,9 @@ class VfProc(VfCommon):
             command += " %s" % op
             if op == "add_vlantag":
                 command += " %d %d" % (vlan_id, pcp)
+            elif op == "weight":
+                # weight is given in the place of vlan_id.
+                command += " %d" % vlan_id
         return command
 
     @exec_command
@@ -223,6 +233,18 @@ class VfProc(VfCommon):
         return ("classifier_table del vlan {vlan_id} {mac_address} {port}"
                 .format(**locals()))
 
+    @exec_command
+    def set_classifier_table_with_acl(self, port, src, dst, proto,
+                                      src_port, dst_port):
+        return ("classifier_table add acl {src} {dst} {proto} "
+                "{src_port} {dst_port} {port}".format(**locals()))
+
+    @exec_command
+    def clear_classifier_table_with_acl(self, port, src, dst, proto,
+                                        src_port, dst_port):
+        return ("classifier_table del acl {src} {dst} {proto} "
+                "{src_port} {dst_port} {port}".format(**locals()))
+
 
 class MirrorProc(VfCommon):
 
@@ -233,6 +255,27 @@ class MirrorProc(VfCommon):
     def _decode_client_id(data):
         return SppProc._decode_client_id_common(data, TYPE_MIRROR)
 
+    @exec_command
+    def start_component(self, comp_name, core_id, comp_type, snaplen=None):
+        cmd = ("component start {comp_name} {core_id} {comp_type}"
+               .format(**locals()))
+        if snaplen is not None:
+            cmd += " %d" % snaplen
+        return cmd
+
+    @exec_command
+    def set_filter(self, comp_name, expr):
+        return "filter {comp_name} {expr}".format(**locals()).rstrip()
+
+    @exec_command
+    def set_copy_mode(self, comp_name, mode):
+        return "copy_mode {comp_name} {mode}".format(**locals())
+
+    @exec_command
+    def set_limit(self, comp_name, sample, rate, unit):
+        return ("limit {comp_name} {sample} {rate} {unit}"
+                .format(**locals()))
+
     @exec_command
     def port_add(self, port, direction, comp_name):
         return "port add {port} {direction} {comp_name}".format(**locals())
@@ -387,8 +430,13 @@ class PcapProc(SppProc):
         return "status"
 
     @exec_command
-    def start(self):
-        return "start"
+    def start(self, snaplen=0, expr=""):
+        cmd = "start"
+        if snaplen:
+            cmd += " snaplen {}".format(snaplen)
+        if expr:
+            cmd += " filter {}".format(expr)
+        return cmd
 
     @exec_command
     def stop(self):
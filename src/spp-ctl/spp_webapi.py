@@ -214,6 +214,12 @@ class V1VFCommon(object):
         vf["components"] = info["core"]
         if "classifier_table" in info:
             vf["classifier_table"] = info["classifier_table"]
+        if "ring_latency" in info:
+            vf["ring_latency"] = info["ring_latency"]
+        if "chain_latency" in info:
+            vf["chain_latency"] = info["chain_latency"]
+        if "mirror_stats" in info:
+            vf["mirror_stats"] = info["mirror_stats"]
 
         return vf
 
@@ -238,6 +244,15 @@ class V1VFCommon(object):
             raise KeyInvalid('dir', body['dir'])
         self._validate_port(body['port'])
 
+    def ring_latency(self, proc, body):
+        for key in ['action', 'port']:
+            if key not in body:
+                raise KeyRequired(key)
+        if body['action'] not in ["start", "stop"]:
+            raise KeyInvalid('action', body['action'])
+        self._validate_port(body['port'], ["ring"])
+        proc.set_ring_latency(body['action'], body['port'])
+
     def vf_exit(self, proc):
         self.ctrl.do_exit(proc.type, proc.id)
         proc.do_exit()
@@ -266,13 +281,22 @@ class V1VFHandler(BaseHandler, V1VFCommon):
                    callback=self.vf_comp_port)
         self.route('/<sec_id:int>/classifier_table', 'PUT',
                    callback=self.vf_classifier)
+        self.route('/<sec_id:int>/ring_latency', 'PUT',
+                   callback=self.ring_latency)
 
     def vf_get(self, proc):
         return self.convert_info(proc.get_status())
 
     def vf_comp_start(self, proc, body):
-        self.validate_comp_start(body, ["forward", "merge", "classifier"])
-        proc.start_component(body['name'], body['core'], body['type'])
+        self.validate_comp_start(body, ["forward", "merge", "classifier",
+                                        "classifier_learn", "balancer"])
+        # classifier sharing the table of another classifier.
+        group = body.get('group')
+        if group is not None:
+            if body['type'] != "classifier" or not isinstance(group, str):
+                raise KeyInvalid('group', group)
+        proc.start_component(body['name'], body['core'], body['type'],
+                             group)
 
     def vf_comp_stop(self, proc, name):
         proc.stop_component(name)
@@ -290,6 +314,16 @@ class V1VFHandler(BaseHandler, V1VFCommon):
                         int(vlan['pcp'])
                 except Exception:
                     raise KeyInvalid('vlan', vlan)
+            # weight of TX port of balancer is given instead of vlan.
+            weight = body.get('weight')
+            if weight is not None:
+                try:
+                    if vlan or body['dir'] != "tx":
+                        raise
+                    if int(weight) < 0 or int(weight) > 255:
+                        raise
+                except Exception:
+                    raise KeyInvalid('weight', weight)
 
     def vf_comp_port(self, proc, name, body):
         self._validate_vf_comp_port(body)
@@ -306,6 +340,10 @@ class V1VFHandler(BaseHandler, V1VFCommon):
                     pcp = vlan['pcp']
                 elif vlan['operation'] == "del":
                     op = "del_vlantag"
+            weight = body.get('weight')
+            if weight is not None:
+                op = "weight"
+                vlan_id = int(weight)
             proc.port_add(body['port'], body['dir'],
                           name, op, vlan_id, pcp)
         else:
@@ -317,16 +355,51 @@ class V1VFHandler(BaseHandler, V1VFCommon):
         except Exception:
             raise KeyInvalid('mac_address', mac_address)
 
+    def _validate_acl_prefix(self, key, prefix):
+        if prefix == 'any':
+            return None
+        try:
+            return netaddr.IPNetwork(prefix).version
+        except Exception:
+            raise KeyInvalid(key, prefix)
+
+    def _validate_acl_port_range(self, key, port_range):
+        if port_range == 'any':
+            return
+        try:
+            ports = [int(p) for p in str(port_range).split('-')]
+        except Exception:
+            raise KeyInvalid(key, port_range)
+        if (len(ports) > 2 or ports[0] > ports[-1] or
+                ports[0] < 0 or ports[-1] > 65535):
+            raise KeyInvalid(key, port_range)
+
+    def _validate_vf_classifier_acl(self, body):
+        src_ver = self._validate_acl_prefix('src', body.get('src', 'any'))
+        dst_ver = self._validate_acl_prefix('dst', body.get('dst', 'any'))
+        if src_ver is not None and dst_ver is not None and \
+                src_ver != dst_ver:
+            raise KeyInvalid('dst', body['dst'])
+        for key in ['src_port', 'dst_port']:
+            self._validate_acl_port_range(key, body.get(key, 'any'))
+
     def _validate_vf_classifier(self, body):
-        for key in ['action', 'type', 'port', 'mac_address']:
+        for key in ['action', 'type', 'port']:
             if key not in body:
                 raise KeyRequired(key)
         if body['action'] not in ["add", "del"]:
             raise KeyInvalid('action', body['action'])
-        if body['type'] not in ["mac", "vlan"]:
+        if body['type'] not in ["mac", "vlan", "acl"]:
             raise KeyInvalid('type', body['type'])
         self._validate_port(body['port'])
 
+        # ACL rule is given with 5-tuple instead of MAC address.
+        if body['type'] == "acl":
+            self._validate_vf_classifier_acl(body)
+            return
+
+        if 'mac_address' not in body:
+            raise KeyRequired('mac_address')
         if not body['mac_address'] == 'default':
             self._validate_mac(body['mac_address'])
 
@@ -340,6 +413,16 @@ class V1VFHandler(BaseHandler, V1VFCommon):
         self._validate_vf_classifier(body)
 
         port = body['port']
+        if body['type'] == "acl":
+            # Omitted fields of 5-tuple match any of values.
+            acl = {key: str(body.get(key, 'any')) for key in
+                   ['src', 'dst', 'proto', 'src_port', 'dst_port']}
+            if body['action'] == "add":
+                proc.set_classifier_table_with_acl(port, **acl)
+            else:
+                proc.clear_classifier_table_with_acl(port, **acl)
+            return
+
         mac_address = body['mac_address']
 
         if body['action'] == "add":
@@ -377,13 +460,27 @@ class V1MirrorHandler(BaseHandler, V1VFCommon):
                    callback=self.mirror_comp_stop)
         self.route('/<sec_id:int>/components/<name>/ports', 'PUT',
                    callback=self.mirror_comp_port)
+        self.route('/<sec_id:int>/components/<name>/filter', 'PUT',
+                   callback=self.mirror_comp_filter)
+        self.route('/<sec_id:int>/components/<name>/limit', 'PUT',
+                   callback=self.mirror_comp_limit)
+        self.route('/<sec_id:int>/components/<name>/copy_mode', 'PUT',
+                   callback=self.mirror_comp_copy_mode)
+        self.route('/<sec_id:int>/ring_latency', 'PUT',
+                   callback=self.ring_latency)
 
     def mirror_get(self, proc):
         return self.convert_info(proc.get_status())
 
     def mirror_comp_start(self, proc, body):
         self.validate_comp_start(body, ["mirror"])
-        proc.start_component(body['name'], body['core'], body['type'])
+        # Only leading bytes of packets are copied if snaplen is given.
+        snaplen = body.get('snaplen')
+        if snaplen is not None:
+            if not isinstance(snaplen, int) or not 0 <= snaplen <= 2048:
+                raise KeyInvalid('snaplen', snaplen)
+        proc.start_component(body['name'], body['core'], body['type'],
+                             snaplen)
 
     def mirror_comp_stop(self, proc, name):
         proc.stop_component(name)
@@ -395,6 +492,38 @@ class V1MirrorHandler(BaseHandler, V1VFCommon):
         else:
             proc.port_del(body['port'], body['dir'], name)
 
+    def mirror_comp_filter(self, proc, name, body):
+        if 'filter' not in body:
+            raise KeyRequired('filter')
+        # Filter is cleared if empty or null.
+        expr = body['filter']
+        if expr is None:
+            expr = ""
+        if (not isinstance(expr, str) or len(expr) >= 256 or
+                any(c in expr for c in "\r\n")):
+            raise KeyInvalid('filter', expr)
+        proc.set_filter(name, expr.strip())
+
+    def mirror_comp_limit(self, proc, name, body):
+        # No sampling and no rate limit if omitted.
+        sample = body.get('sample', 0)
+        rate = body.get('rate', 0)
+        unit = body.get('unit', 'pkts')
+        if not isinstance(sample, int) or not 0 <= sample <= 65535:
+            raise KeyInvalid('sample', sample)
+        if not isinstance(rate, int) or not 0 <= rate <= 100000000000:
+            raise KeyInvalid('rate', rate)
+        if unit not in ['pkts', 'bytes']:
+            raise KeyInvalid('unit', unit)
+        proc.set_limit(name, sample, rate, unit)
+
+    def mirror_comp_copy_mode(self, proc, name, body):
+        if 'mode' not in body:
+            raise KeyRequired('mode')
+        if body['mode'] not in ['shallow', 'deep']:
+            raise KeyInvalid('mode', body['mode'])
+        proc.set_copy_mode(name, body['mode'])
+
 
 class V1NFVHandler(BaseHandler):
 
@@ -777,11 +906,23 @@ class V1PcapHandler(BaseHandler):
             raise KeyRequired('action')
         if body['action'] not in ["start", "stop"]:
             raise KeyInvalid('action', body['action'])
+        # Params of start, all of packets are captured if omitted.
+        snaplen = body.get('snaplen', 0)
+        if (not isinstance(snaplen, int) or isinstance(snaplen, bool) or
+                snaplen < 0 or snaplen > 65535):
+            raise KeyInvalid('snaplen', snaplen)
+        expr = body.get('filter', "")
+        if expr is None:
+            expr = ""
+        if (not isinstance(expr, str) or len(expr) >= 256 or
+                any(c in expr for c in "\r\n")):
+            raise KeyInvalid('filter', expr)
 
     def pcap_action(self, proc, body):
         self._validate_pcap_action(body)
         if body['action'] == "start":
-            proc.start()
+            proc.start(body.get('snaplen', 0),
+                       (body.get('filter') or "").strip())
         else:
             proc.stop()
 
@@ -0,0 +1,718 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <netinet/in.h>
+
+#include <rte_common.h>
+#include <rte_mbuf.h>
+#include <rte_ether.h>
+#include <rte_ip.h>
+#include <rte_log.h>
+#include <rte_cycles.h>
+#include <rte_malloc.h>
+#include <rte_hash.h>
+#include <rte_prefetch.h>
+
+#include "balancer.h"
+#include "shared/secondary/return_codes.h"
+#include "shared/secondary/spp_worker_th/port_capability.h"
+#include "shared/secondary/spp_worker_th/conf_rcu.h"
+#include "shared/secondary/spp_worker_th/tx_coalesce.h"
+
+#define RTE_LOGTYPE_VF_BLC RTE_LOGTYPE_USER1
+
+#ifdef RTE_MACHINE_CPUFLAG_SSE4_2
+#include <rte_hash_crc.h>
+#define DEFAULT_HASH_FUNC rte_hash_crc
+#else
+#include <rte_jhash.h>
+#define DEFAULT_HASH_FUNC rte_jhash
+#endif
+
+/**
+ * Num of entries of lookup table. It must be a prime, and much larger than
+ * num of TX ports to distribute flows evenly.
+ */
+#define BLC_LUT_SIZE 65537
+
+/* Entry of lookup table not assigned to any of TX ports. */
+#define BLC_NO_PORT UINT8_MAX
+
+/* Weight of TX port if it is not given with `port` command. */
+#define BLC_DEFAULT_WEIGHT 1
+
+/* Seeds of hash of port for offset and skip of its permutation. */
+#define BLC_OFFSET_SEED 0x2f1b7c35
+#define BLC_SKIP_SEED 0x7a4e9d13
+
+/* Seed of hash of flow. */
+#define BLC_FLOW_SEED 0
+
+/* Num of packets of which header is prefetched ahead of parsing. */
+#define BLC_PREFETCH_OFFSET 4
+
+/* Length of source and destination ports following IP header. */
+#define BLC_L4_PORTS_LEN 4
+
+/* Max num of entries of flow table checked for aging at once. */
+#define BLC_FLOW_AGE_SCAN 256
+
+/* Interval of checking flow table for aging in msec. */
+#define BLC_FLOW_AGE_INTERVAL_MS 100
+
+/* UID of TX resource of flow not pinned to any of TX ports. */
+#define BLC_NO_TX_UID UINT64_MAX
+
+/**
+ * Key of flow. Addresses and ports are ordered to get the same key for both
+ * directions of the flow.
+ */
+struct blc_flow_key {
+	/* IPv4 address is in the first word, or MAC address for non-IP. */
+	uint32_t addr[2][4];
+	uint16_t port[2];  /* L4 ports, or 0 if not referred. */
+	uint8_t proto;  /* IP protocol number */
+	uint8_t ip_ver;  /* 4 or 6, or 0 for non-IP. */
+	uint16_t pad;
+};
+
+/**
+ * Pinned flow, indexed with position of key of flow table. TX port is
+ * identified with UID of its resource because several queues of the same
+ * ethdev port can be TX ports. Index of TX port is cached for the version
+ * of config to avoid searching it for each of packets.
+ */
+struct blc_flow_ent {
+	uint64_t last_tsc;  /* TSC at last time of receiving. */
+	uint64_t tx_uid;  /* UID of TX resource, or BLC_NO_TX_UID. */
+	unsigned int conf_ver;  /* Version of config of cached `tx_idx`. */
+	int tx_idx;  /* Index of TX port of `tx_uid`, or -1. */
+};
+
+/* Config of balancer published to worker thread. */
+struct blc_conf {
+	char name[STR_LEN_NAME];  /* Component name */
+	unsigned int conf_ver;  /* Version of config for changing TX buffers. */
+	int nof_rx;  /* Num of RX ports */
+	int nof_tx;  /* Num of TX ports */
+	struct sppwk_port_info rx_ports[BLC_MAX_PORTS];
+	struct sppwk_port_info tx_ports[BLC_MAX_PORTS];
+	int weights[BLC_MAX_PORTS];  /* Weights of TX ports. */
+	uint64_t tx_uids[BLC_MAX_PORTS];  /* UIDs of TX resources. */
+	/* Index of TX port from hash of flow, or BLC_NO_PORT. */
+	uint8_t lut[BLC_LUT_SIZE];
+};
+
+/* Permutation of positions of lookup table preferred by TX port. */
+struct blc_perm {
+	uint32_t offset;  /* The first position. */
+	uint32_t skip;  /* Distance to next position. */
+	uint32_t next;  /* Num of positions tried. */
+	int credit;  /* Accumulated weight for taking next position. */
+};
+
+/* Management information of balancer component. */
+struct blc_info {
+	/* Config published to worker thread, or NULL. */
+	struct blc_conf *conf;
+	unsigned int conf_ver;  /* Version of config at last update. */
+	/* Flow table created before config is published, or NULL. */
+	struct rte_hash *flow_hash;
+	struct blc_flow_ent *flow_ents;
+
+	/* Followings are referred only from worker thread. */
+	unsigned int cur_ver __rte_cache_aligned;
+	int nof_tx;  /* Num of TX buffers assigned to ports. */
+	uint64_t last_age_tsc;  /* TSC at last time of aging. */
+	uint32_t age_iter;  /* Position of iterating keys for aging. */
+	uint64_t nof_flow_full;  /* Num of flows failed to be pinned. */
+	struct sppwk_tx_buf tx_bufs[BLC_MAX_PORTS];
+};
+
+static struct blc_info g_blc_info[RTE_MAX_LCORE];
+
+/* Max num of pinned flows, or 0 for no flow table. */
+static uint32_t g_flow_tbl_size;
+
+/* Aging time of pinned flows and interval of checking in TSC cycles. */
+static uint64_t g_flow_age_tsc;
+static uint64_t g_flow_age_intvl_tsc;
+
+/* Release config replaced with new one. */
+static void
+free_blc_conf(void *conf, void *arg __attribute__ ((unused)))
+{
+	rte_free(conf);
+}
+
+/* Initialize management info of balancer. */
+int
+init_balancer_mng_info(uint32_t flow_tbl_size, uint32_t flow_age_sec)
+{
+	uint64_t hz = rte_get_tsc_hz();
+
+	/* Index of TX port is kept in an entry of lookup table. */
+	RTE_BUILD_BUG_ON(BLC_MAX_PORTS >= BLC_NO_PORT);
+
+	memset(g_blc_info, 0, sizeof(g_blc_info));
+	g_flow_tbl_size = flow_tbl_size;
+	/* Pinned flows are kept until the table is full if it is 0. */
+	if (flow_age_sec == 0)
+		g_flow_age_tsc = UINT64_MAX;
+	else
+		g_flow_age_tsc = hz * flow_age_sec;
+	g_flow_age_intvl_tsc = hz * BLC_FLOW_AGE_INTERVAL_MS / 1000;
+
+	RTE_LOG(INFO, VF_BLC, "Init balancer (flow_table_size=%u, "
+			"flow_age_sec=%u).\n", flow_tbl_size, flow_age_sec);
+	return SPPWK_RET_OK;
+}
+
+/* Create flow table of balancer. It is used only from its worker thread. */
+static int
+create_blc_flow_tbl(struct blc_info *info, int comp_id)
+{
+	char name[RTE_HASH_NAMESIZE];
+
+	/* Name of table requires uniqueness between processes. */
+	snprintf(name, sizeof(name), "blcflw_%07x_%d", getpid(), comp_id);
+
+	struct rte_hash_parameters hash_params = {
+			.name      = name,
+			.entries   = g_flow_tbl_size,
+			.key_len   = sizeof(struct blc_flow_key),
+			.hash_func = DEFAULT_HASH_FUNC,
+			.hash_func_init_val = BLC_FLOW_SEED,
+			.socket_id = rte_socket_id(),
+	};
+
+	info->flow_hash = rte_hash_create(&hash_params);
+	if (unlikely(info->flow_hash == NULL)) {
+		RTE_LOG(ERR, VF_BLC, "Cannot create flow table. name=%s\n",
+				name);
+		return SPPWK_RET_NG;
+	}
+
+	/* Position of key is less than num of entries plus a dummy one. */
+	info->flow_ents = rte_zmalloc(NULL,
+			sizeof(struct blc_flow_ent) * (g_flow_tbl_size + 1),
+			RTE_CACHE_LINE_SIZE);
+	if (unlikely(info->flow_ents == NULL)) {
+		RTE_LOG(ERR, VF_BLC, "Cannot allocate pinned flows.\n");
+		rte_hash_free(info->flow_hash);
+		info->flow_hash = NULL;
+		return SPPWK_RET_NG;
+	}
+
+	RTE_LOG(INFO, VF_BLC, "Create flow table. name=%s, entries=%u\n",
+			name, g_flow_tbl_size);
+	return SPPWK_RET_OK;
+}
+
+/* Get weight of TX port given with `port` command. */
+static int
+get_blc_weight(const struct sppwk_port_info *port)
+{
+	int cnt;
+
+	for (cnt = 0; cnt < PORT_CAPABL_MAX; cnt++) {
+		if (port->port_attrs[cnt].ops == SPPWK_PORT_OPS_WEIGHT &&
+				port->port_attrs[cnt].dir == SPPWK_PORT_DIR_TX)
+			return port->port_attrs[cnt].weight;
+	}
+	return BLC_DEFAULT_WEIGHT;
+}
+
+/* Get UID of TX resource from type, number and queue of interface. */
+static inline uint64_t
+get_blc_tx_uid(const struct sppwk_port_info *port)
+{
+	return ((uint64_t)port->iface_type << 48) |
+			((uint64_t)(uint16_t)port->iface_no << 32) |
+			(uint32_t)port->queue_no;
+}
+
+/**
+ * Initialize permutation of TX port. It is given from hash of resource UID,
+ * so that the port prefers the same positions wherever it is placed.
+ */
+static void
+init_blc_perm(struct blc_perm *perm, const struct sppwk_port_info *port)
+{
+	struct sppwk_port_idx idx;
+
+	memset(&idx, 0, sizeof(idx));
+	idx.iface_type = port->iface_type;
+	idx.iface_no = port->iface_no;
+	idx.queue_no = port->queue_no;
+
+	perm->offset = DEFAULT_HASH_FUNC(&idx, sizeof(idx),
+			BLC_OFFSET_SEED) % BLC_LUT_SIZE;
+	perm->skip = DEFAULT_HASH_FUNC(&idx, sizeof(idx),
+			BLC_SKIP_SEED) % (BLC_LUT_SIZE - 1) + 1;
+	perm->next = 0;
+	perm->credit = 0;
+}
+
+/**
+ * Build lookup table of Maglev consistent hashing. Each of TX ports takes
+ * the next position of its permutation not taken yet in turn, and a port
+ * skips its turn until accumulated weight reaches the largest one.
+ */
+static void
+build_blc_lut(struct blc_conf *conf)
+{
+	int i;
+	int max_weight = 0;
+	uint32_t pos;
+	uint32_t nof_filled = 0;
+	struct blc_perm *perm;
+	struct blc_perm perms[BLC_MAX_PORTS];
+
+	memset(conf->lut, BLC_NO_PORT, sizeof(conf->lut));
+	for (i = 0; i < conf->nof_tx; i++) {
+		init_blc_perm(&perms[i], &conf->tx_ports[i]);
+		if (conf->weights[i] > max_weight)
+			max_weight = conf->weights[i];
+	}
+
+	/* No port to send packets if all of weights are 0. */
+	if (max_weight == 0)
+		return;
+
+	while (nof_filled < BLC_LUT_SIZE) {
+		for (i = 0; i < conf->nof_tx && nof_filled < BLC_LUT_SIZE;
+				i++) {
+			perm = &perms[i];
+			perm->credit += conf->weights[i];
+			if (perm->credit < max_weight)
+				continue;
+			perm->credit -= max_weight;
+
+			do {
+				pos = (uint32_t)(((uint64_t)perm->skip *
+						perm->next + perm->offset) %
+						BLC_LUT_SIZE);
+				perm->next++;
+			} while (conf->lut[pos] != BLC_NO_PORT);
+
+			conf->lut[pos] = (uint8_t)i;
+			nof_filled++;
+		}
+	}
+}
+
+/* Update balancer info, and rebuild its lookup table. */
+int
+update_balancer(struct sppwk_comp_info *wk_comp_info)
+{
+	int cnt;
+	int comp_id = wk_comp_info->comp_id;
+	struct blc_info *info = &g_blc_info[comp_id];
+	struct blc_conf *conf = NULL;
+	struct blc_conf *old_conf = NULL;
+
+	if (unlikely(wk_comp_info->nof_rx > BLC_MAX_PORTS ||
+			wk_comp_info->nof_tx > BLC_MAX_PORTS)) {
+		RTE_LOG(ERR, VF_BLC,
+				"Invalid num of ports (id=%d, nof_rx=%d, "
+				"nof_tx=%d).\n", comp_id, wk_comp_info->nof_rx,
+				wk_comp_info->nof_tx);
+		return SPPWK_RET_NG;
+	}
+
+	if (g_flow_tbl_size != 0 && info->flow_hash == NULL) {
+		if (unlikely(create_blc_flow_tbl(info, comp_id) !=
+				SPPWK_RET_OK))
+			return SPPWK_RET_NG;
+	}
+
+	conf = rte_zmalloc(NULL, sizeof(struct blc_conf), 0);
+	if (unlikely(conf == NULL)) {
+		RTE_LOG(ERR, VF_BLC,
+				"Cannot allocate config of balancer "
+				"(id=%d).\n", comp_id);
+		return SPPWK_RET_NG;
+	}
+
+	memcpy(conf->name, wk_comp_info->name, STR_LEN_NAME);
+	conf->nof_rx = wk_comp_info->nof_rx;
+	conf->nof_tx = wk_comp_info->nof_tx;
+	for (cnt = 0; cnt < conf->nof_rx; cnt++)
+		memcpy(&conf->rx_ports[cnt], wk_comp_info->rx_ports[cnt],
+				sizeof(struct sppwk_port_info));
+
+	for (cnt = 0; cnt < conf->nof_tx; cnt++) {
+		memcpy(&conf->tx_ports[cnt], wk_comp_info->tx_ports[cnt],
+				sizeof(struct sppwk_port_info));
+		conf->weights[cnt] = get_blc_weight(&conf->tx_ports[cnt]);
+		conf->tx_uids[cnt] = get_blc_tx_uid(&conf->tx_ports[cnt]);
+	}
+
+	build_blc_lut(conf);
+	conf->conf_ver = ++info->conf_ver;
+
+	/* Old config is released after worker thread stops to refer it. */
+	old_conf = SPPWK_CONF_SET(info->conf, conf);
+	if (old_conf != NULL)
+		sppwk_conf_rcu_defer_free(old_conf, free_blc_conf, NULL);
+
+	RTE_LOG(INFO, VF_BLC,
+			"Done update balancer (id=%d, name=%s, nof_rx=%d, "
+			"nof_tx=%d).\n", comp_id, conf->name, conf->nof_rx,
+			conf->nof_tx);
+	return SPPWK_RET_OK;
+}
+
+/* Transmit all packets in TX buffers. */
+static inline void
+flush_blc_bufs(struct blc_info *info)
+{
+	int i;
+
+	for (i = 0; i < info->nof_tx; i++)
+		sppwk_tx_buf_flush(&info->tx_bufs[i]);
+}
+
+/* Transmit all packets in TX buffers, and change them to new TX ports. */
+static inline void
+change_blc_ports(struct blc_info *info, const struct blc_conf *conf)
+{
+	int i;
+	const struct sppwk_port_info *tx;
+
+	flush_blc_bufs(info);
+
+	info->nof_tx = conf->nof_tx;
+	for (i = 0; i < conf->nof_tx; i++) {
+		tx = &conf->tx_ports[i];
+		sppwk_tx_buf_init(&info->tx_bufs[i], tx->ethdev_port_id,
+				tx->queue_no, tx->iface_type, tx->iface_no, 1);
+	}
+	info->cur_ver = conf->conf_ver;
+}
+
+/* Return 1 if L4 ports follow IP header of the protocol. */
+static inline int
+is_blc_l4_proto(uint8_t proto)
+{
+	return proto == IPPROTO_TCP || proto == IPPROTO_UDP ||
+		proto == IPPROTO_SCTP;
+}
+
+/**
+ * Get key of flow from packet. L4 ports are not referred for fragments of
+ * IPv4 to send all of them to the same port, and non-IP packets are
+ * distributed with MAC addresses.
+ */
+static inline void
+get_blc_flow_key(const struct rte_mbuf *pkt, struct blc_flow_key *key)
+{
+	int cmp;
+	uint16_t ether_type;
+	uint16_t tmp_port;
+	uint32_t tmp_addr[4];
+	uint32_t l3_ofs = sizeof(struct rte_ether_hdr);
+	uint32_t l4_ofs = 0;
+	const struct rte_ether_hdr *eth;
+	const struct rte_vlan_hdr *vh;
+	const struct rte_ipv4_hdr *ipv4;
+	const struct rte_ipv6_hdr *ipv6;
+	const uint16_t *l4_ports;
+
+	memset(key, 0, sizeof(*key));
+	eth = rte_pktmbuf_mtod(pkt, const struct rte_ether_hdr *);
+	ether_type = eth->ether_type;
+	if (ether_type == rte_cpu_to_be_16(RTE_ETHER_TYPE_VLAN)) {
+		vh = (const struct rte_vlan_hdr *)(eth + 1);
+		ether_type = vh->eth_proto;
+		l3_ofs += sizeof(struct rte_vlan_hdr);
+	}
+
+	if (ether_type == rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4) &&
+			likely(rte_pktmbuf_data_len(pkt) >=
+				l3_ofs + sizeof(*ipv4))) {
+		ipv4 = rte_pktmbuf_mtod_offset(pkt,
+				const struct rte_ipv4_hdr *, l3_ofs);
+		key->ip_ver = 4;
+		key->proto = ipv4->next_proto_id;
+		key->addr[0][0] = ipv4->src_addr;
+		key->addr[1][0] = ipv4->dst_addr;
+		if (likely(!(ipv4->fragment_offset & rte_cpu_to_be_16(
+				RTE_IPV4_HDR_OFFSET_MASK |
+				RTE_IPV4_HDR_MF_FLAG))))
+			l4_ofs = l3_ofs + (ipv4->version_ihl &
+					RTE_IPV4_HDR_IHL_MASK) *
+					RTE_IPV4_IHL_MULTIPLIER;
+	} else if (ether_type == rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6) &&
+			likely(rte_pktmbuf_data_len(pkt) >=
+				l3_ofs + sizeof(*ipv6))) {
+		ipv6 = rte_pktmbuf_mtod_offset(pkt,
+				const struct rte_ipv6_hdr *, l3_ofs);
+		key->ip_ver = 6;
+		key->proto = ipv6->proto;
+		memcpy(key->addr[0], ipv6->src_addr, sizeof(key->addr[0]));
+		memcpy(key->addr[1], ipv6->dst_addr, sizeof(key->addr[1]));
+		l4_ofs = l3_ofs + sizeof(*ipv6);
+	} else {
+		memcpy(key->addr[0], &eth->s_addr, RTE_ETHER_ADDR_LEN);
+		memcpy(key->addr[1], &eth->d_addr, RTE_ETHER_ADDR_LEN);
+	}
+
+	if (l4_ofs != 0 && is_blc_l4_proto(key->proto) &&
+			likely(rte_pktmbuf_data_len(pkt) >=
+				l4_ofs + BLC_L4_PORTS_LEN)) {
+		l4_ports = rte_pktmbuf_mtod_offset(pkt, const uint16_t *,
+				l4_ofs);
+		key->port[0] = l4_ports[0];
+		key->port[1] = l4_ports[1];
+	}
+
+	/* Place smaller one of endpoints first to be symmetric. */
+	cmp = memcmp(key->addr[0], key->addr[1], sizeof(key->addr[0]));
+	if (cmp > 0 || (cmp == 0 && key->port[0] > key->port[1])) {
+		memcpy(tmp_addr, key->addr[0], sizeof(tmp_addr));
+		memcpy(key->addr[0], key->addr[1], sizeof(tmp_addr));
+		memcpy(key->addr[1], tmp_addr, sizeof(tmp_addr));
+		tmp_port = key->port[0];
+		key->port[0] = key->port[1];
+		key->port[1] = tmp_port;
+	}
+}
+
+/* Get index of TX port of pinned flow, or -1 if the port is deleted. */
+static inline int
+get_blc_flow_tx_idx(const struct blc_conf *conf, struct blc_flow_ent *ent)
+{
+	int i;
+
+	if (likely(ent->conf_ver == conf->conf_ver))
+		return ent->tx_idx;
+
+	ent->conf_ver = conf->conf_ver;
+	ent->tx_idx = -1;
+	for (i = 0; i < conf->nof_tx; i++) {
+		if (conf->tx_uids[i] == ent->tx_uid) {
+			ent->tx_idx = i;
+			break;
+		}
+	}
+	return ent->tx_idx;
+}
+
+/**
+ * Get index of TX port of flow pinned in flow table. New flow, or flow of
+ * which port is deleted or aged, is pinned to the port of lookup table.
+ */
+static inline int
+get_pinned_tx_idx(struct blc_info *info, const struct blc_conf *conf,
+		const struct blc_flow_key *key, uint32_t sig, uint64_t cur_tsc)
+{
+	int tx_idx;
+	int32_t pos;
+	struct blc_flow_ent *ent;
+
+	pos = rte_hash_lookup_with_hash(info->flow_hash, key, sig);
+	if (likely(pos >= 0)) {
+		ent = &info->flow_ents[pos];
+		if (likely(ent->tx_uid != BLC_NO_TX_UID &&
+				cur_tsc - ent->last_tsc < g_flow_age_tsc)) {
+			tx_idx = get_blc_flow_tx_idx(conf, ent);
+			if (likely(tx_idx >= 0)) {
+				ent->last_tsc = cur_tsc;
+				return tx_idx;
+			}
+		}
+	} else {
+		pos = rte_hash_add_key_with_hash(info->flow_hash, key, sig);
+		if (unlikely(pos < 0)) {
+			info->nof_flow_full++;
+			return conf->lut[sig % BLC_LUT_SIZE];
+		}
+		ent = &info->flow_ents[pos];
+	}
+
+	tx_idx = conf->lut[sig % BLC_LUT_SIZE];
+	if (likely(tx_idx != BLC_NO_PORT)) {
+		ent->tx_uid = conf->tx_uids[tx_idx];
+		ent->tx_idx = tx_idx;
+	} else {
+		ent->tx_uid = BLC_NO_TX_UID;
+		ent->tx_idx = -1;
+	}
+	ent->conf_ver = conf->conf_ver;
+	ent->last_tsc = cur_tsc;
+	return tx_idx;
+}
+
+/* Distribute a burst of packets to TX buffers. */
+static inline void
+_balance_packets(struct blc_info *info, const struct blc_conf *conf,
+		struct rte_mbuf **pkts, uint16_t nb_pkts, uint64_t cur_tsc)
+{
+	int i;
+	int tx_idx;
+	uint32_t sig;
+	struct blc_flow_key key;
+
+	for (i = 0; i < BLC_PREFETCH_OFFSET && i < nb_pkts; i++)
+		rte_prefetch0(rte_pktmbuf_mtod(pkts[i], void *));
+
+	for (i = 0; i < nb_pkts; i++) {
+		if (i + BLC_PREFETCH_OFFSET < nb_pkts)
+			rte_prefetch0(rte_pktmbuf_mtod(
+					pkts[i + BLC_PREFETCH_OFFSET],
+					void *));
+
+		get_blc_flow_key(pkts[i], &key);
+		sig = DEFAULT_HASH_FUNC(&key, sizeof(key), BLC_FLOW_SEED);
+		if (info->flow_hash != NULL)
+			tx_idx = get_pinned_tx_idx(info, conf, &key, sig,
+					cur_tsc);
+		else
+			tx_idx = conf->lut[sig % BLC_LUT_SIZE];
+
+		if (unlikely(tx_idx == BLC_NO_PORT)) {
+			rte_pktmbuf_free(pkts[i]);
+			continue;
+		}
+		sppwk_tx_buf_push(&info->tx_bufs[tx_idx], pkts[i], cur_tsc);
+	}
+}
+
+/**
+ * Delete flows not received for aging time. A part of flow table is
+ * checked at once, and rest of it is checked in next call.
+ */
+static void
+age_blc_flows(struct blc_info *info, uint64_t cur_tsc)
+{
+	int i;
+	int nof_aged = 0;
+	int32_t pos;
+	const void *key;
+	void *data;
+	struct blc_flow_key aged_keys[BLC_FLOW_AGE_SCAN];
+
+	for (i = 0; i < BLC_FLOW_AGE_SCAN; i++) {
+		pos = rte_hash_iterate(info->flow_hash, &key, &data,
+				&info->age_iter);
+		if (pos < 0) {
+			/* Start from the first entry in next call. */
+			info->age_iter = 0;
+			break;
+		}
+
+		if (cur_tsc - info->flow_ents[pos].last_tsc >= g_flow_age_tsc)
+			memcpy(&aged_keys[nof_aged++], key,
+					sizeof(struct blc_flow_key));
+	}
+
+	for (i = 0; i < nof_aged; i++)
+		rte_hash_del_key(info->flow_hash, &aged_keys[i]);
+}
+
+/* Distribute incoming packets to TX ports. */
+int
+balance_packets(int comp_id)
+{
+	int i;
+	uint16_t nb_rx;
+	uint64_t cur_tsc;
+	struct blc_info *info = &g_blc_info[comp_id];
+	struct blc_conf *conf;
+	const struct sppwk_port_info *rx;
+	struct rte_mbuf *pkts[MAX_PKT_BURST];
+
+	conf = SPPWK_CONF_GET(info->conf);
+	if (unlikely(conf == NULL)) {
+		/* Not to keep packets of ports of stopped balancer. */
+		flush_blc_bufs(info);
+		return SPPWK_RET_OK;
+	}
+
+	/* Change TX buffers if config of new ports is published. */
+	if (unlikely(info->cur_ver != conf->conf_ver))
+		change_blc_ports(info, conf);
+
+	cur_tsc = rte_rdtsc();
+
+	for (i = 0; i < conf->nof_rx; i++) {
+		rx = &conf->rx_ports[i];
+		nb_rx = sppwk_eth_vlan_rx_burst(rx->ethdev_port_id,
+				rx->queue_no, pkts, MAX_PKT_BURST);
+		if (nb_rx != 0)
+			_balance_packets(info, conf, pkts, nb_rx, cur_tsc);
+	}
+
+	/* Send packets waiting longer than flush latency budget. */
+	for (i = 0; i < info->nof_tx; i++)
+		sppwk_tx_buf_drain(&info->tx_bufs[i], cur_tsc);
+
+	if (info->flow_hash != NULL && g_flow_age_tsc != UINT64_MAX &&
+			cur_tsc - info->last_age_tsc >= g_flow_age_intvl_tsc) {
+		age_blc_flows(info, cur_tsc);
+		info->last_age_tsc = cur_tsc;
+	}
+
+	return SPPWK_RET_OK;
+}
+
+/* Transmit all packets in TX buffers of balancer. */
+void
+flush_balancer(int comp_id)
+{
+	flush_blc_bufs(&g_blc_info[comp_id]);
+}
+
+/* Get balancer status. */
+int
+get_balancer_status(unsigned int lcore_id, int id,
+		struct sppwk_lcore_params *params)
+{
+	int ret;
+	int cnt;
+	struct blc_info *info = &g_blc_info[id];
+	struct blc_conf *conf = info->conf;
+	struct sppwk_port_idx rx_ports[RTE_MAX_QUEUES_PER_PORT];
+	struct sppwk_port_idx tx_ports[RTE_MAX_QUEUES_PER_PORT];
+	struct sppwk_tx_coal_stats tx_stats;
+
+	if (unlikely(conf == NULL)) {
+		RTE_LOG(ERR, VF_BLC,
+				"Balancer is not used (id=%d, lcore=%d).\n",
+				id, lcore_id);
+		return SPPWK_RET_NG;
+	}
+
+	memset(rx_ports, 0x00, sizeof(rx_ports));
+	for (cnt = 0; cnt < conf->nof_rx; cnt++) {
+		rx_ports[cnt].iface_type = conf->rx_ports[cnt].iface_type;
+		rx_ports[cnt].iface_no = conf->rx_ports[cnt].iface_no;
+		rx_ports[cnt].queue_no = conf->rx_ports[cnt].queue_no;
+	}
+
+	memset(tx_ports, 0x00, sizeof(tx_ports));
+	for (cnt = 0; cnt < conf->nof_tx; cnt++) {
+		tx_ports[cnt].iface_type = conf->tx_ports[cnt].iface_type;
+		tx_ports[cnt].iface_no = conf->tx_ports[cnt].iface_no;
+		tx_ports[cnt].queue_no = conf->tx_ports[cnt].queue_no;
+	}
+
+	memset(&tx_stats, 0x00, sizeof(tx_stats));
+	for (cnt = 0; cnt < BLC_MAX_PORTS; cnt++)
+		sppwk_tx_buf_add_stats(&tx_stats, &info->tx_bufs[cnt]);
+
+	/* Set the information with the function specified by the command. */
+	ret = (*params->lcore_proc)(params, lcore_id, conf->name,
+			SPPWK_TYPE_BLC_STR, conf->nof_rx, rx_ports,
+			conf->nof_tx, tx_ports, &tx_stats);
+	if (unlikely(ret != SPPWK_RET_OK))
+		return SPPWK_RET_NG;
+
+	return SPPWK_RET_OK;
+}
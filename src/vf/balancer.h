@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#ifndef __BALANCER_H__
+#define __BALANCER_H__
+
+#include "shared/secondary/spp_worker_th/cmd_utils.h"
+
+/**
+ * @file
+ * SPP Balancer
+ *
+ * Balancer component distributes packets from RX ports to TX ports with
+ * symmetric hash of 5-tuple, so that both directions of a flow are sent to
+ * the same TX port. Hash is mapped to TX port with a lookup table of Maglev
+ * consistent hashing built from weights of TX ports, and only about 1/N of
+ * flows are moved if one of N ports is added or deleted.
+ *
+ * Flows can be pinned to TX port with a flow table of each of components
+ * to keep existing connections while the lookup table is changed.
+ */
+
+/* Max num of RX or TX ports of balancer component. */
+#define BLC_MAX_PORTS 32
+
+/* Default max num of flows pinned in each of balancers, 0 is for disabled. */
+#define DEFAULT_BLC_FLOW_TABLE_SIZE 0
+
+/* Default aging time of pinned flows in sec. */
+#define DEFAULT_BLC_FLOW_AGE_SEC 60
+
+/**
+ * Initialize management info of balancer.
+ *
+ * @param flow_tbl_size Max num of pinned flows, or 0 for no flow table.
+ * @param flow_age_sec Aging time of pinned flows in sec.
+ * @retval SPPWK_RET_OK succeeded.
+ * @retval SPPWK_RET_NG failed.
+ */
+int init_balancer_mng_info(uint32_t flow_tbl_size, uint32_t flow_age_sec);
+
+/**
+ * Update balancer info, and rebuild its lookup table.
+ *
+ * @param wk_comp_info Pointer to internal data of balancer.
+ * @retval SPPWK_RET_OK If succeeded.
+ * @retval SPPWK_RET_NG If failed.
+ */
+int update_balancer(struct sppwk_comp_info *wk_comp_info);
+
+/**
+ * Distribute incoming packets to TX ports.
+ *
+ * @param comp_id Component ID.
+ * @retval SPPWK_RET_OK succeeded.
+ * @retval SPPWK_RET_NG failed.
+ */
+int balance_packets(int comp_id);
+
+/**
+ * Transmit all packets in TX buffers of balancer. It is called from
+ * worker thread when the balancer is stopped or the thread exits.
+ *
+ * @param comp_id Component ID.
+ */
+void flush_balancer(int comp_id);
+
+/**
+ * Get balancer status.
+ *
+ * @param[in] lcore_id Lcore ID for balancer.
+ * @param[in] id Unique component ID.
+ * @param[in,out] params Pointer to detailed data of the status.
+ * @retval SPPWK_RET_OK If succeeded.
+ * @retval SPPWK_RET_NG If failed.
+ */
+int get_balancer_status(unsigned int lcore_id, int id,
+		struct sppwk_lcore_params *params);
+
+#endif /* __BALANCER_H__ */
@@ -19,19 +19,20 @@
 #include <rte_per_lcore.h>
 #include <rte_eal.h>
 #include <rte_launch.h>
+#include <rte_prefetch.h>
 #include <netinet/in.h>
 
 #include "classifier.h"
+#include "classifier_acl.h"
+#include "classifier_flow.h"
 #include "shared/secondary/return_codes.h"
 #include "shared/secondary/string_buffer.h"
 #include "shared/secondary/json_helper.h"
 #include "shared/secondary/spp_worker_th/cmd_res_formatter.h"
 #include "shared/secondary/spp_worker_th/vf_deps.h"
 #include "shared/secondary/spp_worker_th/port_capability.h"
-
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
-#include "shared/secondary/spp_worker_th/latency_stats.h"
-#endif
+#include "shared/secondary/spp_worker_th/conf_rcu.h"
+#include "shared/secondary/spp_worker_th/tx_coalesce.h"
 
 #define RTE_LOGTYPE_VF_CLS RTE_LOGTYPE_USER1
 
@@ -43,51 +44,90 @@
 #define DEFAULT_HASH_FUNC rte_jhash
 #endif
 
-/* Number of classifier table entry */
-#define NOF_CLS_TABLE_ENTRIES 128
-
-/* Interval transmit burst packet if buffer is not filled. */
-#define DRAIN_TX_PACKET_INTERVAL 100  /* nano sec */
-
-/* VID of VLAN untagged */
-#define VLAN_UNTAGGED_VID 0x0fff
+#ifdef RTE_MACHINE_CPUFLAG_SSE4_1
+#include <rte_vect.h>
+#endif
 
-/** Value for default MAC address of classifier */
-#define CLS_DUMMY_ADDR 0x010000000000
+/* Num of packets of which header is prefetched ahead of parsing. */
+#define CLS_PREFETCH_OFFSET 4
 
 /* classifier management information */
 struct cls_mng_info {
-	struct cls_comp_info comp_list[TWO_SIDES];
-	volatile int ref_index;  /* Flag for ref side */
-	volatile int upd_index;  /* Flag for update side */
-	volatile int is_used;
+	/* Classifier info published to classifier thread, or NULL. */
+	struct cls_comp_info *cmp_info;
+	unsigned int conf_ver;  /* Version of classifier info at last update. */
+	struct rte_hash *spare_tbl;  /* Reset table reused in next update. */
+	/* First classifier of the group whose table is shared, or NULL. */
+	struct cls_mng_info *grp_mng;
+	struct cls_flows *flows;  /* Rules of flow offload, or NULL. */
+
+	/**
+	 * Followings are referred only from classifier thread. TX buffers
+	 * are assigned to ports of classifier info of `cur_ver` to keep
+	 * packets across updating.
+	 */
+	unsigned int cur_ver __rte_cache_aligned;
+	int nof_tx_ports;  /* Number of TX buffers assigned to ports. */
+	struct sppwk_tx_buf tx_bufs[RTE_MAX_QUEUES_PER_PORT];
 };
 
 /* classifier information per lcore */
 struct cls_mng_info cls_mng_info_list[RTE_MAX_LCORE];
 
-/* uninitialize classifier information. */
+/* Max num of entries of classifier table of each of classifiers. */
+static uint32_t g_nof_cls_tbl_entries = DEFAULT_NOF_CLS_TABLE_ENTRIES;
+
+/* check if management information is used. */
+static inline int
+is_used_mng_info(const struct cls_mng_info *mng_info)
+{
+	return (mng_info != NULL && mng_info->cmp_info != NULL);
+}
+
+/**
+ * Release classifier info replaced with new one. If `arg` of management
+ * info is given, the table is reset and kept for reusing in next update.
+ */
 static void
-clean_component_info(struct cls_comp_info *comp_info)
+free_cls_comp_info(void *conf, void *arg)
 {
 	int i;
+	struct cls_comp_info *cmp_info = conf;
+	struct cls_mng_info *mng_info = arg;
+
 	for (i = 0; i < NOF_VLAN; ++i)
-		free_mac_classifier(comp_info->mac_clfs[i]);
-	memset(comp_info, 0, sizeof(struct cls_comp_info));
+		free_mac_classifier(cmp_info->mac_clfs[i]);
+	free_cls_acl(cmp_info->acl);
+
+	if (cmp_info->cls_tbl != NULL) {
+		if (mng_info != NULL && mng_info->spare_tbl == NULL) {
+			rte_hash_reset(cmp_info->cls_tbl);
+			mng_info->spare_tbl = cmp_info->cls_tbl;
+		} else
+			rte_hash_free(cmp_info->cls_tbl);
+	}
+	rte_free(cmp_info);
 }
 
-/* uninitialize classifier. */
+/* Release classifier of a VLAN replaced with new one. */
 static void
-clean_classifier(struct cls_mng_info *mng_info)
+free_cls_of_vid(void *conf, void *arg __attribute__ ((unused)))
 {
-	int i;
-
-	mng_info->is_used = 0;
+	free_mac_classifier(conf);
+}
 
-	for (i = 0; i < TWO_SIDES; ++i)
-		clean_component_info(mng_info->comp_list + (long)i);
+/* Release ACL replaced with new one. */
+static void
+free_cls_acl_of_comp(void *conf, void *arg __attribute__ ((unused)))
+{
+	free_cls_acl(conf);
+}
 
-	memset(mng_info, 0, sizeof(struct cls_mng_info));
+/* Release key deleted from classifier table. Position is given as `arg`. */
+static void
+free_cls_tbl_key(void *conf, void *arg)
+{
+	rte_hash_free_key_with_position(conf, (int32_t)(long)arg);
 }
 
 /* Initialize classifier information. */
@@ -95,9 +135,48 @@ void
 init_classifier_info(int comp_id)
 {
 	struct cls_mng_info *mng_info = NULL;
+	struct cls_comp_info *cmp_info = NULL;
 
 	mng_info = cls_mng_info_list + comp_id;
-	clean_classifier(mng_info);
+	__atomic_store_n(&mng_info->grp_mng, NULL, __ATOMIC_RELEASE);
+	cmp_info = SPPWK_CONF_SET(mng_info->cmp_info, NULL);
+	if (cmp_info != NULL)
+		sppwk_conf_rcu_defer_free(cmp_info, free_cls_comp_info, NULL);
+
+	if (mng_info->spare_tbl != NULL) {
+		rte_hash_free(mng_info->spare_tbl);
+		mng_info->spare_tbl = NULL;
+	}
+
+	free_cls_flows(mng_info->flows);
+	mng_info->flows = NULL;
+}
+
+/* Join classifier to the group of another classifier, or leave. */
+static int
+join_classifier_group(int comp_id, int grp_comp_id)
+{
+	struct cls_mng_info *mng_info = cls_mng_info_list + comp_id;
+	struct cls_mng_info *grp_mng = NULL;
+
+	if (grp_comp_id >= 0) {
+		grp_mng = cls_mng_info_list + grp_comp_id;
+		/* Group is always referred with its first classifier. */
+		if (grp_mng->grp_mng != NULL)
+			grp_mng = grp_mng->grp_mng;
+		if (unlikely(grp_mng == mng_info))
+			return SPPWK_RET_NG;
+	}
+
+	if (mng_info->grp_mng == grp_mng)
+		return SPPWK_RET_OK;
+
+	__atomic_store_n(&mng_info->grp_mng, grp_mng, __ATOMIC_RELEASE);
+	if (grp_mng != NULL)
+		RTE_LOG(INFO, VF_CLS, "Classifier joins group, id=%d, "
+				"grp_id=%d.\n", comp_id,
+				(int)(grp_mng - cls_mng_info_list));
+	return SPPWK_RET_OK;
 }
 
 /**
@@ -128,18 +207,8 @@ static rte_atomic16_t g_hash_table_count = RTE_ATOMIC16_INIT(0xff);
 static inline uint16_t
 get_vid(const struct rte_mbuf *pkt)
 {
-	struct rte_ether_hdr *eth;
-	struct rte_vlan_hdr *vh;
-
-	eth = rte_pktmbuf_mtod(pkt, struct rte_ether_hdr *);
-	if (eth->ether_type == rte_cpu_to_be_16(RTE_ETHER_TYPE_VLAN)) {
-		/* vlan tagged */
-		vh = (struct rte_vlan_hdr *)(eth + 1);
-		return rte_be_to_cpu_16(vh->vlan_tci) & 0x0fff;
-	}
-
-	/* vlan untagged */
-	return VLAN_UNTAGGED_VID;
+	return get_vid_from_hdr(
+			rte_pktmbuf_mtod(pkt, const struct rte_ether_hdr *));
 }
 
 #if RTE_LOG_DP_LEVEL >= RTE_LOG_DEBUG
@@ -246,20 +315,11 @@ log_entry(long clsd_idx, uint16_t vid, const char *mac_addr_str,
 #define LOG_ENT(clsd_idx, vid, mac_addr_str, cmp_info, clsd_data)
 #endif
 
-/* check if management information is used. */
-static inline int
-is_used_mng_info(const struct cls_mng_info *mng_info)
-{
-	return (mng_info != NULL && mng_info->is_used);
-}
-
 /* create mac classification instance. */
 static struct mac_classifier *
 create_mac_classification(void)
 {
 	struct mac_classifier *mac_cls;
-	char hash_tab_name[HASH_TABLE_NAME_BUF_SZ];
-	struct rte_hash **mac_cls_tab;
 
 	mac_cls = (struct mac_classifier *)rte_zmalloc(
 			NULL, sizeof(struct mac_classifier), 0);
@@ -269,37 +329,99 @@ create_mac_classification(void)
 
 	mac_cls->nof_cls_ports = 0;
 	mac_cls->default_cls_idx = -1;
+	mac_cls->nof_entries = 0;
+
+	return mac_cls;
+}
 
-	mac_cls_tab = &mac_cls->cls_tbl;
+/* Create classifier table of pairs of VID and MAC address. */
+static struct rte_hash *
+create_cls_table(void)
+{
+	struct rte_hash *cls_tbl;
+	char hash_tab_name[HASH_TABLE_NAME_BUF_SZ];
 
 	/* make hash table name(require uniqueness between processes) */
 	sprintf(hash_tab_name, "cmtab_%07x%02hx", getpid(),
 			rte_atomic16_add_return(&g_hash_table_count, 1));
 
-	RTE_LOG(INFO, VF_CLS, "Create table. name=%s, bufsz=%lu\n",
-			hash_tab_name, HASH_TABLE_NAME_BUF_SZ);
+	RTE_LOG(INFO, VF_CLS, "Create table. name=%s, bufsz=%lu, "
+			"entries=%u\n", hash_tab_name, HASH_TABLE_NAME_BUF_SZ,
+			g_nof_cls_tbl_entries);
 
 	/* set hash creating parameters */
 	struct rte_hash_parameters hash_params = {
 			.name      = hash_tab_name,
-			.entries   = NOF_CLS_TABLE_ENTRIES,
-			.key_len   = sizeof(struct rte_ether_addr),
+			.entries   = g_nof_cls_tbl_entries,
+			.key_len   = sizeof(struct cls_tbl_key),
 			.hash_func = DEFAULT_HASH_FUNC,
 			.hash_func_init_val = 0,
 			.socket_id = rte_socket_id(),
+			/* Entries are updated while classifier refers. */
+			.extra_flag = RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF,
 	};
 
 	/* Create classifier table. */
-	*mac_cls_tab = rte_hash_create(&hash_params);
-	if (unlikely(*mac_cls_tab == NULL)) {
+	cls_tbl = rte_hash_create(&hash_params);
+	if (unlikely(cls_tbl == NULL)) {
 		RTE_LOG(ERR, VF_CLS,
 				"Cannot create mac classification table. "
 				"name=%s\n", hash_tab_name);
-		rte_free(mac_cls);
 		return NULL;
 	}
 
-	return mac_cls;
+	return cls_tbl;
+}
+
+/* Set VID and MAC address to the key of classifier table. */
+static inline void
+set_cls_tbl_key(struct cls_tbl_key *tbl_key, uint16_t vid, uint64_t mac_addr)
+{
+	memset(tbl_key, 0, sizeof(*tbl_key));
+	tbl_key->vid = vid;
+	rte_memcpy(&tbl_key->addr, &mac_addr, RTE_ETHER_ADDR_LEN);
+}
+
+/* Check if MAC address is registered in classifier table. */
+static inline int
+is_cls_tbl_entry(uint64_t mac_addr)
+{
+	return mac_addr != 0 && mac_addr != CLS_DUMMY_ADDR;
+}
+
+/**
+ * Get a word of MAC address in lower 48 bits and VID in upper bits, which
+ * is read at once by classifier thread, or 0 if no entry in the table.
+ */
+static inline uint64_t
+get_cls_port_key(uint64_t mac_addr, uint16_t vid)
+{
+	if (!is_cls_tbl_entry(mac_addr))
+		return 0;
+	return mac_addr | ((uint64_t)vid << 48);
+}
+
+/**
+ * Get num of RX queues following the first RX port which are of the same
+ * phy port, and paired with TX ports for flow offload.
+ */
+static int
+get_nof_flow_rx(const struct sppwk_comp_info *wk_comp_info)
+{
+	int i;
+	const struct sppwk_port_info *rx_port;
+
+	if (!get_cls_flow_offload() || wk_comp_info->nof_rx == 0 ||
+			wk_comp_info->rx_ports[0]->iface_type != PHY)
+		return 0;
+
+	for (i = 1; i < wk_comp_info->nof_rx; i++) {
+		rx_port = wk_comp_info->rx_ports[i];
+		if (rx_port->iface_type != PHY || rx_port->ethdev_port_id !=
+				wk_comp_info->rx_ports[0]->ethdev_port_id)
+			break;
+	}
+	return i - 1;
 }
 
 /* initialize classifier information. */
@@ -310,7 +432,7 @@ init_component_info(struct cls_comp_info *cmp_info,
 	int ret = SPPWK_RET_NG;
 	int i;
 	struct mac_classifier *mac_cls;
-	struct rte_ether_addr eth_addr;
+	struct cls_tbl_key tbl_key;
 	char mac_addr_str[ETHER_ADDR_STR_BUF_SZ];
 	/* Classifier has one RX port and several TX ports. */
 	struct cls_port_info *cls_rx_port_info = &cmp_info->rx_port_i;
@@ -325,7 +447,6 @@ init_component_info(struct cls_comp_info *cmp_info,
 		cls_rx_port_info->queue_no = DEFAULT_QUEUE_ID;
 		cls_rx_port_info->iface_no_global = 0;
 		cls_rx_port_info->ethdev_port_id = 0;
-		cls_rx_port_info->nof_pkts = 0;
 	} else {
 		cls_rx_port_info->iface_type =
 			wk_comp_info->rx_ports[0]->iface_type;
@@ -336,9 +457,18 @@ init_component_info(struct cls_comp_info *cmp_info,
 			wk_comp_info->rx_ports[0]->iface_no;
 		cls_rx_port_info->ethdev_port_id =
 			wk_comp_info->rx_ports[0]->ethdev_port_id;
-		cls_rx_port_info->nof_pkts = 0;
 	}
 
+	/* set RX queues for flow offload */
+	cmp_info->nof_flow_rx = get_nof_flow_rx(wk_comp_info);
+	for (i = 0; i < cmp_info->nof_flow_rx; i++)
+		cmp_info->flow_rx_queues[i] =
+			wk_comp_info->rx_ports[i + 1]->queue_no;
+	if (unlikely(wk_comp_info->nof_rx > cmp_info->nof_flow_rx + 1))
+		RTE_LOG(ERR, VF_CLS, "RX ports not of queues of the first "
+				"phy port are ignored. nof_rx=%d\n",
+				wk_comp_info->nof_rx);
+
 	/* set tx */
 	cmp_info->nof_tx_ports = wk_comp_info->nof_tx;
 	cmp_info->mac_addr_entry = 0;
@@ -352,7 +482,11 @@ init_component_info(struct cls_comp_info *cmp_info,
 		cls_tx_ports_info[i].queue_no = tx_port->queue_no;
 		cls_tx_ports_info[i].iface_no_global = tx_port->iface_no;
 		cls_tx_ports_info[i].ethdev_port_id = tx_port->ethdev_port_id;
-		cls_tx_ports_info[i].nof_pkts = 0;
+		cls_tx_ports_info[i].cls_mac_addr =
+				tx_port->cls_attrs.mac_addr;
+		cls_tx_ports_info[i].cls_vid = vid;
+		cls_tx_ports_info[i].cls_key = get_cls_port_key(
+				tx_port->cls_attrs.mac_addr, vid);
 
 		if (tx_port->cls_attrs.mac_addr == 0)
 			continue;
@@ -388,14 +522,20 @@ init_component_info(struct cls_comp_info *cmp_info,
 			continue;
 		}
 
+		/* Table is shared among VLANs and created at first entry. */
+		if (unlikely(cmp_info->cls_tbl == NULL)) {
+			cmp_info->cls_tbl = create_cls_table();
+			if (unlikely(cmp_info->cls_tbl == NULL))
+				return SPPWK_RET_NG;
+		}
+
 		/* Add entry to classifier table. */
-		rte_memcpy(&eth_addr, &tx_port->cls_attrs.mac_addr,
-				RTE_ETHER_ADDR_LEN);
+		set_cls_tbl_key(&tbl_key, vid, tx_port->cls_attrs.mac_addr);
 		rte_ether_format_addr(mac_addr_str, sizeof(mac_addr_str),
-				&eth_addr);
+				&tbl_key.addr);
 
-		ret = rte_hash_add_key_data(mac_cls->cls_tbl,
-				(void *)&eth_addr, (void *)(long)i);
+		ret = rte_hash_add_key_data(cmp_info->cls_tbl,
+				(void *)&tbl_key, (void *)(long)i);
 		if (unlikely(ret < 0)) {
 			RTE_LOG(ERR, VF_CLS,
 					"Cannot add to classifier table. "
@@ -404,6 +544,14 @@ init_component_info(struct cls_comp_info *cmp_info,
 			return SPPWK_RET_NG;
 		}
 
+		/* Keep a copy for linear search while the table is small. */
+		if (mac_cls->nof_entries < NOF_CLS_LINEAR_ENTRIES) {
+			mac_cls->lin_keys[mac_cls->nof_entries] =
+					tx_port->cls_attrs.mac_addr;
+			mac_cls->lin_idx[mac_cls->nof_entries] = i;
+		}
+		mac_cls->nof_entries++;
+
 		RTE_LOG(INFO, VF_CLS,
 				"Add entry to classifier table. "
 				"vid=%hu, mac_addr=%s, iface_type=%d, "
@@ -416,74 +564,369 @@ init_component_info(struct cls_comp_info *cmp_info,
 	return SPPWK_RET_OK;
 }
 
-/* transmit packet to one destination. */
-static inline void
-transmit_packets(struct cls_port_info *clsd_data)
+/**
+ * Create mac classification of given VID from entries of TX ports of
+ * component info. It returns SPPWK_RET_NG if failed to create, or
+ * SPPWK_RET_OK and NULL as `mac_cls` if no entry for the VID.
+ */
+static int
+create_mac_classification_of_vid(const struct sppwk_comp_info *wk_comp_info,
+		uint16_t vid, struct mac_classifier **mac_cls)
 {
 	int i;
-	uint16_t n_tx;
+	uint64_t mac_addr;
+	struct mac_classifier *new_cls = NULL;
+	const struct sppwk_port_info *tx_port;
 
-	/* transmit packets */
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
-	n_tx = sppwk_eth_vlan_ring_stats_tx_burst(clsd_data->ethdev_port_id,
-			clsd_data->iface_type, clsd_data->iface_no,
-			0, clsd_data->pkts, clsd_data->nof_pkts);
-#else
-	n_tx = sppwk_eth_vlan_tx_burst(clsd_data->ethdev_port_id,
-			clsd_data->queue_no, clsd_data->pkts,
-			clsd_data->nof_pkts);
-#endif
+	for (i = 0; i < wk_comp_info->nof_tx; i++) {
+		tx_port = wk_comp_info->tx_ports[i];
+		mac_addr = tx_port->cls_attrs.mac_addr;
+		if (mac_addr == 0 || tx_port->cls_attrs.vlantag.vid != vid)
+			continue;
 
-	/* free cannot transmit packets */
-	if (unlikely(n_tx != clsd_data->nof_pkts)) {
-		for (i = n_tx; i < clsd_data->nof_pkts; i++)
-			rte_pktmbuf_free(clsd_data->pkts[i]);
-		RTE_LOG(DEBUG, VF_CLS,
-				"drop packets(tx). num=%hu, ethdev_port_id=%hu\n",
-				(uint16_t)(clsd_data->nof_pkts - n_tx),
-				clsd_data->ethdev_port_id);
+		if (new_cls == NULL) {
+			new_cls = create_mac_classification();
+			if (unlikely(new_cls == NULL))
+				return SPPWK_RET_NG;
+		}
+
+		new_cls->cls_ports[new_cls->nof_cls_ports++] = i;
+		if (unlikely(mac_addr == CLS_DUMMY_ADDR)) {
+			new_cls->default_cls_idx = i;
+			continue;
+		}
+
+		if (new_cls->nof_entries < NOF_CLS_LINEAR_ENTRIES) {
+			new_cls->lin_keys[new_cls->nof_entries] = mac_addr;
+			new_cls->lin_idx[new_cls->nof_entries] = i;
+		}
+		new_cls->nof_entries++;
 	}
 
-	clsd_data->nof_pkts = 0;
+	*mac_cls = new_cls;
+	return SPPWK_RET_OK;
 }
 
-/* transmit packet to one destination. */
-static inline void
-transmit_all_packet(struct cls_comp_info *cmp_info)
+/* Check if ports of classifier are same as given component info. */
+static int
+is_same_cls_ports(const struct cls_comp_info *cmp_info,
+		const struct sppwk_comp_info *wk_comp_info)
 {
 	int i;
-	struct cls_port_info *clsd_data_tx = cmp_info->tx_ports_i;
+	const struct cls_port_info *port_i;
+	const struct sppwk_port_info *port;
+
+	if (strncmp(cmp_info->name, wk_comp_info->name, STR_LEN_NAME) != 0)
+		return 0;
+
+	port_i = &cmp_info->rx_port_i;
+	if (wk_comp_info->nof_rx == 0) {
+		if (port_i->iface_type != UNDEF)
+			return 0;
+	} else {
+		port = wk_comp_info->rx_ports[0];
+		if (port_i->iface_type != port->iface_type ||
+				port_i->iface_no_global != port->iface_no ||
+				port_i->queue_no != port->queue_no ||
+				port_i->ethdev_port_id != port->ethdev_port_id)
+			return 0;
+	}
+
+	if (cmp_info->nof_flow_rx != get_nof_flow_rx(wk_comp_info))
+		return 0;
+	for (i = 0; i < cmp_info->nof_flow_rx; i++) {
+		if (cmp_info->flow_rx_queues[i] !=
+				wk_comp_info->rx_ports[i + 1]->queue_no)
+			return 0;
+	}
+
+	if (cmp_info->nof_tx_ports != wk_comp_info->nof_tx)
+		return 0;
+	for (i = 0; i < wk_comp_info->nof_tx; i++) {
+		port_i = &cmp_info->tx_ports_i[i];
+		port = wk_comp_info->tx_ports[i];
+		if (port_i->iface_type != port->iface_type ||
+				port_i->iface_no_global != port->iface_no ||
+				port_i->queue_no != port->queue_no ||
+				port_i->ethdev_port_id != port->ethdev_port_id)
+			return 0;
+	}
+
+	return 1;
+}
+
+/* Check if entry of TX port is changed. */
+static inline int
+is_cls_entry_changed(const struct cls_port_info *tx_port_i,
+		const struct sppwk_port_info *tx_port)
+{
+	return tx_port_i->cls_mac_addr != tx_port->cls_attrs.mac_addr ||
+		tx_port_i->cls_vid != tx_port->cls_attrs.vlantag.vid;
+}
+
+/* Delete key of classifier table, and release it after quiescent state. */
+static void
+del_cls_tbl_key(struct rte_hash *cls_tbl, const struct cls_tbl_key *tbl_key)
+{
+	int ret;
+
+	ret = rte_hash_del_key(cls_tbl, (const void *)tbl_key);
+	if (ret >= 0)
+		sppwk_conf_rcu_defer_free(cls_tbl, free_cls_tbl_key,
+				(void *)(long)ret);
+}
+
+/**
+ * Revert keys added for TX ports before `nof_added` in updating entries.
+ * Key moved from another port is given back to the port, and others are
+ * deleted. Later ports are reverted first because they overwrite data of
+ * the same key added by earlier ones.
+ */
+static void
+revert_cls_table_entries(struct cls_comp_info *cmp_info,
+		const struct sppwk_comp_info *wk_comp_info, int nof_added)
+{
+	int i, j;
+	int ret;
+	void *data;
+	uint16_t vid;
+	uint64_t mac_addr;
+	const struct cls_port_info *tx_port_i;
+	const struct sppwk_port_info *tx_port;
+	struct cls_tbl_key tbl_key;
+
+	if (cmp_info->cls_tbl == NULL)
+		return;
+
+	for (i = nof_added - 1; i >= 0; i--) {
+		tx_port = wk_comp_info->tx_ports[i];
+		if (!is_cls_entry_changed(&cmp_info->tx_ports_i[i], tx_port))
+			continue;
+
+		mac_addr = tx_port->cls_attrs.mac_addr;
+		vid = tx_port->cls_attrs.vlantag.vid;
+		if (!is_cls_tbl_entry(mac_addr))
+			continue;
+
+		set_cls_tbl_key(&tbl_key, vid, mac_addr);
+		ret = rte_hash_lookup_data(cmp_info->cls_tbl,
+				(const void *)&tbl_key, &data);
+		if (ret < 0 || (long)data != i)
+			continue;
+
+		/* Entries of ports in use are not updated yet. */
+		for (j = 0; j < cmp_info->nof_tx_ports; j++) {
+			tx_port_i = &cmp_info->tx_ports_i[j];
+			if (tx_port_i->cls_mac_addr == mac_addr &&
+					tx_port_i->cls_vid == vid)
+				break;
+		}
+		if (j < cmp_info->nof_tx_ports)
+			rte_hash_add_key_data(cmp_info->cls_tbl,
+					(void *)&tbl_key, (void *)(long)j);
+		else
+			del_cls_tbl_key(cmp_info->cls_tbl, &tbl_key);
+	}
+}
+
+/**
+ * Update entries of classifier in use without switching sides. Classifiers
+ * of updated VLANs are created at first, and keys are added or deleted in
+ * lock-free table. Then the classifiers are replaced. Classifier in use is
+ * not changed if failed. Deleted keys and replaced classifiers are released
+ * after the classifier thread passes through quiescent state.
+ */
+static int
+update_cls_table_entries(struct cls_comp_info *cmp_info,
+		const struct sppwk_comp_info *wk_comp_info)
+{
+	int i, vid;
+	int ret;
+	int mac_addr_entry = 0;
+	void *data;
+	uint16_t old_vid, new_vid;
+	uint64_t old_mac, new_mac;
+	struct cls_port_info *tx_port_i;
+	const struct sppwk_port_info *tx_port;
+	struct cls_tbl_key tbl_key;
+	struct rte_hash *cls_tbl;
+	struct mac_classifier *old_cls;
+	struct mac_classifier **new_clfs;  /* Classifiers of updated VLANs. */
+	uint64_t upd_vids[NOF_VLAN / 64];  /* Bitmap of updated VLANs. */
+
+	memset(upd_vids, 0, sizeof(upd_vids));
 
 	for (i = 0; i < cmp_info->nof_tx_ports; i++) {
-		if (unlikely(clsd_data_tx[i].nof_pkts != 0)) {
-			RTE_LOG(INFO, VF_CLS,
-					"transmit all packets (drain). "
-					"index=%d, nof_pkts=%hu\n",
-					i, clsd_data_tx[i].nof_pkts);
-			transmit_packets(&clsd_data_tx[i]);
+		tx_port_i = &cmp_info->tx_ports_i[i];
+		tx_port = wk_comp_info->tx_ports[i];
+		if (tx_port->cls_attrs.mac_addr != 0)
+			mac_addr_entry = 1;
+		if (!is_cls_entry_changed(tx_port_i, tx_port))
+			continue;
+
+		old_vid = tx_port_i->cls_vid;
+		new_vid = tx_port->cls_attrs.vlantag.vid;
+		if (tx_port_i->cls_mac_addr != 0)
+			upd_vids[old_vid / 64] |= 1ULL << (old_vid % 64);
+		if (tx_port->cls_attrs.mac_addr != 0)
+			upd_vids[new_vid / 64] |= 1ULL << (new_vid % 64);
+	}
+
+	new_clfs = rte_zmalloc(NULL, sizeof(*new_clfs) * NOF_VLAN, 0);
+	if (unlikely(new_clfs == NULL)) {
+		RTE_LOG(ERR, VF_CLS, "Cannot allocate classifiers of VLANs.\n");
+		return SPPWK_RET_NG;
+	}
+
+	/* Create classifiers of updated VLANs before changing the table. */
+	ret = SPPWK_RET_OK;
+	for (vid = 0; vid < NOF_VLAN; vid++) {
+		if (likely(!(upd_vids[vid / 64] & (1ULL << (vid % 64)))))
+			continue;
+
+		ret = create_mac_classification_of_vid(wk_comp_info,
+				(uint16_t)vid, &new_clfs[vid]);
+		if (unlikely(ret != SPPWK_RET_OK))
+			break;
+	}
+
+	/**
+	 * Add new entries. If an entry is moved to another port, data of the
+	 * key is overwritten and not deleted in the next step.
+	 */
+	for (i = 0; ret == SPPWK_RET_OK && i < cmp_info->nof_tx_ports; i++) {
+		tx_port_i = &cmp_info->tx_ports_i[i];
+		tx_port = wk_comp_info->tx_ports[i];
+		new_mac = tx_port->cls_attrs.mac_addr;
+		new_vid = tx_port->cls_attrs.vlantag.vid;
+		if (!is_cls_entry_changed(tx_port_i, tx_port) ||
+				!is_cls_tbl_entry(new_mac))
+			continue;
+
+		if (unlikely(cmp_info->cls_tbl == NULL)) {
+			cls_tbl = create_cls_table();
+			if (unlikely(cls_tbl == NULL)) {
+				ret = SPPWK_RET_NG;
+				break;
+			}
+			__atomic_store_n(&cmp_info->cls_tbl, cls_tbl,
+					__ATOMIC_RELEASE);
+		}
+
+		set_cls_tbl_key(&tbl_key, new_vid, new_mac);
+		ret = rte_hash_add_key_data(cmp_info->cls_tbl,
+				(void *)&tbl_key, (void *)(long)i);
+		if (unlikely(ret < 0)) {
+			RTE_LOG(ERR, VF_CLS,
+					"Cannot add to classifier table. "
+					"ret=%d, vid=%hu\n", ret, new_vid);
+			ret = SPPWK_RET_NG;
+			break;
 		}
+		ret = SPPWK_RET_OK;
+	}
+
+	if (unlikely(ret != SPPWK_RET_OK)) {
+		revert_cls_table_entries(cmp_info, wk_comp_info, i);
+		for (vid = 0; vid < NOF_VLAN; vid++)
+			free_mac_classifier(new_clfs[vid]);
+		rte_free(new_clfs);
+		return SPPWK_RET_NG;
 	}
+
+	/* Delete old entries which are not overwritten by other ports. */
+	for (i = 0; i < cmp_info->nof_tx_ports; i++) {
+		tx_port_i = &cmp_info->tx_ports_i[i];
+		tx_port = wk_comp_info->tx_ports[i];
+		if (!is_cls_entry_changed(tx_port_i, tx_port))
+			continue;
+
+		old_mac = tx_port_i->cls_mac_addr;
+		old_vid = tx_port_i->cls_vid;
+		tx_port_i->cls_mac_addr = tx_port->cls_attrs.mac_addr;
+		tx_port_i->cls_vid = tx_port->cls_attrs.vlantag.vid;
+		/* MAC address and VID are changed at once for the thread. */
+		__atomic_store_n(&tx_port_i->cls_key,
+				get_cls_port_key(tx_port_i->cls_mac_addr,
+					tx_port_i->cls_vid),
+				__ATOMIC_RELEASE);
+		if (!is_cls_tbl_entry(old_mac))
+			continue;
+
+		set_cls_tbl_key(&tbl_key, old_vid, old_mac);
+		ret = rte_hash_lookup_data(cmp_info->cls_tbl,
+				(const void *)&tbl_key, &data);
+		if (ret < 0 || (long)data != i)
+			continue;
+
+		del_cls_tbl_key(cmp_info->cls_tbl, &tbl_key);
+	}
+
+	/* Replace classifiers of updated VLANs. */
+	for (vid = 0; vid < NOF_VLAN; vid++) {
+		if (likely(!(upd_vids[vid / 64] & (1ULL << (vid % 64)))))
+			continue;
+
+		old_cls = cmp_info->mac_clfs[vid];
+		__atomic_store_n(&cmp_info->mac_clfs[vid], new_clfs[vid],
+				__ATOMIC_RELEASE);
+		if (old_cls != NULL)
+			sppwk_conf_rcu_defer_free(old_cls, free_cls_of_vid,
+					NULL);
+
+		RTE_LOG(DEBUG, VF_CLS, "Replace classifier of vid=%d.\n", vid);
+	}
+	rte_free(new_clfs);
+
+	cmp_info->mac_addr_entry = mac_addr_entry;
+
+	return SPPWK_RET_OK;
 }
 
-/* set mbuf pointer to tx buffer and transmit packet, if buffer is filled */
+/**
+ * Compile ACL of classifier again if ACL rules are changed, and replace old
+ * one which is released after classifier thread passes through quiescent
+ * state.
+ */
+static int
+update_cls_acl(struct cls_comp_info *cmp_info)
+{
+	int ret;
+	unsigned int acl_ver = get_cls_acl_rules_ver();
+	struct cls_acl *new_acl, *old_acl;
+
+	if (cmp_info->acl_ver == acl_ver)
+		return SPPWK_RET_OK;
+
+	ret = create_cls_acl(cmp_info, &new_acl);
+	if (unlikely(ret != SPPWK_RET_OK))
+		return SPPWK_RET_NG;
+
+	old_acl = cmp_info->acl;
+	__atomic_store_n(&cmp_info->acl, new_acl, __ATOMIC_RELEASE);
+	if (old_acl != NULL)
+		sppwk_conf_rcu_defer_free(old_acl, free_cls_acl_of_comp, NULL);
+	cmp_info->acl_ver = acl_ver;
+
+	RTE_LOG(DEBUG, VF_CLS, "Replace ACL of classifier, ver=%u.\n",
+			acl_ver);
+	return SPPWK_RET_OK;
+}
+
+/* Transmit all packets in TX buffers. */
 static inline void
-push_packet(struct rte_mbuf *pkt, struct cls_port_info *clsd_data)
+transmit_all_packet(struct cls_mng_info *mng_info)
 {
-	clsd_data->pkts[clsd_data->nof_pkts++] = pkt;
+	int i;
 
-	/* transmit packet, if buffer is filled */
-	if (unlikely(clsd_data->nof_pkts == MAX_PKT_BURST)) {
-		RTE_LOG(DEBUG, VF_CLS,
-				"transmit packets (buffer is filled). "
-				"iface_type=%d, iface_no={%d,%d}, queue_no=%d, "
-				"tx_port=%hu, nof_pkts=%hu\n",
-				clsd_data->iface_type,
-				clsd_data->iface_no_global,
-				clsd_data->iface_no,
-				clsd_data->queue_no,
-				clsd_data->ethdev_port_id,
-				clsd_data->nof_pkts);
-		transmit_packets(clsd_data);
+	for (i = 0; i < mng_info->nof_tx_ports; i++) {
+		if (unlikely(mng_info->tx_bufs[i].nof_pkts != 0)) {
+			RTE_LOG(INFO, VF_CLS,
+					"transmit all packets (drain). "
+					"index=%d, nof_pkts=%hu\n",
+					i, mng_info->tx_bufs[i].nof_pkts);
+			sppwk_tx_buf_flush(&mng_info->tx_bufs[i]);
+		}
 	}
 }
 
@@ -505,13 +948,13 @@ get_general_default_classified_index(struct cls_comp_info *cmp_info)
 
 /* handle L2 multicast(include broadcast) packet */
 static inline void
-handle_l2multicast_packet(struct rte_mbuf *pkt,
+handle_l2multicast_packet(struct rte_mbuf *pkt, uint16_t vid,
 		struct cls_comp_info *cmp_info,
-		struct cls_port_info *clsd_data)
+		struct sppwk_tx_buf *tx_bufs, uint64_t cur_tsc)
 {
+	struct cls_port_info *clsd_data = cmp_info->tx_ports_i;
 	int i;
 	struct mac_classifier *mac_cls;
-	uint16_t vid = get_vid(pkt);
 	int gen_def_clsd_idx = get_general_default_classified_index(cmp_info);
 	int n_act_clsd;
 
@@ -532,7 +975,7 @@ handle_l2multicast_packet(struct rte_mbuf *pkt,
 
 		/* transmit to untagged's default(as general default) */
 		LOG_CLS((long)gen_def_clsd_idx, pkt, cmp_info, clsd_data);
-		push_packet(pkt, clsd_data + (long)gen_def_clsd_idx);
+		sppwk_tx_buf_push(tx_bufs + gen_def_clsd_idx, pkt, cur_tsc);
 		return;
 	}
 
@@ -546,52 +989,64 @@ handle_l2multicast_packet(struct rte_mbuf *pkt,
 	/* transmit to specific segment & general default */
 	for (i = 0; i < mac_cls->nof_cls_ports; i++) {
 		LOG_CLS((long)mac_cls->cls_ports[i], pkt, cmp_info, clsd_data);
-		push_packet(pkt, clsd_data + (long)mac_cls->cls_ports[i]);
+		sppwk_tx_buf_push(tx_bufs + mac_cls->cls_ports[i], pkt,
+				cur_tsc);
 	}
 
 	if (gen_def_clsd_idx >= 0 && vid != VLAN_UNTAGGED_VID) {
 		LOG_CLS((long)gen_def_clsd_idx, pkt, cmp_info, clsd_data);
-		push_packet(pkt, clsd_data + (long)gen_def_clsd_idx);
+		sppwk_tx_buf_push(tx_bufs + gen_def_clsd_idx, pkt, cur_tsc);
 	}
 }
 
-/* select index of classified */
-static inline int
-select_classified_index(const struct rte_mbuf *pkt,
-		struct cls_comp_info *cmp_info)
+/* Get MAC address as an integer key compared with `lin_keys`. */
+static inline uint64_t
+get_mac_key(const struct rte_ether_addr *addr)
 {
-	int ret;
-	struct rte_ether_hdr *eth;
-	void *lookup_data;
-	struct mac_classifier *mac_cls;
-	uint16_t vid;
+	uint64_t key = 0;
 
-	eth = rte_pktmbuf_mtod(pkt, struct rte_ether_hdr *);
-	vid = get_vid(pkt);
+	memcpy(&key, addr, RTE_ETHER_ADDR_LEN);
+	return key;
+}
 
-	/* select mac address classification by vid */
-	mac_cls = cmp_info->mac_clfs[vid];
-	if (unlikely(mac_cls == NULL)) {
-		LOG_DBG(cmp_info->name, "Mac classification is not "
-				"registered. vid=%hu\n", vid);
-		return get_general_default_classified_index(cmp_info);
+/* Find MAC address from small table by comparing entries linearly. */
+static inline int
+lookup_mac_linear(const struct mac_classifier *mac_cls, uint64_t key)
+{
+	int i = 0;
+	int nof_ents = mac_cls->nof_entries;
+#ifdef RTE_MACHINE_CPUFLAG_SSE4_1
+	__m128i keys = _mm_set1_epi64x((long long)key);
+	__m128i ents;
+	int mask;
+
+	/* Compare two entries at once. */
+	for (; i + 1 < nof_ents; i += 2) {
+		ents = _mm_load_si128((const __m128i *)&mac_cls->lin_keys[i]);
+		mask = _mm_movemask_pd(_mm_castsi128_pd(
+				_mm_cmpeq_epi64(ents, keys)));
+		if (mask & 0x1)
+			return mac_cls->lin_idx[i];
+		if (mask & 0x2)
+			return mac_cls->lin_idx[i + 1];
 	}
-
-	/* find in table (by destination mac address) */
-	ret = rte_hash_lookup_data(mac_cls->cls_tbl,
-			(const void *)&eth->d_addr, &lookup_data);
-	if (ret >= 0) {
-		LOG_DBG(cmp_info->name, "Mac address is registered. "
-				"ret=%d, vid=%hu\n", ret, vid);
-		return (int)(long)lookup_data;
+#endif
+	for (; i < nof_ents; i++) {
+		if (mac_cls->lin_keys[i] == key)
+			return mac_cls->lin_idx[i];
 	}
 
-	LOG_DBG(cmp_info->name,
-			"Mac address is not registered. ret=%d, "
-			"(EINVAL=%d, ENOENT=%d)\n", ret, EINVAL, ENOENT);
+	return SPPWK_RET_NG;
+}
 
+/* Get index of classified for a packet not registered in the table. */
+static inline int
+get_default_classified_index(const struct rte_ether_addr *dst_addr,
+		uint16_t vid, const struct mac_classifier *mac_cls,
+		struct cls_comp_info *cmp_info)
+{
 	/* check if packet is l2 multicast */
-	if (unlikely(rte_is_multicast_ether_addr(&eth->d_addr)))
+	if (unlikely(rte_is_multicast_ether_addr(dst_addr)))
 		return -2;
 
 	/* if default is not set, use untagged's default */
@@ -607,63 +1062,258 @@ select_classified_index(const struct rte_mbuf *pkt,
 	return mac_cls->default_cls_idx;
 }
 
+/**
+ * Select indices of classified for a group of packets of the same VID.
+ * Results are stored in `clsd_idx` at the position of each of packets in
+ * the received burst given as `pos`.
+ */
 static inline void
-_classify_packets(struct rte_mbuf **rx_pkts, uint16_t n_rx,
-		struct cls_comp_info *cmp_info,
-		struct cls_port_info *clsd_data)
+select_classified_index_bulk(uint16_t vid,
+		const struct rte_ether_addr **dst_addrs, const int *pos,
+		int nof_pkts, struct cls_comp_info *cmp_info, int *clsd_idx)
 {
 	int i;
-	long clsd_idx;
+	int ret;
+	int gen_def_clsd_idx;
+	uint64_t hit_mask = 0;
+	void *lookup_data[MAX_PKT_BURST];
+	struct cls_tbl_key tbl_keys[MAX_PKT_BURST];
+	const void *key_ptrs[MAX_PKT_BURST];
+	const struct mac_classifier *mac_cls;
+
+	/* select mac address classification by vid */
+	mac_cls = cmp_info->mac_clfs[vid];
+	if (unlikely(mac_cls == NULL)) {
+		LOG_DBG(cmp_info->name, "Mac classification is not "
+				"registered. vid=%hu\n", vid);
+		gen_def_clsd_idx =
+			get_general_default_classified_index(cmp_info);
+		for (i = 0; i < nof_pkts; i++)
+			clsd_idx[pos[i]] = gen_def_clsd_idx;
+		return;
+	}
+
+	/* find in small table without probing hash table */
+	if (mac_cls->nof_entries <= NOF_CLS_LINEAR_ENTRIES) {
+		for (i = 0; i < nof_pkts; i++) {
+			ret = lookup_mac_linear(mac_cls,
+					get_mac_key(dst_addrs[i]));
+			if (ret < 0)
+				ret = get_default_classified_index(
+						dst_addrs[i], vid, mac_cls,
+						cmp_info);
+			clsd_idx[pos[i]] = ret;
+		}
+		return;
+	}
+
+	/* find in table (by VID and destination mac address) */
+	for (i = 0; i < nof_pkts; i++) {
+		tbl_keys[i].vid = vid;
+		rte_ether_addr_copy(dst_addrs[i], &tbl_keys[i].addr);
+		key_ptrs[i] = &tbl_keys[i];
+	}
+	ret = rte_hash_lookup_bulk_data(cmp_info->cls_tbl, key_ptrs,
+			nof_pkts, &hit_mask, lookup_data);
+	LOG_DBG(cmp_info->name, "Lookup mac addresses. "
+			"hits=%d, nof_pkts=%d, vid=%hu\n", ret, nof_pkts, vid);
+
+	for (i = 0; i < nof_pkts; i++) {
+		if (hit_mask & (1ULL << i))
+			clsd_idx[pos[i]] = (int)(long)lookup_data[i];
+		else
+			clsd_idx[pos[i]] = get_default_classified_index(
+					dst_addrs[i], vid, mac_cls, cmp_info);
+	}
+}
 
+/**
+ * Classify a burst of packets. VID and destination MAC address of all of
+ * packets are parsed at first, and packets not matched with ACL rules are
+ * grouped by VID to look up the table of the VID at once. Then packets are
+ * pushed to TX buffers in the received order.
+ */
+static inline void
+_classify_packets(struct rte_mbuf **rx_pkts, uint16_t n_rx,
+		struct cls_comp_info *cmp_info,
+		struct sppwk_tx_buf *tx_bufs, uint64_t cur_tsc)
+{
+	int i, j;
+	int nof_grp_pkts;
+	uint16_t vid;
+	struct rte_ether_hdr *eth;
+	const struct cls_acl *acl;
+	uint16_t vids[MAX_PKT_BURST];
+	int clsd_idx[MAX_PKT_BURST];
+	uint8_t is_grouped[MAX_PKT_BURST];
+	const struct rte_ether_addr *dst_addrs[MAX_PKT_BURST];
+	/* Packets of the same VID in a burst. */
+	int grp_pos[MAX_PKT_BURST];
+	const struct rte_ether_addr *grp_addrs[MAX_PKT_BURST];
+
+	for (i = 0; i < CLS_PREFETCH_OFFSET && i < n_rx; i++)
+		rte_prefetch0(rte_pktmbuf_mtod(rx_pkts[i], void *));
+
+	/* Parse headers of all of packets at once. */
 	for (i = 0; i < n_rx; i++) {
+		if (i + CLS_PREFETCH_OFFSET < n_rx)
+			rte_prefetch0(rte_pktmbuf_mtod(
+					rx_pkts[i + CLS_PREFETCH_OFFSET],
+					void *));
+
 		LOG_PKT(cmp_info->name, rx_pkts[i]);
 
-		clsd_idx = select_classified_index(rx_pkts[i], cmp_info);
-		LOG_CLS(clsd_idx, rx_pkts[i], cmp_info, clsd_data);
+		eth = rte_pktmbuf_mtod(rx_pkts[i], struct rte_ether_hdr *);
+		dst_addrs[i] = &eth->d_addr;
+		vids[i] = get_vid_from_hdr(eth);
+		is_grouped[i] = 0;
+	}
+
+	/* Packets matched with ACL are not classified with MAC address. */
+	acl = __atomic_load_n(&cmp_info->acl, __ATOMIC_ACQUIRE);
+	if (acl != NULL && classify_cls_acl(acl, rx_pkts, n_rx,
+			clsd_idx) > 0) {
+		for (i = 0; i < n_rx; i++)
+			is_grouped[i] = (clsd_idx[i] >= 0);
+	}
+
+	/* Look up table for each group of packets of the same VID. */
+	for (i = 0; i < n_rx; i++) {
+		if (is_grouped[i])
+			continue;
+
+		vid = vids[i];
+		nof_grp_pkts = 0;
+		for (j = i; j < n_rx; j++) {
+			if (is_grouped[j] || vids[j] != vid)
+				continue;
+			is_grouped[j] = 1;
+			grp_pos[nof_grp_pkts] = j;
+			grp_addrs[nof_grp_pkts++] = dst_addrs[j];
+		}
 
-		if (likely(clsd_idx >= 0)) {
+		select_classified_index_bulk(vid, grp_addrs, grp_pos,
+				nof_grp_pkts, cmp_info, clsd_idx);
+	}
+
+	for (i = 0; i < n_rx; i++) {
+		LOG_CLS((long)clsd_idx[i], rx_pkts[i], cmp_info,
+				cmp_info->tx_ports_i);
+
+		if (likely(clsd_idx[i] >= 0)) {
 			LOG_DBG(cmp_info->name, "as unicast packet. i=%d\n",
 					i);
-			push_packet(rx_pkts[i], clsd_data + clsd_idx);
-		} else if (unlikely(clsd_idx == -1)) {
+			sppwk_tx_buf_push(tx_bufs + clsd_idx[i], rx_pkts[i],
+					cur_tsc);
+		} else if (unlikely(clsd_idx[i] == -1)) {
 			LOG_DBG(cmp_info->name, "no destination. "
 					"drop packet. i=%d\n", i);
 			rte_pktmbuf_free(rx_pkts[i]);
-		} else if (unlikely(clsd_idx == -2)) {
+		} else if (unlikely(clsd_idx[i] == -2)) {
 			LOG_DBG(cmp_info->name, "as multicast packet. i=%d\n",
 					i);
-			handle_l2multicast_packet(rx_pkts[i],
-					cmp_info, clsd_data);
+			handle_l2multicast_packet(rx_pkts[i], vids[i],
+					cmp_info, tx_bufs, cur_tsc);
 		}
 	}
 }
 
-/* TODO(yasufum) Revise this comment and name of func. */
-/* change update index at classifier management information */
+/**
+ * Send packets steered with rule of flow offload to the paired TX port if
+ * matched with its entry in the table, and classify other packets in
+ * software.
+ */
 static inline void
-change_classifier_index(struct cls_mng_info *mng_info, int id)
+classify_flow_packets(struct rte_mbuf **rx_pkts, uint16_t n_rx, int tx_idx,
+		const struct cls_port_info *tx_port_i,
+		struct cls_comp_info *tbl_info,
+		struct sppwk_tx_buf *tx_bufs, uint64_t cur_tsc)
 {
-	if (unlikely(mng_info->ref_index ==
-			mng_info->upd_index)) {
-		/* Change reference index of port ability. */
-		sppwk_swap_two_sides(SPPWK_SWAP_REF, 0, 0);
+	int i;
+	uint16_t nof_sw_pkts = 0;
+	uint64_t cls_key;
+	struct rte_ether_hdr *eth;
+	struct rte_mbuf *sw_pkts[MAX_PKT_BURST];
+
+	/* No entry for the queue, or packets matched with ACL. */
+	cls_key = __atomic_load_n(&tx_port_i->cls_key, __ATOMIC_ACQUIRE);
+	if (unlikely(cls_key == 0) ||
+			unlikely(__atomic_load_n(&tbl_info->acl,
+			__ATOMIC_ACQUIRE) != NULL)) {
+		_classify_packets(rx_pkts, n_rx, tbl_info, tx_bufs, cur_tsc);
+		return;
+	}
 
-		/* Transmit all packets for switching the using data. */
-		transmit_all_packet(mng_info->comp_list + mng_info->ref_index);
+	for (i = 0; i < n_rx; i++) {
+		eth = rte_pktmbuf_mtod(rx_pkts[i], struct rte_ether_hdr *);
+		if (likely((get_mac_key(&eth->d_addr) |
+				((uint64_t)get_vid_from_hdr(eth) << 48)) ==
+				cls_key))
+			sppwk_tx_buf_push(tx_bufs + tx_idx, rx_pkts[i],
+					cur_tsc);
+		else
+			sw_pkts[nof_sw_pkts++] = rx_pkts[i];
+	}
 
-		RTE_LOG(DEBUG, VF_CLS,
-				"Core[%u] Change update index.\n", id);
-		mng_info->ref_index =
-				(mng_info->upd_index + 1) % TWO_SIDES;
+	if (nof_sw_pkts != 0)
+		_classify_packets(sw_pkts, nof_sw_pkts, tbl_info, tx_bufs,
+				cur_tsc);
+}
+
+/* Transmit all packets in TX buffers, and change them to new TX ports. */
+static inline void
+change_classifier_ports(struct cls_mng_info *mng_info,
+		const struct cls_comp_info *cmp_info)
+{
+	int i;
+	const struct cls_port_info *tx_port_i;
+
+	/* Transmit all packets for switching the using data. */
+	transmit_all_packet(mng_info);
+
+	mng_info->nof_tx_ports = cmp_info->nof_tx_ports;
+	for (i = 0; i < cmp_info->nof_tx_ports; i++) {
+		tx_port_i = &cmp_info->tx_ports_i[i];
+		sppwk_tx_buf_init(&mng_info->tx_bufs[i],
+				tx_port_i->ethdev_port_id,
+				tx_port_i->queue_no, tx_port_i->iface_type,
+				tx_port_i->iface_no_global, 1);
 	}
+
+	RTE_LOG(DEBUG, VF_CLS, "Change TX ports of classifier, ver=%u.\n",
+			cmp_info->conf_ver);
+	mng_info->cur_ver = cmp_info->conf_ver;
 }
 
 /* classifier(mac address) initialize globals. */
 int
-init_cls_mng_info(void)
+init_cls_mng_info(uint32_t nof_tbl_entries)
 {
 	memset(cls_mng_info_list, 0, sizeof(cls_mng_info_list));
-	return 0;
+	g_nof_cls_tbl_entries = nof_tbl_entries;
+
+	return SPPWK_RET_OK;
+}
+
+/**
+ * Update rules of flow offload of classifier. Entries are classified in
+ * software if failed, so that the error is not returned.
+ */
+static void
+update_classifier_flows(struct cls_mng_info *mng_info,
+		const struct cls_comp_info *cmp_info)
+{
+	/* Members of a group do not have rules of their own table. */
+	if (mng_info->grp_mng != NULL) {
+		free_cls_flows(mng_info->flows);
+		mng_info->flows = NULL;
+		return;
+	}
+
+	if (unlikely(update_cls_flows(cmp_info, &mng_info->flows) !=
+			SPPWK_RET_OK))
+		RTE_LOG(ERR, VF_CLS, "Cannot update rules of classifier, "
+				"classified in software.\n");
 }
 
 /* classifier(mac address) update component info. */
@@ -674,33 +1324,73 @@ update_classifier(struct sppwk_comp_info *wk_comp_info)
 	int wk_id = wk_comp_info->comp_id;
 	struct cls_mng_info *mng_info = cls_mng_info_list + wk_id;
 	struct cls_comp_info *cls_info = NULL;
+	struct cls_comp_info *old_info = NULL;
 
 	RTE_LOG(INFO, VF_CLS,
 			"Start updating classifier, id=%u.\n", wk_id);
 
-	/* TODO(yasufum) rename `infos`. */
-	cls_info = mng_info->comp_list + mng_info->upd_index;
+	/* Group given in start command is applied while flushing. */
+	ret = join_classifier_group(wk_id, wk_comp_info->grp_comp_id);
+	if (unlikely(ret != SPPWK_RET_OK)) {
+		RTE_LOG(ERR, VF_CLS, "Cannot join group, id=%u.\n", wk_id);
+		return ret;
+	}
 
-	/* initialize update side classifier information */
+	/**
+	 * If only entries of classifier table are changed, update the table
+	 * in use without replacing classifier info.
+	 */
+	cls_info = mng_info->cmp_info;
+	if (cls_info != NULL && is_same_cls_ports(cls_info, wk_comp_info)) {
+		ret = update_cls_table_entries(cls_info, wk_comp_info);
+		if (likely(ret == SPPWK_RET_OK))
+			ret = update_cls_acl(cls_info);
+		if (unlikely(ret != SPPWK_RET_OK)) {
+			RTE_LOG(ERR, VF_CLS, "Cannot update classifier "
+					"table, ret=%d.\n", ret);
+			return ret;
+		}
+		update_classifier_flows(mng_info, cls_info);
+		RTE_LOG(INFO, VF_CLS, "Done update classifier table, "
+				"id=%u.\n", wk_id);
+		return SPPWK_RET_OK;
+	}
+
+	cls_info = rte_zmalloc(NULL, sizeof(struct cls_comp_info), 0);
+	if (unlikely(cls_info == NULL)) {
+		RTE_LOG(ERR, VF_CLS,
+				"Cannot allocate classifier info, id=%u.\n",
+				wk_id);
+		return SPPWK_RET_NG;
+	}
+
+	/* Reuse the table released in previous update if exists. */
+	cls_info->cls_tbl = mng_info->spare_tbl;
+	mng_info->spare_tbl = NULL;
+
+	/* TODO(yasufum) rename `infos`. */
 	ret = init_component_info(cls_info, wk_comp_info);
+	if (likely(ret == SPPWK_RET_OK))
+		ret = update_cls_acl(cls_info);
 	if (unlikely(ret != SPPWK_RET_OK)) {
 		RTE_LOG(ERR, VF_CLS,
 				"Cannot update classifier, ret=%d.\n", ret);
+		free_cls_comp_info(cls_info, mng_info);
 		return ret;
 	}
 	memcpy(cls_info->name, wk_comp_info->name, STR_LEN_NAME);
-
-	/* change index of reference side */
-	mng_info->upd_index = mng_info->ref_index;
-	mng_info->is_used = 1;
-
-	/* wait until no longer access the new update side */
-	while (likely(mng_info->ref_index ==
-			mng_info->upd_index))
-		rte_delay_us_block(SPPWK_UPDATE_INTERVAL);
-
-	/* Clean old one. */
-	clean_component_info(mng_info->comp_list + mng_info->upd_index);
+	cls_info->conf_ver = ++mng_info->conf_ver;
+
+	/**
+	 * Publish new one without waiting for classifier thread. Old one is
+	 * released after classifier thread stops to refer it, and its table
+	 * is kept for next update.
+	 */
+	old_info = SPPWK_CONF_SET(mng_info->cmp_info, cls_info);
+	if (old_info != NULL)
+		sppwk_conf_rcu_defer_free(old_info, free_cls_comp_info,
+				mng_info);
+	update_classifier_flows(mng_info, cls_info);
 
 	RTE_LOG(INFO, VF_CLS,
 			"Done update classifier, id=%u.\n", wk_id);
@@ -714,66 +1404,84 @@ classify_packets(int comp_id)
 {
 	int i;
 	int n_rx;
+	uint64_t cur_tsc;
 	struct cls_mng_info *mng_info = cls_mng_info_list + comp_id;
+	struct cls_mng_info *grp_mng;
 	struct cls_comp_info *cmp_info = NULL;
+	struct cls_comp_info *tbl_info;  /* Classifier info of the table. */
 	struct rte_mbuf *rx_pkts[MAX_PKT_BURST];
 
 	struct cls_port_info *clsd_data_rx = NULL;
-	struct cls_port_info *clsd_data_tx = NULL;
 
-	uint64_t cur_tsc, prev_tsc = 0;
-	const uint64_t drain_tsc = (rte_get_tsc_hz() + US_PER_S - 1) /
-			US_PER_S * DRAIN_TX_PACKET_INTERVAL;
+	cmp_info = SPPWK_CONF_GET(mng_info->cmp_info);
+	if (unlikely(cmp_info == NULL)) {
+		/* Not to keep packets of ports of stopped classifier. */
+		transmit_all_packet(mng_info);
+		return SPPWK_RET_OK;
+	}
 
-	/* change index of update classifier management information */
-	change_classifier_index(mng_info, comp_id);
+	/* Change TX buffers if classifier info of new ports is published. */
+	if (unlikely(mng_info->cur_ver != cmp_info->conf_ver))
+		change_classifier_ports(mng_info, cmp_info);
 
-	cmp_info = mng_info->comp_list + mng_info->ref_index;
 	clsd_data_rx = &cmp_info->rx_port_i;
-	clsd_data_tx = cmp_info->tx_ports_i;
 
-	/* Check if it is ready to do classifying. */
-	if (!(clsd_data_rx->iface_type != UNDEF &&
-			cmp_info->nof_tx_ports >= 1 &&
-			cmp_info->mac_addr_entry == 1))
-		return SPPWK_RET_OK;
+	/**
+	 * Member of a group classifies with the table of the first
+	 * classifier, and sends packets to its own TX port of the same index.
+	 */
+	tbl_info = cmp_info;
+	grp_mng = __atomic_load_n(&mng_info->grp_mng, __ATOMIC_ACQUIRE);
+	if (grp_mng != NULL)
+		tbl_info = SPPWK_CONF_GET(grp_mng->cmp_info);
 
 	cur_tsc = rte_rdtsc();
-	if (unlikely(cur_tsc - prev_tsc > drain_tsc)) {
-		for (i = 0; i < cmp_info->nof_tx_ports; i++) {
-			if (likely(clsd_data_tx[i].nof_pkts == 0))
-				continue;
 
-			RTE_LOG(DEBUG, VF_CLS,
-					"transmit packets (drain). index=%d, "
-					"nof_pkts=%hu, interval=%lu\n",
-					i, clsd_data_tx[i].nof_pkts,
-					cur_tsc - prev_tsc);
-				transmit_packets(&clsd_data_tx[i]);
+	/* Check if it is ready to do classifying. */
+	if (clsd_data_rx->iface_type != UNDEF && tbl_info != NULL &&
+			mng_info->nof_tx_ports >= 1 &&
+			mng_info->nof_tx_ports >= tbl_info->nof_tx_ports &&
+			(tbl_info->mac_addr_entry == 1 ||
+			tbl_info->acl != NULL)) {
+		/* Retrieve packets */
+		n_rx = sppwk_eth_vlan_rx_burst(clsd_data_rx->ethdev_port_id,
+				clsd_data_rx->queue_no, rx_pkts, MAX_PKT_BURST);
+		if (n_rx != 0)
+			_classify_packets(rx_pkts, n_rx, tbl_info,
+					mng_info->tx_bufs, cur_tsc);
+
+		/* Receive packets steered with rules of flow offload. */
+		for (i = 0; i < cmp_info->nof_flow_rx &&
+				i < tbl_info->nof_tx_ports; i++) {
+			n_rx = sppwk_eth_vlan_rx_burst(
+					clsd_data_rx->ethdev_port_id,
+					cmp_info->flow_rx_queues[i],
+					rx_pkts, MAX_PKT_BURST);
+			if (n_rx != 0)
+				classify_flow_packets(rx_pkts, n_rx, i,
+						&tbl_info->tx_ports_i[i],
+						tbl_info, mng_info->tx_bufs,
+						cur_tsc);
 		}
-		prev_tsc = cur_tsc;
 	}
 
-	if (clsd_data_rx->iface_type == UNDEF)
-		return SPPWK_RET_OK;
-
-	/* Retrieve packets */
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
-	n_rx = sppwk_eth_vlan_ring_stats_rx_burst(clsd_data_rx->ethdev_port_id,
-			clsd_data_rx->iface_type, clsd_data_rx->iface_no,
-			0, rx_pkts, MAX_PKT_BURST);
-#else
-	n_rx = sppwk_eth_vlan_rx_burst(clsd_data_rx->ethdev_port_id,
-			clsd_data_rx->queue_no, rx_pkts, MAX_PKT_BURST);
-#endif
-	if (unlikely(n_rx == 0))
-		return SPPWK_RET_OK;
-
-	_classify_packets(rx_pkts, n_rx, cmp_info, clsd_data_tx);
+	/**
+	 * Send packets waiting longer than flush latency budget even if
+	 * not ready for receiving.
+	 */
+	for (i = 0; i < mng_info->nof_tx_ports; i++)
+		sppwk_tx_buf_drain(&mng_info->tx_bufs[i], cur_tsc);
 
 	return SPPWK_RET_OK;
 }
 
+/* Transmit all packets in TX buffers of classifier. */
+void
+flush_classifier(int comp_id)
+{
+	transmit_all_packet(cls_mng_info_list + comp_id);
+}
+
 /* classifier iterate component information */
 int
 get_classifier_status(unsigned int lcore_id, int id,
@@ -787,6 +1495,7 @@ get_classifier_status(unsigned int lcore_id, int id,
 	struct cls_port_info *port_info;
 	struct sppwk_port_idx rx_ports[RTE_MAX_QUEUES_PER_PORT];
 	struct sppwk_port_idx tx_ports[RTE_MAX_QUEUES_PER_PORT];
+	struct sppwk_tx_coal_stats tx_stats;
 
 	mng_info = cls_mng_info_list + id;
 	if (!is_used_mng_info(mng_info)) {
@@ -797,7 +1506,7 @@ get_classifier_status(unsigned int lcore_id, int id,
 		return SPPWK_RET_NG;
 	}
 
-	cmp_info = mng_info->comp_list + mng_info->ref_index;
+	cmp_info = mng_info->cmp_info;
 	port_info = cmp_info->tx_ports_i;
 
 	memset(rx_ports, 0x00, sizeof(rx_ports));
@@ -808,6 +1517,13 @@ get_classifier_status(unsigned int lcore_id, int id,
 		rx_ports[0].queue_no = cmp_info->rx_port_i.queue_no;
 	}
 
+	/* RX queues for flow offload are of the same phy port. */
+	for (i = 0; i < cmp_info->nof_flow_rx; i++) {
+		rx_ports[nof_rx].iface_type = PHY;
+		rx_ports[nof_rx].iface_no = cmp_info->rx_port_i.iface_no_global;
+		rx_ports[nof_rx++].queue_no = cmp_info->flow_rx_queues[i];
+	}
+
 	memset(tx_ports, 0x00, sizeof(tx_ports));
 	nof_tx = cmp_info->nof_tx_ports;
 	for (i = 0; i < nof_tx; i++) {
@@ -816,75 +1532,99 @@ get_classifier_status(unsigned int lcore_id, int id,
 		tx_ports[i].queue_no = port_info[i].queue_no;
 	}
 
+	/* Counters are read without locking as they are only shown. */
+	memset(&tx_stats, 0x00, sizeof(tx_stats));
+	for (i = 0; i < RTE_MAX_QUEUES_PER_PORT; i++)
+		sppwk_tx_buf_add_stats(&tx_stats, &mng_info->tx_bufs[i]);
+
 	/* Set the information with the function specified by the command. */
 	ret = (*lcore_params->lcore_proc)(
 		lcore_params, lcore_id, cmp_info->name, SPPWK_TYPE_CLS_STR,
-		nof_rx, rx_ports, nof_tx, tx_ports);
+		nof_rx, rx_ports, nof_tx, tx_ports, &tx_stats);
 	if (unlikely(ret != SPPWK_RET_OK))
 		return SPPWK_RET_NG;
 
 	return SPPWK_RET_OK;
 }
 
-/* Add MAC addresses in classifier table for `status` command. */
+/* Get type of classification from VID for `status` command. */
+static inline enum sppwk_cls_type
+get_cls_type(uint16_t vid)
+{
+	if (unlikely(vid == VLAN_UNTAGGED_VID))
+		return SPPWK_CLS_TYPE_MAC;
+	return SPPWK_CLS_TYPE_VLAN;
+}
+
+/* Add default entry of a VLAN in classifier table for `status` command. */
 static void
-add_mac_entry(struct classifier_table_params *params,
+add_default_entry(struct classifier_table_params *params,
 		uint16_t vid,
 		struct mac_classifier *mac_cls,
 		__rte_unused struct cls_comp_info *cmp_info,
 		struct cls_port_info *port_info)
+{
+	struct sppwk_port_idx port;
+
+	if (mac_cls->default_cls_idx < 0)
+		return;
+
+	port.iface_type = (port_info + mac_cls->default_cls_idx)->iface_type;
+	port.iface_no = (port_info +
+			mac_cls->default_cls_idx)->iface_no_global;
+	port.queue_no = (port_info + mac_cls->default_cls_idx)->queue_no;
+
+	LOG_ENT((long)mac_cls->default_cls_idx, vid,
+			SPPWK_TERM_DEFAULT, cmp_info, port_info);
+	/**
+	 * Append "default" entry. `tbl_proc` is funciton pointer to
+	 * append_classifier_element_value().
+	 */
+	(*params->tbl_proc)(params, get_cls_type(vid), vid,
+			SPPWK_TERM_DEFAULT, &port);
+}
+
+/* Add MAC addresses in classifier table for `status` command. */
+static void
+add_mac_entry(struct classifier_table_params *params,
+		struct cls_comp_info *cmp_info,
+		struct cls_port_info *port_info)
 {
 	int ret;
 	const void *key;
+	const struct cls_tbl_key *tbl_key;
 	void *data;
 	uint32_t next;
 	struct sppwk_port_idx port;
 	char mac_addr_str[ETHER_ADDR_STR_BUF_SZ];
-	enum sppwk_cls_type cls_type;
 
-	cls_type = SPPWK_CLS_TYPE_VLAN;
-	if (unlikely(vid == VLAN_UNTAGGED_VID))
-		cls_type = SPPWK_CLS_TYPE_MAC;
-
-	if (mac_cls->default_cls_idx >= 0) {
-		port.iface_type = (port_info +
-				mac_cls->default_cls_idx)->iface_type;
-		port.iface_no = (port_info +
-				mac_cls->default_cls_idx)->iface_no_global;
-		port.queue_no = (port_info +
-				mac_cls->default_cls_idx)->queue_no;
-
-		LOG_ENT((long)mac_cls->default_cls_idx, vid,
-				SPPWK_TERM_DEFAULT, cmp_info, port_info);
-		/**
-		 * Append "default" entry. `tbl_proc` is funciton pointer to
-		 * append_classifier_element_value().
-		 */
-		(*params->tbl_proc)(params, cls_type, vid,
-				SPPWK_TERM_DEFAULT, &port);
-	}
+	if (cmp_info->cls_tbl == NULL)
+		return;
 
 	next = 0;
 	while (1) {
-		ret = rte_hash_iterate(mac_cls->cls_tbl, &key, &data, &next);
+		ret = rte_hash_iterate(cmp_info->cls_tbl, &key, &data, &next);
 
 		if (unlikely(ret < 0))
 			break;
 
+		tbl_key = (const struct cls_tbl_key *)key;
 		rte_ether_format_addr(mac_addr_str, sizeof(mac_addr_str),
-				(const struct rte_ether_addr *)key);
+				&tbl_key->addr);
 
 		port.iface_type = (port_info + (long)data)->iface_type;
 		port.iface_no = (port_info + (long)data)->iface_no_global;
 		port.queue_no = (port_info + (long)data)->queue_no;
 
-		LOG_ENT((long)data, vid, mac_addr_str, cmp_info, port_info);
+		LOG_ENT((long)data, tbl_key->vid, mac_addr_str, cmp_info,
+				port_info);
 
 		/**
 		 * Append each entry of MAC address. `tbl_proc` is function
 		 * pointer to append_classifier_element_value().
 		 */
-		(*params->tbl_proc)(params, cls_type, vid, mac_addr_str, &port);
+		(*params->tbl_proc)(params, get_cls_type(tbl_key->vid),
+				tbl_key->vid, mac_addr_str, &port);
 	}
 }
 
@@ -902,7 +1642,11 @@ _add_classifier_table(struct classifier_table_params *params)
 		if (!is_used_mng_info(mng_info))
 			continue;
 
-		cmp_info = mng_info->comp_list + mng_info->ref_index;
+		/* Members of a group do not refer their own table. */
+		if (mng_info->grp_mng != NULL)
+			continue;
+
+		cmp_info = mng_info->cmp_info;
 		port_info = cmp_info->tx_ports_i;
 
 		RTE_LOG(DEBUG, VF_CLS,
@@ -912,12 +1656,17 @@ _add_classifier_table(struct classifier_table_params *params)
 			if (cmp_info->mac_clfs[vlan_id] == NULL)
 				continue;
 
-			add_mac_entry(params, (uint16_t) vlan_id,
+			add_default_entry(params, (uint16_t) vlan_id,
 					cmp_info->mac_clfs[vlan_id], cmp_info,
 					port_info);
 		}
+
+		add_mac_entry(params, cmp_info, port_info);
 	}
 
+	/* ACL rules are shown even if the port is not used in classifier. */
+	add_cls_acl_entries(params);
+
 	return SPPWK_RET_OK;
 }
 
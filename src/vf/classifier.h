@@ -15,8 +15,17 @@
  * one port to one port. Classifier has table of virtual MAC address.
  * According to this table, classifier lookups L2 destination MAC address
  * and determines which port to be transferred to incoming packets.
+ * 5-tuple ACL rules can be also registered to be matched before MAC address.
+ * Several classifiers, for example on each of RX queues of a port, can be
+ * grouped to share one table updated only once.
  */
 
+/* Default max num of entries of classifier table of each of classifiers. */
+#define DEFAULT_NOF_CLS_TABLE_ENTRIES 16384
+
+/** Value for default MAC address of classifier */
+#define CLS_DUMMY_ADDR 0x010000000000
+
 struct classifier_table_params;
 /**
  * Define func to iterate classifier for showing status or so, as a member
@@ -60,10 +69,11 @@ int add_classifier_table(const char *name, char **output,
 /**
  * classifier(mac address) initialize globals.
  *
+ * @param nof_tbl_entries Max num of entries of classifier table.
  * @retval SPPWK_RET_OK succeeded.
  * @retval SPPWK_RET_NG failed.
  */
-int init_cls_mng_info(void);
+int init_cls_mng_info(uint32_t nof_tbl_entries);
 
 /**
  * initialize classifier information.
@@ -84,6 +94,14 @@ void init_classifier_info(int comp_id);
  */
 int classify_packets(int comp_id);
 
+/**
+ * Transmit all packets in TX buffers of classifier. It is called from
+ * worker thread when the classifier is stopped or the thread exits.
+ *
+ * @param comp_id Component ID.
+ */
+void flush_classifier(int comp_id);
+
 /**
  * Get classifier status.
  *
@@ -0,0 +1,751 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#include <unistd.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include <rte_acl.h>
+#include <rte_ether.h>
+#include <rte_ip.h>
+#include <rte_log.h>
+#include <rte_malloc.h>
+#include <rte_byteorder.h>
+
+#include "classifier_acl.h"
+#include "shared/secondary/return_codes.h"
+
+#define RTE_LOGTYPE_VF_CLS_ACL RTE_LOGTYPE_USER1
+
+/* Length of source and destination ports following IP header. */
+#define CLS_ACL_L4_PORTS_LEN 4
+
+/* Version and header length of IPv4 header without options. */
+#define CLS_ACL_IPV4_VHL 0x45
+
+/* Kind of input of ACL for a packet. */
+enum cls_acl_input {
+	CLS_ACL_IN_NONE,  /* Not matched, such as non-IP. */
+	CLS_ACL_IN_IPV4,  /* IPv4 of which L4 ports are at fixed offset. */
+	CLS_ACL_IN_IPV4_L3,  /* IPv4 matched with L3 fields only. */
+	CLS_ACL_IN_IPV6,  /* IPv6 */
+};
+
+/**
+ * Fields of IPv4 rule. Input of ACL starts from protocol of IP header
+ * because the first field must be one byte.
+ */
+enum {
+	CLS_ACL4_PROTO,
+	CLS_ACL4_SRC,
+	CLS_ACL4_DST,
+	CLS_ACL4_SPORT,
+	CLS_ACL4_DPORT,
+	NOF_CLS_ACL4_FIELDS,
+};
+
+/* Offset of field of IPv4 header from protocol. */
+#define CLS_ACL4_OFS(field) (offsetof(struct rte_ipv4_hdr, field) - \
+		offsetof(struct rte_ipv4_hdr, next_proto_id))
+
+static const struct rte_acl_field_def cls_acl4_defs[NOF_CLS_ACL4_FIELDS] = {
+	{
+		.type = RTE_ACL_FIELD_TYPE_BITMASK,
+		.size = sizeof(uint8_t),
+		.field_index = CLS_ACL4_PROTO,
+		.input_index = 0,
+		.offset = 0,
+	},
+	{
+		.type = RTE_ACL_FIELD_TYPE_MASK,
+		.size = sizeof(uint32_t),
+		.field_index = CLS_ACL4_SRC,
+		.input_index = 1,
+		.offset = CLS_ACL4_OFS(src_addr),
+	},
+	{
+		.type = RTE_ACL_FIELD_TYPE_MASK,
+		.size = sizeof(uint32_t),
+		.field_index = CLS_ACL4_DST,
+		.input_index = 2,
+		.offset = CLS_ACL4_OFS(dst_addr),
+	},
+	{
+		.type = RTE_ACL_FIELD_TYPE_RANGE,
+		.size = sizeof(uint16_t),
+		.field_index = CLS_ACL4_SPORT,
+		.input_index = 3,
+		.offset = CLS_ACL4_OFS(dst_addr) + sizeof(uint32_t),
+	},
+	{
+		.type = RTE_ACL_FIELD_TYPE_RANGE,
+		.size = sizeof(uint16_t),
+		.field_index = CLS_ACL4_DPORT,
+		.input_index = 3,
+		.offset = CLS_ACL4_OFS(dst_addr) + sizeof(uint32_t) +
+			sizeof(uint16_t),
+	},
+};
+
+/* Fields of IPv6 rule. Each of addresses is divided into four words. */
+enum {
+	CLS_ACL6_PROTO,
+	CLS_ACL6_SRC0,
+	CLS_ACL6_SRC1,
+	CLS_ACL6_SRC2,
+	CLS_ACL6_SRC3,
+	CLS_ACL6_DST0,
+	CLS_ACL6_DST1,
+	CLS_ACL6_DST2,
+	CLS_ACL6_DST3,
+	CLS_ACL6_SPORT,
+	CLS_ACL6_DPORT,
+	NOF_CLS_ACL6_FIELDS,
+};
+
+/* Offset of field of IPv6 header from protocol. */
+#define CLS_ACL6_OFS(field) (offsetof(struct rte_ipv6_hdr, field) - \
+		offsetof(struct rte_ipv6_hdr, proto))
+
+#define CLS_ACL6_ADDR_DEF(idx, field, word) {		\
+		.type = RTE_ACL_FIELD_TYPE_MASK,	\
+		.size = sizeof(uint32_t),		\
+		.field_index = (idx),			\
+		.input_index = (idx),			\
+		.offset = CLS_ACL6_OFS(field) +		\
+			sizeof(uint32_t) * (word),	\
+	}
+
+static const struct rte_acl_field_def cls_acl6_defs[NOF_CLS_ACL6_FIELDS] = {
+	{
+		.type = RTE_ACL_FIELD_TYPE_BITMASK,
+		.size = sizeof(uint8_t),
+		.field_index = CLS_ACL6_PROTO,
+		.input_index = CLS_ACL6_PROTO,
+		.offset = 0,
+	},
+	CLS_ACL6_ADDR_DEF(CLS_ACL6_SRC0, src_addr, 0),
+	CLS_ACL6_ADDR_DEF(CLS_ACL6_SRC1, src_addr, 1),
+	CLS_ACL6_ADDR_DEF(CLS_ACL6_SRC2, src_addr, 2),
+	CLS_ACL6_ADDR_DEF(CLS_ACL6_SRC3, src_addr, 3),
+	CLS_ACL6_ADDR_DEF(CLS_ACL6_DST0, dst_addr, 0),
+	CLS_ACL6_ADDR_DEF(CLS_ACL6_DST1, dst_addr, 1),
+	CLS_ACL6_ADDR_DEF(CLS_ACL6_DST2, dst_addr, 2),
+	CLS_ACL6_ADDR_DEF(CLS_ACL6_DST3, dst_addr, 3),
+	{
+		.type = RTE_ACL_FIELD_TYPE_RANGE,
+		.size = sizeof(uint16_t),
+		.field_index = CLS_ACL6_SPORT,
+		.input_index = CLS_ACL6_SPORT,
+		.offset = sizeof(struct rte_ipv6_hdr) -
+			offsetof(struct rte_ipv6_hdr, proto),
+	},
+	{
+		.type = RTE_ACL_FIELD_TYPE_RANGE,
+		.size = sizeof(uint16_t),
+		.field_index = CLS_ACL6_DPORT,
+		.input_index = CLS_ACL6_SPORT,
+		.offset = sizeof(struct rte_ipv6_hdr) -
+			offsetof(struct rte_ipv6_hdr, proto) +
+			sizeof(uint16_t),
+	},
+};
+
+RTE_ACL_RULE_DEF(cls_acl4_rule, NOF_CLS_ACL4_FIELDS);
+RTE_ACL_RULE_DEF(cls_acl6_rule, NOF_CLS_ACL6_FIELDS);
+
+/* Compiled ACL of a classifier. */
+struct cls_acl {
+	struct rte_acl_ctx *ctx4;  /* Context of IPv4 rules, or NULL. */
+	/* Context of IPv4 rules of any L4 ports, or NULL. */
+	struct rte_acl_ctx *ctx4_l3;
+	struct rte_acl_ctx *ctx6;  /* Context of IPv6 rules, or NULL. */
+};
+
+/* ACL rule and its destination port. */
+struct cls_acl_entry {
+	struct sppwk_cls_acl_rule rule;
+	struct sppwk_port_idx port;
+};
+
+/**
+ * ACL rules in the order of adding, referred only from master. Rules added
+ * earlier have higher priority.
+ */
+static struct cls_acl_entry g_acl_ents[CLS_ACL_MAX_RULES];
+static int g_nof_acl_ents;
+static unsigned int g_acl_rules_ver;
+
+/* Count of ACL contexts for making unique name. */
+static unsigned int g_acl_ctx_count;
+
+/* Check if given entry is the same as rule and port. */
+static inline int
+is_same_acl_entry(const struct cls_acl_entry *ent,
+		const struct sppwk_cls_acl_rule *rule,
+		const struct sppwk_port_idx *port)
+{
+	return memcmp(&ent->rule, rule, sizeof(*rule)) == 0 &&
+		ent->port.iface_type == port->iface_type &&
+		ent->port.iface_no == port->iface_no &&
+		ent->port.queue_no == port->queue_no;
+}
+
+/* Add or delete ACL rule of given port. */
+int
+update_cls_acl_rules(enum sppwk_action wk_action,
+		const struct sppwk_cls_acl_rule *rule,
+		const struct sppwk_port_idx *port)
+{
+	int i;
+
+	for (i = 0; i < g_nof_acl_ents; i++) {
+		if (wk_action == SPPWK_ACT_ADD &&
+				memcmp(&g_acl_ents[i].rule, rule,
+				sizeof(*rule)) == 0) {
+			RTE_LOG(ERR, VF_CLS_ACL,
+					"ACL rule is already added.\n");
+			return SPPWK_RET_NG;
+		}
+		if (wk_action == SPPWK_ACT_DEL &&
+				is_same_acl_entry(&g_acl_ents[i], rule, port))
+			break;
+	}
+
+	if (wk_action == SPPWK_ACT_ADD) {
+		if (unlikely(g_nof_acl_ents >= CLS_ACL_MAX_RULES)) {
+			RTE_LOG(ERR, VF_CLS_ACL, "No space for ACL rule.\n");
+			return SPPWK_RET_NG;
+		}
+		g_acl_ents[g_nof_acl_ents].rule = *rule;
+		g_acl_ents[g_nof_acl_ents].port = *port;
+		g_nof_acl_ents++;
+	} else if (wk_action == SPPWK_ACT_DEL) {
+		if (unlikely(i == g_nof_acl_ents)) {
+			RTE_LOG(ERR, VF_CLS_ACL, "No such ACL rule.\n");
+			return SPPWK_RET_NG;
+		}
+		/* Keep the order of rules for priority. */
+		memmove(&g_acl_ents[i], &g_acl_ents[i + 1],
+				sizeof(struct cls_acl_entry) *
+				(g_nof_acl_ents - i - 1));
+		g_nof_acl_ents--;
+	} else
+		return SPPWK_RET_NG;
+
+	g_acl_rules_ver++;
+	return SPPWK_RET_OK;
+}
+
+/* Get version of ACL rules. */
+unsigned int
+get_cls_acl_rules_ver(void)
+{
+	return g_acl_rules_ver;
+}
+
+/* Get index of TX port of classifier for given port, or -1 if not found. */
+static int
+get_cls_tx_index(const struct cls_comp_info *cmp_info,
+		const struct sppwk_port_idx *port)
+{
+	int i;
+	const struct cls_port_info *tx_port_i;
+
+	for (i = 0; i < cmp_info->nof_tx_ports; i++) {
+		tx_port_i = &cmp_info->tx_ports_i[i];
+		if (tx_port_i->iface_type == port->iface_type &&
+				tx_port_i->iface_no_global == port->iface_no &&
+				tx_port_i->queue_no == port->queue_no)
+			return i;
+	}
+	return -1;
+}
+
+/* Get a word of address in host byte order for ACL field. */
+static inline uint32_t
+get_addr_word(const uint8_t *addr, int word)
+{
+	uint32_t val;
+
+	memcpy(&val, addr + sizeof(uint32_t) * word, sizeof(val));
+	return rte_be_to_cpu_32(val);
+}
+
+/* Get prefix length of a word of address for ACL field. */
+static inline uint32_t
+get_plen_of_word(uint8_t plen, int word)
+{
+	int bits = (int)plen - 32 * word;
+
+	return (uint32_t)RTE_MAX(0, RTE_MIN(bits, 32));
+}
+
+/* Set data of ACL rule common among IPv4 and IPv6. */
+static inline void
+set_acl_rule_data(struct rte_acl_rule_data *data, int prio, int tx_idx)
+{
+	data->category_mask = 1;
+	data->priority = RTE_ACL_MAX_PRIORITY - prio;
+	/* Userdata 0 is reserved for no match. */
+	data->userdata = (uint32_t)tx_idx + 1;
+}
+
+/* Check if ACL rule matches any of L4 ports. */
+static inline int
+is_acl_rule_l3(const struct sppwk_cls_acl_rule *rule)
+{
+	return rule->src_port_lo == 0 && rule->src_port_hi == UINT16_MAX &&
+		rule->dst_port_lo == 0 && rule->dst_port_hi == UINT16_MAX;
+}
+
+/* Set IPv4 rule of ACL from 5-tuple. */
+static void
+set_acl4_rule(struct cls_acl4_rule *acl_rule,
+		const struct sppwk_cls_acl_rule *rule, int prio, int tx_idx)
+{
+	struct rte_acl_field *field = acl_rule->field;
+
+	set_acl_rule_data(&acl_rule->data, prio, tx_idx);
+	field[CLS_ACL4_PROTO].value.u8 = rule->proto;
+	field[CLS_ACL4_PROTO].mask_range.u8 = rule->proto_mask;
+	field[CLS_ACL4_SRC].value.u32 = get_addr_word(rule->src_addr, 0);
+	field[CLS_ACL4_SRC].mask_range.u32 = rule->src_plen;
+	field[CLS_ACL4_DST].value.u32 = get_addr_word(rule->dst_addr, 0);
+	field[CLS_ACL4_DST].mask_range.u32 = rule->dst_plen;
+	field[CLS_ACL4_SPORT].value.u16 = rule->src_port_lo;
+	field[CLS_ACL4_SPORT].mask_range.u16 = rule->src_port_hi;
+	field[CLS_ACL4_DPORT].value.u16 = rule->dst_port_lo;
+	field[CLS_ACL4_DPORT].mask_range.u16 = rule->dst_port_hi;
+}
+
+/* Set IPv6 rule of ACL from 5-tuple. */
+static void
+set_acl6_rule(struct cls_acl6_rule *acl_rule,
+		const struct sppwk_cls_acl_rule *rule, int prio, int tx_idx)
+{
+	int i;
+	struct rte_acl_field *field = acl_rule->field;
+
+	set_acl_rule_data(&acl_rule->data, prio, tx_idx);
+	field[CLS_ACL6_PROTO].value.u8 = rule->proto;
+	field[CLS_ACL6_PROTO].mask_range.u8 = rule->proto_mask;
+	for (i = 0; i < 4; i++) {
+		field[CLS_ACL6_SRC0 + i].value.u32 =
+				get_addr_word(rule->src_addr, i);
+		field[CLS_ACL6_SRC0 + i].mask_range.u32 =
+				get_plen_of_word(rule->src_plen, i);
+		field[CLS_ACL6_DST0 + i].value.u32 =
+				get_addr_word(rule->dst_addr, i);
+		field[CLS_ACL6_DST0 + i].mask_range.u32 =
+				get_plen_of_word(rule->dst_plen, i);
+	}
+	field[CLS_ACL6_SPORT].value.u16 = rule->src_port_lo;
+	field[CLS_ACL6_SPORT].mask_range.u16 = rule->src_port_hi;
+	field[CLS_ACL6_DPORT].value.u16 = rule->dst_port_lo;
+	field[CLS_ACL6_DPORT].mask_range.u16 = rule->dst_port_hi;
+}
+
+/* Create ACL context and compile given rules. */
+static struct rte_acl_ctx *
+create_acl_ctx(int ip_ver, const struct rte_acl_field_def *defs,
+		uint32_t nof_fields, const void *rules, uint32_t nof_rules)
+{
+	int ret;
+	struct rte_acl_ctx *ctx;
+	struct rte_acl_param param;
+	struct rte_acl_config cfg;
+	char name[RTE_ACL_NAMESIZE];
+
+	/* Name must be unique because existing context is returned. */
+	snprintf(name, sizeof(name), "clacl%d_%07x_%u", ip_ver, getpid(),
+			g_acl_ctx_count++);
+
+	memset(&param, 0x00, sizeof(param));
+	param.name = name;
+	param.socket_id = SOCKET_ID_ANY;
+	param.rule_size = RTE_ACL_RULE_SZ(nof_fields);
+	param.max_rule_num = nof_rules;
+
+	ctx = rte_acl_create(&param);
+	if (unlikely(ctx == NULL)) {
+		RTE_LOG(ERR, VF_CLS_ACL, "Cannot create ACL `%s`.\n", name);
+		return NULL;
+	}
+
+	ret = rte_acl_add_rules(ctx, rules, nof_rules);
+	if (unlikely(ret != 0)) {
+		RTE_LOG(ERR, VF_CLS_ACL, "Cannot add rules to ACL `%s`, "
+				"ret=%d.\n", name, ret);
+		rte_acl_free(ctx);
+		return NULL;
+	}
+
+	memset(&cfg, 0x00, sizeof(cfg));
+	cfg.num_categories = 1;
+	cfg.num_fields = nof_fields;
+	memcpy(cfg.defs, defs, sizeof(struct rte_acl_field_def) * nof_fields);
+
+	ret = rte_acl_build(ctx, &cfg);
+	if (unlikely(ret != 0)) {
+		RTE_LOG(ERR, VF_CLS_ACL, "Cannot build ACL `%s`, ret=%d.\n",
+				name, ret);
+		rte_acl_free(ctx);
+		return NULL;
+	}
+
+	RTE_LOG(INFO, VF_CLS_ACL, "Build ACL `%s` of %u rules.\n",
+			name, nof_rules);
+	return ctx;
+}
+
+/**
+ * Create ACL of contexts of IPv4 and IPv6 rules, and IPv4 rules of any L4
+ * ports for packets of which ports are not at fixed offset.
+ */
+static struct cls_acl *
+build_cls_acl(const struct cls_acl4_rule *rules4, uint32_t nof_rules4,
+		const struct cls_acl4_rule *rules4_l3, uint32_t nof_rules4_l3,
+		const struct cls_acl6_rule *rules6, uint32_t nof_rules6)
+{
+	struct cls_acl *acl;
+
+	acl = rte_zmalloc(NULL, sizeof(*acl), 0);
+	if (unlikely(acl == NULL)) {
+		RTE_LOG(ERR, VF_CLS_ACL, "Cannot allocate ACL.\n");
+		return NULL;
+	}
+
+	if (nof_rules4 != 0) {
+		acl->ctx4 = create_acl_ctx(4, cls_acl4_defs,
+				NOF_CLS_ACL4_FIELDS, rules4, nof_rules4);
+		if (unlikely(acl->ctx4 == NULL)) {
+			free_cls_acl(acl);
+			return NULL;
+		}
+	}
+
+	if (nof_rules4_l3 != 0) {
+		acl->ctx4_l3 = create_acl_ctx(4, cls_acl4_defs,
+				NOF_CLS_ACL4_FIELDS, rules4_l3,
+				nof_rules4_l3);
+		if (unlikely(acl->ctx4_l3 == NULL)) {
+			free_cls_acl(acl);
+			return NULL;
+		}
+	}
+
+	if (nof_rules6 != 0) {
+		acl->ctx6 = create_acl_ctx(6, cls_acl6_defs,
+				NOF_CLS_ACL6_FIELDS, rules6, nof_rules6);
+		if (unlikely(acl->ctx6 == NULL)) {
+			free_cls_acl(acl);
+			return NULL;
+		}
+	}
+
+	return acl;
+}
+
+/* Compile ACL of rules of TX ports of given classifier. */
+int
+create_cls_acl(const struct cls_comp_info *cmp_info, struct cls_acl **acl)
+{
+	int i;
+	int tx_idx;
+	int ret = SPPWK_RET_OK;
+	uint32_t nof_rules4 = 0, nof_rules4_l3 = 0, nof_rules6 = 0;
+	const struct sppwk_cls_acl_rule *rule;
+	struct cls_acl4_rule *rules4 = NULL;
+	struct cls_acl4_rule *rules4_l3 = NULL;
+	struct cls_acl6_rule *rules6 = NULL;
+
+	*acl = NULL;
+	if (g_nof_acl_ents == 0)
+		return SPPWK_RET_OK;
+
+	rules4 = rte_zmalloc(NULL, sizeof(*rules4) * g_nof_acl_ents, 0);
+	rules4_l3 = rte_zmalloc(NULL, sizeof(*rules4_l3) * g_nof_acl_ents, 0);
+	rules6 = rte_zmalloc(NULL, sizeof(*rules6) * g_nof_acl_ents, 0);
+	if (unlikely(rules4 == NULL || rules4_l3 == NULL || rules6 == NULL)) {
+		RTE_LOG(ERR, VF_CLS_ACL, "Cannot allocate ACL rules.\n");
+		rte_free(rules4);
+		rte_free(rules4_l3);
+		rte_free(rules6);
+		return SPPWK_RET_NG;
+	}
+
+	/* Rule of which both of addresses are any is added to both. */
+	for (i = 0; i < g_nof_acl_ents; i++) {
+		tx_idx = get_cls_tx_index(cmp_info, &g_acl_ents[i].port);
+		if (tx_idx < 0)
+			continue;
+
+		rule = &g_acl_ents[i].rule;
+		if (rule->ip_ver != 6)
+			set_acl4_rule(&rules4[nof_rules4++], rule, i, tx_idx);
+		if (rule->ip_ver != 6 && is_acl_rule_l3(rule))
+			set_acl4_rule(&rules4_l3[nof_rules4_l3++], rule, i,
+					tx_idx);
+		if (rule->ip_ver != 4)
+			set_acl6_rule(&rules6[nof_rules6++], rule, i, tx_idx);
+	}
+
+	if (nof_rules4 != 0 || nof_rules6 != 0) {
+		*acl = build_cls_acl(rules4, nof_rules4, rules4_l3,
+				nof_rules4_l3, rules6, nof_rules6);
+		if (unlikely(*acl == NULL))
+			ret = SPPWK_RET_NG;
+	}
+
+	rte_free(rules4);
+	rte_free(rules4_l3);
+	rte_free(rules6);
+	return ret;
+}
+
+/* Release compiled ACL. */
+void
+free_cls_acl(struct cls_acl *acl)
+{
+	if (acl == NULL)
+		return;
+
+	rte_acl_free(acl->ctx4);
+	rte_acl_free(acl->ctx4_l3);
+	rte_acl_free(acl->ctx6);
+	rte_free(acl);
+}
+
+/**
+ * Get kind of input of ACL for packet and pointer to it. IPv4 with options
+ * or non-first fragment is matched with L3 fields only because L4 ports are
+ * not placed at fixed offset.
+ *
+ * L4 ports of IPv6 are referred just after the fixed header, so that IPv6
+ * with extension headers is not matched with rules of L4 ports. Rules of
+ * ports are only for tcp, udp or sctp which is not the next header of it.
+ */
+static inline enum cls_acl_input
+get_acl_input(const struct rte_mbuf *pkt, const uint8_t **data)
+{
+	uint16_t ether_type;
+	uint32_t l3_ofs = sizeof(struct rte_ether_hdr);
+	const struct rte_ether_hdr *eth;
+	const struct rte_vlan_hdr *vh;
+	const struct rte_ipv4_hdr *ipv4;
+	const struct rte_ipv6_hdr *ipv6;
+
+	eth = rte_pktmbuf_mtod(pkt, const struct rte_ether_hdr *);
+	ether_type = eth->ether_type;
+	if (ether_type == rte_cpu_to_be_16(RTE_ETHER_TYPE_VLAN)) {
+		vh = (const struct rte_vlan_hdr *)(eth + 1);
+		ether_type = vh->eth_proto;
+		l3_ofs += sizeof(struct rte_vlan_hdr);
+	}
+
+	if (ether_type == rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV4)) {
+		if (unlikely(rte_pktmbuf_data_len(pkt) < l3_ofs +
+				sizeof(*ipv4) + CLS_ACL_L4_PORTS_LEN))
+			return CLS_ACL_IN_NONE;
+		ipv4 = rte_pktmbuf_mtod_offset(pkt,
+				const struct rte_ipv4_hdr *, l3_ofs);
+		*data = &ipv4->next_proto_id;
+		if (likely(ipv4->version_ihl == CLS_ACL_IPV4_VHL &&
+				(ipv4->fragment_offset & rte_cpu_to_be_16(
+				RTE_IPV4_HDR_OFFSET_MASK)) == 0))
+			return CLS_ACL_IN_IPV4;
+
+		/* Fixed header is valid even if L4 ports are not after it. */
+		if (unlikely((ipv4->version_ihl & ~RTE_IPV4_HDR_IHL_MASK) !=
+				(CLS_ACL_IPV4_VHL & ~RTE_IPV4_HDR_IHL_MASK) ||
+				(ipv4->version_ihl & RTE_IPV4_HDR_IHL_MASK) <
+				(CLS_ACL_IPV4_VHL & RTE_IPV4_HDR_IHL_MASK)))
+			return CLS_ACL_IN_NONE;
+		return CLS_ACL_IN_IPV4_L3;
+	}
+
+	if (ether_type == rte_cpu_to_be_16(RTE_ETHER_TYPE_IPV6)) {
+		if (unlikely(rte_pktmbuf_data_len(pkt) < l3_ofs +
+				sizeof(*ipv6) + CLS_ACL_L4_PORTS_LEN))
+			return CLS_ACL_IN_NONE;
+		ipv6 = rte_pktmbuf_mtod_offset(pkt,
+				const struct rte_ipv6_hdr *, l3_ofs);
+		*data = &ipv6->proto;
+		return CLS_ACL_IN_IPV6;
+	}
+
+	return CLS_ACL_IN_NONE;
+}
+
+/* Match a group of packets of the same IP version with ACL context. */
+static inline int
+classify_acl_grp(const struct rte_acl_ctx *ctx, const uint8_t **data,
+		const int *pos, int nof_pkts, int *clsd_idx)
+{
+	int i;
+	int nof_hits = 0;
+	uint32_t results[MAX_PKT_BURST];
+
+	if (nof_pkts == 0)
+		return 0;
+
+	rte_acl_classify(ctx, data, results, nof_pkts, 1);
+	for (i = 0; i < nof_pkts; i++) {
+		if (results[i] == 0)
+			continue;
+		clsd_idx[pos[i]] = (int)results[i] - 1;
+		nof_hits++;
+	}
+	return nof_hits;
+}
+
+/* Match packets with ACL rules. */
+int
+classify_cls_acl(const struct cls_acl *acl, struct rte_mbuf **pkts,
+		uint16_t nb_pkts, int *clsd_idx)
+{
+	int i;
+	int nof_pkts4 = 0, nof_pkts4_l3 = 0, nof_pkts6 = 0;
+	enum cls_acl_input input;
+	const uint8_t *data;
+	const uint8_t *data4[MAX_PKT_BURST], *data6[MAX_PKT_BURST];
+	const uint8_t *data4_l3[MAX_PKT_BURST];
+	int pos4[MAX_PKT_BURST], pos4_l3[MAX_PKT_BURST], pos6[MAX_PKT_BURST];
+
+	for (i = 0; i < nb_pkts; i++) {
+		clsd_idx[i] = -1;
+		input = get_acl_input(pkts[i], &data);
+		if (input == CLS_ACL_IN_IPV4 && acl->ctx4 != NULL) {
+			pos4[nof_pkts4] = i;
+			data4[nof_pkts4++] = data;
+		} else if (input == CLS_ACL_IN_IPV4_L3 &&
+				acl->ctx4_l3 != NULL) {
+			pos4_l3[nof_pkts4_l3] = i;
+			data4_l3[nof_pkts4_l3++] = data;
+		} else if (input == CLS_ACL_IN_IPV6 && acl->ctx6 != NULL) {
+			pos6[nof_pkts6] = i;
+			data6[nof_pkts6++] = data;
+		}
+	}
+
+	return classify_acl_grp(acl->ctx4, data4, pos4, nof_pkts4,
+			clsd_idx) +
+		classify_acl_grp(acl->ctx4_l3, data4_l3, pos4_l3,
+			nof_pkts4_l3, clsd_idx) +
+		classify_acl_grp(acl->ctx6, data6, pos6, nof_pkts6,
+			clsd_idx);
+}
+
+/* Format prefix of ACL rule for `status` command. */
+static void
+format_acl_prefix(char *buf, size_t bufsz, int ip_ver, const uint8_t *addr,
+		uint8_t plen)
+{
+	char addr_str[INET6_ADDRSTRLEN];
+
+	if (ip_ver == 0) {
+		snprintf(buf, bufsz, "any");
+		return;
+	}
+
+	inet_ntop(ip_ver == 4 ? AF_INET : AF_INET6, addr, addr_str,
+			sizeof(addr_str));
+	snprintf(buf, bufsz, "%s/%u", addr_str, plen);
+}
+
+/* Format range of L4 ports of ACL rule for `status` command. */
+static void
+format_acl_port_range(char *buf, size_t bufsz, uint16_t lo, uint16_t hi)
+{
+	if (lo == 0 && hi == UINT16_MAX)
+		snprintf(buf, bufsz, "any");
+	else if (lo == hi)
+		snprintf(buf, bufsz, "%u", lo);
+	else
+		snprintf(buf, bufsz, "%u-%u", lo, hi);
+}
+
+/* Format protocol of ACL rule for `status` command. */
+static void
+format_acl_proto(char *buf, size_t bufsz, uint8_t proto, uint8_t mask)
+{
+	if (mask == 0) {
+		snprintf(buf, bufsz, "any");
+		return;
+	}
+
+	switch (proto) {
+	case IPPROTO_TCP:
+		snprintf(buf, bufsz, "tcp");
+		break;
+	case IPPROTO_UDP:
+		snprintf(buf, bufsz, "udp");
+		break;
+	case IPPROTO_SCTP:
+		snprintf(buf, bufsz, "sctp");
+		break;
+	case IPPROTO_ICMP:
+		snprintf(buf, bufsz, "icmp");
+		break;
+	case IPPROTO_ICMPV6:
+		snprintf(buf, bufsz, "icmpv6");
+		break;
+	default:
+		snprintf(buf, bufsz, "%u", proto);
+		break;
+	}
+}
+
+/**
+ * Add ACL rules to classifier table for `status` command. Each of rules is
+ * formatted in the same order of params of `classifier_table` command.
+ */
+void
+add_cls_acl_entries(struct classifier_table_params *params)
+{
+	int i;
+	int src_ver, dst_ver;
+	const struct sppwk_cls_acl_rule *rule;
+	char src_str[INET6_ADDRSTRLEN + 4], dst_str[INET6_ADDRSTRLEN + 4];
+	char proto_str[8];
+	char sport_str[12], dport_str[12];
+	char rule_str[CLS_ACL_RULE_STR_BUFSZ];
+
+	for (i = 0; i < g_nof_acl_ents; i++) {
+		rule = &g_acl_ents[i].rule;
+
+		/**
+		 * Prefix of zero length is shown as `any`, but IP version is
+		 * kept by showing source if both of them are zero length.
+		 */
+		src_ver = rule->ip_ver;
+		dst_ver = rule->ip_ver;
+		if (rule->dst_plen == 0)
+			dst_ver = 0;
+		if (rule->src_plen == 0 && rule->dst_plen != 0)
+			src_ver = 0;
+
+		format_acl_prefix(src_str, sizeof(src_str), src_ver,
+				rule->src_addr, rule->src_plen);
+		format_acl_prefix(dst_str, sizeof(dst_str), dst_ver,
+				rule->dst_addr, rule->dst_plen);
+		format_acl_proto(proto_str, sizeof(proto_str), rule->proto,
+				rule->proto_mask);
+		format_acl_port_range(sport_str, sizeof(sport_str),
+				rule->src_port_lo, rule->src_port_hi);
+		format_acl_port_range(dport_str, sizeof(dport_str),
+				rule->dst_port_lo, rule->dst_port_hi);
+		snprintf(rule_str, sizeof(rule_str), "%s %s %s %s %s",
+				src_str, dst_str, proto_str, sport_str,
+				dport_str);
+
+		/**
+		 * `tbl_proc` is function pointer to
+		 * append_classifier_element_value().
+		 */
+		(*params->tbl_proc)(params, SPPWK_CLS_TYPE_ACL, 0, rule_str,
+				&g_acl_ents[i].port);
+	}
+}
@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#ifndef __CLASSIFIER_ACL_H__
+#define __CLASSIFIER_ACL_H__
+
+#include <rte_mbuf.h>
+#include "classifier.h"
+#include "shared/secondary/spp_worker_th/vf_deps.h"
+
+/**
+ * @file
+ * SPP Classifier with ACL
+ *
+ * ACL rules of 5-tuple, IPv4 or IPv6 prefixes of source and destination,
+ * protocol and ranges of L4 ports, are registered with a TX port of
+ * classifier. Rules are matched before MAC address in the order of adding,
+ * and packets not matched are classified with MAC address as usual.
+ *
+ * ACL contexts are compiled for each of classifiers from the rules of its
+ * TX ports in master, and replaced with old ones without stopping
+ * classifier thread.
+ */
+
+/* Max num of ACL rules of classifier. */
+#define CLS_ACL_MAX_RULES 1024
+
+/* Size of string of ACL rule for `status` command. */
+#define CLS_ACL_RULE_STR_BUFSZ 160
+
+/**
+ * Add or delete ACL rule of given port. Classifier of the port is updated
+ * in next flush.
+ *
+ * @param wk_action Action, add or del.
+ * @param rule 5-tuple rule.
+ * @param port Destination TX port.
+ * @retval SPPWK_RET_OK If succeeded.
+ * @retval SPPWK_RET_NG If failed.
+ */
+int update_cls_acl_rules(enum sppwk_action wk_action,
+		const struct sppwk_cls_acl_rule *rule,
+		const struct sppwk_port_idx *port);
+
+/**
+ * Get version of ACL rules incremented each time rules are updated.
+ *
+ * @return Version of ACL rules.
+ */
+unsigned int get_cls_acl_rules_ver(void);
+
+/**
+ * Compile ACL of rules of TX ports of given classifier.
+ *
+ * @param[in] cmp_info Classifier info which has TX ports.
+ * @param[out] acl Compiled ACL, or NULL if no rule for the TX ports.
+ * @retval SPPWK_RET_OK If succeeded.
+ * @retval SPPWK_RET_NG If failed.
+ */
+int create_cls_acl(const struct cls_comp_info *cmp_info,
+		struct cls_acl **acl);
+
+/**
+ * Release ACL compiled with create_cls_acl().
+ *
+ * @param acl ACL to be released, or NULL.
+ */
+void free_cls_acl(struct cls_acl *acl);
+
+/**
+ * Match packets with ACL rules.
+ *
+ * @param[in] acl Compiled ACL.
+ * @param[in] pkts Packets to be matched.
+ * @param[in] nb_pkts Num of packets.
+ * @param[out] clsd_idx Index of TX port of matched rule for each of packets,
+ *     or -1 if not matched.
+ * @return Num of matched packets.
+ */
+int classify_cls_acl(const struct cls_acl *acl, struct rte_mbuf **pkts,
+		uint16_t nb_pkts, int *clsd_idx);
+
+/**
+ * Add ACL rules to classifier table for `status` command.
+ *
+ * @param params Object which has pointer of operation func and attrs.
+ */
+void add_cls_acl_entries(struct classifier_table_params *params);
+
+#endif /* __CLASSIFIER_ACL_H__ */
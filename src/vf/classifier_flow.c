@@ -0,0 +1,252 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#include <string.h>
+
+#include <rte_flow.h>
+#include <rte_ether.h>
+#include <rte_log.h>
+#include <rte_malloc.h>
+#include <rte_byteorder.h>
+
+#include "classifier_flow.h"
+#include "shared/secondary/return_codes.h"
+
+#define RTE_LOGTYPE_VF_CLS_FLOW RTE_LOGTYPE_USER1
+
+/* Mask of VID in TCI of VLAN header. */
+#define CLS_FLOW_VID_MASK 0x0fff
+
+/* Rule created for an entry of TX port. */
+struct cls_flow {
+	struct rte_flow *flow;  /* Rule, or NULL if not created. */
+	uint64_t mac_addr;  /* MAC address of the entry, or 0 for no rule. */
+	uint16_t vid;  /* VID of the entry. */
+	uint16_t queue_no;  /* RX queue to which packets are steered. */
+};
+
+/* Rules created for entries of TX ports of classifier. */
+struct cls_flows {
+	uint16_t port_id;  /* Ethdev port ID of rules. */
+	int nof_flows;  /* Num of entries of `flows`. */
+	struct cls_flow flows[];  /* Rule for each of TX ports. */
+};
+
+/* Flow offload is enabled with `--cls-flow-offload`. */
+static int g_cls_flow_offload;
+
+/* Enable or disable flow offload of classifier. */
+void
+set_cls_flow_offload(int enabled)
+{
+	g_cls_flow_offload = enabled;
+}
+
+/* Check if flow offload of classifier is enabled. */
+int
+get_cls_flow_offload(void)
+{
+	return g_cls_flow_offload;
+}
+
+/* Create rule steering packets of VID and MAC address to given queue. */
+static struct rte_flow *
+create_cls_flow(uint16_t port_id, uint16_t vid, uint64_t mac_addr,
+		uint16_t queue_no)
+{
+	int nof_items = 0;
+	struct rte_flow *flow;
+	struct rte_flow_error err;
+	struct rte_flow_attr attr;
+	struct rte_flow_item_eth eth_spec, eth_mask;
+	struct rte_flow_item_vlan vlan_spec, vlan_mask;
+	struct rte_flow_action_queue queue;
+	struct rte_flow_item pattern[3];
+	struct rte_flow_action actions[2];
+
+	memset(&attr, 0, sizeof(attr));
+	attr.ingress = 1;
+
+	memset(pattern, 0, sizeof(pattern));
+	memset(&eth_spec, 0, sizeof(eth_spec));
+	memset(&eth_mask, 0, sizeof(eth_mask));
+	memcpy(&eth_spec.dst, &mac_addr, RTE_ETHER_ADDR_LEN);
+	memset(&eth_mask.dst, 0xff, RTE_ETHER_ADDR_LEN);
+	pattern[nof_items].type = RTE_FLOW_ITEM_TYPE_ETH;
+	pattern[nof_items].spec = &eth_spec;
+	pattern[nof_items++].mask = &eth_mask;
+
+	/**
+	 * Untagged entry is matched only with MAC address, and tagged
+	 * packets steered with it are classified in software.
+	 */
+	if (vid != VLAN_UNTAGGED_VID) {
+		memset(&vlan_spec, 0, sizeof(vlan_spec));
+		memset(&vlan_mask, 0, sizeof(vlan_mask));
+		vlan_spec.tci = rte_cpu_to_be_16(vid);
+		vlan_mask.tci = rte_cpu_to_be_16(CLS_FLOW_VID_MASK);
+		pattern[nof_items].type = RTE_FLOW_ITEM_TYPE_VLAN;
+		pattern[nof_items].spec = &vlan_spec;
+		pattern[nof_items++].mask = &vlan_mask;
+	}
+	pattern[nof_items].type = RTE_FLOW_ITEM_TYPE_END;
+
+	memset(actions, 0, sizeof(actions));
+	queue.index = queue_no;
+	actions[0].type = RTE_FLOW_ACTION_TYPE_QUEUE;
+	actions[0].conf = &queue;
+	actions[1].type = RTE_FLOW_ACTION_TYPE_END;
+
+	memset(&err, 0, sizeof(err));
+	flow = rte_flow_create(port_id, &attr, pattern, actions, &err);
+	if (flow == NULL)
+		RTE_LOG(INFO, VF_CLS_FLOW, "Rule is rejected, classified in "
+				"software. port=%hu, vid=%hu, queue=%hu, "
+				"err=%s\n", port_id, vid, queue_no,
+				err.message != NULL ? err.message : "none");
+	return flow;
+}
+
+/* Destroy rules created for classifier. */
+void
+free_cls_flows(struct cls_flows *flows)
+{
+	int i;
+	int ret;
+	struct rte_flow_error err;
+
+	if (flows == NULL)
+		return;
+
+	for (i = 0; i < flows->nof_flows; i++) {
+		if (flows->flows[i].flow == NULL)
+			continue;
+		ret = rte_flow_destroy(flows->port_id, flows->flows[i].flow,
+				&err);
+		if (unlikely(ret != 0))
+			RTE_LOG(ERR, VF_CLS_FLOW, "Cannot destroy rule. "
+					"port=%hu, ret=%d\n",
+					flows->port_id, ret);
+	}
+	rte_free(flows);
+}
+
+/**
+ * Move rule of the same entry and queue from old rules to `flow` not to
+ * destroy and create it again. Return 1 if it is moved, or 0.
+ */
+static int
+take_cls_flow(struct cls_flows *old_flows, uint16_t port_id,
+		struct cls_flow *flow)
+{
+	int i;
+	struct cls_flow *old;
+
+	if (old_flows == NULL || old_flows->port_id != port_id)
+		return 0;
+
+	for (i = 0; i < old_flows->nof_flows; i++) {
+		old = &old_flows->flows[i];
+		if (old->flow == NULL || old->mac_addr != flow->mac_addr ||
+				old->vid != flow->vid ||
+				old->queue_no != flow->queue_no)
+			continue;
+
+		flow->flow = old->flow;
+		old->flow = NULL;
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * Create rules for entries of TX ports paired with RX queues. New rules
+ * are created before old ones are destroyed not to steer packets to other
+ * queues while updating. Rules rejected because of conflicting with old
+ * ones are created again after destroying.
+ */
+int
+update_cls_flows(const struct cls_comp_info *cmp_info,
+		struct cls_flows **flows)
+{
+	int i;
+	int nof_created = 0;
+	int nof_rejected = 0;
+	struct cls_flows *new_flows;
+	struct cls_flow *flow;
+	const struct cls_port_info *tx_port_i;
+
+	if (!g_cls_flow_offload || cmp_info->nof_flow_rx == 0) {
+		free_cls_flows(*flows);
+		*flows = NULL;
+		return SPPWK_RET_OK;
+	}
+
+	if (cmp_info->acl != NULL) {
+		RTE_LOG(INFO, VF_CLS_FLOW, "No rule for classifier with ACL. "
+				"name=%s\n", cmp_info->name);
+		free_cls_flows(*flows);
+		*flows = NULL;
+		return SPPWK_RET_OK;
+	}
+
+	/* Old rules are kept if failed to allocate. */
+	new_flows = rte_zmalloc(NULL, sizeof(struct cls_flows) +
+			sizeof(struct cls_flow) * cmp_info->nof_flow_rx, 0);
+	if (unlikely(new_flows == NULL)) {
+		RTE_LOG(ERR, VF_CLS_FLOW, "Cannot allocate rules. name=%s\n",
+				cmp_info->name);
+		return SPPWK_RET_NG;
+	}
+	new_flows->port_id = cmp_info->rx_port_i.ethdev_port_id;
+	new_flows->nof_flows = cmp_info->nof_flow_rx;
+
+	for (i = 0; i < cmp_info->nof_flow_rx; i++) {
+		tx_port_i = &cmp_info->tx_ports_i[i];
+		if (tx_port_i->cls_mac_addr == 0 ||
+				tx_port_i->cls_mac_addr == CLS_DUMMY_ADDR)
+			continue;
+
+		flow = &new_flows->flows[i];
+		flow->mac_addr = tx_port_i->cls_mac_addr;
+		flow->vid = tx_port_i->cls_vid;
+		flow->queue_no = cmp_info->flow_rx_queues[i];
+		if (take_cls_flow(*flows, new_flows->port_id, flow))
+			continue;
+
+		flow->flow = create_cls_flow(new_flows->port_id, flow->vid,
+				flow->mac_addr, flow->queue_no);
+	}
+
+	free_cls_flows(*flows);
+	*flows = new_flows;
+
+	for (i = 0; i < new_flows->nof_flows; i++) {
+		flow = &new_flows->flows[i];
+		if (flow->mac_addr == 0)
+			continue;
+
+		if (flow->flow == NULL)
+			flow->flow = create_cls_flow(new_flows->port_id,
+					flow->vid, flow->mac_addr,
+					flow->queue_no);
+		if (flow->flow != NULL)
+			nof_created++;
+		else
+			nof_rejected++;
+	}
+
+	RTE_LOG(INFO, VF_CLS_FLOW, "Create rules of classifier. name=%s, "
+			"nof_rules=%d, nof_queues=%d\n", cmp_info->name,
+			nof_created, cmp_info->nof_flow_rx);
+
+	/* Packets of rejected entries are classified in software. */
+	if (unlikely(nof_rejected != 0)) {
+		RTE_LOG(ERR, VF_CLS_FLOW, "Cannot create rules. name=%s, "
+				"nof_rejected=%d\n", cmp_info->name,
+				nof_rejected);
+		return SPPWK_RET_NG;
+	}
+	return SPPWK_RET_OK;
+}
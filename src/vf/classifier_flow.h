@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#ifndef __CLASSIFIER_FLOW_H__
+#define __CLASSIFIER_FLOW_H__
+
+#include "classifier.h"
+#include "shared/secondary/spp_worker_th/vf_deps.h"
+
+/**
+ * @file
+ * SPP Classifier with flow offload
+ *
+ * Entries of MAC address of classifier on a phy port are compiled into
+ * `rte_flow` rules which steer packets of each of entries to a dedicated RX
+ * queue. The queues are added to classifier as RX ports following the first
+ * one, and paired with TX ports in the order of adding. Packets from the
+ * queues are sent to the paired TX port without looking up the table.
+ *
+ * Entries rejected by NIC are classified in software as usual, and packets
+ * from the queues not matched with the entry of the pair, for example
+ * distributed with RSS, are also classified in software.
+ */
+
+/* Rules created for classifier, defined in spp_vf. */
+struct cls_flows;
+
+/**
+ * Enable or disable flow offload of classifier.
+ *
+ * @param enabled 1 for enabled, or 0.
+ */
+void set_cls_flow_offload(int enabled);
+
+/**
+ * Check if flow offload of classifier is enabled.
+ *
+ * @retval 1 if enabled, or 0.
+ */
+int get_cls_flow_offload(void);
+
+/**
+ * Create rules for entries of TX ports paired with RX queues of given
+ * classifier, and destroy old ones after that. Rules of entries not
+ * changed are kept. No rule is created if the classifier has ACL because
+ * packets matched with ACL must not bypass it.
+ *
+ * @param[in] cmp_info Classifier info which has RX queues and entries.
+ * @param[in,out] flows Rules created previously, replaced with new ones
+ *   even if some of them are rejected.
+ * @retval SPPWK_RET_OK If succeeded.
+ * @retval SPPWK_RET_NG If any of rules is rejected, or failed.
+ */
+int update_cls_flows(const struct cls_comp_info *cmp_info,
+		struct cls_flows **flows);
+
+/**
+ * Destroy rules created with update_cls_flows().
+ *
+ * @param flows Rules to be destroyed, or NULL.
+ */
+void free_cls_flows(struct cls_flows *flows);
+
+#endif /* __CLASSIFIER_FLOW_H__ */
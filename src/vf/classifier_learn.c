@@ -0,0 +1,741 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#include <unistd.h>
+#include <stdint.h>
+
+#include <rte_common.h>
+#include <rte_mbuf.h>
+#include <rte_log.h>
+#include <rte_cycles.h>
+#include <rte_malloc.h>
+#include <rte_ring.h>
+#include <rte_hash.h>
+#include <rte_prefetch.h>
+
+#include "classifier_learn.h"
+#include "shared/secondary/return_codes.h"
+#include "shared/secondary/spp_worker_th/vf_deps.h"
+#include "shared/secondary/spp_worker_th/port_capability.h"
+#include "shared/secondary/spp_worker_th/conf_rcu.h"
+#include "shared/secondary/spp_worker_th/tx_coalesce.h"
+
+#define RTE_LOGTYPE_VF_CLS_LEARN RTE_LOGTYPE_USER1
+
+#ifdef RTE_MACHINE_CPUFLAG_SSE4_2
+#include <rte_hash_crc.h>
+#define DEFAULT_HASH_FUNC rte_hash_crc
+#else
+#include <rte_jhash.h>
+#define DEFAULT_HASH_FUNC rte_jhash
+#endif
+
+/* Num of packets of which header is prefetched ahead of parsing. */
+#define CLS_LEARN_PREFETCH_OFFSET 4
+
+/* Port ID of learned entry which is not valid. */
+#define CLS_LEARN_NO_PORT UINT16_MAX
+
+/* Num of entries of learning cache from worker thread to master. */
+#define CLS_LEARN_RING_SIZE 1024
+
+/* Num of entries of recently learned ones kept in each of components. */
+#define CLS_LEARN_RECENT_BITS 8
+#define CLS_LEARN_RECENT_SIZE (1 << CLS_LEARN_RECENT_BITS)
+
+/* Max num of learned entries merged at once for each of components. */
+#define CLS_LEARN_MERGE_BURST 64
+
+/* Max num of entries of the table checked for aging at once. */
+#define CLS_LEARN_AGE_SCAN 256
+
+/* Max interval of refreshing time of learned entries in sec. */
+#define CLS_LEARN_REFRESH_SEC 1
+
+/**
+ * Learned entry is sent from worker thread to master as a value of 64 bits,
+ * which consists of MAC address, VID and index of pair of ports.
+ */
+#define CLS_LEARN_VAL_MAC_SHIFT 16
+#define CLS_LEARN_VAL_VID_SHIFT 4
+#define CLS_LEARN_VAL_PAIR_MASK 0x0f
+
+/* Attributes of learned entry, indexed with position of key of the table. */
+struct cls_learn_ent {
+	uint64_t last_tsc;  /* TSC at last time of learning. */
+	uint16_t port_id;  /* Ethdev port ID of RX port learned. */
+};
+
+/* Table of learned entries shared among all of components. */
+struct cls_learn_tbl {
+	struct rte_hash *hash;  /* Keys of VID and MAC address. */
+	struct cls_learn_ent *ents;  /* Attributes of learned entries. */
+	uint64_t age_tsc;  /* Aging time in TSC cycles, or 0 for no aging. */
+	uint64_t refresh_tsc;  /* Interval of refreshing learned entries. */
+	uint32_t age_iter;  /* Position of iterating keys for aging. */
+	uint64_t nof_tbl_full;  /* Num of entries failed to be added. */
+};
+
+/* Config of classifier learn published to worker thread. */
+struct cls_learn_conf {
+	char name[STR_LEN_NAME];  /* Component name */
+	unsigned int conf_ver;  /* Version of config for changing TX buffers. */
+	int nof_rx;  /* Num of RX ports */
+	int nof_tx;  /* Num of TX ports */
+	int nof_pairs;  /* Num of pairs of RX and TX ports. */
+	struct sppwk_port_info rx_ports[CLS_LEARN_MAX_PORTS];
+	struct sppwk_port_info tx_ports[CLS_LEARN_MAX_PORTS];
+	/* Flooded packet is copied for TX port if 1, or shared. */
+	uint8_t flood_copy[CLS_LEARN_MAX_PORTS];
+	/* Index of pair from ethdev port ID of RX port, or -1. */
+	int8_t pair_idx[RTE_MAX_ETHPORTS];
+	/* Learning cache referred from worker thread via config. */
+	struct rte_ring *learn_ring;
+};
+
+/* Entry sent to master recently, for avoiding to send it repeatedly. */
+struct cls_learn_recent {
+	uint64_t val;  /* Learned entry. */
+	uint64_t tsc;  /* TSC at sending. */
+};
+
+/* Management information of classifier learn component. */
+struct cls_learn_info {
+	/* Config published to worker thread, or NULL. */
+	struct cls_learn_conf *conf;
+	unsigned int conf_ver;  /* Version of config at last update. */
+	/* Cache of learned entries sent from worker thread to master. */
+	struct rte_ring *learn_ring;
+
+	/* Followings are referred only from worker thread. */
+	unsigned int cur_ver __rte_cache_aligned;
+	int nof_pairs;  /* Num of TX buffers assigned to ports. */
+	uint64_t nof_ring_full;  /* Num of entries failed to be sent. */
+	uint64_t nof_copy_failed;  /* Num of flooded packets not copied. */
+	struct sppwk_tx_buf tx_bufs[CLS_LEARN_MAX_PORTS];
+	struct cls_learn_recent recent[CLS_LEARN_RECENT_SIZE];
+};
+
+static struct cls_learn_tbl g_learn_tbl;
+static struct cls_learn_info g_learn_info[RTE_MAX_LCORE];
+
+/* Release config replaced with new one. */
+static void
+free_cls_learn_conf(void *conf, void *arg __attribute__ ((unused)))
+{
+	rte_free(conf);
+}
+
+/* Release learning cache of stopped component. */
+static void
+free_cls_learn_ring(void *conf, void *arg __attribute__ ((unused)))
+{
+	rte_ring_free(conf);
+}
+
+/* Release key deleted from the table. Position is given as `arg`. */
+static void
+free_cls_learn_key(void *conf, void *arg)
+{
+	rte_hash_free_key_with_position(conf, (int32_t)(long)arg);
+}
+
+/* Encode learned entry to be sent to master. */
+static inline uint64_t
+encode_learned(uint16_t vid, const struct rte_ether_addr *addr, int pair)
+{
+	uint64_t mac = 0;
+
+	memcpy(&mac, addr, RTE_ETHER_ADDR_LEN);
+	return (mac << CLS_LEARN_VAL_MAC_SHIFT) |
+		((uint64_t)vid << CLS_LEARN_VAL_VID_SHIFT) | (uint64_t)pair;
+}
+
+/* Decode learned entry sent from worker thread. */
+static inline void
+decode_learned(uint64_t val, struct cls_tbl_key *key, int *pair)
+{
+	uint64_t mac = val >> CLS_LEARN_VAL_MAC_SHIFT;
+
+	memset(key, 0, sizeof(*key));
+	key->vid = (uint16_t)((val >> CLS_LEARN_VAL_VID_SHIFT) & 0x0fff);
+	memcpy(&key->addr, &mac, RTE_ETHER_ADDR_LEN);
+	*pair = (int)(val & CLS_LEARN_VAL_PAIR_MASK);
+}
+
+/* Initialize the shared table of learned entries. */
+int
+init_cls_learn_mng_info(uint32_t nof_tbl_entries, uint32_t age_sec)
+{
+	uint32_t i;
+	uint64_t hz = rte_get_tsc_hz();
+	char name[RTE_HASH_NAMESIZE];
+
+	/* Learned entry is sent as a pointer via rte_ring. */
+	RTE_BUILD_BUG_ON(sizeof(void *) < sizeof(uint64_t));
+	RTE_BUILD_BUG_ON(CLS_LEARN_MAX_PORTS > CLS_LEARN_VAL_PAIR_MASK + 1);
+
+	memset(&g_learn_tbl, 0, sizeof(g_learn_tbl));
+	memset(g_learn_info, 0, sizeof(g_learn_info));
+
+	/* Name of table requires uniqueness between processes. */
+	snprintf(name, sizeof(name), "cllrn_%07x", getpid());
+
+	struct rte_hash_parameters hash_params = {
+			.name      = name,
+			.entries   = nof_tbl_entries,
+			.key_len   = sizeof(struct cls_tbl_key),
+			.hash_func = DEFAULT_HASH_FUNC,
+			.hash_func_init_val = 0,
+			.socket_id = rte_socket_id(),
+			/* Entries are updated while workers refer. */
+			.extra_flag = RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF,
+	};
+
+	g_learn_tbl.hash = rte_hash_create(&hash_params);
+	if (unlikely(g_learn_tbl.hash == NULL)) {
+		RTE_LOG(ERR, VF_CLS_LEARN,
+				"Cannot create table of learned entries. "
+				"name=%s\n", name);
+		return SPPWK_RET_NG;
+	}
+
+	/* Position of key is less than num of entries plus a dummy one. */
+	g_learn_tbl.ents = rte_zmalloc(NULL,
+			sizeof(struct cls_learn_ent) * (nof_tbl_entries + 1),
+			RTE_CACHE_LINE_SIZE);
+	if (unlikely(g_learn_tbl.ents == NULL)) {
+		RTE_LOG(ERR, VF_CLS_LEARN,
+				"Cannot allocate learned entries.\n");
+		rte_hash_free(g_learn_tbl.hash);
+		g_learn_tbl.hash = NULL;
+		return SPPWK_RET_NG;
+	}
+	for (i = 0; i <= nof_tbl_entries; i++)
+		g_learn_tbl.ents[i].port_id = CLS_LEARN_NO_PORT;
+
+	g_learn_tbl.age_tsc = hz * age_sec;
+	g_learn_tbl.refresh_tsc = hz * CLS_LEARN_REFRESH_SEC;
+	if (age_sec != 0 && g_learn_tbl.refresh_tsc > g_learn_tbl.age_tsc / 4)
+		g_learn_tbl.refresh_tsc = g_learn_tbl.age_tsc / 4;
+
+	RTE_LOG(INFO, VF_CLS_LEARN,
+			"Create table of learned entries. name=%s, "
+			"entries=%u, age_sec=%u\n",
+			name, nof_tbl_entries, age_sec);
+	return SPPWK_RET_OK;
+}
+
+/* Update classifier learn info. */
+int
+update_cls_learn(struct sppwk_comp_info *wk_comp_info)
+{
+	int cnt;
+	int port_id;
+	int comp_id = wk_comp_info->comp_id;
+	struct cls_learn_info *info = &g_learn_info[comp_id];
+	struct cls_learn_conf *conf = NULL;
+	struct cls_learn_conf *old_conf = NULL;
+	char ring_name[RTE_RING_NAMESIZE];
+
+	if (unlikely(wk_comp_info->nof_rx > CLS_LEARN_MAX_PORTS ||
+			wk_comp_info->nof_tx > CLS_LEARN_MAX_PORTS)) {
+		RTE_LOG(ERR, VF_CLS_LEARN,
+				"Invalid num of ports (id=%d, nof_rx=%d, "
+				"nof_tx=%d).\n", comp_id, wk_comp_info->nof_rx,
+				wk_comp_info->nof_tx);
+		return SPPWK_RET_NG;
+	}
+
+	/* Name is unique while ring of stopped one is not released yet. */
+	if (info->learn_ring == NULL) {
+		snprintf(ring_name, sizeof(ring_name), "cllrn_%07x_%d_%x",
+				getpid(), comp_id, info->conf_ver);
+		info->learn_ring = rte_ring_create(ring_name,
+				CLS_LEARN_RING_SIZE, rte_socket_id(),
+				RING_F_SP_ENQ | RING_F_SC_DEQ);
+		if (unlikely(info->learn_ring == NULL)) {
+			RTE_LOG(ERR, VF_CLS_LEARN,
+					"Cannot create learning cache "
+					"(id=%d).\n", comp_id);
+			return SPPWK_RET_NG;
+		}
+	}
+
+	conf = rte_zmalloc(NULL, sizeof(struct cls_learn_conf), 0);
+	if (unlikely(conf == NULL)) {
+		RTE_LOG(ERR, VF_CLS_LEARN,
+				"Cannot allocate config of classifier learn "
+				"(id=%d).\n", comp_id);
+		return SPPWK_RET_NG;
+	}
+
+	memcpy(conf->name, wk_comp_info->name, STR_LEN_NAME);
+	conf->nof_rx = wk_comp_info->nof_rx;
+	conf->nof_tx = wk_comp_info->nof_tx;
+	for (cnt = 0; cnt < conf->nof_rx; cnt++)
+		memcpy(&conf->rx_ports[cnt], wk_comp_info->rx_ports[cnt],
+				sizeof(struct sppwk_port_info));
+	for (cnt = 0; cnt < conf->nof_tx; cnt++) {
+		memcpy(&conf->tx_ports[cnt], wk_comp_info->tx_ports[cnt],
+				sizeof(struct sppwk_port_info));
+		conf->flood_copy[cnt] =
+			!sppwk_is_pkt_sharable_port(&conf->tx_ports[cnt]);
+	}
+	conf->learn_ring = info->learn_ring;
+
+	/* Ports without a counterpart are not used until it is added. */
+	conf->nof_pairs = RTE_MIN(conf->nof_rx, conf->nof_tx);
+	memset(conf->pair_idx, -1, sizeof(conf->pair_idx));
+	for (cnt = 0; cnt < conf->nof_pairs; cnt++) {
+		port_id = conf->rx_ports[cnt].ethdev_port_id;
+		if (port_id >= 0 && port_id < RTE_MAX_ETHPORTS)
+			conf->pair_idx[port_id] = (int8_t)cnt;
+	}
+	conf->conf_ver = ++info->conf_ver;
+
+	/* Old config is released after worker thread stops to refer it. */
+	old_conf = SPPWK_CONF_SET(info->conf, conf);
+	if (old_conf != NULL)
+		sppwk_conf_rcu_defer_free(old_conf, free_cls_learn_conf, NULL);
+
+	RTE_LOG(INFO, VF_CLS_LEARN,
+			"Done update classifier learn (id=%d, name=%s, "
+			"nof_pairs=%d).\n", comp_id, conf->name,
+			conf->nof_pairs);
+	return SPPWK_RET_OK;
+}
+
+/* Release config and learning cache of stopped classifier learn. */
+void
+init_cls_learn_info(int comp_id)
+{
+	struct cls_learn_info *info = &g_learn_info[comp_id];
+	struct cls_learn_conf *old_conf;
+
+	old_conf = SPPWK_CONF_SET(info->conf, NULL);
+	if (old_conf != NULL)
+		sppwk_conf_rcu_defer_free(old_conf, free_cls_learn_conf, NULL);
+
+	/* Ring is referred from worker thread only via the config. */
+	if (info->learn_ring != NULL) {
+		sppwk_conf_rcu_defer_free(info->learn_ring,
+				free_cls_learn_ring, NULL);
+		info->learn_ring = NULL;
+	}
+}
+
+/* Transmit all packets in TX buffers. */
+static inline void
+flush_cls_learn_bufs(struct cls_learn_info *info)
+{
+	int i;
+
+	for (i = 0; i < info->nof_pairs; i++)
+		sppwk_tx_buf_flush(&info->tx_bufs[i]);
+}
+
+/* Transmit all packets in TX buffers, and change them to new TX ports. */
+static inline void
+change_cls_learn_ports(struct cls_learn_info *info,
+		const struct cls_learn_conf *conf)
+{
+	int i;
+	const struct sppwk_port_info *tx;
+
+	flush_cls_learn_bufs(info);
+
+	info->nof_pairs = conf->nof_pairs;
+	for (i = 0; i < conf->nof_pairs; i++) {
+		tx = &conf->tx_ports[i];
+		sppwk_tx_buf_init(&info->tx_bufs[i], tx->ethdev_port_id,
+				tx->queue_no, tx->iface_type, tx->iface_no, 1);
+	}
+	info->cur_ver = conf->conf_ver;
+}
+
+/**
+ * Send learned entry to master if it is not sent recently. It is sent
+ * again after refreshing interval to keep the entry from aging.
+ */
+static inline void
+send_learned(struct cls_learn_info *info, struct rte_ring *learn_ring,
+		uint64_t val, uint64_t cur_tsc)
+{
+	struct cls_learn_recent *recent;
+
+	recent = &info->recent[(val * 0x9e3779b97f4a7c15ULL) >>
+			(64 - CLS_LEARN_RECENT_BITS)];
+	if (recent->val == val &&
+			cur_tsc - recent->tsc < g_learn_tbl.refresh_tsc)
+		return;
+
+	if (unlikely(rte_ring_sp_enqueue(learn_ring,
+				(void *)(uintptr_t)val) != 0)) {
+		info->nof_ring_full++;
+		return;
+	}
+	recent->val = val;
+	recent->tsc = cur_tsc;
+}
+
+/**
+ * Send packet to all of pairs other than incoming one. It is shared with
+ * refcnt among pairs, and copied for a pair of which TX port modifies or
+ * releases packets regardless of refcnt.
+ */
+static inline void
+flood_packet(struct cls_learn_info *info, const struct cls_learn_conf *conf,
+		int in_pair, struct rte_mbuf *pkt, uint64_t cur_tsc)
+{
+	int i;
+	int nof_shared = 0;
+	struct rte_mbuf *seg;
+	struct rte_mbuf *copy;
+
+	/* Copies are sent before sharing because it may be sent at once. */
+	for (i = 0; i < info->nof_pairs; i++) {
+		if (i == in_pair)
+			continue;
+		if (likely(!conf->flood_copy[i])) {
+			nof_shared++;
+			continue;
+		}
+
+		copy = rte_pktmbuf_copy(pkt, pkt->pool, 0, UINT32_MAX);
+		if (unlikely(copy == NULL)) {
+			info->nof_copy_failed++;
+			continue;
+		}
+		sppwk_tx_buf_push(&info->tx_bufs[i], copy, cur_tsc);
+	}
+
+	if (unlikely(nof_shared == 0)) {
+		rte_pktmbuf_free(pkt);
+		return;
+	}
+
+	for (seg = pkt; seg != NULL; seg = seg->next)
+		rte_mbuf_refcnt_update(seg, (int16_t)(nof_shared - 1));
+	for (i = 0; i < info->nof_pairs; i++) {
+		if (i != in_pair && likely(!conf->flood_copy[i]))
+			sppwk_tx_buf_push(&info->tx_bufs[i], pkt, cur_tsc);
+	}
+}
+
+/**
+ * Learn source of a burst of packets from a pair, and classify them.
+ * Destination and source of all packets are looked up at once.
+ */
+static inline void
+_learn_classify_packets(struct cls_learn_info *info,
+		const struct cls_learn_conf *conf, int in_pair,
+		struct rte_mbuf **pkts, uint16_t nb_pkts, uint64_t cur_tsc)
+{
+	int i;
+	int out_pair;
+	uint16_t port_id;
+	uint16_t rx_port_id = (uint16_t)conf->rx_ports[in_pair].ethdev_port_id;
+	struct cls_learn_ent *ent;
+	struct rte_ether_hdr *eth;
+	uint16_t vids[MAX_PKT_BURST];
+	struct rte_ether_hdr *eths[MAX_PKT_BURST];
+	/* Keys of destination followed by keys of source. */
+	struct cls_tbl_key keys[MAX_PKT_BURST * 2];
+	const void *key_ptrs[MAX_PKT_BURST * 2];
+	int32_t positions[MAX_PKT_BURST * 2];
+
+	for (i = 0; i < CLS_LEARN_PREFETCH_OFFSET && i < nb_pkts; i++)
+		rte_prefetch0(rte_pktmbuf_mtod(pkts[i], void *));
+
+	for (i = 0; i < nb_pkts; i++) {
+		if (i + CLS_LEARN_PREFETCH_OFFSET < nb_pkts)
+			rte_prefetch0(rte_pktmbuf_mtod(
+					pkts[i + CLS_LEARN_PREFETCH_OFFSET],
+					void *));
+
+		eth = rte_pktmbuf_mtod(pkts[i], struct rte_ether_hdr *);
+		eths[i] = eth;
+		vids[i] = get_vid_from_hdr(eth);
+
+		keys[i].vid = vids[i];
+		rte_ether_addr_copy(&eth->d_addr, &keys[i].addr);
+		keys[nb_pkts + i].vid = vids[i];
+		rte_ether_addr_copy(&eth->s_addr, &keys[nb_pkts + i].addr);
+		key_ptrs[i] = &keys[i];
+		key_ptrs[nb_pkts + i] = &keys[nb_pkts + i];
+	}
+
+	rte_hash_lookup_bulk(g_learn_tbl.hash, key_ptrs, nb_pkts * 2,
+			positions);
+
+	/* Learn source, or refresh it if it is learned already. */
+	for (i = 0; i < nb_pkts; i++) {
+		if (unlikely(rte_is_multicast_ether_addr(&eths[i]->s_addr)))
+			continue;
+
+		if (likely(positions[nb_pkts + i] >= 0)) {
+			ent = &g_learn_tbl.ents[positions[nb_pkts + i]];
+			port_id = __atomic_load_n(&ent->port_id,
+					__ATOMIC_ACQUIRE);
+			if (likely(port_id == rx_port_id)) {
+				if (unlikely(cur_tsc - ent->last_tsc >=
+						g_learn_tbl.refresh_tsc))
+					send_learned(info,
+						conf->learn_ring,
+						encode_learned(vids[i],
+							&eths[i]->s_addr,
+							in_pair), cur_tsc);
+				continue;
+			}
+		}
+
+		/* New entry, or moved from other port. */
+		send_learned(info, conf->learn_ring, encode_learned(vids[i],
+					&eths[i]->s_addr, in_pair), cur_tsc);
+	}
+
+	/* Classify with destination, or flood if it is unknown. */
+	for (i = 0; i < nb_pkts; i++) {
+		out_pair = -1;
+		if (likely(!rte_is_multicast_ether_addr(&eths[i]->d_addr) &&
+				positions[i] >= 0)) {
+			port_id = __atomic_load_n(
+					&g_learn_tbl.ents[positions[i]].port_id,
+					__ATOMIC_ACQUIRE);
+			if (likely(port_id < RTE_MAX_ETHPORTS))
+				out_pair = conf->pair_idx[port_id];
+		}
+
+		if (likely(out_pair >= 0)) {
+			/* Destination is on the side of incoming port. */
+			if (unlikely(out_pair == in_pair)) {
+				rte_pktmbuf_free(pkts[i]);
+				continue;
+			}
+			sppwk_tx_buf_push(&info->tx_bufs[out_pair], pkts[i],
+					cur_tsc);
+			continue;
+		}
+
+		flood_packet(info, conf, in_pair, pkts[i], cur_tsc);
+	}
+}
+
+/* Learn source and classify incoming packets. */
+int
+learn_classify_packets(int comp_id)
+{
+	int i;
+	uint16_t nb_rx;
+	uint64_t cur_tsc;
+	struct cls_learn_info *info = &g_learn_info[comp_id];
+	struct cls_learn_conf *conf;
+	const struct sppwk_port_info *rx;
+	struct rte_mbuf *pkts[MAX_PKT_BURST];
+
+	conf = SPPWK_CONF_GET(info->conf);
+	if (unlikely(conf == NULL)) {
+		/* Not to keep packets of ports of stopped component. */
+		flush_cls_learn_bufs(info);
+		return SPPWK_RET_OK;
+	}
+
+	/* Change TX buffers if config of new ports is published. */
+	if (unlikely(info->cur_ver != conf->conf_ver))
+		change_cls_learn_ports(info, conf);
+
+	cur_tsc = rte_rdtsc();
+
+	for (i = 0; i < conf->nof_pairs; i++) {
+		rx = &conf->rx_ports[i];
+		nb_rx = sppwk_eth_vlan_rx_burst(rx->ethdev_port_id,
+				rx->queue_no, pkts, MAX_PKT_BURST);
+		if (nb_rx != 0)
+			_learn_classify_packets(info, conf, i, pkts, nb_rx,
+					cur_tsc);
+	}
+
+	/* Send packets waiting longer than flush latency budget. */
+	for (i = 0; i < info->nof_pairs; i++)
+		sppwk_tx_buf_drain(&info->tx_bufs[i], cur_tsc);
+
+	return SPPWK_RET_OK;
+}
+
+/* Transmit all packets in TX buffers of classifier learn. */
+void
+flush_cls_learn(int comp_id)
+{
+	flush_cls_learn_bufs(&g_learn_info[comp_id]);
+}
+
+/* Add learned entry to the table, or update port of it. */
+static inline void
+add_learned_entry(const struct cls_tbl_key *key, uint16_t port_id,
+		uint64_t cur_tsc)
+{
+	int32_t pos;
+	struct cls_learn_ent *ent;
+
+	pos = rte_hash_add_key(g_learn_tbl.hash, key);
+	if (unlikely(pos < 0)) {
+		g_learn_tbl.nof_tbl_full++;
+		RTE_LOG(DEBUG, VF_CLS_LEARN,
+				"Cannot add learned entry, vid=%hu, ret=%d.\n",
+				key->vid, pos);
+		return;
+	}
+
+	ent = &g_learn_tbl.ents[pos];
+	__atomic_store_n(&ent->last_tsc, cur_tsc, __ATOMIC_RELAXED);
+	if (ent->port_id != port_id) {
+		__atomic_store_n(&ent->port_id, port_id, __ATOMIC_RELEASE);
+		RTE_LOG(DEBUG, VF_CLS_LEARN,
+				"Learned entry, vid=%hu, port=%hu.\n",
+				key->vid, port_id);
+	}
+}
+
+/**
+ * Delete entries not learned for aging time. A part of the table is
+ * checked at once, and rest of it is checked in next call.
+ */
+static void
+age_learned_entries(uint64_t cur_tsc)
+{
+	int i;
+	int nof_aged = 0;
+	int32_t pos;
+	const void *key;
+	void *data;
+	struct cls_learn_ent *ent;
+	struct cls_tbl_key aged_keys[CLS_LEARN_AGE_SCAN];
+
+	for (i = 0; i < CLS_LEARN_AGE_SCAN; i++) {
+		pos = rte_hash_iterate(g_learn_tbl.hash, &key, &data,
+				&g_learn_tbl.age_iter);
+		if (pos < 0) {
+			/* Start from the first entry in next call. */
+			g_learn_tbl.age_iter = 0;
+			break;
+		}
+
+		ent = &g_learn_tbl.ents[pos];
+		if (cur_tsc - ent->last_tsc >= g_learn_tbl.age_tsc)
+			memcpy(&aged_keys[nof_aged++], key,
+					sizeof(struct cls_tbl_key));
+	}
+
+	for (i = 0; i < nof_aged; i++) {
+		pos = rte_hash_del_key(g_learn_tbl.hash, &aged_keys[i]);
+		if (unlikely(pos < 0))
+			continue;
+
+		/**
+		 * Invalidate port before the position is reused, and release
+		 * the key after workers stop to refer it.
+		 */
+		__atomic_store_n(&g_learn_tbl.ents[pos].port_id,
+				CLS_LEARN_NO_PORT, __ATOMIC_RELEASE);
+		sppwk_conf_rcu_defer_free(g_learn_tbl.hash,
+				free_cls_learn_key, (void *)(long)pos);
+		RTE_LOG(DEBUG, VF_CLS_LEARN, "Aged entry, vid=%hu.\n",
+				aged_keys[i].vid);
+	}
+}
+
+/* Merge entries learned in worker threads into the shared table. */
+void
+merge_cls_learn_entries(void)
+{
+	int comp_id;
+	int pair;
+	unsigned int i, nb_vals;
+	uint64_t cur_tsc;
+	struct cls_tbl_key key;
+	struct cls_learn_info *info;
+	struct cls_learn_conf *conf;
+	void *vals[CLS_LEARN_MERGE_BURST];
+
+	if (unlikely(g_learn_tbl.hash == NULL))
+		return;
+
+	cur_tsc = rte_rdtsc();
+	for (comp_id = 0; comp_id < RTE_MAX_LCORE; comp_id++) {
+		info = &g_learn_info[comp_id];
+		if (info->learn_ring == NULL)
+			continue;
+
+		nb_vals = rte_ring_sc_dequeue_burst(info->learn_ring, vals,
+				CLS_LEARN_MERGE_BURST, NULL);
+		if (nb_vals == 0)
+			continue;
+
+		conf = info->conf;
+		if (unlikely(conf == NULL))
+			continue;
+
+		for (i = 0; i < nb_vals; i++) {
+			decode_learned((uint64_t)(uintptr_t)vals[i], &key,
+					&pair);
+			if (unlikely(pair >= conf->nof_pairs))
+				continue;
+			add_learned_entry(&key,
+				(uint16_t)conf->rx_ports[pair].ethdev_port_id,
+				cur_tsc);
+		}
+	}
+
+	if (g_learn_tbl.age_tsc != 0)
+		age_learned_entries(cur_tsc);
+}
+
+/* Get classifier learn status. */
+int
+get_cls_learn_status(unsigned int lcore_id, int id,
+		struct sppwk_lcore_params *params)
+{
+	int ret;
+	int cnt;
+	struct cls_learn_info *info = &g_learn_info[id];
+	struct cls_learn_conf *conf = info->conf;
+	struct sppwk_port_idx rx_ports[RTE_MAX_QUEUES_PER_PORT];
+	struct sppwk_port_idx tx_ports[RTE_MAX_QUEUES_PER_PORT];
+	struct sppwk_tx_coal_stats tx_stats;
+
+	if (unlikely(conf == NULL)) {
+		RTE_LOG(ERR, VF_CLS_LEARN,
+				"Classifier learn is not used "
+				"(id=%d, lcore=%d).\n", id, lcore_id);
+		return SPPWK_RET_NG;
+	}
+
+	memset(rx_ports, 0x00, sizeof(rx_ports));
+	for (cnt = 0; cnt < conf->nof_rx; cnt++) {
+		rx_ports[cnt].iface_type = conf->rx_ports[cnt].iface_type;
+		rx_ports[cnt].iface_no = conf->rx_ports[cnt].iface_no;
+		rx_ports[cnt].queue_no = conf->rx_ports[cnt].queue_no;
+	}
+
+	memset(tx_ports, 0x00, sizeof(tx_ports));
+	for (cnt = 0; cnt < conf->nof_tx; cnt++) {
+		tx_ports[cnt].iface_type = conf->tx_ports[cnt].iface_type;
+		tx_ports[cnt].iface_no = conf->tx_ports[cnt].iface_no;
+		tx_ports[cnt].queue_no = conf->tx_ports[cnt].queue_no;
+	}
+
+	memset(&tx_stats, 0x00, sizeof(tx_stats));
+	for (cnt = 0; cnt < CLS_LEARN_MAX_PORTS; cnt++)
+		sppwk_tx_buf_add_stats(&tx_stats, &info->tx_bufs[cnt]);
+
+	/* Set the information with the function specified by the command. */
+	ret = (*params->lcore_proc)(params, lcore_id, conf->name,
+			SPPWK_TYPE_CLS_LEARN_STR, conf->nof_rx, rx_ports,
+			conf->nof_tx, tx_ports, &tx_stats);
+	if (unlikely(ret != SPPWK_RET_OK))
+		return SPPWK_RET_NG;
+
+	return SPPWK_RET_OK;
+}
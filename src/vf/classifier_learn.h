@@ -0,0 +1,93 @@
+/* SPDX-License-Identifier: BSD-3-Clause
+ * Copyright(c) 2019 Nippon Telegraph and Telephone Corporation
+ */
+
+#ifndef __CLASSIFIER_LEARN_H__
+#define __CLASSIFIER_LEARN_H__
+
+#include "shared/secondary/spp_worker_th/cmd_utils.h"
+
+/**
+ * @file
+ * SPP Classifier with MAC learning
+ *
+ * Classifier learn component behaves as an L2 switch. Each of RX ports is
+ * paired with a TX port of the same index, and source MAC address of
+ * incoming packets is learned with VID as a binding to the pair. Packets
+ * are sent to the pair of learned destination, or flooded to all of pairs
+ * other than incoming one if destination is unknown or multicast.
+ *
+ * Learned entries are sent from worker threads to master via a cache of
+ * each of components, and master merges them into the table shared among
+ * all of components. Entries not referred for aging time are deleted.
+ */
+
+/* Default aging time of learned entries in sec. */
+#define DEFAULT_CLS_LEARN_AGE_SEC 300
+
+/* Max num of pairs of RX and TX ports of classifier learn component. */
+#define CLS_LEARN_MAX_PORTS 16
+
+/**
+ * Initialize the shared table of learned entries.
+ *
+ * @param nof_tbl_entries Max num of entries of the table.
+ * @param age_sec Aging time of learned entries in sec, or 0 for no aging.
+ * @retval SPPWK_RET_OK succeeded.
+ * @retval SPPWK_RET_NG failed.
+ */
+int init_cls_learn_mng_info(uint32_t nof_tbl_entries, uint32_t age_sec);
+
+/**
+ * Update classifier learn info.
+ *
+ * @param wk_comp_info Pointer to internal data of classifier learn.
+ * @retval SPPWK_RET_OK If succeeded.
+ * @retval SPPWK_RET_NG If failed.
+ */
+int update_cls_learn(struct sppwk_comp_info *wk_comp_info);
+
+/**
+ * Release config and learning cache of stopped classifier learn after
+ * worker threads stop to refer them.
+ *
+ * @param comp_id Component ID.
+ */
+void init_cls_learn_info(int comp_id);
+
+/**
+ * Learn source and classify incoming packets.
+ *
+ * @param comp_id Component ID.
+ * @retval SPPWK_RET_OK succeeded.
+ * @retval SPPWK_RET_NG failed.
+ */
+int learn_classify_packets(int comp_id);
+
+/**
+ * Transmit all packets in TX buffers of classifier learn. It is called
+ * from worker thread when the component is stopped or the thread exits.
+ *
+ * @param comp_id Component ID.
+ */
+void flush_cls_learn(int comp_id);
+
+/**
+ * Merge entries learned in worker threads into the shared table, and
+ * delete aged ones. It is called from master periodically.
+ */
+void merge_cls_learn_entries(void);
+
+/**
+ * Get classifier learn status.
+ *
+ * @param[in] lcore_id Lcore ID for classifier learn.
+ * @param[in] id Unique component ID.
+ * @param[in,out] params Pointer to detailed data of the status.
+ * @retval SPPWK_RET_OK If succeeded.
+ * @retval SPPWK_RET_NG If failed.
+ */
+int get_cls_learn_status(unsigned int lcore_id, int id,
+		struct sppwk_lcore_params *params);
+
+#endif /* __CLASSIFIER_LEARN_H__ */
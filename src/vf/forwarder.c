@@ -3,15 +3,14 @@
  */
 
 #include <rte_cycles.h>
+#include <rte_malloc.h>
 
 #include "forwarder.h"
 #include "shared/secondary/return_codes.h"
 #include "shared/secondary/spp_worker_th/vf_deps.h"
 #include "shared/secondary/spp_worker_th/port_capability.h"
-
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
-#include "shared/secondary/spp_worker_th/latency_stats.h"
-#endif
+#include "shared/secondary/spp_worker_th/conf_rcu.h"
+#include "shared/secondary/spp_worker_th/tx_coalesce.h"
 
 #define RTE_LOGTYPE_FORWARD RTE_LOGTYPE_USER1
 
@@ -32,24 +31,31 @@ struct forward_path {
 
 /* Information for forward. */
 struct forward_info {
-	volatile int ref_index; /* index to reference area */
-	volatile int upd_index; /* index to update area    */
-	struct forward_path path[TWO_SIDES];
-				/* Information of data path */
+	/* Information of data path published to forwarder, or NULL. */
+	struct forward_path *path;
+	/* Buffer of TX port referred only from forwarder thread. */
+	struct sppwk_tx_buf tx_buf __rte_cache_aligned;
 };
 
 struct forward_info g_forward_info[RTE_MAX_LCORE];
 
-/* Clear g_forward_info, ref and update indices. */
+/* Clear g_forward_info. */
 void
 init_forwarder(void)
 {
-	int cnt = 0;
+	int cnt;
+
 	memset(&g_forward_info, 0x00, sizeof(g_forward_info));
-	for (cnt = 0; cnt < RTE_MAX_LCORE; cnt++) {
-		g_forward_info[cnt].ref_index = 0;
-		g_forward_info[cnt].upd_index = 1;
-	}
+	for (cnt = 0; cnt < RTE_MAX_LCORE; cnt++)
+		sppwk_tx_buf_init(&g_forward_info[cnt].tx_buf, -1, 0, UNDEF,
+				0, 1);
+}
+
+/* Release path replaced with new one. */
+static void
+free_forward_path(void *conf, void *arg __attribute__ ((unused)))
+{
+	rte_free(conf);
 }
 
 /* Get forwarder status. */
@@ -60,16 +66,16 @@ get_forwarder_status(unsigned int lcore_id, int id,
 	int ret = SPPWK_RET_NG;
 	int cnt;
 	const char *component_type = NULL;
-	struct forward_info *fwd_info = &g_forward_info[id];
-	struct forward_path *fwd_path = &fwd_info->path[fwd_info->ref_index];
+	struct forward_path *fwd_path = g_forward_info[id].path;
 	struct sppwk_port_idx rx_ports[RTE_MAX_QUEUES_PER_PORT];
 	struct sppwk_port_idx tx_ports[RTE_MAX_QUEUES_PER_PORT];
+	struct sppwk_tx_coal_stats tx_stats;
 
-	if (unlikely(fwd_path->wk_type == SPPWK_TYPE_NONE)) {
+	if (unlikely(fwd_path == NULL ||
+				fwd_path->wk_type == SPPWK_TYPE_NONE)) {
 		RTE_LOG(ERR, FORWARD,
 				"Forwarder is not used. "
-				"(id=%d, lcore=%d, type=%d).\n",
-				id, lcore_id, fwd_path->wk_type);
+				"(id=%d, lcore=%d).\n", id, lcore_id);
 		return SPPWK_RET_NG;
 	}
 
@@ -92,10 +98,13 @@ get_forwarder_status(unsigned int lcore_id, int id,
 		tx_ports[cnt].queue_no = fwd_path->ports[cnt].tx.queue_no;
 	}
 
+	memset(&tx_stats, 0x00, sizeof(tx_stats));
+	sppwk_tx_buf_add_stats(&tx_stats, &g_forward_info[id].tx_buf);
+
 	/* Set the information with the function specified by the command. */
 	ret = (*params->lcore_proc)(params, lcore_id, fwd_path->name,
 			component_type, fwd_path->nof_rx, rx_ports,
-			fwd_path->nof_tx, tx_ports);
+			fwd_path->nof_tx, tx_ports, &tx_stats);
 	if (unlikely(ret != SPPWK_RET_OK))
 		return SPPWK_RET_NG;
 
@@ -112,7 +121,8 @@ update_forwarder(struct sppwk_comp_info *comp_info)
 	int max = (nof_rx > nof_tx)?nof_rx*nof_tx:nof_tx;
 	struct forward_info *fwd_info = &g_forward_info[comp_info->comp_id];
 	/* TODO(yasufum) rename `path` of struct forward_path. */
-	struct forward_path *fwd_path = &fwd_info->path[fwd_info->upd_index];
+	struct forward_path *fwd_path = NULL;
+	struct forward_path *old_path = NULL;
 
 	/**
 	 * Check num of RX and TX ports because forwarder has just a set of
@@ -134,7 +144,13 @@ update_forwarder(struct sppwk_comp_info *comp_info)
 		return SPPWK_RET_NG;
 	}
 
-	memset(fwd_path, 0x00, sizeof(struct forward_path));
+	fwd_path = rte_zmalloc(NULL, sizeof(struct forward_path), 0);
+	if (unlikely(fwd_path == NULL)) {
+		RTE_LOG(ERR, FORWARD,
+			"Cannot allocate path of forwarder (id=%d).\n",
+			comp_info->comp_id);
+		return SPPWK_RET_NG;
+	}
 
 	RTE_LOG(INFO, FORWARD,
 			"Start updating forwarder (id=%d, name=%s, type=%d)\n",
@@ -154,9 +170,10 @@ update_forwarder(struct sppwk_comp_info *comp_info)
 		memcpy(&fwd_path->ports[cnt].tx, comp_info->tx_ports[0],
 				sizeof(struct sppwk_port_info));
 
-	fwd_info->upd_index = fwd_info->ref_index;
-	while (likely(fwd_info->ref_index == fwd_info->upd_index))
-		rte_delay_us_block(SPPWK_UPDATE_INTERVAL);
+	/* Old path is released after forwarder stops to refer it. */
+	old_path = SPPWK_CONF_SET(fwd_info->path, fwd_path);
+	if (old_path != NULL)
+		sppwk_conf_rcu_defer_free(old_path, free_forward_path, NULL);
 
 	RTE_LOG(INFO, FORWARD,
 			"Done update forwarder. (id=%d, name=%s, type=%d)\n",
@@ -166,18 +183,6 @@ update_forwarder(struct sppwk_comp_info *comp_info)
 	return SPPWK_RET_OK;
 }
 
-/* Change index of forward info */
-static inline void
-change_forward_index(int id)
-{
-	struct forward_info *info = &g_forward_info[id];
-	if (info->ref_index == info->upd_index) {
-		/* Change reference index of port ability. */
-		sppwk_swap_two_sides(SPPWK_SWAP_REF, 0, 0);
-
-		info->ref_index = (info->upd_index+1) % TWO_SIDES;
-	}
-}
 /**
  * Forward packets as forwarder or merger.
  *
@@ -187,60 +192,63 @@ change_forward_index(int id)
 int
 forward_packets(int id)
 {
-	int cnt, buf;
+	int cnt;
+	int nof_rx;  /* Num of RX ports to receive packets. */
 	int nb_rx = 0;
-	int nb_tx = 0;
+	uint64_t cur_tsc;
 	struct forward_info *info = &g_forward_info[id];
 	struct forward_path *path = NULL;
+	struct sppwk_tx_buf *tx_buf = &info->tx_buf;
 	struct sppwk_port_info *rx;
 	struct sppwk_port_info *tx;
 	struct rte_mbuf *bufs[MAX_PKT_BURST];
 
-	change_forward_index(id);
-	path = &info->path[info->ref_index];
+	path = SPPWK_CONF_GET(info->path);
+	if (unlikely(path == NULL)) {
+		/* Not to keep packets of the port of stopped forwarder. */
+		sppwk_tx_buf_flush(tx_buf);
+		return SPPWK_RET_OK;
+	}
+
+	/* Transmit packets to previous TX port before changing to new one. */
+	tx = &path->ports[0].tx;
+	if (unlikely(tx_buf->ethdev_port_id != tx->ethdev_port_id ||
+			tx_buf->queue_no != tx->queue_no)) {
+		sppwk_tx_buf_flush(tx_buf);
+		sppwk_tx_buf_init(tx_buf, tx->ethdev_port_id, tx->queue_no,
+				tx->iface_type, tx->iface_no, 1);
+	}
+
+	cur_tsc = rte_rdtsc();
 
 	/* Practice condition check */
-	if (path->wk_type == SPPWK_TYPE_MRG) {
+	if (path->wk_type == SPPWK_TYPE_MRG)
 		/* merger */
-		if (!(path->nof_tx == 1 && path->nof_rx >= 1))
-			return SPPWK_RET_OK;
-	} else {
+		nof_rx = (path->nof_tx == 1) ? path->nof_rx : 0;
+	else
 		/* forwarder */
-		if (!(path->nof_tx == 1 && path->nof_rx == 1))
-			return SPPWK_RET_OK;
-	}
+		nof_rx = (path->nof_tx == 1 && path->nof_rx == 1) ? 1 : 0;
 
-	for (cnt = 0; cnt < path->nof_rx; cnt++) {
+	for (cnt = 0; cnt < nof_rx; cnt++) {
 		rx = &path->ports[cnt].rx;
-		tx = &path->ports[cnt].tx;
 
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
-		nb_rx = sppwk_eth_vlan_ring_stats_rx_burst(rx->ethdev_port_id,
-				rx->iface_type, rx->iface_no, 0,
-				bufs, MAX_PKT_BURST);
-#else
 		nb_rx = sppwk_eth_vlan_rx_burst(rx->ethdev_port_id,
 				rx->queue_no, bufs, MAX_PKT_BURST);
-#endif
 		if (unlikely(nb_rx == 0))
 			continue;
 
-		/* Send packets */
-		if (tx->ethdev_port_id >= 0)
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
-			nb_tx = sppwk_eth_vlan_ring_stats_tx_burst(
-					tx->ethdev_port_id, tx->iface_type,
-					tx->iface_no, 0, bufs, nb_rx);
-#else
-			nb_tx = sppwk_eth_vlan_tx_burst(tx->ethdev_port_id,
-					tx->queue_no, bufs, nb_rx);
-#endif
-
-		/* Discard remained packets to release mbuf */
-		if (unlikely(nb_tx < nb_rx)) {
-			for (buf = nb_tx; buf < nb_rx; buf++)
-				rte_pktmbuf_free(bufs[buf]);
-		}
+		/* Send packets if enough packets are buffered. */
+		sppwk_tx_buf_push_bulk(tx_buf, bufs, nb_rx, cur_tsc);
 	}
+
+	/* Send packets waiting longer than flush latency budget. */
+	sppwk_tx_buf_drain(tx_buf, cur_tsc);
 	return SPPWK_RET_OK;
 }
+
+/* Transmit all packets in TX buffer of forwarder. */
+void
+flush_forwarder(int id)
+{
+	sppwk_tx_buf_flush(&g_forward_info[id].tx_buf);
+}
@@ -23,7 +23,7 @@
  * is specified by port command.
  */
 
-/* Clear g_forward_info, ref and update indices. */
+/* Clear g_forward_info. */
 void init_forwarder(void);
 
 /**
@@ -38,6 +38,14 @@ void init_forwarder(void);
  */
 int forward_packets(int id);
 
+/**
+ * Transmit all packets in TX buffer of forwarder or merger. It is called
+ * from worker thread when the component is stopped or the thread exits.
+ *
+ * @param id Unique component ID.
+ */
+void flush_forwarder(int id);
+
 /**
  * Get forwarder status.
  *
@@ -7,6 +7,9 @@
 #include <getopt.h>
 
 #include "classifier.h"
+#include "classifier_flow.h"
+#include "classifier_learn.h"
+#include "balancer.h"
 #include "forwarder.h"
 #include "shared/secondary/common.h"
 #include "shared/secondary/utils.h"
@@ -16,12 +19,13 @@
 #include "shared/secondary/spp_worker_th/cmd_runner.h"
 #include "shared/secondary/spp_worker_th/cmd_parser.h"
 #include "shared/secondary/spp_worker_th/port_capability.h"
+#include "shared/secondary/spp_worker_th/conf_rcu.h"
+#include "shared/secondary/spp_worker_th/tx_coalesce.h"
+#include "shared/chain_latency.h"
 
 #define RTE_LOGTYPE_SPP_VF RTE_LOGTYPE_USER1
 
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
 #include "shared/secondary/spp_worker_th/latency_stats.h"
-#endif
 
 /* getopt_long return value for long option */
 enum SPP_LONGOPT_RETVAL {
@@ -29,7 +33,16 @@ enum SPP_LONGOPT_RETVAL {
 
 	/* Return value definition for getopt_long(). Only for long option. */
 	SPP_LONGOPT_RETVAL_CLIENT_ID,    /* For `--client-id` */
-	SPP_LONGOPT_RETVAL_VHOST_CLIENT  /* For `--vhost-client` */
+	SPP_LONGOPT_RETVAL_VHOST_CLIENT,  /* For `--vhost-client` */
+	SPP_LONGOPT_RETVAL_CLS_TBL_SIZE,  /* For `--cls-table-size` */
+	SPP_LONGOPT_RETVAL_TX_FLUSH_US,  /* For `--tx-flush-us` */
+	SPP_LONGOPT_RETVAL_TX_MIN_BURST,  /* For `--tx-min-burst` */
+	SPP_LONGOPT_RETVAL_LEARN_AGE_SEC,  /* For `--learn-age-sec` */
+	SPP_LONGOPT_RETVAL_BLC_FLOW_TBL_SIZE,  /* For `--blc-flow-table-size` */
+	SPP_LONGOPT_RETVAL_BLC_FLOW_AGE_SEC,  /* For `--blc-flow-age-sec` */
+	SPP_LONGOPT_RETVAL_CLS_FLOW_OFFLOAD,  /* For `--cls-flow-offload` */
+	SPP_LONGOPT_RETVAL_VLAN_FCS,  /* For `--vlan-fcs` */
+	SPP_LONGOPT_RETVAL_CHAIN_LATENCY  /* For `--chain-latency` */
 };
 
 /* Declare global variables */
@@ -51,6 +64,18 @@ static int g_change_component[RTE_MAX_LCORE];
 /* Backup information for cancel command */
 static struct cancel_backup_info g_backup_info;
 
+/* Max num of entries of classifier table */
+static uint32_t g_nof_cls_tbl_entries = DEFAULT_NOF_CLS_TABLE_ENTRIES;
+
+/* Aging time of entries learned by classifier learn in sec */
+static uint32_t g_learn_age_sec = DEFAULT_CLS_LEARN_AGE_SEC;
+
+/* Max num of flows pinned in balancer, or 0 for no flow table */
+static uint32_t g_blc_flow_tbl_size = DEFAULT_BLC_FLOW_TABLE_SIZE;
+
+/* Aging time of flows pinned in balancer in sec */
+static uint32_t g_blc_flow_age_sec = DEFAULT_BLC_FLOW_AGE_SEC;
+
 /* Print help message */
 static void
 usage(const char *progname)
@@ -58,12 +83,100 @@ usage(const char *progname)
 	RTE_LOG(INFO, SPP_VF, "Usage: %s [EAL args] --"
 			" --client-id CLIENT_ID"
 			" -s SERVER_IP:SERVER_PORT"
-			" [--vhost-client]\n"
+			" [--vhost-client]"
+			" [--cls-table-size NUM]"
+			" [--tx-flush-us USEC]"
+			" [--tx-min-burst NUM]"
+			" [--learn-age-sec SEC]"
+			" [--blc-flow-table-size NUM]"
+			" [--blc-flow-age-sec SEC]"
+			" [--cls-flow-offload]"
+			" [--vlan-fcs]"
+			" [--chain-latency]\n"
 			" --client-id CLIENT_ID   : My client ID\n"
 			" -s SERVER_IP:SERVER_PORT  :"
 			" Access information to the server\n"
 			" --vhost-client            : Run vhost on client\n"
-			, progname);
+			" --cls-table-size NUM      :"
+			" Max num of classifier table entries (Default is %d)\n"
+			" --tx-flush-us USEC        :"
+			" Max time packets wait in TX buffer (Default is %d)\n"
+			" --tx-min-burst NUM        :"
+			" Num of packets sent at once (Default is %d)\n"
+			" --learn-age-sec SEC       :"
+			" Aging time of learned MAC addresses (Default is %d)\n"
+			" --blc-flow-table-size NUM :"
+			" Max num of flows pinned in balancer (Default is %d)\n"
+			" --blc-flow-age-sec SEC    :"
+			" Aging time of pinned flows (Default is %d)\n"
+			" --cls-flow-offload        :"
+			" Steer classifier entries to RX queues with rte_flow\n"
+			" --vlan-fcs                :"
+			" Calculate FCS of packets of VLAN tag added or deleted\n"
+			" --chain-latency           :"
+			" Measure latency of service chain\n"
+			, progname, DEFAULT_NOF_CLS_TABLE_ENTRIES,
+			DEFAULT_TX_FLUSH_US, DEFAULT_TX_MIN_BURST,
+			DEFAULT_CLS_LEARN_AGE_SEC, DEFAULT_BLC_FLOW_TABLE_SIZE,
+			DEFAULT_BLC_FLOW_AGE_SEC);
+}
+
+/* Parse `--cls-table-size` option and get the value */
+static int
+parse_cls_table_size(const char *size_str, uint32_t *size)
+{
+	unsigned long tbl_size;
+	char *endptr = NULL;
+
+	tbl_size = strtoul(size_str, &endptr, 10);
+	if (unlikely(size_str == endptr) || unlikely(*endptr != '\0'))
+		return SPPWK_RET_NG;
+
+	/* rte_hash requires at least one bucket of entries */
+	if (unlikely(tbl_size < 8 || tbl_size > UINT32_MAX))
+		return SPPWK_RET_NG;
+
+	*size = (uint32_t)tbl_size;
+	return SPPWK_RET_OK;
+}
+
+/* Parse `--learn-age-sec` or `--blc-flow-age-sec` option */
+static int
+parse_age_sec(const char *sec_str, uint32_t *sec)
+{
+	unsigned long age_sec;
+	char *endptr = NULL;
+
+	age_sec = strtoul(sec_str, &endptr, 10);
+	if (unlikely(sec_str == endptr) || unlikely(*endptr != '\0'))
+		return SPPWK_RET_NG;
+
+	/* 0 is for no aging. */
+	if (unlikely(age_sec > UINT32_MAX))
+		return SPPWK_RET_NG;
+
+	*sec = (uint32_t)age_sec;
+	return SPPWK_RET_OK;
+}
+
+/* Parse `--blc-flow-table-size` option and get the value */
+static int
+parse_blc_flow_table_size(const char *size_str, uint32_t *size)
+{
+	unsigned long tbl_size;
+	char *endptr = NULL;
+
+	tbl_size = strtoul(size_str, &endptr, 10);
+	if (unlikely(size_str == endptr) || unlikely(*endptr != '\0'))
+		return SPPWK_RET_NG;
+
+	/* 0 is for no flow table, or at least one bucket of rte_hash. */
+	if (unlikely((tbl_size != 0 && tbl_size < 8) ||
+			tbl_size > UINT32_MAX))
+		return SPPWK_RET_NG;
+
+	*size = (uint32_t)tbl_size;
+	return SPPWK_RET_OK;
 }
 
 /* Parse options for client app */
@@ -89,6 +202,24 @@ parse_app_args(int argc, char *argv[])
 					SPP_LONGOPT_RETVAL_CLIENT_ID },
 			{ "vhost-client", no_argument, NULL,
 					SPP_LONGOPT_RETVAL_VHOST_CLIENT },
+			{ "cls-table-size", required_argument, NULL,
+					SPP_LONGOPT_RETVAL_CLS_TBL_SIZE },
+			{ "tx-flush-us", required_argument, NULL,
+					SPP_LONGOPT_RETVAL_TX_FLUSH_US },
+			{ "tx-min-burst", required_argument, NULL,
+					SPP_LONGOPT_RETVAL_TX_MIN_BURST },
+			{ "learn-age-sec", required_argument, NULL,
+					SPP_LONGOPT_RETVAL_LEARN_AGE_SEC },
+			{ "blc-flow-table-size", required_argument, NULL,
+					SPP_LONGOPT_RETVAL_BLC_FLOW_TBL_SIZE },
+			{ "blc-flow-age-sec", required_argument, NULL,
+					SPP_LONGOPT_RETVAL_BLC_FLOW_AGE_SEC },
+			{ "cls-flow-offload", no_argument, NULL,
+					SPP_LONGOPT_RETVAL_CLS_FLOW_OFFLOAD },
+			{ "vlan-fcs", no_argument, NULL,
+					SPP_LONGOPT_RETVAL_VLAN_FCS },
+			{ "chain-latency", no_argument, NULL,
+					SPP_LONGOPT_RETVAL_CHAIN_LATENCY },
 			{ 0 },
 	};
 
@@ -120,6 +251,57 @@ parse_app_args(int argc, char *argv[])
 		case SPP_LONGOPT_RETVAL_VHOST_CLIENT:
 			set_vhost_cli_mode(1);
 			break;
+		case SPP_LONGOPT_RETVAL_CLS_TBL_SIZE:
+			if (parse_cls_table_size(optarg,
+					&g_nof_cls_tbl_entries) !=
+					SPPWK_RET_OK) {
+				usage(progname);
+				return SPPWK_RET_NG;
+			}
+			break;
+		case SPP_LONGOPT_RETVAL_TX_FLUSH_US:
+			if (sppwk_parse_tx_flush_us(optarg) != SPPWK_RET_OK) {
+				usage(progname);
+				return SPPWK_RET_NG;
+			}
+			break;
+		case SPP_LONGOPT_RETVAL_TX_MIN_BURST:
+			if (sppwk_parse_tx_min_burst(optarg) != SPPWK_RET_OK) {
+				usage(progname);
+				return SPPWK_RET_NG;
+			}
+			break;
+		case SPP_LONGOPT_RETVAL_LEARN_AGE_SEC:
+			if (parse_age_sec(optarg, &g_learn_age_sec) !=
+					SPPWK_RET_OK) {
+				usage(progname);
+				return SPPWK_RET_NG;
+			}
+			break;
+		case SPP_LONGOPT_RETVAL_BLC_FLOW_TBL_SIZE:
+			if (parse_blc_flow_table_size(optarg,
+					&g_blc_flow_tbl_size) != SPPWK_RET_OK) {
+				usage(progname);
+				return SPPWK_RET_NG;
+			}
+			break;
+		case SPP_LONGOPT_RETVAL_BLC_FLOW_AGE_SEC:
+			if (parse_age_sec(optarg, &g_blc_flow_age_sec) !=
+					SPPWK_RET_OK) {
+				usage(progname);
+				return SPPWK_RET_NG;
+			}
+			break;
+		case SPP_LONGOPT_RETVAL_CLS_FLOW_OFFLOAD:
+			set_cls_flow_offload(1);
+			break;
+		case SPP_LONGOPT_RETVAL_VLAN_FCS:
+			sppwk_set_vlan_fcs(1);
+			break;
+		case SPP_LONGOPT_RETVAL_CHAIN_LATENCY:
+			if (chain_lat_init() != 0)
+				return SPPWK_RET_NG;
+			break;
 		case 's':
 			ret = parse_server(&ctl_ip, &ctl_port, optarg);
 			set_spp_ctl_ip(ctl_ip);
@@ -143,45 +325,102 @@ parse_app_args(int argc, char *argv[])
 	}
 	RTE_LOG(INFO, SPP_VF,
 			"Parsed app args (client_id=%d,server=%s:%d,"
-			"vhost_client=%d)\n",
-			cli_id, ctl_ip, ctl_port, get_vhost_cli_mode());
+			"vhost_client=%d,cls_table_size=%u,"
+			"tx_flush_us=%u,tx_min_burst=%hu,learn_age_sec=%u,"
+			"blc_flow_table_size=%u,blc_flow_age_sec=%u,"
+			"cls_flow_offload=%d,vlan_fcs=%d,chain_latency=%d)\n",
+			cli_id, ctl_ip, ctl_port, get_vhost_cli_mode(),
+			g_nof_cls_tbl_entries, sppwk_get_tx_flush_us(),
+			sppwk_get_tx_min_burst(), g_learn_age_sec,
+			g_blc_flow_tbl_size, g_blc_flow_age_sec,
+			get_cls_flow_offload(), sppwk_get_vlan_fcs(),
+			chain_lat_enabled());
 	return SPPWK_RET_OK;
 }
 
+/**
+ * Transmit all packets in TX buffers of component of given ID. Buffers of
+ * all types are flushed because type of stopped component is already
+ * cleared. Empty buffers are not referred.
+ */
+static void
+flush_comp_tx_bufs(int id)
+{
+	flush_classifier(id);
+	flush_cls_learn(id);
+	flush_balancer(id);
+	flush_forwarder(id);
+}
+
+/* Flush components removed from lcore before referring to new info. */
+static void
+flush_removed_comps(const struct core_info *cur,
+		const struct core_info *next)
+{
+	int i, j;
+
+	for (i = 0; i < cur->num; i++) {
+		for (j = 0; j < next->num; j++) {
+			if (cur->id[i] == next->id[j])
+				break;
+		}
+		if (j == next->num)
+			flush_comp_tx_bufs(cur->id[i]);
+	}
+}
+
 /* Main process of slave core */
 static int
 slave_main(void *arg __attribute__ ((unused)))
 {
 	int ret = 0;
 	int cnt = 0;
+	int next_index;
 	unsigned int lcore_id = rte_lcore_id();
 	enum sppwk_lcore_status status = SPPWK_LCORE_STOPPED;
+	enum sppwk_worker_type comp_type;
 	struct core_mng_info *info = &g_core_info[lcore_id];
 	struct core_info *core = get_core_info(lcore_id);
 
 	RTE_LOG(INFO, SPP_VF, "Slave started on lcore %d.\n", lcore_id);
+	sppwk_conf_rcu_online(lcore_id);
 	set_core_status(lcore_id, SPPWK_LCORE_IDLING);
 
 	while ((status = sppwk_get_lcore_status(lcore_id)) !=
 			SPPWK_LCORE_REQ_STOP) {
+		/* No config is referred from here to the end of loop. */
+		sppwk_conf_rcu_quiescent(lcore_id);
+
 		if (status != SPPWK_LCORE_RUNNING)
 			continue;
 
 		if (sppwk_is_lcore_updated(lcore_id) == 1) {
 			/* Setting with the flush command trigger. */
-			info->ref_index = (info->upd_index+1) % TWO_SIDES;
+			next_index = (info->upd_index+1) % TWO_SIDES;
+			flush_removed_comps(core, &info->core[next_index]);
+			info->ref_index = next_index;
 			core = get_core_info(lcore_id);
 		}
 
 		/* It is for processing multiple components. */
 		for (cnt = 0; cnt < core->num; cnt++) {
 			/* Component classification to call a function. */
-			if (sppwk_get_comp_type(core->id[cnt]) ==
-					SPPWK_TYPE_CLS) {
+			comp_type = sppwk_get_comp_type(core->id[cnt]);
+			if (comp_type == SPPWK_TYPE_CLS) {
 				/* Component type for classifier. */
 				ret = classify_packets(core->id[cnt]);
 				if (unlikely(ret != 0))
 					break;
+			} else if (comp_type == SPPWK_TYPE_CLS_LEARN) {
+				/* Component type for classifier learn. */
+				ret = learn_classify_packets(core->id[cnt]);
+				if (unlikely(ret != 0))
+					break;
+			} else if (comp_type == SPPWK_TYPE_BLC) {
+				/* Component type for balancer. */
+				ret = balance_packets(core->id[cnt]);
+				if (unlikely(ret != 0))
+					break;
 			} else {
 				/* Component type for forward or merge. */
 				ret = forward_packets(core->id[cnt]);
@@ -197,6 +436,11 @@ slave_main(void *arg __attribute__ ((unused)))
 		}
 	}
 
+	/* Not to leave packets in TX buffers of exiting thread. */
+	for (cnt = 0; cnt < core->num; cnt++)
+		flush_comp_tx_bufs(core->id[cnt]);
+
+	sppwk_conf_rcu_offline(lcore_id);
 	set_core_status(lcore_id, SPPWK_LCORE_STOPPED);
 	RTE_LOG(INFO, SPP_VF, "Terminated slave on lcore %d.\n", lcore_id);
 	return ret;
@@ -266,7 +510,21 @@ main(int argc, char *argv[])
 		if (unlikely(ret != SPPWK_RET_OK))
 			break;
 
-		ret = init_cls_mng_info();
+		ret = sppwk_conf_rcu_init();
+		if (unlikely(ret != SPPWK_RET_OK))
+			break;
+
+		ret = init_cls_mng_info(g_nof_cls_tbl_entries);
+		if (unlikely(ret != SPPWK_RET_OK))
+			break;
+
+		ret = init_cls_learn_mng_info(g_nof_cls_tbl_entries,
+				g_learn_age_sec);
+		if (unlikely(ret != SPPWK_RET_OK))
+			break;
+
+		ret = init_balancer_mng_info(g_blc_flow_tbl_size,
+				g_blc_flow_age_sec);
 		if (unlikely(ret != SPPWK_RET_OK))
 			break;
 
@@ -280,24 +538,12 @@ main(int argc, char *argv[])
 		if (unlikely(ret != SPPWK_RET_OK))
 			break;
 
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
-		int port_type, port_id;
-		char dev_name[RTE_DEV_NAME_MAX_LEN] = { 0 };
-		int nof_rings = 0;
-		for (int i = 0; i < RTE_MAX_ETHPORTS; i++) {
-			if (!rte_eth_dev_is_valid_port(i))
-				continue;
-			rte_eth_dev_get_name_by_port(i, dev_name);
-			ret = parse_dev_name(dev_name, &port_type, &port_id);
-			if (port_type == RING)
-				nof_rings++;
-		}
+		/* Rings can be added after launched, so all of IDs are kept. */
 		ret = sppwk_init_ring_latency_stats(
 				SPP_RING_LATENCY_STATS_SAMPLING_INTERVAL,
-				nof_rings);
+				RTE_MAX_ETHPORTS);
 		if (unlikely(ret != SPPWK_RET_OK))
 			break;
-#endif /* SPP_RINGLATENCYSTATS_ENABLE */
 
 		/* Start worker threads of classifier and forwarder */
 		RTE_LCORE_FOREACH_SLAVE(lcore_id) {
@@ -327,14 +573,16 @@ main(int argc, char *argv[])
 			if (unlikely(ret != SPPWK_RET_OK))
 				break;
 
+			/* Merge MAC addresses learned in workers. */
+			merge_cls_learn_entries();
+
+			/* Release configs not referred from workers. */
+			sppwk_conf_rcu_reclaim();
+
 		       /*
 			* Wait to avoid CPU overloaded.
 			*/
 			usleep(100);
-
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
-			print_ring_latency_stats(&g_iface_info);
-#endif /* SPP_RINGLATENCYSTATS_ENABLE */
 		}
 
 		if (unlikely(ret != SPPWK_RET_OK)) {
@@ -358,9 +606,7 @@ main(int argc, char *argv[])
 	 */
 	del_vhost_sockfile(g_iface_info.vhost);
 
-#ifdef SPP_RINGLATENCYSTATS_ENABLE
 	sppwk_clean_ring_latency_stats();
-#endif /* SPP_RINGLATENCYSTATS_ENABLE */
 
 	RTE_LOG(INFO, SPP_VF, "Exit spp_vf.\n");
 	return ret;
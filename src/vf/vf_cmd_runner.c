@@ -3,6 +3,10 @@
  */
 
 #include "classifier.h"
+#include "classifier_acl.h"
+#include "classifier_flow.h"
+#include "classifier_learn.h"
+#include "balancer.h"
 #include "forwarder.h"
 #include "shared/secondary/return_codes.h"
 #include "shared/secondary/json_helper.h"
@@ -10,6 +14,7 @@
 #include "shared/secondary/spp_worker_th/cmd_parser.h"
 #include "shared/secondary/spp_worker_th/cmd_runner.h"
 #include "shared/secondary/spp_worker_th/cmd_res_formatter.h"
+#include "shared/secondary/spp_worker_th/latency_stats.h"
 #include "shared/secondary/spp_worker_th/vf_deps.h"
 
 #define RTE_LOGTYPE_VF_CMD_RUNNER RTE_LOGTYPE_USER1
@@ -23,6 +28,7 @@ const char *CLS_TYPE_A_LIST[] = {
 	"none",
 	"mac",
 	"vlan",
+	"acl",
 	"",  /* termination */
 };
 
@@ -118,15 +124,61 @@ update_cls_table(enum sppwk_action wk_action,
 	return SPPWK_RET_OK;
 }
 
+/* Update ACL rules of classifier with given action, add or del. */
+static int
+update_cls_acl_table(enum sppwk_action wk_action,
+		const struct sppwk_cls_acl_rule *rule,
+		const struct sppwk_port_idx *port)
+{
+	int ret;
+	struct sppwk_port_info *port_info;
+
+	port_info = get_sppwk_port(port->iface_type, port->iface_no,
+			port->queue_no);
+	if (unlikely(port_info == NULL) ||
+			unlikely(port_info->iface_type == UNDEF)) {
+		RTE_LOG(ERR, VF_CMD_RUNNER, "Port %d:%d nq %d doesn't exist.\n",
+				port->iface_type, port->iface_no,
+				port->queue_no);
+		return SPPWK_RET_NG;
+	}
+
+	ret = update_cls_acl_rules(wk_action, rule, port);
+	if (unlikely(ret != SPPWK_RET_OK))
+		return SPPWK_RET_NG;
+
+	/* ACL of classifier of the port is compiled again in flush. */
+	set_component_change_port(port_info, SPPWK_PORT_DIR_TX);
+	return SPPWK_RET_OK;
+}
+
+/* Check if classifier has members of its group including not flushed. */
+static int
+has_cls_group_members(const struct sppwk_comp_info *comp_info_base,
+		int comp_id)
+{
+	int cnt;
+
+	for (cnt = 0; cnt < RTE_MAX_LCORE; cnt++) {
+		if ((comp_info_base + cnt)->wk_type == SPPWK_TYPE_CLS &&
+				(comp_info_base + cnt)->grp_comp_id == comp_id)
+			return 1;
+	}
+	return 0;
+}
+
 /* Assign worker thread or remove on specified lcore. */
 /* TODO(yasufum) revise func name for removing term `component` or `comp`. */
 static int
 update_comp(enum sppwk_action wk_action, const char *name,
-		unsigned int lcore_id, enum sppwk_worker_type wk_type)
+		unsigned int lcore_id, enum sppwk_worker_type wk_type,
+		const char *grp_name)
 {
 	int ret;
 	int ret_del;
 	int comp_lcore_id = 0;
+	int grp_comp_id = -1;
+	enum sppwk_worker_type comp_type;
 	unsigned int tmp_lcore_id = 0;
 	struct sppwk_comp_info *comp_info = NULL;
 	/* TODO(yasufum) revise `core` to be more specific. */
@@ -158,6 +210,21 @@ update_comp(enum sppwk_action wk_action, const char *name,
 			return SPPWK_RET_NG;
 		}
 
+		/* Classifier of given group must be running. */
+		if (grp_name[0] != '\0') {
+			grp_comp_id = sppwk_get_lcore_id(grp_name);
+			if (grp_comp_id < 0 || (comp_info_base +
+					grp_comp_id)->wk_type != SPPWK_TYPE_CLS) {
+				RTE_LOG(ERR, VF_CMD_RUNNER, "No classifier "
+					"'%s' for group.\n", grp_name);
+				return SPPWK_RET_NG;
+			}
+			/* Group is always referred with its first one. */
+			if ((comp_info_base + grp_comp_id)->grp_comp_id >= 0)
+				grp_comp_id = (comp_info_base +
+						grp_comp_id)->grp_comp_id;
+		}
+
 		comp_lcore_id = get_free_lcore_id();
 		if (comp_lcore_id < 0) {
 			RTE_LOG(ERR, VF_CMD_RUNNER, "Cannot assign component over the "
@@ -173,6 +240,8 @@ update_comp(enum sppwk_action wk_action, const char *name,
 		comp_info->wk_type = wk_type;
 		comp_info->lcore_id = lcore_id;
 		comp_info->comp_id = comp_lcore_id;
+		/* Joined to the group in flush, not to be left if canceled. */
+		comp_info->grp_comp_id = grp_comp_id;
 
 		core->id[core->num] = comp_lcore_id;
 		core->num++;
@@ -187,6 +256,17 @@ update_comp(enum sppwk_action wk_action, const char *name,
 			return SPPWK_RET_OK;
 
 		comp_info = (comp_info_base + comp_lcore_id);
+		comp_type = comp_info->wk_type;
+
+		/* Shared table must be kept while members are running. */
+		if (comp_type == SPPWK_TYPE_CLS &&
+				has_cls_group_members(comp_info_base,
+					comp_lcore_id)) {
+			RTE_LOG(ERR, VF_CMD_RUNNER, "Cannot stop '%s' while "
+				"members of its group are running.\n", name);
+			return SPPWK_RET_NG;
+		}
+
 		tmp_lcore_id = comp_info->lcore_id;
 		memset(comp_info, 0x00, sizeof(struct sppwk_comp_info));
 
@@ -194,8 +274,10 @@ update_comp(enum sppwk_action wk_action, const char *name,
 		core = &info->core[info->upd_index];
 
 		/* initialize classifier information */
-		if (comp_info->wk_type == SPPWK_TYPE_CLS)
+		if (comp_type == SPPWK_TYPE_CLS)
 			init_classifier_info(comp_lcore_id);
+		else if (comp_type == SPPWK_TYPE_CLS_LEARN)
+			init_cls_learn_info(comp_lcore_id);
 
 		/* The latest lcore is released if worker thread is stopped. */
 		ret_del = del_comp_info(comp_lcore_id, core->num, core->id);
@@ -242,7 +324,20 @@ check_vf_port_count(int component_type, enum sppwk_port_dir dir,
 		break;
 
 	case SPPWK_TYPE_CLS:
-		if (nof_rx > 1)
+		/* RX queues paired with TX ports for flow offload. */
+		if (nof_rx > 1 && !get_cls_flow_offload())
+			return SPPWK_RET_NG;
+		break;
+
+	case SPPWK_TYPE_CLS_LEARN:
+		/* RX and TX ports are paired in the order of adding. */
+		if (nof_rx > CLS_LEARN_MAX_PORTS ||
+				nof_tx > CLS_LEARN_MAX_PORTS)
+			return SPPWK_RET_NG;
+		break;
+
+	case SPPWK_TYPE_BLC:
+		if (nof_rx > BLC_MAX_PORTS || nof_tx > BLC_MAX_PORTS)
 			return SPPWK_RET_NG;
 		break;
 
@@ -321,6 +416,30 @@ update_port(enum sppwk_action wk_action,
 				ret = SPPWK_RET_OK;
 				break;
 			}
+			if (port_attrs->ops == SPPWK_PORT_OPS_WEIGHT) {
+				/* Change weight, or add it if not given. */
+				while ((cnt < PORT_CAPABL_MAX) &&
+					    (port_info->port_attrs[cnt].ops !=
+					    SPPWK_PORT_OPS_WEIGHT))
+					cnt++;
+				if (cnt >= PORT_CAPABL_MAX) {
+					cnt = 0;
+					while ((cnt < PORT_CAPABL_MAX) &&
+						(port_info->port_attrs[cnt].ops
+						!= SPPWK_PORT_OPS_NONE))
+						cnt++;
+				}
+				if (cnt >= PORT_CAPABL_MAX) {
+					RTE_LOG(ERR, VF_CMD_RUNNER,
+						"No space of port ability.\n");
+					return SPPWK_RET_NG;
+				}
+				memcpy(&port_info->port_attrs[cnt], port_attrs,
+					sizeof(struct sppwk_port_attrs));
+
+				ret = SPPWK_RET_OK;
+				break;
+			}
 			return SPPWK_RET_OK;
 		}
 
@@ -401,12 +520,23 @@ exec_one_cmd(const struct sppwk_cmd_attrs *cmd)
 		}
 		break;
 
+	case SPPWK_CMDTYPE_CLS_ACL:
+		ret = update_cls_acl_table(cmd->spec.cls_table.wk_action,
+				&cmd->spec.cls_table.acl,
+				&cmd->spec.cls_table.port);
+		if (ret == 0) {
+			RTE_LOG(INFO, VF_CMD_RUNNER, "Exec flush.\n");
+			ret = flush_cmd();
+		}
+		break;
+
 	case SPPWK_CMDTYPE_WORKER:
 		ret = update_comp(
 				cmd->spec.comp.wk_action,
 				cmd->spec.comp.name,
 				cmd->spec.comp.core,
-				cmd->spec.comp.wk_type);
+				cmd->spec.comp.wk_type,
+				cmd->spec.comp.grp_name);
 		if (ret == 0) {
 			RTE_LOG(INFO, VF_CMD_RUNNER, "Exec flush.\n");
 			ret = flush_cmd();
@@ -426,6 +556,14 @@ exec_one_cmd(const struct sppwk_cmd_attrs *cmd)
 		}
 		break;
 
+	case SPPWK_CMDTYPE_RING_LATENCY:
+		RTE_LOG(INFO, VF_CMD_RUNNER, "with action `%s`.\n",
+				sppwk_action_str(cmd->spec.ring_lat.wk_action));
+		ret = sppwk_set_ring_latency(cmd->spec.ring_lat.port.iface_no,
+				cmd->spec.ring_lat.wk_action ==
+				SPPWK_ACT_START);
+		break;
+
 	default:
 		/* Do nothing. */
 		ret = SPPWK_RET_OK;
@@ -452,7 +590,7 @@ iterate_lcore_info(struct sppwk_lcore_params *params)
 		core = get_core_info(lcore_id);
 		if (core->num == 0) {
 			ret = (*params->lcore_proc)(params, lcore_id, "",
-				SPPWK_TYPE_NONE_STR, 0, NULL, 0, NULL);
+				SPPWK_TYPE_NONE_STR, 0, NULL, 0, NULL, NULL);
 			if (unlikely(ret != 0)) {
 				RTE_LOG(ERR, VF_CMD_RUNNER,
 						"Failed to proc on lcore %d\n",
@@ -470,6 +608,13 @@ iterate_lcore_info(struct sppwk_lcore_params *params)
 			if (comp_info->wk_type == SPPWK_TYPE_CLS) {
 				ret = get_classifier_status(lcore_id,
 						core->id[cnt], params);
+			} else if (comp_info->wk_type ==
+					SPPWK_TYPE_CLS_LEARN) {
+				ret = get_cls_learn_status(lcore_id,
+						core->id[cnt], params);
+			} else if (comp_info->wk_type == SPPWK_TYPE_BLC) {
+				ret = get_balancer_status(lcore_id,
+						core->id[cnt], params);
 			} else {
 				ret = get_forwarder_status(lcore_id,
 						core->id[cnt], params);
@@ -528,11 +673,24 @@ update_comp_info(struct sppwk_comp_info *p_comp_info, int *p_change_comp)
 			continue;
 
 		comp_info = (p_comp_info + cnt);
-		sppwk_update_port_dir(comp_info);
+		ret = sppwk_update_port_dir(comp_info);
+		if (unlikely(ret < 0)) {
+			RTE_LOG(ERR, VF_CMD_RUNNER, "Failed to update port "
+					"attributes. ( component = %s)\n",
+					comp_info->name);
+			return SPPWK_RET_NG;
+		}
 
 		if (comp_info->wk_type == SPPWK_TYPE_CLS) {
 			ret = update_classifier(comp_info);
 			RTE_LOG(DEBUG, VF_CMD_RUNNER, "Update classifier.\n");
+		} else if (comp_info->wk_type == SPPWK_TYPE_CLS_LEARN) {
+			ret = update_cls_learn(comp_info);
+			RTE_LOG(DEBUG, VF_CMD_RUNNER,
+					"Update classifier learn.\n");
+		} else if (comp_info->wk_type == SPPWK_TYPE_BLC) {
+			ret = update_balancer(comp_info);
+			RTE_LOG(DEBUG, VF_CMD_RUNNER, "Update balancer.\n");
 		} else {
 			ret = update_forwarder(comp_info);
 			RTE_LOG(DEBUG, VF_CMD_RUNNER, "Update forwarder.\n");
@@ -563,7 +721,7 @@ append_classifier_element_value(
 	int ret = SPPWK_RET_NG;
 	char *buff, *tmp_buff;
 	char port_str[CMD_TAG_APPEND_SIZE];
-	char value_str[STR_LEN_SHORT];
+	char value_str[CLS_ACL_RULE_STR_BUFSZ];
 	buff = params->output;
 	tmp_buff = spp_strbuf_allocate(CMD_RES_BUF_INIT_SIZE);
 	if (unlikely(tmp_buff == NULL)) {
@@ -580,11 +738,15 @@ append_classifier_element_value(
 	if (unlikely(ret < SPPWK_RET_OK))
 		return ret;
 
-	memset(value_str, 0x00, STR_LEN_SHORT);
+	memset(value_str, 0x00, sizeof(value_str));
 	switch (cls_type) {
 	case SPPWK_CLS_TYPE_MAC:
 		sprintf(value_str, "%s", mac);
 		break;
+	case SPPWK_CLS_TYPE_ACL:
+		/* ACL rule is given as a formatted string. */
+		snprintf(value_str, sizeof(value_str), "%s", mac);
+		break;
 	case SPPWK_CLS_TYPE_VLAN:
 		sprintf(value_str, "%d/%s", vid, mac);
 		break;
@@ -617,6 +779,12 @@ get_comp_type_from_str(const char *type_str)
 	if (strncmp(type_str, CORE_TYPE_CLASSIFIER_MAC_STR,
 			strlen(CORE_TYPE_CLASSIFIER_MAC_STR)+1) == 0) {
 		return SPPWK_TYPE_CLS;
+	} else if (strncmp(type_str, CORE_TYPE_CLASSIFIER_LEARN_STR,
+			strlen(CORE_TYPE_CLASSIFIER_LEARN_STR)+1) == 0) {
+		return SPPWK_TYPE_CLS_LEARN;
+	} else if (strncmp(type_str, CORE_TYPE_BALANCER_STR,
+			strlen(CORE_TYPE_BALANCER_STR)+1) == 0) {
+		return SPPWK_TYPE_BLC;
 	} else if (strncmp(type_str, CORE_TYPE_MERGE_STR,
 			strlen(CORE_TYPE_MERGE_STR)+1) == 0) {
 		return SPPWK_TYPE_MRG;
@@ -651,6 +819,8 @@ int get_status_ops(struct cmd_res_formatter_ops *ops_list)
 		{ "ring", add_interface },
 		{ "master-lcore", add_master_lcore},
 		{ "core", add_core},
+		{ "ring_latency", add_ring_latency},
+		{ "chain_latency", add_chain_latency},
 		{ "classifier_table", add_classifier_table},
 		{ "", NULL }
 	};